@@ -169,6 +169,36 @@ INGESCAPE_EXPORT igs_result_t igsagent_output_set_double (igsagent_t *self, cons
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_string (igsagent_t *self, const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_impulsion (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_data (igsagent_t *self, const char *name, void *value, size_t size);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_data_owned (igsagent_t *self, const char *name, void *value, size_t size, igs_data_free_fn free_fn);
+
+//output handles, see igs_output_handle_new in ingescape.h
+typedef struct _igs_output_handle_t igsagent_output_handle_t;
+INGESCAPE_EXPORT igsagent_output_handle_t * igsagent_output_handle_new (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT void igsagent_output_handle_destroy (igsagent_output_handle_t **handle);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_bool (igsagent_output_handle_t *handle, bool value);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_int (igsagent_output_handle_t *handle, int value);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_double (igsagent_output_handle_t *handle, double value);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_string (igsagent_output_handle_t *handle, const char *value);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_impulsion (igsagent_output_handle_t *handle);
+INGESCAPE_EXPORT igs_result_t igsagent_output_handle_set_data (igsagent_output_handle_t *handle, void *value, size_t size);
+
+//read handles, see igs_read_handle_new in ingescape.h
+typedef struct _igs_read_handle_t igsagent_read_handle_t;
+INGESCAPE_EXPORT igsagent_read_handle_t * igsagent_read_handle_new (igsagent_t *self, const char *name, igs_iop_type_t type);
+INGESCAPE_EXPORT void igsagent_read_handle_destroy (igsagent_read_handle_t **handle);
+INGESCAPE_EXPORT bool igsagent_read_handle_bool (igsagent_read_handle_t *handle);
+INGESCAPE_EXPORT int igsagent_read_handle_int (igsagent_read_handle_t *handle);
+INGESCAPE_EXPORT double igsagent_read_handle_double (igsagent_read_handle_t *handle);
+
+//pinned values, see igs_input_pin in ingescape.h
+INGESCAPE_EXPORT igs_result_t igsagent_input_pin (igsagent_t *self, const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT igs_result_t igsagent_output_pin (igsagent_t *self, const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT igs_result_t igsagent_parameter_pin (igsagent_t *self, const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT void igsagent_value_unpin (igs_value_pin_t **pin);
+
+//output batches, see igs_output_batch_begin in ingescape.h
+INGESCAPE_EXPORT igs_result_t igsagent_output_batch_begin (igsagent_t *self);
+INGESCAPE_EXPORT igs_result_t igsagent_output_batch_commit (igsagent_t *self);
 
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_bool (igsagent_t *self, const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_int (igsagent_t *self, const char *name, int value);
@@ -176,6 +206,14 @@ INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_double (igsagent_t *self, c
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_string (igsagent_t *self, const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_data (igsagent_t *self, const char *name, void *value, size_t size);
 
+//typed arrays, see igs_input_array in ingescape.h
+INGESCAPE_EXPORT igs_result_t igsagent_input_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, void **values, size_t *count);//caller owns returned value
+INGESCAPE_EXPORT igs_result_t igsagent_output_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, void **values, size_t *count);//caller owns returned value
+INGESCAPE_EXPORT igs_result_t igsagent_parameter_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, void **values, size_t *count);//caller owns returned value
+INGESCAPE_EXPORT igs_result_t igsagent_input_set_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_array (igsagent_t *self, const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+
 INGESCAPE_EXPORT void igsagent_constraints_enforce(igsagent_t *self, bool enforce); //default is false, i.e. disabled
 INGESCAPE_EXPORT igs_result_t igsagent_input_add_constraint(igsagent_t *self, const char *name, const char *constraint);
 INGESCAPE_EXPORT igs_result_t igsagent_output_add_constraint(igsagent_t *self, const char *name, const char *constraint);
@@ -213,6 +251,33 @@ INGESCAPE_EXPORT void igsagent_output_mute (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT void igsagent_output_unmute (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT bool igsagent_output_is_muted (igsagent_t *self, const char *name);
 
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_max_rate (igsagent_t *self, const char *name, double rate);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_min_interval (igsagent_t *self, const char *name, unsigned int interval);
+INGESCAPE_EXPORT double igsagent_output_max_rate (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_conflate (igsagent_t *self, const char *name, bool conflate);
+INGESCAPE_EXPORT bool igsagent_output_is_conflated (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT void igsagent_output_publication_stats (igsagent_t *self, const char *name,
+                                                         size_t *suppressed, size_t *flushed);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_publication_filter (igsagent_t *self, const char *name,
+                                                                      igs_publication_filter_t filter, double deadband);
+INGESCAPE_EXPORT igs_publication_filter_t igsagent_output_publication_filter (igsagent_t *self, const char *name,
+                                                                              double *deadband);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_refresh_interval (igsagent_t *self, const char *name, unsigned int interval);
+INGESCAPE_EXPORT size_t igsagent_output_filtered_publications (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_delta_encoding (igsagent_t *self, const char *name,
+                                                                  unsigned int keyframe_interval);
+INGESCAPE_EXPORT unsigned int igsagent_output_delta_encoding (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT void igsagent_output_delta_stats (igsagent_t *self, const char *name,
+                                                   size_t *keyframes, size_t *deltas);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_codec (igsagent_t *self, const char *name,
+                                                         igs_codec_t codec, size_t threshold);
+INGESCAPE_EXPORT igs_codec_t igsagent_output_codec (igsagent_t *self, const char *name, size_t *threshold);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_chunk_size (igsagent_t *self, const char *name, size_t chunk_size);
+INGESCAPE_EXPORT size_t igsagent_output_chunk_size (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_priority (igsagent_t *self, const char *name,
+                                                            igs_output_priority_t priority);
+INGESCAPE_EXPORT igs_output_priority_t igsagent_output_priority (igsagent_t *self, const char *name);
+
 
 ////////////////////////////////
 // Mapping edition & inspection
@@ -276,6 +341,9 @@ INGESCAPE_EXPORT igs_result_t igsagent_service_reply_arg_add(igsagent_t *self, c
 INGESCAPE_EXPORT igs_result_t igsagent_service_reply_arg_remove(igsagent_t *self, const char *service_name,
                                                                 const char *reply_name,
                                                                 const char *arg_name);
+INGESCAPE_EXPORT igs_result_t igsagent_service_set_codec (igsagent_t *self, const char *name,
+                                                          igs_codec_t codec, size_t threshold);
+INGESCAPE_EXPORT igs_codec_t igsagent_service_codec (igsagent_t *self, const char *name, size_t *threshold);
 INGESCAPE_EXPORT size_t igsagent_service_count (igsagent_t *self);
 INGESCAPE_EXPORT bool igsagent_service_exists (igsagent_t *self, const char *service_name);
 INGESCAPE_EXPORT char ** igsagent_service_list (igsagent_t *self, size_t *nb_of_elements);//returned char** must be freed using igs_free_services_list
@@ -85,6 +85,9 @@ INGESCAPE_MAKE_VERSION(INGESCAPE_VERSION_MAJOR, INGESCAPE_VERSION_MINOR, INGESCA
 typedef struct _igs_json_t igs_json_t;
 typedef struct _igs_json_node_t igs_json_node_t;
 typedef struct _igs_service_arg_t igs_service_arg_t;
+typedef struct _igs_output_handle_t igs_output_handle_t;
+typedef struct _igs_read_handle_t igs_read_handle_t;
+typedef struct _igs_value_pin_t igs_value_pin_t;
 
 #define IGS_MAX_PATH_LENGTH 4096             //
 #define IGS_MAX_IOP_NAME_LENGTH 1024         //
@@ -233,7 +236,12 @@ typedef enum {
     IGS_STRING_T,
     IGS_BOOL_T,
     IGS_IMPULSION_T,
-    IGS_DATA_T
+    IGS_DATA_T,
+    //typed numeric arrays, stored as contiguous native values of int,
+    //float and double, their size being in bytes
+    IGS_INTEGER_ARRAY_T = 16,
+    IGS_FLOAT_ARRAY_T,
+    IGS_DOUBLE_ARRAY_T
 } igs_iop_value_type_t;
 
 //load / set / get definition
@@ -319,12 +327,81 @@ INGESCAPE_EXPORT igs_result_t igs_output_set_string(const char *name, const char
 INGESCAPE_EXPORT igs_result_t igs_output_set_impulsion(const char *name);
 INGESCAPE_EXPORT igs_result_t igs_output_set_data(const char *name, void *value, size_t size);
 
+/*Zero-copy DATA outputs: ownership of value is transferred to ingescape,
+ even if the call fails, and value is then shared by the output and its
+ publications without being copied, except by publications transforming it
+ (compression, timestamps, deltas, batches and shared memory). It is
+ released using free_fn, or free if free_fn is NULL, when the output value
+ is replaced and all publications using it have been sent. Value shall not
+ be modified after this call.*/
+typedef void (igs_data_free_fn)(void *data);
+INGESCAPE_EXPORT igs_result_t igs_output_set_data_owned(const char *name, void *value, size_t size, igs_data_free_fn free_fn);
+
+/*Output handles resolve an output once by its name and are then used
+ to write it without any lookup by name, which is useful for outputs
+ written at high frequency. Handles survive definition changes: if
+ their output is removed, writes fail until an output with the same
+ name is created again. Handles must be destroyed before their agent.*/
+INGESCAPE_EXPORT igs_output_handle_t * igs_output_handle_new(const char *name); //returns NULL if output does not exist
+INGESCAPE_EXPORT void igs_output_handle_destroy(igs_output_handle_t **handle);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_bool(igs_output_handle_t *handle, bool value);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_int(igs_output_handle_t *handle, int value);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_double(igs_output_handle_t *handle, double value);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_string(igs_output_handle_t *handle, const char *value);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_impulsion(igs_output_handle_t *handle);
+INGESCAPE_EXPORT igs_result_t igs_output_handle_set_data(igs_output_handle_t *handle, void *value, size_t size);
+
+/*Read handles resolve an input, output or parameter once by its name and
+ then read bool, int and double values without any lookup or lock, so that
+ threads polling values at high frequency never contend with the threads
+ writing them. Other value types are converted under the model lock.
+ Like output handles, read handles follow definition changes and must be
+ destroyed before their agent.*/
+INGESCAPE_EXPORT igs_read_handle_t * igs_read_handle_new(const char *name, igs_iop_type_t type); //returns NULL if iop does not exist
+INGESCAPE_EXPORT void igs_read_handle_destroy(igs_read_handle_t **handle);
+INGESCAPE_EXPORT bool igs_read_handle_bool(igs_read_handle_t *handle);
+INGESCAPE_EXPORT int igs_read_handle_int(igs_read_handle_t *handle);
+INGESCAPE_EXPORT double igs_read_handle_double(igs_read_handle_t *handle);
+
+/*Pins give a read-only pointer to the current value of a string, data or
+ array IOP without copying it. A pinned value stays valid and unchanged
+ until it is unpinned, even if its IOP is written, cleared or removed in
+ the meantime. Strings include their terminating zero in size. Empty
+ values give a NULL value and pin. Pins shall be released quickly because
+ pinned values are not reused by the IOP. Unpinning a NULL pin is safe.*/
+INGESCAPE_EXPORT igs_result_t igs_input_pin(const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT igs_result_t igs_output_pin(const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT igs_result_t igs_parameter_pin(const char *name, const void **value, size_t *size, igs_value_pin_t **pin);
+INGESCAPE_EXPORT void igs_value_unpin(igs_value_pin_t **pin);
+
+/*Output batches group the outputs written between begin and commit into
+ a single publication. Values are updated locally as usual but are only
+ published at commit, so that subscribers receive all of them together
+ and run their observe callbacks once all inputs have been updated. DATA
+ and array outputs, and outputs having a maximum publication rate, are
+ published individually at commit, as are all outputs when the publication
+ queue is enabled.*/
+INGESCAPE_EXPORT igs_result_t igs_output_batch_begin(void);
+INGESCAPE_EXPORT igs_result_t igs_output_batch_commit(void);
+
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_bool(const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_int(const char *name, int value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_double(const char *name, double value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_string(const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_data(const char *name, void *value, size_t size);
 
+/*Typed arrays: values are count contiguous elements of the C type matching
+ array_type (int, float or double). Elements are converted when the IOP
+ has another array type, and when reading them as another array type.
+ Scalars written into arrays become single elements and strings of numbers
+ separated by commas or spaces are parsed, e.g. "[1, 2.5, 3]".*/
+INGESCAPE_EXPORT igs_result_t igs_input_array(const char *name, igs_iop_value_type_t array_type, void **values, size_t *count); //caller owns returned value
+INGESCAPE_EXPORT igs_result_t igs_output_array(const char *name, igs_iop_value_type_t array_type, void **values, size_t *count); //caller owns returned value
+INGESCAPE_EXPORT igs_result_t igs_parameter_array(const char *name, igs_iop_value_type_t array_type, void **values, size_t *count); //caller owns returned value
+INGESCAPE_EXPORT igs_result_t igs_input_set_array(const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+INGESCAPE_EXPORT igs_result_t igs_output_set_array(const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+INGESCAPE_EXPORT igs_result_t igs_parameter_set_array(const char *name, igs_iop_value_type_t array_type, const void *values, size_t count);
+
 /*Constraints on IOPs
  Constraints enable verifications upon sending or receiving information
  with inputs and outputs. The syntax for the constraints is global but
@@ -398,6 +475,78 @@ INGESCAPE_EXPORT void igs_output_mute(const char *name);
 INGESCAPE_EXPORT void igs_output_unmute(const char *name);
 INGESCAPE_EXPORT bool igs_output_is_muted(const char *name);
 
+/*Publication policies for outputs written faster than their consumers
+ need them. While the agent is started, an output is not published again
+ before its minimum interval has elapsed. Suppressed values are dropped,
+ unless the output is conflated : its latest value is then published when
+ the interval has elapsed. Policies are part of the definition.*/
+INGESCAPE_EXPORT igs_result_t igs_output_set_max_rate(const char *name, double rate); //in Hz, 0 to disable
+INGESCAPE_EXPORT igs_result_t igs_output_set_min_interval(const char *name, unsigned int interval); //in milliseconds
+INGESCAPE_EXPORT double igs_output_max_rate(const char *name); //0 if not set
+INGESCAPE_EXPORT igs_result_t igs_output_set_conflate(const char *name, bool conflate);
+INGESCAPE_EXPORT bool igs_output_is_conflated(const char *name);
+//number of values suppressed by the policy and of conflated values published by its timer
+INGESCAPE_EXPORT void igs_output_publication_stats(const char *name, size_t *suppressed, size_t *flushed);
+
+/*Publication filters : written values are not published when they did not
+ change, or changed less than a dead-band for integer and double outputs.
+ Relative dead-bands are a ratio of the last published value. Filtered values
+ are still published once the refresh interval has elapsed since the last
+ publication, so that late joiners converge. Filters are part of the definition.*/
+typedef enum {
+    IGS_PUBLICATION_FILTER_NONE = 0,
+    IGS_PUBLICATION_FILTER_CHANGE,
+    IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE,
+    IGS_PUBLICATION_FILTER_DEADBAND_RELATIVE
+} igs_publication_filter_t;
+INGESCAPE_EXPORT igs_result_t igs_output_set_publication_filter(const char *name, igs_publication_filter_t filter, double deadband);
+INGESCAPE_EXPORT igs_publication_filter_t igs_output_publication_filter(const char *name, double *deadband);
+INGESCAPE_EXPORT igs_result_t igs_output_set_refresh_interval(const char *name, unsigned int interval); //in milliseconds, 0 to disable
+INGESCAPE_EXPORT size_t igs_output_filtered_publications(const char *name);
+
+/*Delta encoding for data outputs carrying large values that change little
+ between publications. Peers using protocol v5 receive a full keyframe, then
+ the changed bytes only, until the next keyframe sent every keyframe_interval
+ publications. Peers joining the stream or missing a publication ask for a
+ keyframe, which is sent with the next publication. Delta encoding is part
+ of the definition.*/
+INGESCAPE_EXPORT igs_result_t igs_output_set_delta_encoding(const char *name, unsigned int keyframe_interval); //0 to disable
+INGESCAPE_EXPORT unsigned int igs_output_delta_encoding(const char *name); //keyframe interval, 0 if disabled
+INGESCAPE_EXPORT void igs_output_delta_stats(const char *name, size_t *keyframes, size_t *deltas);
+
+/*Compression of data outputs in publications to peers using protocol v5 and
+ of data arguments sent by remote callers of a service. Values smaller than
+ the threshold (in bytes) or that do not compress are sent as is. Codecs are
+ part of the definition.*/
+typedef enum {
+    IGS_CODEC_NONE = 0,
+    IGS_CODEC_LZ //fast LZ77 codec built into the library
+} igs_codec_t;
+INGESCAPE_EXPORT igs_result_t igs_output_set_codec(const char *name, igs_codec_t codec, size_t threshold);
+INGESCAPE_EXPORT igs_codec_t igs_output_codec(const char *name, size_t *threshold);
+
+/*Streaming of large data outputs to peers using protocol v5 : values larger
+ than the chunk size are published in chunks, between which publications of
+ other outputs can be sent. Subscribers write the value when all its chunks
+ are received and discard it if its chunks stop arriving. Chunk size is part
+ of the definition.*/
+INGESCAPE_EXPORT igs_result_t igs_output_set_chunk_size(const char *name, size_t chunk_size); //in bytes, 0 to disable
+INGESCAPE_EXPORT size_t igs_output_chunk_size(const char *name);
+
+/*Priority classes of outputs : each class is published on its own TCP
+ socket with its own high water mark and drop policy, so that bursts of
+ bulky outputs do not make peers drop control outputs. Peers using protocol
+ v5 subscribe to each class separately, or to the socket of the normal class
+ if they cannot connect to the one of a class. IPC, inproc and batches use the
+ sockets of the normal class. Priority is part of the definition.*/
+typedef enum {
+    IGS_PRIORITY_NORMAL = 0,
+    IGS_PRIORITY_CONTROL, //small outputs that must get through congestion
+    IGS_PRIORITY_BULK //large outputs dropped first under congestion
+} igs_output_priority_t;
+INGESCAPE_EXPORT igs_result_t igs_output_set_priority(const char *name, igs_output_priority_t priority);
+INGESCAPE_EXPORT igs_output_priority_t igs_output_priority(const char *name);
+
 
 ////////////////////////////////
 // Mapping edition & inspection
@@ -512,6 +661,10 @@ INGESCAPE_EXPORT igs_result_t igs_service_reply_arg_remove(const char *service_n
                                                            const char *reply_name,
                                                            const char *arg_name);//removes first occurence of an argument with this name
 
+//compression of data arguments, see igs_output_set_codec
+INGESCAPE_EXPORT igs_result_t igs_service_set_codec(const char *name, igs_codec_t codec, size_t threshold);
+INGESCAPE_EXPORT igs_codec_t igs_service_codec(const char *name, size_t *threshold);
+
 //introspection for services, their arguments and optional replies
 INGESCAPE_EXPORT size_t igs_service_count(void);
 INGESCAPE_EXPORT bool igs_service_exists(const char *name);
@@ -821,6 +974,13 @@ INGESCAPE_EXPORT bool igs_has_ipc(void);
 //set IPC folder path on UNIX systems (default is /tmp/ingescape/)
 INGESCAPE_EXPORT void igs_set_ipc_dir(const char *path);
 INGESCAPE_EXPORT const char * igs_ipc_dir(void);
+/*Shared memory for agents on the same host using IPC : data outputs of at
+ least threshold bytes are copied once into a shared ring of the given size
+ and IPC subscribers only receive their position. Values larger than half
+ the ring are sent on the socket. Size 0 disables shared memory, which is
+ the default. To be called before igs_start.*/
+INGESCAPE_EXPORT igs_result_t igs_net_set_shared_memory(size_t size, size_t threshold);
+INGESCAPE_EXPORT size_t igs_net_shared_memory(size_t *threshold);
 #endif
 
 
@@ -838,10 +998,37 @@ INGESCAPE_EXPORT void igs_net_set_publishing_port(unsigned int port);
 INGESCAPE_EXPORT void igs_net_set_log_stream_port(unsigned int port);
 INGESCAPE_EXPORT void igs_net_set_discovery_interval(unsigned int interval); //in milliseconds
 INGESCAPE_EXPORT void igs_net_set_timeout(unsigned int duration); //in milliseconds
+//Changes to definitions and mappings are sent to other agents after this
+//delay, together with the other changes made in the meantime. Default is 5 ms.
+INGESCAPE_EXPORT void igs_net_set_update_debounce(unsigned int delay); //in milliseconds
+INGESCAPE_EXPORT unsigned int igs_net_update_debounce(void);
 INGESCAPE_EXPORT void  igs_net_raise_sockets_limit(void); //UNIX only, to be called before any ingescape or ZeroMQ activity
 //Set high water marks (HWM) for the publish/subscribe sockets.
 //Setting HWM to 0 means that they are disabled.
 INGESCAPE_EXPORT void igs_net_set_high_water_marks(int hwm_value);
+/*Queued publication: threads writing outputs only copy their values into
+ a lock-free queue and a dedicated thread serializes and sends them.
+ Depth is rounded up to a power of two and 0 disables queued publication,
+ which is the default. To be called before igs_start.*/
+typedef enum {
+    IGS_PUBLICATION_QUEUE_BLOCK = 0, //writers wait until the queue has room
+    IGS_PUBLICATION_QUEUE_DROP_OLDEST, //oldest queued publication is discarded
+    IGS_PUBLICATION_QUEUE_DROP_NEWEST //new publication is discarded
+} igs_publication_queue_policy_t;
+INGESCAPE_EXPORT igs_result_t igs_net_set_publication_queue(size_t depth, igs_publication_queue_policy_t policy);
+//queued publications counters, any parameter can be NULL
+INGESCAPE_EXPORT void igs_net_publication_queue_stats(size_t *occupancy, size_t *high_water_mark,
+                                                      size_t *dropped, size_t *published);
+/*High water mark and drop policy of the TCP publisher of an output priority
+ class. IGS_PUBLICATION_QUEUE_DROP_NEWEST is the default and drops messages
+ for subscribers reaching the HWM, IGS_PUBLICATION_QUEUE_BLOCK makes
+ publications wait for them, IGS_PUBLICATION_QUEUE_DROP_OLDEST is not
+ supported by sockets. Classes keep the value of igs_net_set_high_water_marks
+ until they are configured here.*/
+INGESCAPE_EXPORT igs_result_t igs_net_set_priority_policy(igs_output_priority_t priority, int hwm_value,
+                                                          igs_publication_queue_policy_t policy);
+INGESCAPE_EXPORT int igs_net_priority_policy(igs_output_priority_t priority,
+                                             igs_publication_queue_policy_t *policy); //returns HWM
 
 
 /*PERFORMANCE CHECK
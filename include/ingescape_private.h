@@ -61,6 +61,50 @@ typedef CRITICAL_SECTION igs_mutex_t;
 #   define IGS_MUTEX_DESTROY(m) DeleteCriticalSection (&m)
 #endif
 
+//  Reader/writer lock macros
+#if defined (__UNIX__)
+typedef pthread_rwlock_t igs_rwlock_t;
+#   define IGS_RWLOCK_INIT(l)           pthread_rwlock_init (&l, NULL)
+#   define IGS_RWLOCK_READ_LOCK(l)      pthread_rwlock_rdlock (&l)
+#   define IGS_RWLOCK_READ_UNLOCK(l)    pthread_rwlock_unlock (&l)
+#   define IGS_RWLOCK_WRITE_LOCK(l)     pthread_rwlock_wrlock (&l)
+#   define IGS_RWLOCK_WRITE_UNLOCK(l)   pthread_rwlock_unlock (&l)
+#   define IGS_RWLOCK_DESTROY(l)        pthread_rwlock_destroy (&l)
+#   define IGS_THREAD_LOCAL __thread
+#elif defined (__WINDOWS__)
+typedef SRWLOCK igs_rwlock_t;
+#   define IGS_RWLOCK_INIT(l)           InitializeSRWLock (&l)
+#   define IGS_RWLOCK_READ_LOCK(l)      AcquireSRWLockShared (&l)
+#   define IGS_RWLOCK_READ_UNLOCK(l)    ReleaseSRWLockShared (&l)
+#   define IGS_RWLOCK_WRITE_LOCK(l)     AcquireSRWLockExclusive (&l)
+#   define IGS_RWLOCK_WRITE_UNLOCK(l)   ReleaseSRWLockExclusive (&l)
+#   define IGS_RWLOCK_DESTROY(l)
+#   define IGS_THREAD_LOCAL __declspec(thread)
+#endif
+
+//  Atomic macros, loads have acquire and stores release semantics
+#if defined (__WINDOWS__)
+#   define IGS_ATOMIC_LOAD(p)           InterlockedCompareExchange ((volatile LONG *) (p), 0, 0)
+#   define IGS_ATOMIC_STORE(p, v)       InterlockedExchange ((volatile LONG *) (p), (LONG) (v))
+#   define IGS_ATOMIC_LOAD_PTR(p)       InterlockedCompareExchangePointer ((PVOID volatile *) (p), NULL, NULL)
+#   define IGS_ATOMIC_STORE_PTR(p, v)   InterlockedExchangePointer ((PVOID volatile *) (p), (v))
+#   define IGS_ATOMIC_FENCE()           MemoryBarrier ()
+#   define IGS_ATOMIC_LOAD64(p)         InterlockedCompareExchange64 ((p), 0, 0)
+#   define IGS_ATOMIC_STORE64(p, v)     InterlockedExchange64 ((p), (v))
+#   define IGS_ATOMIC_ADD64(p, v)       InterlockedAdd64 ((p), (v))
+#   define IGS_ATOMIC_CAS64(p, e, d)    (InterlockedCompareExchange64 ((p), (d), (e)) == (e))
+#else
+#   define IGS_ATOMIC_LOAD(p)           __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#   define IGS_ATOMIC_STORE(p, v)       __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#   define IGS_ATOMIC_LOAD_PTR(p)       __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#   define IGS_ATOMIC_STORE_PTR(p, v)   __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#   define IGS_ATOMIC_FENCE()           __atomic_thread_fence (__ATOMIC_SEQ_CST)
+#   define IGS_ATOMIC_LOAD64(p)         __atomic_load_n ((p), __ATOMIC_ACQUIRE)
+#   define IGS_ATOMIC_STORE64(p, v)     __atomic_store_n ((p), (v), __ATOMIC_RELEASE)
+#   define IGS_ATOMIC_ADD64(p, v)       __atomic_add_fetch ((p), (v), __ATOMIC_ACQ_REL)
+#   define IGS_ATOMIC_CAS64(p, e, d)    __sync_bool_compare_and_swap ((p), (e), (d))
+#endif
+
 typedef struct igs_core_context igs_core_context_t;
 
 typedef enum {
@@ -72,6 +116,8 @@ typedef enum {
     IGS_TIMESTAMPED_DATA_T
 } igs_iop_value_type_extended_t;
 
+#define IGS_OUTPUT_PRIORITIES_NB (IGS_PRIORITY_BULK + 1)
+
 //////////////////  IOP/SERVICE STRUCTURES AND ENUMS   //////////////////
 
 typedef struct igs_observe_wrapper{
@@ -90,6 +136,7 @@ typedef enum {
 
 typedef struct igs_constraint{
     igs_constraint_type_t type;
+    igs_iop_value_type_t value_type; // selects the int or double members below
     union {
         struct {
             int min;
@@ -120,6 +167,56 @@ typedef struct igs_constraint{
     struct igs_constraint *next;
 } igs_constraint_t;
 
+/*
+ Refcounted buffer for DATA values. A buffer is shared by the iop
+ holding it, the zero-copy frames publishing it and the inputs
+ receiving it in the same process, and is freed with the last of them.
+ */
+typedef struct igs_data_buffer {
+    void *data;
+    size_t size;
+    igs_data_free_fn *free_fn; //NULL to use free
+    zframe_t *frame; //when set, data belongs to this frame
+    void *refcount; //zmq atomic counter
+} igs_data_buffer_t;
+
+/*
+ Scalar value of an iop, published for lock-free readers. Writers hold
+ the agent write lock and make sequence odd while updating the value,
+ readers retry until they read the same even sequence before and after
+ copying it. Snapshots are refcounted by the iop and the read handles
+ using them, and are detached when their iop is freed.
+ */
+typedef struct igs_iop_snapshot {
+    int32_t sequence;
+    int32_t detached;
+    igs_iop_value_type_t value_type;
+    union {
+        int i;
+        double d;
+        bool b;
+    } value;
+    void *refcount; //zmq atomic counter
+} igs_iop_snapshot_t;
+
+// bytes of a chunked value already received, from start to end excluded
+typedef struct igs_chunk_range {
+    uint64_t start;
+    uint64_t end;
+    struct igs_chunk_range *prev;
+    struct igs_chunk_range *next;
+} igs_chunk_range_t;
+
+// data value of a remote output being reassembled from its chunks
+typedef struct igs_chunked_value {
+    uint32_t stream;
+    uint64_t size;
+    uint64_t received; //duplicated bytes are counted once
+    igs_chunk_range_t *ranges; //ordered, disjoint and not adjacent
+    uint8_t *data;
+    int64_t last_chunk; //monotonic milliseconds
+} igs_chunked_value_t;
+
 typedef struct igs_iop{
     char* name;
     char *description;
@@ -133,12 +230,102 @@ typedef struct igs_iop{
         void* data;
     } value;
     size_t value_size;
+    igs_data_buffer_t *data_buffer; //holds value.data for DATA iops when set
+    igs_iop_snapshot_t *snapshot; //created on first lock-free access
     bool is_muted;
     igs_observe_wrapper_t *callbacks;
     igs_constraint_t *constraint;
+    uint16_t id; //outputs only, used in compact publications, 0 if none
+    int64_t publication_min_interval; //outputs only, microseconds, 0 if none
+    bool publication_conflate; //suppressed value is published once interval has elapsed
+    bool publication_flush_pending; //a timer will publish the conflated value
+    int64_t last_publication; //microseconds
+    size_t suppressed_publications_nb;
+    size_t flushed_publications_nb;
+    igs_publication_filter_t publication_filter; //outputs only
+    double publication_deadband; //absolute, or ratio of the reference for relative dead-bands
+    int64_t publication_refresh_interval; //microseconds, 0 if none
+    bool has_publication_reference;
+    double publication_reference; //last published numeric value
+    igs_data_buffer_t *publication_reference_buffer; //last published string, data or array
+    int64_t last_unfiltered_publication; //microseconds
+    size_t filtered_publications_nb;
+    // delta encoding of data outputs, see s_network_encode_delta
+    unsigned int delta_keyframe_interval; //0 if disabled
+    igs_data_buffer_t *delta_reference; //last published value
+    uint32_t delta_sequence;
+    unsigned int deltas_since_keyframe;
+    bool delta_keyframe_requested;
+    size_t published_keyframes_nb;
+    size_t published_deltas_nb;
+    igs_codec_t codec; //compression of data values in compact publications
+    size_t codec_threshold; //smaller values are not compressed
+    size_t chunk_size; //larger data values are streamed in chunks, 0 if disabled
+    igs_output_priority_t priority; //publisher socket class
     UT_hash_handle hh;         /* makes this structure hashable */
+    UT_hash_handle hh_id;      /* makes outputs hashable by id */
 } igs_iop_t;
 
+// specialized writer converting a value of a given type into an iop of a
+// given type, see model_iop_writer
+#define IGS_SCALAR_TYPES_NB (IGS_DATA_T + 1)
+typedef int (igs_iop_writer_fn) (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t val_type,
+                                 void *value, size_t size, igs_data_buffer_t *buffer,
+                                 void **written_value, size_t *written_size);
+
+// observe callbacks deferred until a batch of writes has been applied
+typedef struct igs_deferred_observe {
+    igsagent_t *agent;
+    igs_iop_t *iop;
+    int64_t timestamp;
+    struct igs_deferred_observe *next;
+} igs_deferred_observe_t;
+
+/*
+ Queued publications : a bounded multi-producer queue where each record
+ has a sequence telling if it is free for the producer at this position
+ or filled for the consumer, publisher thread being the only consumer
+ unless drop-oldest policy makes producers discard records.
+ */
+#define IGS_PUBLICATION_RECORD_NAME_LENGTH 64
+typedef struct igs_publication_record {
+    igsagent_t *agent;
+    char agent_uuid[IGS_AGENT_UUID_LENGTH + 1]; //to check agent is still alive
+    igs_iop_t output; //copy of the published output and value
+    char name[IGS_PUBLICATION_RECORD_NAME_LENGTH]; //output name when short enough, to avoid allocations
+    int64_t timestamp;
+    uint8_t delta_flags; //keyframe or delta flag for delta encoded outputs, 0 otherwise
+    uint32_t delta_sequence;
+    uint8_t *delta; //changes since the previous publication for delta flag
+    size_t delta_size;
+} igs_publication_record_t;
+
+typedef struct igs_publication_slot {
+    int64_t sequence;
+    igs_publication_record_t record;
+} igs_publication_slot_t;
+
+typedef struct igs_publication_queue {
+    igs_publication_slot_t *slots;
+    int64_t depth; //power of two
+    int64_t enqueue_position;
+    int64_t dequeue_position;
+    int64_t running;
+    int64_t sleeping; //publisher thread waits for a wake up
+    int64_t high_water_mark;
+    int64_t dropped;
+    int64_t published;
+    igs_publication_queue_policy_t policy;
+    igs_mutex_t wakeup_mutex; //protects publisher pipe
+    zactor_t *publisher;
+} igs_publication_queue_t;
+
+// outputs written during a publication batch
+typedef struct igs_batched_output {
+    char *name;
+    struct igs_batched_output *next;
+} igs_batched_output_t;
+
 typedef struct igs_service{
     char * name;
     char * description;
@@ -146,6 +333,8 @@ typedef struct igs_service{
     void *cb_data;
     igs_service_arg_t *arguments;
     struct igs_service *replies;
+    igs_codec_t codec; //compression of data arguments sent by remote callers
+    size_t codec_threshold;
     UT_hash_handle hh;
 } igs_service_t;
 
@@ -157,6 +346,8 @@ typedef struct igs_definition{
     igs_iop_t* params_table;
     igs_iop_t* inputs_table;
     igs_iop_t* outputs_table;
+    igs_iop_t* outputs_by_id; //uses hh_id
+    uint16_t last_output_id;
     igs_service_t *services_table;
 } igs_definition_t;
 
@@ -181,8 +372,56 @@ typedef struct igs_mapping{
     igs_split_t* split_elements;
 } igs_mapping_t;
 
+/*
+ Routes are an inverted index of the mappings of all our agents.
+ They are keyed by emitting agent name and output name and give
+ the inputs to be written in our agents when a publication is
+ received, without iterating on agents and mapping elements.
+ Routes are edited and read with the model lock held.
+ */
+typedef struct igs_route_target {
+    igsagent_t *agent;
+    igs_map_t *map_elmt;
+    igs_iop_t *input; //NULL if input is missing in agent definition
+    igs_iop_writer_fn *writers[IGS_SCALAR_TYPES_NB]; //into input, by received value type
+} igs_route_target_t;
+
+typedef struct igs_route {
+    char *output;
+    igs_route_target_t *targets;
+    size_t targets_nb;
+    UT_hash_handle hh;
+} igs_route_t;
+
+typedef struct igs_route_emitter {
+    char *agent_name;
+    igs_route_t *routes;
+    UT_hash_handle hh;
+} igs_route_emitter_t;
+
+/*
+ Output handles cache the resolution of an output by name and
+ its publication topic. The cached iop is resolved again when
+ the agent definition generation changes.
+ */
+struct _igs_read_handle_t {
+    igsagent_t *agent;
+    char *name;
+    igs_iop_type_t type;
+    igs_iop_snapshot_t *snapshot; //NULL when the iop does not exist anymore
+};
+
+struct _igs_output_handle_t {
+    igsagent_t *agent;
+    char *name;
+    char *topic; //prebuilt uuid-name publication topic
+    igs_iop_t *iop; //NULL when the output does not exist anymore
+    uint64_t definition_generation;
+};
+
 typedef struct igs_mapping_filter {
     char *filter;
+    zsock_t *subscriber; //socket of the peer the filter is set on
     struct igs_mapping_filter *next, *prev;
 } igs_mapping_filter_t;
 
@@ -217,27 +456,75 @@ typedef struct igs_splitter{
 
 //////////////////  NETWORK  STRUCTURES AND ENUMS   //////////////////
 
+// shared memory ring holding the large data values published to agents
+// running on the same host
+typedef struct igs_shared_memory {
+    char *name;
+    size_t size; //mapped size
+    uint8_t *region;
+} igs_shared_memory_t;
+
 typedef struct igs_zyre_peer {
     char *peer_id;
     char *name;
     zsock_t *subscriber; //link to the peer's publisher socket
+    zsock_t *priority_subscribers[IGS_OUTPUT_PRIORITIES_NB]; //links to its priority class publishers over TCP, normal class uses subscriber
     int reconnected;
     bool has_joined_private_channel;
     char *protocol;
+    bool uses_legacy_publications; //peer protocol is older than v5
+    bool is_on_same_host; //v5 peer in another process of our host
+    igs_shared_memory_t *shared_memory; //mapped when subscribing using ipc
+    struct igs_remote_agent *remote_agents_by_topic_key; //exact match of compact topics
     UT_hash_handle hh;
 } igs_zyre_peer_t;
 
+// element of a definition or a mapping changed since the last update sent
+// to peers, see definition and mapping deltas in igs_network.c
+typedef struct igs_delta_change {
+    char kind; //IGS_DELTA_INPUT, ...
+    char *name; //iops and services
+    uint64_t id; //mapping elements
+    struct igs_delta_change *next;
+} igs_delta_change_t;
+
+// remote definition parsed once and shared by all remote agents
+// announcing the same fingerprint, never modified once shared
+typedef struct igs_shared_definition {
+    char *fingerprint; //SHA-1 of the exported definition
+    igs_definition_t *definition;
+    size_t refcount;
+    UT_hash_handle hh;
+} igs_shared_definition_t;
+
+// reception state of a remote output, kept by each remote agent
+// because definitions may be shared
+typedef struct igs_remote_output_state {
+    char *name;
+    igs_data_buffer_t *delta_reference; //last rebuilt value
+    uint32_t delta_sequence;
+    int64_t delta_keyframe_request; //time of our last keyframe request
+    igs_chunked_value_t *chunked_value; //value being reassembled
+    UT_hash_handle hh;
+} igs_remote_output_state_t;
+
 // remote agent we are subscribing to
 typedef struct igs_remote_agent{
     char *uuid;
     igs_zyre_peer_t *peer;
     igs_core_context_t *context;
-    igs_definition_t *definition;
+    igs_definition_t *definition; //owned by shared_definition
+    igs_shared_definition_t *shared_definition;
+    igs_remote_output_state_t *output_states;
+    uint64_t definition_revision; //last revision received, 0 if unknown
+    uint64_t mapping_revision;
+    uint16_t topic_key; //announced with its definition, 0 if unknown
     bool shall_send_outputs_request;
     igs_mapping_t *mapping;
     igs_mapping_filter_t *mapping_filters;
     int timer_id;
     UT_hash_handle hh;
+    UT_hash_handle hh_topic_key;
 } igs_remote_agent_t;
 
 typedef struct igs_timer{
@@ -247,6 +534,16 @@ typedef struct igs_timer{
     UT_hash_handle hh;
 } igs_timer_t;
 
+// conflated output waiting for its publication timer
+typedef struct igs_publication_flush {
+    igsagent_t *agent;
+    char agent_uuid[IGS_AGENT_UUID_LENGTH + 1]; //to check agent is still alive
+    char *output;
+    int timer_id;
+    struct igs_publication_flush *prev;
+    struct igs_publication_flush *next;
+} igs_publication_flush_t;
+
 typedef struct igs_peer_header {
     char *key;
     char *value;
@@ -345,10 +642,28 @@ struct _igsagent_t {
     // definition
     char *definition_path;
     igs_definition_t* definition;
+    uint64_t definition_generation; //incremented when outputs may have been added or freed
+    uint64_t definition_revision; //incremented on every change to the exported definition
+    // cached exports shared by all peers, valid while their revision matches
+    igs_data_buffer_t *definition_export;
+    uint64_t definition_export_revision;
+    char *definition_export_fingerprint; //sent to recent peers with our definition
+    // changes since the last definition update sent to peers
+    igs_delta_change_t *definition_changes;
+    bool definition_needs_full_update; //some changes cannot be sent as deltas
+    uint64_t definition_sent_revision; //0 if never sent
+    igs_data_buffer_t *definition_export_legacy;
+    uint64_t definition_export_legacy_revision;
+    igs_data_buffer_t *definition_export_without_arrays;
+    uint64_t definition_export_without_arrays_revision;
 
     // mapping
     char *mapping_path;
     igs_mapping_t *mapping;
+    uint64_t mapping_revision; //incremented on every change
+    igs_delta_change_t *mapping_changes;
+    bool mapping_needs_full_update;
+    uint64_t mapping_sent_revision; //0 if never sent
 
     //real-time
     bool rt_timestamps_enabled;
@@ -359,10 +674,18 @@ struct _igsagent_t {
     bool network_need_to_send_mapping_update;
     bool network_request_outputs_from_mapped_agents;
     bool network_activation_during_runtime;
+    uint16_t topic_key; //unique in our context, prefixes our compact topics
 
     bool is_whole_agent_muted;
     igs_mute_wrapper_t *mute_callbacks;
 
+    // protects the values of our iops, see model locks
+    igs_rwlock_t values_lock;
+
+    // publication batch
+    bool batch_in_progress;
+    igs_batched_output_t *batched_outputs;
+
     zlist_t *elections;
 
     UT_hash_handle hh;
@@ -404,8 +727,12 @@ typedef struct igs_core_context {
     bool network_allow_inproc;
     int network_zyre_port;
     int network_hwm_value;
+    int network_priority_hwm_values[IGS_OUTPUT_PRIORITIES_NB]; //-1 to use network_hwm_value
+    igs_publication_queue_policy_t network_priority_policies[IGS_OUTPUT_PRIORITIES_NB];
+    igs_publication_queue_t *publication_queue; //NULL unless queued publication is enabled
     unsigned int network_discovery_interval;
     unsigned int network_agent_timeout;
+    unsigned int network_update_debounce; //in milliseconds
     unsigned int network_publishing_port;
     unsigned int network_log_stream_port;
     bool network_shall_raise_file_descriptors_limit;
@@ -450,20 +777,34 @@ typedef struct igs_core_context {
     char *command_line;
     char *replay_channel;
     igs_timer_t *timers; // set manually, destroyed automatically
+    igs_publication_flush_t *publication_flushes;
+    size_t chunked_values_nb; //values being reassembled from chunks
+    int chunked_values_timer_id; //expires these values, 0 if none
     int process_id;
     char *network_ipc_folder_path;
     char *network_ipc_full_path;
     char *network_ipc_endpoint;
     igs_zyre_peer_t *zyre_peers;
+    size_t legacy_publications_peers_nb; //peers needing uuid-name publications
+    size_t network_shared_memory_size; //0 if disabled
+    size_t network_shared_memory_threshold;
+    igs_shared_memory_t *shared_memory_publisher;
+    int64_t same_host_peers_nb; //possible readers of our shared memory
     igs_channels_wrapper_t *zyre_callbacks;
     igsagent_t *agents;
     zhash_t *created_agents;
+    uint16_t last_topic_key; //see network_intern_topic_key
     igs_remote_agent_t *remote_agents; // those our agents subscribed to
+    igs_shared_definition_t *shared_definitions; //definitions of remote agents by fingerprint
+    igs_route_emitter_t *routes; // updated with our mappings and definitions
+    uint64_t routes_generation; // incremented on each routes update
     igs_splitter_t *splitters;
     zactor_t *network_actor;
     zsock_t *internal_pipe;
+    bool network_updates_pending; //a flush of definition and mapping updates is scheduled
     zyre_t *node;
     zsock_t *publisher;
+    zsock_t *priority_publishers[IGS_OUTPUT_PRIORITIES_NB]; //TCP, normal class uses publisher
     zsock_t *ipc_publisher;
     zsock_t *inproc_publisher;
     zsock_t *logger;
@@ -484,6 +825,18 @@ void core_init_context(void);
 // definition
 INGESCAPE_EXPORT void definition_free_definition (igs_definition_t **definition);
 INGESCAPE_EXPORT void definition_free_constraint (igs_constraint_t **constraint);
+void definition_index_output (igs_definition_t *def, igs_iop_t *output); //keeps a valid id or assigns a new one
+igs_iop_t* definition_find_output_by_id (igs_definition_t *def, uint16_t id);
+// changes to the definition, to be called with the model lock held: they
+// invalidate cached exports and record deltas for peers
+void definition_touch (igsagent_t *agent); //change that deltas cannot describe
+void definition_touch_iop (igsagent_t *agent, igs_iop_type_t type, const char *name);
+void definition_touch_service (igsagent_t *agent, const char *name);
+void definition_free_changes (igs_delta_change_t **changes);
+// applies the iops and services of a fragment to a definition, replacing
+// existing ones, and frees the fragment
+void definition_merge (igs_definition_t *def, igs_definition_t **fragment);
+igs_result_t definition_remove_element (igs_definition_t *def, char kind, const char *name);
 
 // mapping
 INGESCAPE_EXPORT void mapping_free_mapping (igs_mapping_t **map);
@@ -494,6 +847,15 @@ INGESCAPE_EXPORT bool mapping_is_equal(const char *first_str, const char *second
 
 uint64_t s_djb2_hash (unsigned char *str);
 bool mapping_check_input_output_compatibility(igsagent_t *agent, igs_iop_t *found_input, igs_iop_t *found_output);
+void mapping_update_routes (igsagent_t *agent); //model lock must be held
+void mapping_remove_routes (igsagent_t *agent); //model lock must be held
+void mapping_touch (igsagent_t *agent); //change that deltas cannot describe
+void mapping_touch_element (igsagent_t *agent, uint64_t id);
+igs_result_t mapping_remove_element (igs_mapping_t *mapping, uint64_t id);
+// moves the elements of a fragment to a mapping, replacing existing ones,
+// and frees the fragment
+void mapping_merge (igs_mapping_t *mapping, igs_mapping_t **fragment);
+igs_route_t * mapping_find_route (const char *agent_name, const char *output); //model lock must be held
 
 // split
 void split_free_split_element (igs_split_t **split_elmt);
@@ -509,11 +871,72 @@ int split_message_from_splitter(zmsg_t *msg, igs_core_context_t *context);
 uint8_t* s_model_string_to_bytes (char* string);
 const igs_iop_t* model_write_iop (igsagent_t *agent, const char *iop_name, igs_iop_type_t type,
                                   igs_iop_value_type_t val_type, void* value, size_t size);
+//model lock (shared or exclusive) must be held and is released before returning
+//when buffer is set, it is shared by DATA iops instead of copying value
+//when publish is set, it tells if the new value of an output passes its publication filter
+const igs_iop_t* model_write_resolved_iop (igsagent_t *agent, igs_iop_t *iop, igs_iop_type_t type,
+                                           igs_iop_value_type_t val_type, void* value, size_t size,
+                                           igs_data_buffer_t *buffer, bool *publish);
+//model lock and agent write lock must be held and are kept, observe callbacks are not run,
+//returns -1 on error, 0 if the iop has not been written, 1 otherwise
+int model_write_iop_locked (igsagent_t *agent, igs_iop_t *iop, igs_iop_type_t type,
+                            igs_iop_value_type_t val_type, void* value, size_t size,
+                            igs_data_buffer_t *buffer, void **written_value, size_t *written_size);
+//the value of an output is published and becomes the reference of its
+//publication filter, agent write lock must be held
+void model_set_publication_reference (igs_iop_t *iop);
+//agent write lock must be held, same returns as model_write_iop_locked,
+//NULL when an array is written into a scalar iop : use model_write_iop_locked
+igs_iop_writer_fn* model_iop_writer (igs_iop_value_type_t val_type, igs_iop_value_type_t iop_val_type);
+//model_write_iop_locked with a writer chosen beforehand, constraints are checked
+int model_write_iop_with (igs_iop_writer_fn *writer, igsagent_t *agent, igs_iop_t *iop,
+                          igs_iop_type_t type, igs_iop_value_type_t val_type, void* value, size_t size,
+                          igs_data_buffer_t *buffer, void **written_value, size_t *written_size);
+void model_iop_value (igs_iop_t *iop, void **value, size_t *size);
+//model lock (shared or exclusive) must be held
+igs_iop_snapshot_t* model_iop_snapshot (igsagent_t *agent, igs_iop_t *iop);
+//agent write lock must be held
+void model_update_iop_snapshot (igs_iop_t *iop);
+//no lock needed, fails if the iop of the snapshot has been freed
+igs_result_t model_read_iop_snapshot (igs_iop_snapshot_t *snapshot, igs_iop_t *copy);
+igs_iop_snapshot_t* model_iop_snapshot_retain (igs_iop_snapshot_t *snapshot);
+void model_iop_snapshot_release (igs_iop_snapshot_t **snapshot);
+//model lock must be held
+void model_defer_observe_callbacks (igs_deferred_observe_t **list, igsagent_t *agent,
+                                    igs_iop_t *iop, int64_t timestamp);
+//model lock must not be held
+void model_run_deferred_observe_callbacks (igs_deferred_observe_t **list);
+igs_data_buffer_t* model_data_buffer_new (void *data, size_t size, igs_data_free_fn *free_fn);
+igs_data_buffer_t* model_data_buffer_from_frame (zframe_t **frame);
+igs_data_buffer_t* model_data_buffer_retain (igs_data_buffer_t *buffer);
+void model_data_buffer_release (igs_data_buffer_t **buffer);
+void model_release_iop_data (igs_iop_t *iop);
 igs_iop_t* model_find_iop_by_name(igsagent_t *agent, const char* name, igs_iop_type_t type);
 char* model_get_iop_value_as_string (igs_iop_t* iop); //caller owns returned value
+bool model_is_array_type (igs_iop_value_type_t type);
+size_t model_array_element_size (igs_iop_value_type_t type);
+void model_convert_array (igs_iop_value_type_t to_type, void *to,
+                          igs_iop_value_type_t from_type, const void *from, size_t count);
+char* model_array_to_string (igs_iop_value_type_t type, const void *values, size_t size); //caller owns returned value
+/* Model locks, always taken in this order:
+ 1- the global model lock, exclusive (model_read_write_lock) to modify
+ agents, definitions, mappings, routes and remote agents, or shared
+ (model_read_lock) to read or write iop values,
+ 2- the values lock of a single agent (model_agent_read/write_lock),
+ needed for iop values when the global lock is only shared,
+ 3- leaf mutexes (split queues, publisher sockets, zyre peers, logs).
+ The shared global lock cannot be upgraded. Agent locks are no-ops for a
+ thread holding the exclusive lock, which may thus use the same code
+ paths. Observe callbacks never run with any model lock held.*/
 #define IGS_MODEL_READ_WRITE_MUTEX_DEBUG 0
 INGESCAPE_EXPORT void model_read_write_lock(const char *function, int line);
 INGESCAPE_EXPORT void model_read_write_unlock(const char *function, int line);
+void model_read_lock (const char *function, int line);
+void model_read_unlock (const char *function, int line);
+void model_agent_read_lock (igsagent_t *agent);
+void model_agent_read_unlock (igsagent_t *agent);
+void model_agent_write_lock (igsagent_t *agent);
+void model_agent_write_unlock (igsagent_t *agent);
 igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
                                            const char *expression,char **error);
 
@@ -521,6 +944,22 @@ igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
 #define IGS_PRIVATE_CHANNEL "INGESCAPE_PRIVATE"
 #define IGS_DEFAULT_AGENT_NAME "no_name"
 igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop);
+//topic is the prebuilt uuid-name string or NULL to compose it
+igs_result_t network_publish_output_with_topic (igsagent_t *agent, const igs_iop_t *iop, const char *topic);
+//outputs list is consumed
+igs_result_t network_publish_output_batch (igsagent_t *agent, igs_batched_output_t **outputs);
+void network_start_publication_queue (igs_core_context_t *context);
+void network_stop_publication_queue (igs_core_context_t *context); //sends queued records
+void network_free_publication_queue (igs_publication_queue_t **queue);
+//compressed frame starting with the codec id, NULL if size is below threshold
+//or if compression does not reduce it
+zframe_t *network_compress_frame (igs_codec_t codec, size_t threshold, const void *data, size_t size);
+//compact topic key not used by any of our created agents, call with model lock
+uint16_t network_intern_topic_key (igs_core_context_t *context);
+//mark the definition or mapping of an agent as changed and schedule
+//their propagation to our peers, from any thread
+void network_schedule_definition_update (igsagent_t *agent);
+void network_schedule_mapping_update (igsagent_t *agent);
 
 // parser
 INGESCAPE_EXPORT igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json);
@@ -528,10 +967,15 @@ INGESCAPE_EXPORT igs_definition_t* parser_load_definition (const char* json_str)
 INGESCAPE_EXPORT igs_definition_t* parser_load_definition_from_path (const char* file_path);
 INGESCAPE_EXPORT char* parser_export_definition(igs_definition_t* def);
 INGESCAPE_EXPORT char* parser_export_definition_legacy(igs_definition_t* def);
+// typed arrays exported as DATA for peers older than protocol v5
+char *parser_export_definition_without_arrays (igs_definition_t *def);
 INGESCAPE_EXPORT char* parser_export_mapping(igs_mapping_t* mapping);
 INGESCAPE_EXPORT char* parser_export_mapping_legacy(igs_mapping_t* mapping);
 INGESCAPE_EXPORT igs_mapping_t* parser_load_mapping (const char* json_str);
 INGESCAPE_EXPORT igs_mapping_t* parser_load_mapping_from_path (const char* load_file);
+// definition and mapping made of the changed elements that still exist
+char *parser_export_definition_fragment (igs_definition_t *def, igs_delta_change_t *changes);
+char *parser_export_mapping_fragment (igs_mapping_t *mapping, igs_delta_change_t *changes);
 
 // admin
 void s_admin_make_file_path(const char *from, char *to, size_t size_of_to);
@@ -553,12 +997,57 @@ void service_log_received_service(igsagent_t *agent, const char *caller_agent_na
 // agent
 void s_agent_propagate_agent_event(igs_agent_event_t event, const char *uuid, const char *name, void *event_data);
 
+// compact publications (protocol v5) use a fixed size topic made of a
+// prefix, the topic key interned for the publishing agent by its peer and
+// the output id, both in hexadecimal, so that subscription filters match
+// exactly one output of one agent. Keys are announced with the agent
+// definition. Compact publications also use a header frame made of the
+// value type, flags, an optional timestamp and the value itself for scalar
+// types. Strings and data use an extra frame.
+#define IGS_COMPACT_PUBLICATIONS_PROTOCOL 5
+#define IGS_COMPACT_TOPIC_PREFIX '#' //never starts a uuid-name topic
+#define IGS_COMPACT_TOPIC_LENGTH 9
+#define IGS_COMPACT_HEADER_LENGTH 2
+#define IGS_COMPACT_FLAG_TIMESTAMP 0x01
+// delta encoded data outputs add a 32-bit sequence after the timestamp,
+// their value frame being a full keyframe or the changes since the
+// previous sequence
+#define IGS_COMPACT_FLAG_KEYFRAME 0x02
+#define IGS_COMPACT_FLAG_DELTA 0x04
+// compressed value frames start with the codec id and the uncompressed size
+#define IGS_COMPACT_FLAG_COMPRESSED 0x08
+// chunks of a streamed data value add a 32-bit stream id, the 64-bit offset
+// of the chunk and the 64-bit size of the value after the timestamp
+#define IGS_COMPACT_FLAG_CHUNK 0x10
+// data values sent on the ipc publisher may be replaced by a frame made of
+// their 64-bit position and size in the shared memory of the publisher
+#define IGS_COMPACT_FLAG_SHARED 0x20
+#define IGS_COMPACT_KNOWN_FLAGS (IGS_COMPACT_FLAG_TIMESTAMP | IGS_COMPACT_FLAG_KEYFRAME \
+                                 | IGS_COMPACT_FLAG_DELTA | IGS_COMPACT_FLAG_COMPRESSED \
+                                 | IGS_COMPACT_FLAG_CHUNK | IGS_COMPACT_FLAG_SHARED)
+// compact batches use output id 0 in their topic and carry entries made of
+// the 16-bit output id (big endian) followed by a compact header frame
+#define IGS_COMPACT_BATCH_ID 0
+
+// definition and mapping deltas (protocol v6) describe the elements changed
+// since a previous revision, see igs_network.c
+#define IGS_DEFINITION_DELTAS_PROTOCOL 6
+#define IGS_DELTA_INPUT 'i'
+#define IGS_DELTA_OUTPUT 'o'
+#define IGS_DELTA_PARAMETER 'p'
+#define IGS_DELTA_SERVICE 's'
+#define IGS_DELTA_MAPPING 'm'
+
 // protocol messages
 #define REMOTE_AGENT_EXIT_MSG "REMOTE_AGENT_EXIT"
 #define REMOTE_PEER_KNOWS_AGENT_MSG "REMOTE_PEER_KNOWS_AGENT"
 
 #define EXTERNAL_DEFINITION_MSG "EXTERNAL_DEFINITION#"
 #define EXTERNAL_MAPPING_MSG "EXTERNAL_MAPPING#"
+#define EXTERNAL_DEFINITION_DELTA_MSG "EXTERNAL_DEFINITION_DELTA#"
+#define EXTERNAL_MAPPING_DELTA_MSG "EXTERNAL_MAPPING_DELTA#"
+#define GET_DEFINITION_MSG "GET_DEFINITION"
+#define GET_MAPPING_MSG "GET_MAPPING"
 
 #define LOAD_DEFINITION_MSG "LOAD_THIS_DEFINITION#"
 #define LOAD_MAPPING_MSG "LOAD_THIS_MAPPING#"
@@ -569,6 +1058,7 @@ void s_agent_propagate_agent_event(igs_agent_event_t event, const char *uuid, co
 #define CURRENT_INPUTS_MSG "CURRENT_INPUTS"
 #define GET_CURRENT_PARAMETERS_MSG "GET_CURRENT_PARAMETERS"
 #define CURRENT_PARAMETERS_MSG "CURRENT_PARAMETERS"
+#define GET_OUTPUT_KEYFRAME_MSG "GET_OUTPUT_KEYFRAME"
 
 #define STATE_MSG "STATE"
 
@@ -597,6 +1087,8 @@ void s_agent_propagate_agent_event(igs_agent_event_t event, const char *uuid, co
 #define SET_PARAMETER_MSG "SET_PARAMETER"
 #define CALL_SERVICE_MSG "SERVICE"
 #define CALL_SERVICE_MSG_DEPRECATED "CALL" // DEPRECATED since ingescape 3.0 that uses protocol v4
+// service call followed by a frame giving the codec of each argument after the token
+#define CALL_SERVICE_COMPRESSED_MSG "SERVICE_COMPRESSED"
 
 
 #define MAP_MSG "MAP"
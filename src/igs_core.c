@@ -88,8 +88,13 @@ void core_init_context (void)
         core_context->network_allow_ipc = true;
         core_context->network_allow_inproc = true;
         core_context->network_hwm_value = 1000;
+        for (int i = 0; i < IGS_OUTPUT_PRIORITIES_NB; i++) {
+            core_context->network_priority_hwm_values[i] = -1;
+            core_context->network_priority_policies[i] = IGS_PUBLICATION_QUEUE_DROP_NEWEST;
+        }
         core_context->network_discovery_interval = 1000;
         core_context->network_agent_timeout = 8000;
+        core_context->network_update_debounce = 5;
         core_context->log_level = IGS_LOG_WARN;
         core_context->log_file_level = IGS_LOG_TRACE;
         core_context->log_file_max_line_length = IGS_MAX_LOG_LENGTH;
@@ -221,6 +226,7 @@ void igs_clear_context (void)
             }
             zhash_destroy (&core_context->elections);
         }
+        network_free_publication_queue (&core_context->publication_queue);
 
         free (core_context);
         core_context = NULL;
@@ -520,6 +526,114 @@ igs_result_t igs_output_set_data (const char *name, void *value, size_t size)
     return igsagent_output_set_data (core_agent, name, value, size);
 }
 
+igs_result_t igs_output_set_data_owned (const char *name, void *value, size_t size, igs_data_free_fn free_fn)
+{
+    core_init_agent ();
+    return igsagent_output_set_data_owned (core_agent, name, value, size, free_fn);
+}
+
+igs_output_handle_t *igs_output_handle_new (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_handle_new (core_agent, name);
+}
+
+void igs_output_handle_destroy (igs_output_handle_t **handle)
+{
+    igsagent_output_handle_destroy (handle);
+}
+
+igs_result_t igs_output_handle_set_bool (igs_output_handle_t *handle, bool value)
+{
+    return igsagent_output_handle_set_bool (handle, value);
+}
+
+igs_result_t igs_output_handle_set_int (igs_output_handle_t *handle, int value)
+{
+    return igsagent_output_handle_set_int (handle, value);
+}
+
+igs_result_t igs_output_handle_set_double (igs_output_handle_t *handle, double value)
+{
+    return igsagent_output_handle_set_double (handle, value);
+}
+
+igs_result_t igs_output_handle_set_string (igs_output_handle_t *handle, const char *value)
+{
+    return igsagent_output_handle_set_string (handle, value);
+}
+
+igs_result_t igs_output_handle_set_impulsion (igs_output_handle_t *handle)
+{
+    return igsagent_output_handle_set_impulsion (handle);
+}
+
+igs_result_t igs_output_handle_set_data (igs_output_handle_t *handle, void *value, size_t size)
+{
+    return igsagent_output_handle_set_data (handle, value, size);
+}
+
+igs_read_handle_t *igs_read_handle_new (const char *name, igs_iop_type_t type)
+{
+    core_init_agent ();
+    return igsagent_read_handle_new (core_agent, name, type);
+}
+
+void igs_read_handle_destroy (igs_read_handle_t **handle)
+{
+    igsagent_read_handle_destroy (handle);
+}
+
+bool igs_read_handle_bool (igs_read_handle_t *handle)
+{
+    return igsagent_read_handle_bool (handle);
+}
+
+int igs_read_handle_int (igs_read_handle_t *handle)
+{
+    return igsagent_read_handle_int (handle);
+}
+
+double igs_read_handle_double (igs_read_handle_t *handle)
+{
+    return igsagent_read_handle_double (handle);
+}
+
+igs_result_t igs_input_pin (const char *name, const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    core_init_agent ();
+    return igsagent_input_pin (core_agent, name, value, size, pin);
+}
+
+igs_result_t igs_output_pin (const char *name, const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    core_init_agent ();
+    return igsagent_output_pin (core_agent, name, value, size, pin);
+}
+
+igs_result_t igs_parameter_pin (const char *name, const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    core_init_agent ();
+    return igsagent_parameter_pin (core_agent, name, value, size, pin);
+}
+
+void igs_value_unpin (igs_value_pin_t **pin)
+{
+    igsagent_value_unpin (pin);
+}
+
+igs_result_t igs_output_batch_begin (void)
+{
+    core_init_agent ();
+    return igsagent_output_batch_begin (core_agent);
+}
+
+igs_result_t igs_output_batch_commit (void)
+{
+    core_init_agent ();
+    return igsagent_output_batch_commit (core_agent);
+}
+
 igs_result_t igs_parameter_set_bool (const char *name, bool value)
 {
     core_init_agent ();
@@ -550,6 +664,48 @@ igs_result_t igs_parameter_set_data (const char *name, void *value, size_t size)
     return igsagent_parameter_set_data (core_agent, name, value, size);
 }
 
+igs_result_t igs_input_array (const char *name, igs_iop_value_type_t array_type,
+                              void **values, size_t *count)
+{
+    core_init_agent ();
+    return igsagent_input_array (core_agent, name, array_type, values, count);
+}
+
+igs_result_t igs_output_array (const char *name, igs_iop_value_type_t array_type,
+                               void **values, size_t *count)
+{
+    core_init_agent ();
+    return igsagent_output_array (core_agent, name, array_type, values, count);
+}
+
+igs_result_t igs_parameter_array (const char *name, igs_iop_value_type_t array_type,
+                                  void **values, size_t *count)
+{
+    core_init_agent ();
+    return igsagent_parameter_array (core_agent, name, array_type, values, count);
+}
+
+igs_result_t igs_input_set_array (const char *name, igs_iop_value_type_t array_type,
+                                  const void *values, size_t count)
+{
+    core_init_agent ();
+    return igsagent_input_set_array (core_agent, name, array_type, values, count);
+}
+
+igs_result_t igs_output_set_array (const char *name, igs_iop_value_type_t array_type,
+                                   const void *values, size_t count)
+{
+    core_init_agent ();
+    return igsagent_output_set_array (core_agent, name, array_type, values, count);
+}
+
+igs_result_t igs_parameter_set_array (const char *name, igs_iop_value_type_t array_type,
+                                      const void *values, size_t count)
+{
+    core_init_agent ();
+    return igsagent_parameter_set_array (core_agent, name, array_type, values, count);
+}
+
 igs_result_t igs_input_add_constraint (const char *name, const char *constraint)
 {
     core_init_agent ();
@@ -696,6 +852,120 @@ bool igs_output_is_muted (const char *name)
     return igsagent_output_is_muted (core_agent, name);
 }
 
+igs_result_t igs_output_set_max_rate (const char *name, double rate)
+{
+    core_init_agent ();
+    return igsagent_output_set_max_rate (core_agent, name, rate);
+}
+
+igs_result_t igs_output_set_min_interval (const char *name, unsigned int interval)
+{
+    core_init_agent ();
+    return igsagent_output_set_min_interval (core_agent, name, interval);
+}
+
+double igs_output_max_rate (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_max_rate (core_agent, name);
+}
+
+igs_result_t igs_output_set_conflate (const char *name, bool conflate)
+{
+    core_init_agent ();
+    return igsagent_output_set_conflate (core_agent, name, conflate);
+}
+
+bool igs_output_is_conflated (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_is_conflated (core_agent, name);
+}
+
+void igs_output_publication_stats (const char *name, size_t *suppressed, size_t *flushed)
+{
+    core_init_agent ();
+    igsagent_output_publication_stats (core_agent, name, suppressed, flushed);
+}
+
+igs_result_t igs_output_set_publication_filter (const char *name, igs_publication_filter_t filter, double deadband)
+{
+    core_init_agent ();
+    return igsagent_output_set_publication_filter (core_agent, name, filter, deadband);
+}
+
+igs_publication_filter_t igs_output_publication_filter (const char *name, double *deadband)
+{
+    core_init_agent ();
+    return igsagent_output_publication_filter (core_agent, name, deadband);
+}
+
+igs_result_t igs_output_set_refresh_interval (const char *name, unsigned int interval)
+{
+    core_init_agent ();
+    return igsagent_output_set_refresh_interval (core_agent, name, interval);
+}
+
+size_t igs_output_filtered_publications (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_filtered_publications (core_agent, name);
+}
+
+igs_result_t igs_output_set_delta_encoding (const char *name, unsigned int keyframe_interval)
+{
+    core_init_agent ();
+    return igsagent_output_set_delta_encoding (core_agent, name, keyframe_interval);
+}
+
+unsigned int igs_output_delta_encoding (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_delta_encoding (core_agent, name);
+}
+
+void igs_output_delta_stats (const char *name, size_t *keyframes, size_t *deltas)
+{
+    core_init_agent ();
+    igsagent_output_delta_stats (core_agent, name, keyframes, deltas);
+}
+
+igs_result_t igs_output_set_codec (const char *name, igs_codec_t codec, size_t threshold)
+{
+    core_init_agent ();
+    return igsagent_output_set_codec (core_agent, name, codec, threshold);
+}
+
+igs_codec_t igs_output_codec (const char *name, size_t *threshold)
+{
+    core_init_agent ();
+    return igsagent_output_codec (core_agent, name, threshold);
+}
+
+igs_result_t igs_output_set_chunk_size (const char *name, size_t chunk_size)
+{
+    core_init_agent ();
+    return igsagent_output_set_chunk_size (core_agent, name, chunk_size);
+}
+
+size_t igs_output_chunk_size (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_chunk_size (core_agent, name);
+}
+
+igs_result_t igs_output_set_priority (const char *name, igs_output_priority_t priority)
+{
+    core_init_agent ();
+    return igsagent_output_set_priority (core_agent, name, priority);
+}
+
+igs_output_priority_t igs_output_priority (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_priority (core_agent, name);
+}
+
 igs_iop_value_type_t igs_input_type (const char *name)
 {
     core_init_agent ();
@@ -1188,6 +1458,18 @@ igs_result_t igs_service_reply_arg_remove(const char *service_name, const char *
     return igsagent_service_reply_arg_remove(core_agent, service_name, reply_name, arg_name);
 }
 
+igs_result_t igs_service_set_codec (const char *name, igs_codec_t codec, size_t threshold)
+{
+    core_init_agent ();
+    return igsagent_service_set_codec (core_agent, name, codec, threshold);
+}
+
+igs_codec_t igs_service_codec (const char *name, size_t *threshold)
+{
+    core_init_agent ();
+    return igsagent_service_codec (core_agent, name, threshold);
+}
+
 size_t igs_service_count (void)
 {
     core_init_agent ();
@@ -10,6 +10,7 @@
     =========================================================================
 */
 
+#include "ingescape_classes.h"
 #include "ingescape_private.h"
 #include "uthash/uthash.h"
 #include "uthash/utlist.h"
@@ -42,16 +43,19 @@ void s_definition_free_iop (igs_iop_t **iop)
 
     switch ((*iop)->value_type) {
         case IGS_STRING_T:
-            if ((*iop)->value.s)
-                free ((char *) (*iop)->value.s);
-            break;
         case IGS_DATA_T:
-            if ((*iop)->value.data)
-                free ((*iop)->value.data);
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            model_release_iop_data (*iop);
             break;
         default:
             break;
     }
+    if ((*iop)->delta_reference)
+        model_data_buffer_release (&(*iop)->delta_reference);
+    if ((*iop)->publication_reference_buffer)
+        model_data_buffer_release (&(*iop)->publication_reference_buffer);
     if ((*iop)->callbacks) {
         igs_observe_wrapper_t *cb, *tmp;
         DL_FOREACH_SAFE ((*iop)->callbacks, cb, tmp){
@@ -63,6 +67,11 @@ void s_definition_free_iop (igs_iop_t **iop)
         definition_free_constraint(&(*iop)->constraint);
     if ((*iop)->description)
         free((*iop)->description);
+    if ((*iop)->snapshot) {
+        // read handles still using the snapshot will resolve their iop again
+        IGS_ATOMIC_STORE (&(*iop)->snapshot->detached, 1);
+        model_iop_snapshot_release (&(*iop)->snapshot);
+    }
 
     free (*iop);
     *iop = NULL;
@@ -105,9 +114,14 @@ igs_result_t definition_add_iop_to_definition (igsagent_t *agent,
     switch (iop_type) {
         case IGS_INPUT_T:
             HASH_ADD_STR (def->inputs_table, name, iop);
+            if (def == agent->definition)
+                mapping_update_routes (agent);
             break;
         case IGS_OUTPUT_T:
             HASH_ADD_STR (def->outputs_table, name, iop);
+            definition_index_output (def, iop);
+            if (def == agent->definition)
+                agent->definition_generation++;
             break;
         case IGS_PARAMETER_T:
             HASH_ADD_STR (def->params_table, name, iop);
@@ -115,6 +129,10 @@ igs_result_t definition_add_iop_to_definition (igsagent_t *agent,
         default:
             break;
     }
+    if (def == agent->definition) {
+        definition_touch_iop (agent, iop_type, iop->name);
+        network_schedule_definition_update (agent);
+    }
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -129,7 +147,8 @@ igs_iop_t *definition_create_iop (igsagent_t *agent,
     assert (agent);
     assert (name);
     assert (agent->definition);
-    if (value_type < IGS_UNKNOWN_T || value_type > IGS_DATA_T){
+    if ((value_type < IGS_UNKNOWN_T || value_type > IGS_DATA_T)
+        && !model_is_array_type (value_type)){
         igsagent_error(agent, "invalid value type %d", value_type);
         return NULL;
     }
@@ -184,6 +203,175 @@ igs_iop_t *definition_create_iop (igsagent_t *agent,
 ////////////////////////////////////////////////////////////////////////
 // PRIVATE API
 ////////////////////////////////////////////////////////////////////////
+void definition_index_output (igs_definition_t *def, igs_iop_t *output)
+{
+    assert (def);
+    assert (output);
+    igs_iop_t *existing = NULL;
+    if (output->id) {
+        HASH_FIND (hh_id, def->outputs_by_id, &output->id, sizeof (uint16_t), existing);
+        if (existing == output)
+            return;
+    }
+    if (!output->id || existing) {
+        // find the next free id, 0 being reserved for outputs without id
+        output->id = 0;
+        uint16_t candidate = def->last_output_id;
+        size_t attempts = 0;
+        for (attempts = 0; attempts < UINT16_MAX; attempts++) {
+            candidate++;
+            if (candidate == 0)
+                candidate = 1;
+            HASH_FIND (hh_id, def->outputs_by_id, &candidate, sizeof (uint16_t), existing);
+            if (!existing) {
+                output->id = candidate;
+                break;
+            }
+        }
+        if (!output->id) {
+            igs_warn ("no id available for output %s : it will only be published by name", output->name);
+            return;
+        }
+    }
+    if (output->id > def->last_output_id)
+        def->last_output_id = output->id;
+    HASH_ADD (hh_id, def->outputs_by_id, id, sizeof (uint16_t), output);
+}
+
+igs_iop_t *definition_find_output_by_id (igs_definition_t *def, uint16_t id)
+{
+    assert (def);
+    igs_iop_t *found = NULL;
+    if (id)
+        HASH_FIND (hh_id, def->outputs_by_id, &id, sizeof (uint16_t), found);
+    return found;
+}
+
+void definition_free_changes (igs_delta_change_t **changes)
+{
+    assert (changes);
+    igs_delta_change_t *change, *tmp;
+    LL_FOREACH_SAFE (*changes, change, tmp){
+        LL_DELETE (*changes, change);
+        if (change->name)
+            free (change->name);
+        free (change);
+    }
+}
+
+void definition_touch (igsagent_t *agent)
+{
+    assert (agent);
+    // cached exports are compared against this revision when sent
+    agent->definition_revision++;
+    agent->definition_needs_full_update = true;
+    definition_free_changes (&agent->definition_changes);
+}
+
+void s_definition_touch_element (igsagent_t *agent, char kind, const char *name)
+{
+    assert (agent);
+    assert (name);
+    agent->definition_revision++;
+    if (agent->definition_needs_full_update)
+        return; // peers will receive our whole definition anyway
+    igs_delta_change_t *change = NULL;
+    LL_FOREACH (agent->definition_changes, change){
+        if (change->kind == kind && streq (change->name, name))
+            return;
+    }
+    change = (igs_delta_change_t *) zmalloc (sizeof (igs_delta_change_t));
+    change->kind = kind;
+    change->name = strdup (name);
+    LL_APPEND (agent->definition_changes, change);
+}
+
+void definition_touch_iop (igsagent_t *agent, igs_iop_type_t type, const char *name)
+{
+    if (type == IGS_INPUT_T)
+        s_definition_touch_element (agent, IGS_DELTA_INPUT, name);
+    else if (type == IGS_OUTPUT_T)
+        s_definition_touch_element (agent, IGS_DELTA_OUTPUT, name);
+    else if (type == IGS_PARAMETER_T)
+        s_definition_touch_element (agent, IGS_DELTA_PARAMETER, name);
+    else
+        definition_touch (agent);
+}
+
+void definition_touch_service (igsagent_t *agent, const char *name)
+{
+    s_definition_touch_element (agent, IGS_DELTA_SERVICE, name);
+}
+
+igs_result_t definition_remove_element (igs_definition_t *def, char kind, const char *name)
+{
+    assert (def);
+    assert (name);
+    igs_iop_t *iop = NULL;
+    if (kind == IGS_DELTA_SERVICE) {
+        igs_service_t *service = NULL;
+        HASH_FIND_STR (def->services_table, name, service);
+        if (!service)
+            return IGS_FAILURE;
+        HASH_DEL (def->services_table, service);
+        service_free_service (service);
+        return IGS_SUCCESS;
+    }
+    if (kind == IGS_DELTA_INPUT) {
+        HASH_FIND_STR (def->inputs_table, name, iop);
+        if (iop)
+            HASH_DEL (def->inputs_table, iop);
+    } else if (kind == IGS_DELTA_OUTPUT) {
+        HASH_FIND_STR (def->outputs_table, name, iop);
+        if (iop) {
+            HASH_DEL (def->outputs_table, iop);
+            if (iop->id)
+                HASH_DELETE (hh_id, def->outputs_by_id, iop);
+        }
+    } else if (kind == IGS_DELTA_PARAMETER) {
+        HASH_FIND_STR (def->params_table, name, iop);
+        if (iop)
+            HASH_DEL (def->params_table, iop);
+    }
+    if (!iop)
+        return IGS_FAILURE;
+    s_definition_free_iop (&iop);
+    return IGS_SUCCESS;
+}
+
+void definition_merge (igs_definition_t *def, igs_definition_t **fragment)
+{
+    assert (def);
+    assert (fragment);
+    assert (*fragment);
+    igs_iop_t *iop, *tmp_iop;
+    HASH_ITER (hh, (*fragment)->inputs_table, iop, tmp_iop){
+        HASH_DEL ((*fragment)->inputs_table, iop);
+        definition_remove_element (def, IGS_DELTA_INPUT, iop->name);
+        HASH_ADD_STR (def->inputs_table, name, iop);
+    }
+    HASH_ITER (hh, (*fragment)->outputs_table, iop, tmp_iop){
+        HASH_DEL ((*fragment)->outputs_table, iop);
+        if (iop->id)
+            HASH_DELETE (hh_id, (*fragment)->outputs_by_id, iop);
+        definition_remove_element (def, IGS_DELTA_OUTPUT, iop->name);
+        HASH_ADD_STR (def->outputs_table, name, iop);
+        definition_index_output (def, iop);
+    }
+    HASH_ITER (hh, (*fragment)->params_table, iop, tmp_iop){
+        HASH_DEL ((*fragment)->params_table, iop);
+        definition_remove_element (def, IGS_DELTA_PARAMETER, iop->name);
+        HASH_ADD_STR (def->params_table, name, iop);
+    }
+    igs_service_t *service, *tmp_service;
+    HASH_ITER (hh, (*fragment)->services_table, service, tmp_service){
+        HASH_DEL ((*fragment)->services_table, service);
+        definition_remove_element (def, IGS_DELTA_SERVICE, service->name);
+        HASH_ADD_STR (def->services_table, name, service);
+    }
+    definition_free_definition (fragment);
+}
+
 void definition_free_definition (igs_definition_t **def)
 {
     assert (def);
@@ -213,6 +401,7 @@ void definition_free_definition (igs_definition_t **def)
         HASH_DEL ((*def)->inputs_table, current_iop);
         s_definition_free_iop (&current_iop);
     }
+    HASH_CLEAR (hh_id, (*def)->outputs_by_id);
     HASH_ITER (hh, (*def)->outputs_table, current_iop, tmp_iop){
         HASH_DEL ((*def)->outputs_table, current_iop);
         s_definition_free_iop (&current_iop);
@@ -239,12 +428,16 @@ void igsagent_clear_definition (igsagent_t *agent)
         return;
     }
     char *previous_name = NULL;
+    uint16_t previous_output_id = 0;
     if (agent->definition) {
         if (agent->definition->name)
             previous_name = strdup (agent->definition->name);
+        previous_output_id = agent->definition->last_output_id;
         definition_free_definition (&agent->definition);
     }
     agent->definition = (igs_definition_t *) zmalloc (sizeof (igs_definition_t));
+    // do not reuse output ids that peers may still be subscribed to
+    agent->definition->last_output_id = previous_output_id;
     if (previous_name) {
         agent->definition->name = previous_name;
         igsagent_debug (agent, "Reuse previous name '%s'", previous_name);
@@ -252,7 +445,10 @@ void igsagent_clear_definition (igsagent_t *agent)
         agent->definition->name = strdup (IGS_DEFAULT_AGENT_NAME);
         // igsagent_debug(agent, "Use default name '%s'", IGS_DEFAULT_AGENT_NAME);
     }
-    agent->network_need_to_send_definition_update = true;
+    mapping_update_routes (agent);
+    agent->definition_generation++;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
@@ -296,10 +492,18 @@ void igsagent_set_family (igsagent_t *agent, const char *family)
     assert (agent);
     assert (agent->definition);
     assert (family);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return;
+    }
     if (agent->definition->family)
         free (agent->definition->family);
     agent->definition->family = s_strndup (family, IGS_MAX_FAMILY_LENGTH);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
 void igsagent_definition_set_description (igsagent_t *agent,
@@ -308,11 +512,19 @@ void igsagent_definition_set_description (igsagent_t *agent,
     assert (agent);
     assert (description);
     assert (agent->definition);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return;
+    }
     if (agent->definition->description)
         free (agent->definition->description);
     agent->definition->description =
       s_strndup (description, IGS_MAX_DESCRIPTION_LENGTH);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
 void igsagent_definition_set_version (igsagent_t *agent, const char *version)
@@ -320,10 +532,18 @@ void igsagent_definition_set_version (igsagent_t *agent, const char *version)
     assert (agent);
     assert (version);
     assert (agent->definition);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return;
+    }
     if (agent->definition->version)
         free (agent->definition->version);
     agent->definition->version = s_strndup (version, IGS_MAX_VERSION_LENGTH);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
 igs_result_t igsagent_input_create (igsagent_t *agent,
@@ -338,7 +558,6 @@ igs_result_t igsagent_input_create (igsagent_t *agent,
     igs_iop_t *iop = definition_create_iop (agent, name, IGS_INPUT_T, value_type, value, size);
     if (!iop)
         return IGS_FAILURE;
-    agent->network_need_to_send_definition_update = true;
     return IGS_SUCCESS;
 }
 
@@ -355,7 +574,6 @@ igs_result_t igsagent_output_create (igsagent_t *agent,
                                             value_type, value, size);
     if (!iop)
         return IGS_FAILURE;
-    agent->network_need_to_send_definition_update = true;
     return IGS_SUCCESS;
 }
 
@@ -372,7 +590,6 @@ igs_result_t igsagent_parameter_create (igsagent_t *agent,
                                             value_type, value, size);
     if (!iop)
         return IGS_FAILURE;
-    agent->network_need_to_send_definition_update = true;
     return IGS_SUCCESS;
 }
 
@@ -394,7 +611,9 @@ igs_result_t igsagent_input_remove (igsagent_t *agent, const char *name)
     }
     HASH_DEL (agent->definition->inputs_table, iop);
     s_definition_free_iop (&iop);
-    agent->network_need_to_send_definition_update = true;
+    mapping_update_routes (agent);
+    definition_touch_iop (agent, IGS_INPUT_T, name);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -416,8 +635,12 @@ igs_result_t igsagent_output_remove (igsagent_t *agent, const char *name)
         return IGS_SUCCESS;
     }
     HASH_DEL (agent->definition->outputs_table, iop);
+    if (iop->id)
+        HASH_DELETE (hh_id, agent->definition->outputs_by_id, iop);
     s_definition_free_iop (&iop);
-    agent->network_need_to_send_definition_update = true;
+    agent->definition_generation++;
+    definition_touch_iop (agent, IGS_OUTPUT_T, name);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -440,7 +663,8 @@ igs_result_t igsagent_parameter_remove (igsagent_t *agent, const char *name)
     }
     HASH_DEL (agent->definition->params_table, iop);
     s_definition_free_iop (&iop);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch_iop (agent, IGS_PARAMETER_T, name);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -500,3 +724,99 @@ void igsagent_definition_save (igsagent_t *agent)
     }
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
+
+////////////////////////////////////////////////////////////////////////
+// SELFTEST
+////////////////////////////////////////////////////////////////////////
+
+void
+igs_definition_test (bool verbose)
+{
+    IGS_UNUSED(verbose)
+    printf (" * igs_definition: ");
+
+    //  @selftest
+    igsagent_t *agent = igsagent_new ("selftest_definition", false);
+    assert (igsagent_output_create (agent, "my_int", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+    char *full_definition = parser_export_definition (agent->definition);
+    igs_definition_t *peer_definition = parser_load_definition (full_definition);
+    assert (peer_definition);
+    free (full_definition);
+
+    //  Definition deltas : a fragment holds the changed elements that still exist
+    assert (igsagent_input_create (agent, "delta_input", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+    assert (igsagent_input_add_constraint (agent, "delta_input", "[1, 10]") == IGS_SUCCESS);
+    igsagent_input_set_description (agent, "delta_input", "delta description");
+    igs_delta_change_t removed_change = {.kind = IGS_DELTA_OUTPUT, .name = (char *) "removed_output"};
+    igs_delta_change_t input_change = {.kind = IGS_DELTA_INPUT, .name = (char *) "delta_input",
+                                       .next = &removed_change};
+    char *fragment_str = parser_export_definition_fragment (agent->definition, &input_change);
+    assert (strstr (fragment_str, "[1, 10]") && !strstr (fragment_str, "removed_output"));
+    igs_definition_t *fragment = parser_load_definition (fragment_str);
+    assert (fragment && HASH_COUNT (fragment->inputs_table) == 1);
+    assert (fragment->outputs_table == NULL && fragment->params_table == NULL);
+
+    //  Merging a fragment adds or replaces its elements
+    definition_merge (peer_definition, &fragment);
+    assert (fragment == NULL);
+    igs_iop_t *merged_input = NULL;
+    HASH_FIND_STR (peer_definition->inputs_table, "delta_input", merged_input);
+    assert (merged_input && streq (merged_input->description, "delta description"));
+    assert (merged_input->constraint && merged_input->constraint->type == IGS_CONSTRAINT_RANGE);
+    assert (merged_input->constraint->range_int.min == 1 && merged_input->constraint->range_int.max == 10);
+    size_t peer_inputs_nb = HASH_COUNT (peer_definition->inputs_table);
+    fragment = parser_load_definition (fragment_str);
+    definition_merge (peer_definition, &fragment);
+    assert (HASH_COUNT (peer_definition->inputs_table) == peer_inputs_nb);
+
+    //  Removed elements are listed apart from the fragment
+    assert (definition_remove_element (peer_definition, IGS_DELTA_INPUT, "delta_input") == IGS_SUCCESS);
+    assert (definition_remove_element (peer_definition, IGS_DELTA_INPUT, "delta_input") == IGS_FAILURE);
+    assert (definition_remove_element (peer_definition, IGS_DELTA_OUTPUT, "removed_output") == IGS_FAILURE);
+    assert (definition_remove_element (peer_definition, IGS_DELTA_OUTPUT, "my_int") == IGS_SUCCESS);
+    HASH_FIND_STR (peer_definition->inputs_table, "delta_input", merged_input);
+    assert (merged_input == NULL && HASH_COUNT (peer_definition->inputs_table) == peer_inputs_nb - 1);
+    free (fragment_str);
+    definition_free_definition (&peer_definition);
+
+    //  Typed arrays are exported as numbers, or as DATA for peers older
+    //  than protocol v5, and arrays of other values are rejected
+    double array_values[] = {1.5, 2.5};
+    assert (igsagent_output_create (agent, "my_array", IGS_DOUBLE_ARRAY_T, NULL, 0) == IGS_SUCCESS);
+    assert (igsagent_output_set_array (agent, "my_array", IGS_DOUBLE_ARRAY_T, array_values, 2) == IGS_SUCCESS);
+    char *array_definition_str = parser_export_definition (agent->definition);
+    igs_definition_t *array_definition = parser_load_definition (array_definition_str);
+    igs_iop_t *array_output = NULL;
+    HASH_FIND_STR (array_definition->outputs_table, "my_array", array_output);
+    assert (array_output && array_output->value_type == IGS_DOUBLE_ARRAY_T);
+    assert (array_output->value_size == sizeof (array_values));
+    assert (memcmp (array_output->value.data, array_values, sizeof (array_values)) == 0);
+    free (array_definition_str);
+    definition_free_definition (&array_definition);
+    array_definition_str = parser_export_definition_without_arrays (agent->definition);
+    assert (!strstr (array_definition_str, "ARRAY"));
+    array_definition = parser_load_definition (array_definition_str);
+    HASH_FIND_STR (array_definition->outputs_table, "my_array", array_output);
+    assert (array_output && array_output->value_type == IGS_DATA_T);
+    assert (array_output->value_size == sizeof (array_values));
+    assert (memcmp (array_output->value.data, array_values, sizeof (array_values)) == 0);
+    free (array_definition_str);
+    definition_free_definition (&array_definition);
+    array_definition_str = parser_export_definition_legacy (agent->definition);
+    assert (!strstr (array_definition_str, "ARRAY"));
+    free (array_definition_str);
+    array_definition = parser_load_definition ("{\"definition\": {\"name\": \"arrays\", \"outputs\": ["
+                                               "{\"name\": \"numbers\", \"type\": \"INTEGER_ARRAY\", \"value\": [1, 2.5]},"
+                                               "{\"name\": \"mixed\", \"type\": \"DOUBLE_ARRAY\", \"value\": [1, \"2\"]}]}}");
+    assert (array_definition);
+    HASH_FIND_STR (array_definition->outputs_table, "numbers", array_output);
+    assert (array_output && array_output->value_size == 2 * sizeof (int));
+    assert (((int *) array_output->value.data)[0] == 1);
+    HASH_FIND_STR (array_definition->outputs_table, "mixed", array_output);
+    assert (array_output && array_output->value.data == NULL && array_output->value_size == 0);
+    definition_free_definition (&array_definition);
+
+    igsagent_destroy (&agent);
+    //  @end
+    printf ("OK\n");
+}
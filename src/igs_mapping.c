@@ -10,6 +10,7 @@
     =========================================================================
 */
 
+#include "ingescape_classes.h"
 #include "ingescape_private.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -167,21 +168,171 @@ bool mapping_check_input_output_compatibility (igsagent_t *agent,
                                                igs_iop_t *input,
                                                igs_iop_t *output)
 {
-    // for compatibility, only DATA outputs imply limitations
+    // for compatibility, only DATA and array outputs imply limitations
     // the rest is handled correctly in model_write_iop
     bool is_compatible = true;
     igs_iop_value_type_t type = input->value_type;
     if (output->value_type == IGS_DATA_T) {
-        if (type != IGS_DATA_T && type != IGS_IMPULSION_T) {
+        if (type != IGS_DATA_T && type != IGS_IMPULSION_T
+            && !model_is_array_type (type)) {
             is_compatible = false;
             igsagent_warn (
               agent,
-              "DATA outputs can only be mapped by DATA or IMPULSION inputs");
+              "DATA outputs can only be mapped by DATA, IMPULSION or array inputs");
+        }
+    }
+    else
+    if (model_is_array_type (output->value_type)) {
+        // arrays are converted element-wise into other arrays and kept
+        // as raw bytes by DATA inputs
+        if (type != IGS_DATA_T && type != IGS_IMPULSION_T
+            && !model_is_array_type (type)) {
+            is_compatible = false;
+            igsagent_warn (
+              agent,
+              "array outputs can only be mapped by array, DATA or IMPULSION inputs");
         }
     }
     return is_compatible;
 }
 
+igs_route_t *mapping_find_route (const char *agent_name, const char *output)
+{
+    assert (agent_name);
+    assert (output);
+    if (!core_context)
+        return NULL;
+    igs_route_emitter_t *emitter = NULL;
+    HASH_FIND_STR (core_context->routes, agent_name, emitter);
+    if (!emitter)
+        return NULL;
+    igs_route_t *route = NULL;
+    HASH_FIND_STR (emitter->routes, output, route);
+    return route;
+}
+
+void mapping_remove_routes (igsagent_t *agent)
+{
+    assert (agent);
+    if (!core_context)
+        return;
+    igs_route_emitter_t *emitter, *tmp_emitter;
+    HASH_ITER (hh, core_context->routes, emitter, tmp_emitter){
+        igs_route_t *route, *tmp_route;
+        HASH_ITER (hh, emitter->routes, route, tmp_route){
+            size_t i = 0, kept = 0;
+            for (i = 0; i < route->targets_nb; i++) {
+                if (route->targets[i].agent != agent)
+                    route->targets[kept++] = route->targets[i];
+            }
+            route->targets_nb = kept;
+            if (route->targets_nb == 0) {
+                HASH_DEL (emitter->routes, route);
+                free (route->output);
+                free (route->targets);
+                free (route);
+            }
+        }
+        if (!emitter->routes) {
+            HASH_DEL (core_context->routes, emitter);
+            free (emitter->agent_name);
+            free (emitter);
+        }
+    }
+    core_context->routes_generation++;
+}
+
+void mapping_touch (igsagent_t *agent)
+{
+    assert (agent);
+    agent->mapping_revision++;
+    agent->mapping_needs_full_update = true;
+    definition_free_changes (&agent->mapping_changes);
+}
+
+void mapping_touch_element (igsagent_t *agent, uint64_t id)
+{
+    assert (agent);
+    agent->mapping_revision++;
+    if (agent->mapping_needs_full_update)
+        return; // peers will receive our whole mapping anyway
+    igs_delta_change_t *change = NULL;
+    LL_FOREACH (agent->mapping_changes, change){
+        if (change->id == id)
+            return;
+    }
+    change = (igs_delta_change_t *) zmalloc (sizeof (igs_delta_change_t));
+    change->kind = IGS_DELTA_MAPPING;
+    change->id = id;
+    LL_APPEND (agent->mapping_changes, change);
+}
+
+igs_result_t mapping_remove_element (igs_mapping_t *mapping, uint64_t id)
+{
+    assert (mapping);
+    igs_map_t *elmt = NULL;
+    HASH_FIND (hh, mapping->map_elements, &id, sizeof (uint64_t), elmt);
+    if (!elmt)
+        return IGS_FAILURE;
+    HASH_DEL (mapping->map_elements, elmt);
+    s_mapping_free_mapping_element (&elmt);
+    return IGS_SUCCESS;
+}
+
+void mapping_merge (igs_mapping_t *mapping, igs_mapping_t **fragment)
+{
+    assert (mapping);
+    assert (fragment);
+    assert (*fragment);
+    igs_map_t *elmt, *tmp;
+    HASH_ITER (hh, (*fragment)->map_elements, elmt, tmp){
+        HASH_DEL ((*fragment)->map_elements, elmt);
+        mapping_remove_element (mapping, elmt->id);
+        HASH_ADD (hh, mapping->map_elements, id, sizeof (uint64_t), elmt);
+    }
+    mapping_free_mapping (fragment);
+}
+
+void mapping_update_routes (igsagent_t *agent)
+{
+    assert (agent);
+    if (!core_context)
+        return;
+    mapping_remove_routes (agent);
+    if (!agent->uuid || !agent->mapping || !agent->definition)
+        return;
+    igs_map_t *elmt, *tmp;
+    HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp){
+        igs_route_emitter_t *emitter = NULL;
+        HASH_FIND_STR (core_context->routes, elmt->to_agent, emitter);
+        if (!emitter) {
+            emitter = (igs_route_emitter_t *) zmalloc (sizeof (igs_route_emitter_t));
+            emitter->agent_name = strdup (elmt->to_agent);
+            HASH_ADD_STR (core_context->routes, agent_name, emitter);
+        }
+        igs_route_t *route = NULL;
+        HASH_FIND_STR (emitter->routes, elmt->to_output, route);
+        if (!route) {
+            route = (igs_route_t *) zmalloc (sizeof (igs_route_t));
+            route->output = strdup (elmt->to_output);
+            HASH_ADD_STR (emitter->routes, output, route);
+        }
+        route->targets = (igs_route_target_t *) realloc (route->targets,
+                                                         (route->targets_nb + 1) * sizeof (igs_route_target_t));
+        assert (route->targets);
+        igs_route_target_t *target = route->targets + route->targets_nb;
+        target->agent = agent;
+        target->map_elmt = elmt;
+        target->input = NULL;
+        HASH_FIND_STR (agent->definition->inputs_table, elmt->from_input, target->input);
+        for (int value_type = IGS_UNKNOWN_T; value_type < IGS_SCALAR_TYPES_NB; value_type++)
+            target->writers[value_type] = (target->input)
+                                            ? model_iop_writer (value_type, target->input->value_type)
+                                            : NULL;
+        route->targets_nb++;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////
 // PUBLIC API
 ////////////////////////////////////////////////////////////////////////
@@ -216,7 +367,9 @@ igs_result_t igsagent_mapping_load_str (igsagent_t *agent,
         if (agent->mapping)
             mapping_free_mapping (&agent->mapping);
         agent->mapping = tmp;
-        agent->network_need_to_send_mapping_update = true;
+        mapping_update_routes (agent);
+        mapping_touch (agent);
+        network_schedule_mapping_update (agent);
         model_read_write_unlock (__FUNCTION__, __LINE__);
     }
     return IGS_SUCCESS;
@@ -243,7 +396,9 @@ igs_result_t igsagent_mapping_load_file (igsagent_t *agent,
         mapping_free_mapping (&agent->mapping);
     agent->mapping_path = s_strndup (file_path, IGS_MAX_PATH_LENGTH - 1);
     agent->mapping = tmp;
-    agent->network_need_to_send_mapping_update = true;
+    mapping_update_routes (agent);
+    mapping_touch (agent);
+    network_schedule_mapping_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -263,7 +418,9 @@ void igsagent_clear_mappings (igsagent_t *agent)
         mapping_free_mapping (&agent->mapping);
     agent->mapping =
       (struct igs_mapping *) zmalloc (sizeof (struct igs_mapping));
-    agent->network_need_to_send_mapping_update = true;
+    mapping_update_routes (agent);
+    mapping_touch (agent);
+    network_schedule_mapping_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
@@ -282,10 +439,12 @@ void igsagent_clear_mappings_with_agent (igsagent_t *agent,
         {
             if (streq (elmt->to_agent, agent_name)) {
                 HASH_DEL (agent->mapping->map_elements, elmt);
+                mapping_touch_element (agent, elmt->id);
                 s_mapping_free_mapping_element (&elmt);
-                agent->network_need_to_send_mapping_update = true;
+                network_schedule_mapping_update (agent);
             }
         }
+        mapping_update_routes (agent);
         model_read_write_unlock (__FUNCTION__, __LINE__);
     }
 }
@@ -300,10 +459,12 @@ void igsagent_clear_mappings_for_input (igsagent_t *agent,
         {
             if (streq (elmt->from_input, input_name)) {
                 HASH_DEL (agent->mapping->map_elements, elmt);
+                mapping_touch_element (agent, elmt->id);
                 s_mapping_free_mapping_element (&elmt);
-                agent->network_need_to_send_mapping_update = true;
+                network_schedule_mapping_update (agent);
             }
         }
+        mapping_update_routes (agent);
         model_read_write_unlock (__FUNCTION__, __LINE__);
     }
 }
@@ -442,7 +603,9 @@ uint64_t igsagent_mapping_add (igsagent_t *agent,
         igs_map_t *new = mapping_create_mapping_element (reviewed_from_our_input, reviewed_to_agent, reviewed_with_output);
         new->id = hash;
         HASH_ADD (hh, agent->mapping->map_elements, id, sizeof (uint64_t), new);
-        agent->network_need_to_send_mapping_update = true;
+        mapping_update_routes (agent);
+        mapping_touch_element (agent, hash);
+        network_schedule_mapping_update (agent);
     } else
         igsagent_warn (agent,
                        "mapping combination %s->%s.%s already exists : will not be duplicated",
@@ -480,7 +643,9 @@ igs_result_t igsagent_mapping_remove_with_id (igsagent_t *agent,
     }
     HASH_DEL (agent->mapping->map_elements, el);
     s_mapping_free_mapping_element (&el);
-    agent->network_need_to_send_mapping_update = true;
+    mapping_update_routes (agent);
+    mapping_touch_element (agent, the_id);
+    network_schedule_mapping_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -529,7 +694,9 @@ igs_result_t igsagent_mapping_remove_with_name (igsagent_t *agent,
     }
     HASH_DEL (agent->mapping->map_elements, tmp);
     s_mapping_free_mapping_element (&tmp);
-    agent->network_need_to_send_mapping_update = true;
+    mapping_update_routes (agent);
+    mapping_touch_element (agent, h);
+    network_schedule_mapping_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -589,3 +756,51 @@ void igsagent_mapping_save (igsagent_t *agent)
     }
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
+
+////////////////////////////////////////////////////////////////////////
+// SELFTEST
+////////////////////////////////////////////////////////////////////////
+
+void
+igs_mapping_test (bool verbose)
+{
+    IGS_UNUSED(verbose)
+    printf (" * igs_mapping: ");
+
+    //  @selftest
+    igsagent_t *agent = igsagent_new ("selftest_mapping", false);
+    assert (igsagent_input_create (agent, "toto", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+
+    //  Mapping deltas : a fragment holds the changed elements that still exist
+    uint64_t map_id = igsagent_mapping_add (agent, "toto", "other_agent", "tata");
+    assert (map_id);
+    igs_delta_change_t removed_change = {.kind = IGS_DELTA_MAPPING, .id = 12345};
+    igs_delta_change_t map_change = {.kind = IGS_DELTA_MAPPING, .id = map_id, .next = &removed_change};
+    char *fragment_str = parser_export_mapping_fragment (agent->mapping, &map_change);
+    igs_mapping_t *fragment = parser_load_mapping (fragment_str);
+    assert (fragment && HASH_COUNT (fragment->map_elements) == 1);
+
+    //  Merging a fragment adds or replaces its elements
+    igs_mapping_t *peer_mapping = (igs_mapping_t *) zmalloc (sizeof (igs_mapping_t));
+    mapping_merge (peer_mapping, &fragment);
+    assert (fragment == NULL);
+    igs_map_t *merged_element = NULL;
+    HASH_FIND (hh, peer_mapping->map_elements, &map_id, sizeof (uint64_t), merged_element);
+    assert (merged_element && streq (merged_element->from_input, "toto"));
+    assert (streq (merged_element->to_agent, "other_agent") && streq (merged_element->to_output, "tata"));
+    fragment = parser_load_mapping (fragment_str);
+    mapping_merge (peer_mapping, &fragment);
+    assert (HASH_COUNT (peer_mapping->map_elements) == 1);
+
+    //  Removed elements are listed apart from the fragment
+    assert (mapping_remove_element (peer_mapping, 12345) == IGS_FAILURE);
+    assert (mapping_remove_element (peer_mapping, map_id) == IGS_SUCCESS);
+    assert (mapping_remove_element (peer_mapping, map_id) == IGS_FAILURE);
+    assert (peer_mapping->map_elements == NULL);
+    mapping_free_mapping (&peer_mapping);
+    free (fragment_str);
+
+    igsagent_destroy (&agent);
+    //  @end
+    printf ("OK\n");
+}
@@ -16,6 +16,11 @@
 #include <czmq.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#include <ctype.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #ifndef W_OK
 #define W_OK 02
@@ -57,9 +62,20 @@ uint8_t *s_model_string_to_bytes (char *string)
     return data;
 }
 
-igs_mutex_t s_model_read_write_mutex;
-static bool s_model_read_write_mutex_initialized = false;
+igs_rwlock_t s_model_read_write_lock;
+static bool s_model_read_write_lock_initialized = false;
 static int s_model_lock_counter = 0;
+// set for the thread holding the exclusive model lock
+static IGS_THREAD_LOCAL bool s_model_exclusive_owner = false;
+
+static void s_model_init_lock (void)
+{
+    if (!s_model_read_write_lock_initialized) {
+        IGS_RWLOCK_INIT (s_model_read_write_lock);
+        s_model_read_write_lock_initialized = true;
+    }
+}
+
 void model_read_write_lock (const char *function, int line)
 {
     if (IGS_MODEL_READ_WRITE_MUTEX_DEBUG){
@@ -67,11 +83,9 @@ void model_read_write_lock (const char *function, int line)
         if (s_model_lock_counter++)
             printf("---model_read_write_lock ACTIVE\n");
     }
-    if (!s_model_read_write_mutex_initialized) {
-        IGS_MUTEX_INIT (s_model_read_write_mutex);
-        s_model_read_write_mutex_initialized = true;
-    }
-    IGS_MUTEX_LOCK (s_model_read_write_mutex);
+    s_model_init_lock ();
+    IGS_RWLOCK_WRITE_LOCK (s_model_read_write_lock);
+    s_model_exclusive_owner = true;
 }
 
 void model_read_write_unlock (const char *function, int line)
@@ -80,8 +94,351 @@ void model_read_write_unlock (const char *function, int line)
         printf("-model_read_write_unlock from %s (line %d)\n", function, line);
         s_model_lock_counter--;
     }
-    assert (s_model_read_write_mutex_initialized);
-    IGS_MUTEX_UNLOCK (s_model_read_write_mutex);
+    assert (s_model_read_write_lock_initialized);
+    assert (s_model_exclusive_owner);
+    s_model_exclusive_owner = false;
+    IGS_RWLOCK_WRITE_UNLOCK (s_model_read_write_lock);
+}
+
+void model_read_lock (const char *function, int line)
+{
+    if (IGS_MODEL_READ_WRITE_MUTEX_DEBUG)
+        printf("---model_read_lock from %s (line %d)\n", function, line);
+    if (s_model_exclusive_owner)
+        return;
+    s_model_init_lock ();
+    IGS_RWLOCK_READ_LOCK (s_model_read_write_lock);
+}
+
+void model_read_unlock (const char *function, int line)
+{
+    if (IGS_MODEL_READ_WRITE_MUTEX_DEBUG)
+        printf("-model_read_unlock from %s (line %d)\n", function, line);
+    if (s_model_exclusive_owner)
+        return;
+    assert (s_model_read_write_lock_initialized);
+    IGS_RWLOCK_READ_UNLOCK (s_model_read_write_lock);
+}
+
+void model_agent_read_lock (igsagent_t *agent)
+{
+    if (!s_model_exclusive_owner)
+        IGS_RWLOCK_READ_LOCK (agent->values_lock);
+}
+
+void model_agent_read_unlock (igsagent_t *agent)
+{
+    if (!s_model_exclusive_owner)
+        IGS_RWLOCK_READ_UNLOCK (agent->values_lock);
+}
+
+void model_agent_write_lock (igsagent_t *agent)
+{
+    if (!s_model_exclusive_owner)
+        IGS_RWLOCK_WRITE_LOCK (agent->values_lock);
+}
+
+void model_agent_write_unlock (igsagent_t *agent)
+{
+    if (!s_model_exclusive_owner)
+        IGS_RWLOCK_WRITE_UNLOCK (agent->values_lock);
+}
+
+/*
+ Typed arrays hold contiguous native elements. Conversions between their
+ element types are vectorized with SSE2 when available, 4 elements at a
+ time, the remaining elements being converted one by one. Like the scalar
+ casts, conversions to int truncate their values.
+ */
+bool model_is_array_type (igs_iop_value_type_t type)
+{
+    return type == IGS_INTEGER_ARRAY_T || type == IGS_FLOAT_ARRAY_T
+           || type == IGS_DOUBLE_ARRAY_T;
+}
+
+size_t model_array_element_size (igs_iop_value_type_t type)
+{
+    switch (type) {
+        case IGS_INTEGER_ARRAY_T:
+            return sizeof (int);
+        case IGS_FLOAT_ARRAY_T:
+            return sizeof (float);
+        case IGS_DOUBLE_ARRAY_T:
+            return sizeof (double);
+        default:
+            return 0;
+    }
+}
+
+static void s_model_float_to_double (double *to, const float *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128 values = _mm_loadu_ps (from + i);
+        _mm_storeu_pd (to + i, _mm_cvtps_pd (values));
+        _mm_storeu_pd (to + i + 2, _mm_cvtps_pd (_mm_movehl_ps (values, values)));
+    }
+#endif
+    for (; i < count; i++)
+        to[i] = (double) from[i];
+}
+
+static void s_model_double_to_float (float *to, const double *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128 low = _mm_cvtpd_ps (_mm_loadu_pd (from + i));
+        __m128 high = _mm_cvtpd_ps (_mm_loadu_pd (from + i + 2));
+        _mm_storeu_ps (to + i, _mm_movelh_ps (low, high));
+    }
+#endif
+    for (; i < count; i++)
+        to[i] = (float) from[i];
+}
+
+static void s_model_int_to_double (double *to, const int *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128 ((const __m128i *) (from + i));
+        _mm_storeu_pd (to + i, _mm_cvtepi32_pd (values));
+        _mm_storeu_pd (to + i + 2, _mm_cvtepi32_pd (_mm_srli_si128 (values, 8)));
+    }
+#endif
+    for (; i < count; i++)
+        to[i] = (double) from[i];
+}
+
+static void s_model_double_to_int (int *to, const double *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        __m128i low = _mm_cvttpd_epi32 (_mm_loadu_pd (from + i));
+        __m128i high = _mm_cvttpd_epi32 (_mm_loadu_pd (from + i + 2));
+        _mm_storeu_si128 ((__m128i *) (to + i), _mm_unpacklo_epi64 (low, high));
+    }
+#endif
+    for (; i < count; i++)
+        to[i] = (int) from[i];
+}
+
+static void s_model_int_to_float (float *to, const int *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps (to + i, _mm_cvtepi32_ps (_mm_loadu_si128 ((const __m128i *) (from + i))));
+#endif
+    for (; i < count; i++)
+        to[i] = (float) from[i];
+}
+
+static void s_model_float_to_int (int *to, const float *from, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128 ((__m128i *) (to + i), _mm_cvttps_epi32 (_mm_loadu_ps (from + i)));
+#endif
+    for (; i < count; i++)
+        to[i] = (int) from[i];
+}
+
+// converts count elements between two array types, to and from shall not overlap
+void model_convert_array (igs_iop_value_type_t to_type, void *to,
+                          igs_iop_value_type_t from_type, const void *from, size_t count)
+{
+    assert (model_is_array_type (to_type));
+    assert (model_is_array_type (from_type));
+    if (!count)
+        return;
+    if (to_type == from_type) {
+        memcpy (to, from, count * model_array_element_size (to_type));
+        return;
+    }
+    switch (to_type) {
+        case IGS_INTEGER_ARRAY_T:
+            if (from_type == IGS_FLOAT_ARRAY_T)
+                s_model_float_to_int ((int *) to, (const float *) from, count);
+            else
+                s_model_double_to_int ((int *) to, (const double *) from, count);
+            break;
+        case IGS_FLOAT_ARRAY_T:
+            if (from_type == IGS_INTEGER_ARRAY_T)
+                s_model_int_to_float ((float *) to, (const int *) from, count);
+            else
+                s_model_double_to_float ((float *) to, (const double *) from, count);
+            break;
+        case IGS_DOUBLE_ARRAY_T:
+            if (from_type == IGS_INTEGER_ARRAY_T)
+                s_model_int_to_double ((double *) to, (const int *) from, count);
+            else
+                s_model_float_to_double ((double *) to, (const float *) from, count);
+            break;
+        default:
+            break;
+    }
+}
+
+// text of an array as [1, 2, 3], which can be written back into arrays
+char *model_array_to_string (igs_iop_value_type_t type, const void *values, size_t size)
+{
+    size_t element_size = model_array_element_size (type);
+    size_t count = (values && element_size) ? size / element_size : 0;
+    // each element takes at most 24 characters and its separator
+    size_t length = 3 + count * 26;
+    char *str = (char *) zmalloc (length);
+    size_t offset = 0;
+    str[offset++] = '[';
+    for (size_t i = 0; i < count; i++) {
+        const char *separator = (i) ? ", " : "";
+        switch (type) {
+            case IGS_INTEGER_ARRAY_T:
+                offset += snprintf (str + offset, length - offset, "%s%d",
+                                    separator, ((const int *) values)[i]);
+                break;
+            case IGS_FLOAT_ARRAY_T:
+                offset += snprintf (str + offset, length - offset, "%s%.9g",
+                                    separator, (double) ((const float *) values)[i]);
+                break;
+            default:
+                offset += snprintf (str + offset, length - offset, "%s%.17g",
+                                    separator, ((const double *) values)[i]);
+                break;
+        }
+    }
+    str[offset] = ']';
+    return str;
+}
+
+// parses numbers separated by commas or spaces, optionally between
+// brackets, returns their count or -1 if str is not such a list
+static long s_model_parse_array_string (const char *str, double **values)
+{
+    *values = NULL;
+    const char *position = str;
+    while (isspace ((unsigned char) *position))
+        position++;
+    bool brackets = (*position == '[');
+    if (brackets)
+        position++;
+    size_t capacity = 0;
+    long count = 0;
+    while (true) {
+        while (isspace ((unsigned char) *position) || *position == ',')
+            position++;
+        if (*position == '\0' || (brackets && *position == ']'))
+            break;
+        char *end = NULL;
+        double value = strtod (position, &end);
+        if (end == position) {
+            free (*values);
+            *values = NULL;
+            return -1;
+        }
+        if ((size_t) count == capacity) {
+            capacity = (capacity) ? 2 * capacity : 16;
+            *values = (double *) realloc (*values, capacity * sizeof (double));
+        }
+        (*values)[count++] = value;
+        position = end;
+    }
+    if (brackets && *position != ']') {
+        free (*values);
+        *values = NULL;
+        return -1;
+    }
+    return count;
+}
+
+// writes a value of any type into an array iop, scalars becoming single
+// elements, agent write lock must be held
+static int s_model_write_array_locked (igsagent_t *agent, igs_iop_t *iop,
+                                       igs_iop_value_type_t value_type,
+                                       void *value, size_t size,
+                                       igs_data_buffer_t *buffer,
+                                       void **out_value, size_t *out_size)
+{
+    size_t element_size = model_array_element_size (iop->value_type);
+    igs_data_buffer_t *shared = NULL;
+    void *converted = NULL;
+    size_t count = 0;
+    switch (value_type) {
+        case IGS_INTEGER_T:
+        case IGS_BOOL_T: {
+            int element = 0;
+            if (value)
+                element = (value_type == IGS_BOOL_T) ? *(bool *) value : *(int *) value;
+            count = 1;
+            converted = zmalloc (element_size);
+            model_convert_array (iop->value_type, converted, IGS_INTEGER_ARRAY_T, &element, 1);
+        } break;
+        case IGS_DOUBLE_T: {
+            double element = (value) ? *(double *) value : 0;
+            count = 1;
+            converted = zmalloc (element_size);
+            model_convert_array (iop->value_type, converted, IGS_DOUBLE_ARRAY_T, &element, 1);
+        } break;
+        case IGS_STRING_T: {
+            double *parsed = NULL;
+            long parsed_nb = (value) ? s_model_parse_array_string ((char *) value, &parsed) : 0;
+            if (parsed_nb < 0) {
+                igsagent_error (agent, "string %s is not a valid list of numbers for %s",
+                                (char *) value, iop->name);
+                return -1;
+            }
+            count = (size_t) parsed_nb;
+            if (count) {
+                converted = malloc (count * element_size);
+                model_convert_array (iop->value_type, converted, IGS_DOUBLE_ARRAY_T, parsed, count);
+            }
+            free (parsed);
+        } break;
+        case IGS_IMPULSION_T:
+            // impulsions empty the array
+            break;
+        case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T: {
+            // raw data is made of elements of our own type
+            igs_iop_value_type_t source_type = (value_type == IGS_DATA_T) ? iop->value_type : value_type;
+            size_t source_element_size = model_array_element_size (source_type);
+            if (!value)
+                size = 0;
+            if (size % source_element_size) {
+                igsagent_error (agent, "%zu bytes are not a whole number of elements for array %s",
+                                size, iop->name);
+                return -1;
+            }
+            count = size / source_element_size;
+            if (!count)
+                break;
+            if (source_type == iop->value_type && buffer)
+                shared = buffer;
+            else {
+                converted = malloc (count * element_size);
+                model_convert_array (iop->value_type, converted, source_type, value, count);
+            }
+        } break;
+        default:
+            igsagent_error (agent, "%s has an invalid value type %d", iop->name, value_type);
+            return 0;
+    }
+    model_release_iop_data (iop);
+    if (shared)
+        iop->data_buffer = model_data_buffer_retain (shared);
+    else
+    if (converted)
+        iop->data_buffer = model_data_buffer_new (converted, count * element_size, NULL);
+    iop->value.data = (iop->data_buffer) ? iop->data_buffer->data : NULL;
+    *out_size = iop->value_size = count * element_size;
+    *out_value = iop->value.data;
+    return 1;
 }
 
 char *model_get_iop_value_as_string (igs_iop_t *iop)
@@ -121,6 +478,12 @@ char *model_get_iop_value_as_string (igs_iop_t *iop)
                 snprintf (str_value, iop->value_size + 1, "%s",
                           (char *) iop->value.data);
                 break;
+            case IGS_INTEGER_ARRAY_T:
+            case IGS_FLOAT_ARRAY_T:
+            case IGS_DOUBLE_ARRAY_T:
+                str_value = model_array_to_string (iop->value_type, iop->value.data,
+                                                   iop->value_size);
+                break;
             default:
                 break;
         }
@@ -130,6 +493,153 @@ char *model_get_iop_value_as_string (igs_iop_t *iop)
 
 #define MAX_IOP_VALUE_LOG_BUFFER_LENGTH 256
 
+igs_data_buffer_t *model_data_buffer_new (void *data, size_t size, igs_data_free_fn *free_fn)
+{
+    igs_data_buffer_t *buffer = (igs_data_buffer_t *) zmalloc (sizeof (igs_data_buffer_t));
+    buffer->data = data;
+    buffer->size = size;
+    buffer->free_fn = free_fn;
+    buffer->refcount = zmq_atomic_counter_new ();
+    zmq_atomic_counter_set (buffer->refcount, 1);
+    return buffer;
+}
+
+igs_data_buffer_t *model_data_buffer_from_frame (zframe_t **frame)
+{
+    assert (frame);
+    assert (*frame);
+    igs_data_buffer_t *buffer = model_data_buffer_new (zframe_data (*frame), zframe_size (*frame), NULL);
+    buffer->frame = *frame;
+    *frame = NULL;
+    return buffer;
+}
+
+igs_data_buffer_t *model_data_buffer_retain (igs_data_buffer_t *buffer)
+{
+    assert (buffer);
+    zmq_atomic_counter_inc (buffer->refcount);
+    return buffer;
+}
+
+void model_data_buffer_release (igs_data_buffer_t **buffer)
+{
+    assert (buffer);
+    if (*buffer == NULL)
+        return;
+    if (zmq_atomic_counter_dec ((*buffer)->refcount) == 0) {
+        if ((*buffer)->frame)
+            zframe_destroy (&(*buffer)->frame);
+        else if ((*buffer)->free_fn)
+            (*buffer)->free_fn ((*buffer)->data);
+        else
+            free ((*buffer)->data);
+        zmq_atomic_counter_destroy (&(*buffer)->refcount);
+        free (*buffer);
+    }
+    *buffer = NULL;
+}
+
+static void s_model_fill_iop_snapshot (igs_iop_snapshot_t *snapshot, igs_iop_t *iop)
+{
+    snapshot->value_type = iop->value_type;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            snapshot->value.i = iop->value.i;
+            break;
+        case IGS_DOUBLE_T:
+            snapshot->value.d = iop->value.d;
+            break;
+        case IGS_BOOL_T:
+            snapshot->value.b = iop->value.b;
+            break;
+        default:
+            break;
+    }
+}
+
+igs_iop_snapshot_t *model_iop_snapshot (igsagent_t *agent, igs_iop_t *iop)
+{
+    assert (agent);
+    assert (iop);
+    igs_iop_snapshot_t *snapshot = IGS_ATOMIC_LOAD_PTR (&iop->snapshot);
+    if (snapshot)
+        return snapshot;
+    model_agent_write_lock (agent);
+    snapshot = iop->snapshot;
+    if (!snapshot) {
+        snapshot = (igs_iop_snapshot_t *) zmalloc (sizeof (igs_iop_snapshot_t));
+        snapshot->refcount = zmq_atomic_counter_new ();
+        zmq_atomic_counter_set (snapshot->refcount, 1);
+        s_model_fill_iop_snapshot (snapshot, iop);
+        IGS_ATOMIC_STORE_PTR (&iop->snapshot, snapshot);
+    }
+    model_agent_write_unlock (agent);
+    return snapshot;
+}
+
+void model_update_iop_snapshot (igs_iop_t *iop)
+{
+    assert (iop);
+    igs_iop_snapshot_t *snapshot = iop->snapshot;
+    if (!snapshot)
+        return;
+    // only one writer at a time thanks to the agent write lock
+    int32_t sequence = snapshot->sequence;
+    IGS_ATOMIC_STORE (&snapshot->sequence, sequence + 1);
+    IGS_ATOMIC_FENCE ();
+    s_model_fill_iop_snapshot (snapshot, iop);
+    IGS_ATOMIC_STORE (&snapshot->sequence, sequence + 2);
+}
+
+igs_result_t model_read_iop_snapshot (igs_iop_snapshot_t *snapshot, igs_iop_t *copy)
+{
+    assert (snapshot);
+    assert (copy);
+    int32_t before = 0;
+    int32_t after = 0;
+    do {
+        before = IGS_ATOMIC_LOAD (&snapshot->sequence);
+        if (before & 1)
+            continue; // being written
+        copy->value_type = snapshot->value_type;
+        memcpy (&copy->value, &snapshot->value, sizeof (snapshot->value));
+        IGS_ATOMIC_FENCE ();
+        after = IGS_ATOMIC_LOAD (&snapshot->sequence);
+    } while ((before & 1) || before != after);
+    if (IGS_ATOMIC_LOAD (&snapshot->detached))
+        return IGS_FAILURE;
+    return IGS_SUCCESS;
+}
+
+igs_iop_snapshot_t *model_iop_snapshot_retain (igs_iop_snapshot_t *snapshot)
+{
+    assert (snapshot);
+    zmq_atomic_counter_inc (snapshot->refcount);
+    return snapshot;
+}
+
+void model_iop_snapshot_release (igs_iop_snapshot_t **snapshot)
+{
+    assert (snapshot);
+    if (*snapshot == NULL)
+        return;
+    if (zmq_atomic_counter_dec ((*snapshot)->refcount) == 0) {
+        zmq_atomic_counter_destroy (&(*snapshot)->refcount);
+        free (*snapshot);
+    }
+    *snapshot = NULL;
+}
+
+void model_release_iop_data (igs_iop_t *iop)
+{
+    assert (iop);
+    if (iop->data_buffer)
+        model_data_buffer_release (&iop->data_buffer);
+    else if (iop->value.data)
+        free (iop->value.data);
+    iop->value.data = NULL;
+}
+
 void s_model_run_observe_callbacks_for_iop (igsagent_t *agent,
                                             igs_iop_t *iop,
                                             void *value,
@@ -149,558 +659,1045 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
 {
     assert (agent);
     assert (name);
-    model_read_write_lock (__FUNCTION__, __LINE__);
+    model_read_lock (__FUNCTION__, __LINE__);
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
     if (!iop) {
         igsagent_error (agent, "%s not found for writing", name);
-        model_read_write_unlock (__FUNCTION__, __LINE__);
+        model_read_unlock (__FUNCTION__, __LINE__);
         return NULL;
     }
-    int ret = 1;
-    void *out_value = NULL;
-    size_t out_size = 0;
+    return model_write_resolved_iop (agent, iop, type, value_type, value, size, NULL, NULL);
+}
+
+// checks the constraint of an iop against a value of any scalar type
+static bool s_model_value_satisfies_constraint (igsagent_t *agent, igs_iop_t *iop,
+                                                igs_iop_value_type_t value_type,
+                                                void *value)
+{
     char buf[NUMBER_TO_STRING_MAX_LENGTH + 1] = "";
-    // check that this agent has not been destroyed when we were locked
-    if (!agent || !(agent->uuid)) {
-        model_read_write_unlock (__FUNCTION__, __LINE__);
-        return NULL;
+    if (iop->value_type == IGS_INTEGER_T){
+        int converted_value = 0;
+        switch (value_type) {
+            case IGS_STRING_T:
+                converted_value = atoi((char *)value);
+                break;
+            case IGS_DATA_T:
+                igsagent_error(agent, "constraint type error for %s (value is data and IOP is integer)", iop->name);
+                return false;
+            case IGS_DOUBLE_T:
+                converted_value = (int)(*(double*)value);
+                break;
+            default:
+                converted_value = *(int*)value;
+                break;
+        }
+        
+        switch (iop->constraint->type) {
+            case IGS_CONSTRAINT_MIN:
+                if (converted_value < iop->constraint->min_int.min){
+                    igsagent_error(agent, "constraint error for %s (too low)", iop->name);
+                    return false;
+                }
+                break;
+            case IGS_CONSTRAINT_MAX:
+                if (converted_value > iop->constraint->max_int.max){
+                    igsagent_error(agent, "constraint error for %s (too high)", iop->name);
+                    return false;
+                }
+                break;
+            case IGS_CONSTRAINT_RANGE:
+                if (converted_value > iop->constraint->range_int.max){
+                    igsagent_error(agent, "constraint error for %s (too high)", iop->name);
+                    return false;
+                }else if (converted_value < iop->constraint->range_int.min){
+                    igsagent_error(agent, "constraint error for %s (too low)", iop->name);
+                    return false;
+                }
+                break;
+                
+            default:
+                break;
+        }
+    }else if(iop->value_type == IGS_DOUBLE_T){
+        double converted_value = 0;
+        switch (value_type) {
+            case IGS_STRING_T:
+                converted_value = atof((char *)value);
+                break;
+            case IGS_DATA_T:
+                igsagent_error(agent, "constraint type error for %s (value is data and IOP is double)", iop->name);
+                return false;
+            case IGS_INTEGER_T:
+            case IGS_BOOL_T:
+                converted_value = (double)(*(int*)value);
+                break;
+            default:
+                converted_value = *(double*)value;
+                break;
+        }
+        
+        switch (iop->constraint->type) {
+            case IGS_CONSTRAINT_MIN:
+                if (converted_value < iop->constraint->min_double.min){
+                    igsagent_error(agent, "constraint error for %s (too low)", iop->name);
+                    return false;
+                }
+                break;
+            case IGS_CONSTRAINT_MAX:
+                if (converted_value > iop->constraint->max_double.max){
+                    igsagent_error(agent, "constraint error for %s (too high)", iop->name);
+                    return false;
+                }
+                break;
+            case IGS_CONSTRAINT_RANGE:
+                if (converted_value > iop->constraint->range_double.max){
+                    igsagent_error(agent, "constraint error for %s (too high)", iop->name);
+                    return false;
+                }else if (converted_value < iop->constraint->range_double.min){
+                    igsagent_error(agent, "constraint error for %s (too low)", iop->name);
+                    return false;
+                }
+                break;
+                
+            default:
+                break;
+        }
+    }else if (iop->value_type == IGS_STRING_T){
+        char *converted_value = NULL;
+        switch (value_type) {
+            case IGS_STRING_T:
+                converted_value = (char *)value;
+                break;
+            case IGS_DATA_T:
+                igsagent_error(agent, "constraint type error for %s (value is data and IOP is string)", iop->name);
+                return false;
+            case IGS_INTEGER_T:
+            case IGS_BOOL_T:
+                snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
+                          (value == NULL) ? 0 : *(int *) (value));
+                converted_value = buf;
+                break;
+            case IGS_DOUBLE_T:
+                snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%f",
+                          (value == NULL) ? 0 : *(double *) (value));
+                converted_value = buf;
+                break;
+            default:
+                snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "");
+                converted_value = buf;
+                break;
+        }
+        if (!converted_value){
+            igsagent_error(agent, "constraint error for %s (value is NULL)", iop->name);
+            return false;
+        }
+        if (!zrex_matches(iop->constraint->regexp.rex, converted_value)){
+            igsagent_error(agent, "constraint error for %s (not matching regexp)", iop->name);
+            return false;
+        }
     }
-    
-    //apply constraint if any
-    if (iop->constraint && agent->enforce_constraints){
-        if (iop->value_type == IGS_INTEGER_T){
-            int converted_value = 0;
-            switch (value_type) {
-                case IGS_STRING_T:
-                    converted_value = atoi((char *)value);
-                    break;
-                case IGS_DATA_T:
-                    igsagent_error(agent, "constraint type error for %s (value is data and IOP is integer)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return NULL;
-                case IGS_DOUBLE_T:
-                    converted_value = (int)(*(double*)value);
-                    break;
-                default:
-                    converted_value = *(int*)value;
-                    break;
-            }
-            
-            switch (iop->constraint->type) {
-                case IGS_CONSTRAINT_MIN:
-                    if (converted_value < iop->constraint->min_int.min){
-                        igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                case IGS_CONSTRAINT_MAX:
-                    if (converted_value > iop->constraint->max_int.max){
-                        igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                case IGS_CONSTRAINT_RANGE:
-                    if (converted_value > iop->constraint->range_int.max){
-                        igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }else if (converted_value < iop->constraint->range_int.min){
-                        igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                    
-                default:
-                    break;
-            }
-        }else if(iop->value_type == IGS_DOUBLE_T){
-            double converted_value = 0;
-            switch (value_type) {
-                case IGS_STRING_T:
-                    converted_value = atof((char *)value);
-                    break;
-                case IGS_DATA_T:
-                    igsagent_error(agent, "constraint type error for %s (value is data and IOP is double)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return NULL;
-                case IGS_INTEGER_T:
-                case IGS_BOOL_T:
-                    converted_value = (double)(*(int*)value);
-                    break;
-                default:
-                    converted_value = *(double*)value;
-                    break;
-            }
-            
-            switch (iop->constraint->type) {
-                case IGS_CONSTRAINT_MIN:
-                    if (converted_value < iop->constraint->min_double.min){
-                        igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                case IGS_CONSTRAINT_MAX:
-                    if (converted_value > iop->constraint->max_double.max){
-                        igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                case IGS_CONSTRAINT_RANGE:
-                    if (converted_value > iop->constraint->range_double.max){
-                        igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }else if (converted_value < iop->constraint->range_double.min){
-                        igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
-                        return NULL;
-                    }
-                    break;
-                    
-                default:
-                    break;
-            }
-        }else if (iop->value_type == IGS_STRING_T){
-            char *converted_value = NULL;
-            switch (value_type) {
-                case IGS_STRING_T:
-                    converted_value = (char *)value;
-                    break;
-                case IGS_DATA_T:
-                    igsagent_error(agent, "constraint type error for %s (value is data and IOP is string)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return NULL;
-                case IGS_INTEGER_T:
-                case IGS_BOOL_T:
-                    snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
-                              (value == NULL) ? 0 : *(int *) (value));
-                    converted_value = buf;
-                    break;
-                case IGS_DOUBLE_T:
-                    snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%f",
-                              (value == NULL) ? 0 : *(double *) (value));
-                    converted_value = buf;
-                    break;
-                default:
-                    snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "");
-                    converted_value = buf;
-                    break;
-            }
-            if (!converted_value){
-                igsagent_error(agent, "constraint error for %s (value is NULL)", iop->name);
-                model_read_write_unlock (__FUNCTION__, __LINE__);
-                return NULL;
-            }
-            if (!zrex_matches(iop->constraint->regexp.rex, converted_value)){
-                igsagent_error(agent, "constraint error for %s (not matching regexp)", iop->name);
-                model_read_write_unlock (__FUNCTION__, __LINE__);
-                return NULL;
-            }
+    return true;
+}
+
+/*
+ Specialized writers convert a value of a given type into an iop of a given
+ type. They replace the conversion switch of the general write path and are
+ chosen with model_iop_writer. Values may be NULL, the iop then receiving the
+ default value of its type.
+ */
+static void s_model_set_string (igs_iop_t *iop, const char *str,
+                                void **out_value, size_t *out_size)
+{
+    model_release_iop_data (iop); //previous value may be pinned
+    iop->value.s = strdup ((str) ? str : "");
+    *out_size = iop->value_size = (strlen (iop->value.s) + 1) * sizeof (char);
+    *out_value = iop->value.s;
+}
+
+static void s_model_set_data_copy (igs_iop_t *iop, const void *value, size_t size,
+                                   void **out_value, size_t *out_size)
+{
+    model_release_iop_data (iop);
+    iop->value.data = (void *) zmalloc (size);
+    if (value)
+        memcpy (iop->value.data, value, size);
+    *out_size = iop->value_size = size;
+    *out_value = iop->value.data;
+}
+
+static int s_model_write_int_to_int (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                     void *value, size_t size, igs_data_buffer_t *buffer,
+                                     void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (int);
+    iop->value.i = (value == NULL) ? 0 : *(int *) (value);
+    *out_value = &(iop->value.i);
+    return 1;
+}
+
+static int s_model_write_int_to_double (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                        void *value, size_t size, igs_data_buffer_t *buffer,
+                                        void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (double);
+    iop->value.d = (value == NULL) ? 0 : *(int *) (value);
+    *out_value = &(iop->value.d);
+    return 1;
+}
+
+static int s_model_write_int_to_bool (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                      void *value, size_t size, igs_data_buffer_t *buffer,
+                                      void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (bool);
+    iop->value.b = (value == NULL) ? false : ((*(int *) (value)) ? true : false);
+    *out_value = &(iop->value.b);
+    return 1;
+}
+
+static int s_model_write_int_to_string (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                        void *value, size_t size, igs_data_buffer_t *buffer,
+                                        void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    char buf[NUMBER_TO_STRING_MAX_LENGTH + 1] = "";
+    if (value)
+        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d", *(int *) (value));
+    s_model_set_string (iop, buf, out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_int_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                      void *value, size_t size, igs_data_buffer_t *buffer,
+                                      void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    s_model_set_data_copy (iop, value, sizeof (int), out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_double_to_int (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                        void *value, size_t size, igs_data_buffer_t *buffer,
+                                        void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (int);
+    iop->value.i = (value == NULL) ? 0 : (int) (*(double *) (value));
+    *out_value = &(iop->value.i);
+    return 1;
+}
+
+static int s_model_write_double_to_double (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (double);
+    iop->value.d = (value == NULL) ? 0 : *(double *) (value);
+    *out_value = &(iop->value.d);
+    return 1;
+}
+
+static int s_model_write_double_to_bool (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (bool);
+    iop->value.b = (value == NULL) ? false : (((int) (*(double *) (value))) ? true : false);
+    *out_value = &(iop->value.b);
+    return 1;
+}
+
+static int s_model_write_double_to_string (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    char buf[NUMBER_TO_STRING_MAX_LENGTH + 1] = "";
+    if (value)
+        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%lf", *(double *) (value));
+    s_model_set_string (iop, buf, out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_double_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    s_model_set_data_copy (iop, value, sizeof (double), out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_bool_to_int (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                      void *value, size_t size, igs_data_buffer_t *buffer,
+                                      void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (int);
+    iop->value.i = (value == NULL) ? 0 : *(bool *) (value);
+    *out_value = &(iop->value.i);
+    return 1;
+}
+
+static int s_model_write_bool_to_double (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (double);
+    iop->value.d = (value == NULL) ? 0 : *(bool *) (value);
+    *out_value = &(iop->value.d);
+    return 1;
+}
+
+static int s_model_write_bool_to_bool (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                       void *value, size_t size, igs_data_buffer_t *buffer,
+                                       void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (bool);
+    iop->value.b = (value == NULL) ? false : *(bool *) value;
+    *out_value = &(iop->value.b);
+    return 1;
+}
+
+static int s_model_write_bool_to_string (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    char buf[NUMBER_TO_STRING_MAX_LENGTH + 1] = "";
+    if (value)
+        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d", *(bool *) value);
+    s_model_set_string (iop, buf, out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_bool_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                       void *value, size_t size, igs_data_buffer_t *buffer,
+                                       void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    s_model_set_data_copy (iop, value, sizeof (bool), out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_string_to_int (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                        void *value, size_t size, igs_data_buffer_t *buffer,
+                                        void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (int);
+    iop->value.i = (value == NULL) ? 0 : atoi ((char *) value);
+    *out_value = &(iop->value.i);
+    return 1;
+}
+
+static int s_model_write_string_to_double (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    *out_size = iop->value_size = sizeof (double);
+    iop->value.d = (value == NULL) ? 0 : atof ((char *) value);
+    *out_value = &(iop->value.d);
+    return 1;
+}
+
+static int s_model_write_string_to_bool (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    char *v = (char *) value;
+    if (v == NULL)
+        iop->value.b = false;
+    else
+    if (streq (v, "false") || streq (v, "False") || streq (v, "FALSE"))
+        iop->value.b = false;
+    else
+    if (streq (v, "true") || streq (v, "True") || streq (v, "TRUE"))
+        iop->value.b = true;
+    else
+        iop->value.b = atoi (v) ? true : false;
+    *out_size = iop->value_size = sizeof (bool);
+    *out_value = &(iop->value.b);
+    return 1;
+}
+
+static int s_model_write_string_to_string (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    s_model_set_string (iop, (char *) value, out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_string_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                         void *value, size_t size, igs_data_buffer_t *buffer,
+                                         void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    model_release_iop_data (iop);
+    size_t s = 0;
+    if (value) {
+        uint8_t *converted = s_model_string_to_bytes (value);
+        if (converted){
+            iop->value.data = converted;
+            s = strlen (value) / 2;
+        }else {
+            igs_error ("string %s is not a valid hexadecimal-encoded string",
+                       (char *) value);
+            return -1;
         }
     }
-    
-    // TODO: optimize if value is NULL
-    switch (value_type) {
-        case IGS_INTEGER_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    out_size = iop->value_size = sizeof (int);
-                    iop->value.i = (value == NULL) ? 0 : *(int *) (value);
-                    out_value = &(iop->value.i);
-                    break;
-                case IGS_DOUBLE_T:
-                    out_size = iop->value_size = sizeof (double);
-                    iop->value.d = (value == NULL) ? 0 : *(int *) (value);
-                    out_value = &(iop->value.d);
-                    break;
-                case IGS_BOOL_T:
-                    out_size = iop->value_size = sizeof (bool);
-                    iop->value.b = (value == NULL)
-                                     ? false
-                                     : ((*(int *) (value)) ? true : false);
-                    out_value = &(iop->value.b);
-                    break;
-                case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    if (value == NULL)
-                        iop->value.s = strdup ("");
-                    else {
-                        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
-                                  (value == NULL) ? 0 : *(int *) (value));
-                        iop->value.s = strdup (buf);
-                    }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
-                    out_value = iop->value.s;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (int));
-                    memcpy (iop->value.data, value, sizeof (int));
-                    out_size = iop->value_size = sizeof (int);
-                    out_value = iop->value.data;
-                } break;
-                default:
-                    igsagent_error (agent, "%s has an invalid value type %d",
-                                     name, iop->value_type);
-                    ret = 0;
-                    break;
-            }
-        } break;
-        case IGS_DOUBLE_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    out_size = iop->value_size = sizeof (int);
-                    iop->value.i =
-                      (value == NULL) ? 0 : (int) (*(double *) (value));
-                    out_value = &(iop->value.i);
-                    break;
-                case IGS_DOUBLE_T:
-                    out_size = iop->value_size = sizeof (double);
-                    iop->value.d =
-                      (value == NULL) ? 0 : (double) (*(double *) (value));
-                    out_value = &(iop->value.d);
-                    break;
-                case IGS_BOOL_T:
-                    out_size = iop->value_size = sizeof (bool);
-                    iop->value.b =
-                      (value == NULL)
-                        ? false
-                        : (((int) (*(double *) (value))) ? true : false);
-                    out_value = &(iop->value.b);
-                    break;
-                case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    if (value == NULL)
-                        iop->value.s = strdup ("");
-                    else {
-                        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%lf",
-                                  (value == NULL) ? 0 : *(double *) (value));
-                        iop->value.s = strdup (buf);
-                    }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
-                    out_value = iop->value.s;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (double));
-                    memcpy (iop->value.data, value, sizeof (double));
-                    out_size = iop->value_size = sizeof (double);
-                    out_value = iop->value.data;
-                } break;
-                default:
-                    igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
-                    ret = 0;
-                    break;
-            }
-        } break;
-        case IGS_BOOL_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    out_size = iop->value_size = sizeof (int);
-                    iop->value.i = (value == NULL) ? 0 : *(bool *) (value);
-                    out_value = &(iop->value.i);
-                    break;
-                case IGS_DOUBLE_T:
-                    out_size = iop->value_size = sizeof (double);
-                    iop->value.d = (value == NULL) ? 0 : *(bool *) (value);
-                    out_value = &(iop->value.d);
-                    break;
-                case IGS_BOOL_T:
-                    out_size = iop->value_size = sizeof (bool);
-                    iop->value.b = (value == NULL) ? false : *(bool *) value;
-                    out_value = &(iop->value.b);
-                    break;
-                case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    if (value == NULL)
-                        iop->value.s = strdup ("");
-                    else {
-                        snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
-                                  (value == NULL) ? 0 : *(bool *) value);
-                        iop->value.s = strdup (buf);
-                    }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
-                    out_value = iop->value.s;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (bool));
-                    memcpy (iop->value.data, value, sizeof (bool));
-                    out_size = iop->value_size = sizeof (bool);
-                    out_value = iop->value.data;
-                } break;
-                default:
-                    igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
-                    ret = 0;
-                    break;
-            }
-        } break;
-        case IGS_STRING_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    out_size = iop->value_size = sizeof (int);
-                    iop->value.i = (value == NULL) ? 0 : atoi ((char *) value);
-                    out_value = &(iop->value.i);
-                    break;
-                case IGS_DOUBLE_T:
-                    out_size = iop->value_size = sizeof (double);
-                    iop->value.d = (value == NULL) ? 0 : atof ((char *) value);
-                    out_value = &(iop->value.d);
-                    break;
-                case IGS_BOOL_T: {
-                    char *v = (char *) value;
-                    if (v == NULL)
-                        iop->value.b = false;
-                    else
-                    if (streq (v, "false") || streq (v, "False")
-                        || streq (v, "FALSE"))
-                        iop->value.b = false;
-                    else
-                    if (streq (v, "true") || streq (v, "True")
-                        || streq (v, "TRUE"))
-                        iop->value.b = true;
-                    else
-                        iop->value.b = atoi (v) ? true : false;
+    *out_size = iop->value_size = s;
+    *out_value = iop->value.data;
+    return 1;
+}
+
+static int s_model_write_impulsion_to_int (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    return s_model_write_int_to_int (agent, iop, value_type, NULL, 0, NULL, out_value, out_size);
+}
+
+static int s_model_write_impulsion_to_double (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                              void *value, size_t size, igs_data_buffer_t *buffer,
+                                              void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    return s_model_write_double_to_double (agent, iop, value_type, NULL, 0, NULL, out_value, out_size);
+}
+
+static int s_model_write_impulsion_to_bool (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                            void *value, size_t size, igs_data_buffer_t *buffer,
+                                            void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    return s_model_write_bool_to_bool (agent, iop, value_type, NULL, 0, NULL, out_value, out_size);
+}
+
+static int s_model_write_impulsion_to_string (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                              void *value, size_t size, igs_data_buffer_t *buffer,
+                                              void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    s_model_set_string (iop, NULL, out_value, out_size);
+    return 1;
+}
+
+static int s_model_write_impulsion_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                            void *value, size_t size, igs_data_buffer_t *buffer,
+                                            void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    IGS_UNUSED (out_value)
+    IGS_UNUSED (out_size)
+    model_release_iop_data (iop);
+    iop->value_size = 0;
+    return 1;
+}
+
+static int s_model_write_data_to_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                       void *value, size_t size, igs_data_buffer_t *buffer,
+                                       void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    model_release_iop_data (iop);
+    if (buffer)
+        iop->data_buffer = model_data_buffer_retain (buffer);
+    else {
+        void *copy = zmalloc (size);
+        memcpy (copy, value, size);
+        iop->data_buffer = model_data_buffer_new (copy, size, NULL);
+    }
+    iop->value.data = iop->data_buffer->data;
+    *out_size = iop->value_size = size;
+    *out_value = iop->value.data;
+    return 1;
+}
+
+// impulsions have no value, whatever is written into them
+static int s_model_write_to_impulsion (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                       void *value, size_t size, igs_data_buffer_t *buffer,
+                                       void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    IGS_UNUSED (out_value)
+    IGS_UNUSED (out_size)
+    iop->value_size = 0;
+    return 1;
+}
+
+static int s_model_refuse_data (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                void *value, size_t size, igs_data_buffer_t *buffer,
+                                void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    IGS_UNUSED (out_value)
+    IGS_UNUSED (out_size)
+    const char *iop_type = NULL;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            iop_type = "integer";
+            break;
+        case IGS_DOUBLE_T:
+            iop_type = "double";
+            break;
+        case IGS_BOOL_T:
+            iop_type = "boolean";
+            break;
+        default:
+            iop_type = "string";
+            break;
+    }
+    igsagent_warn (agent, "Raw data is not allowed into %s IOP %s", iop_type, iop->name);
+    return 0;
+}
+
+static int s_model_refuse_invalid_type (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                        void *value, size_t size, igs_data_buffer_t *buffer,
+                                        void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    IGS_UNUSED (out_value)
+    IGS_UNUSED (out_size)
+    igsagent_error (agent, "%s has an invalid value type %d", iop->name, iop->value_type);
+    return 0;
+}
+
+// values of unknown types are ignored but the iop is considered as written
+static int s_model_ignore_value (igsagent_t *agent, igs_iop_t *iop, igs_iop_value_type_t value_type,
+                                 void *value, size_t size, igs_data_buffer_t *buffer,
+                                 void **out_value, size_t *out_size)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (iop)
+    IGS_UNUSED (value_type)
+    IGS_UNUSED (value)
+    IGS_UNUSED (size)
+    IGS_UNUSED (buffer)
+    IGS_UNUSED (out_value)
+    IGS_UNUSED (out_size)
+    return 1;
+}
+
+// indexed by value type, then by iop value type
+static igs_iop_writer_fn *s_model_writers[IGS_SCALAR_TYPES_NB][IGS_SCALAR_TYPES_NB] = {
+    [IGS_INTEGER_T] = {
+        [IGS_INTEGER_T] = s_model_write_int_to_int,
+        [IGS_DOUBLE_T] = s_model_write_int_to_double,
+        [IGS_STRING_T] = s_model_write_int_to_string,
+        [IGS_BOOL_T] = s_model_write_int_to_bool,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_int_to_data,
+    },
+    [IGS_DOUBLE_T] = {
+        [IGS_INTEGER_T] = s_model_write_double_to_int,
+        [IGS_DOUBLE_T] = s_model_write_double_to_double,
+        [IGS_STRING_T] = s_model_write_double_to_string,
+        [IGS_BOOL_T] = s_model_write_double_to_bool,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_double_to_data,
+    },
+    [IGS_STRING_T] = {
+        [IGS_INTEGER_T] = s_model_write_string_to_int,
+        [IGS_DOUBLE_T] = s_model_write_string_to_double,
+        [IGS_STRING_T] = s_model_write_string_to_string,
+        [IGS_BOOL_T] = s_model_write_string_to_bool,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_string_to_data,
+    },
+    [IGS_BOOL_T] = {
+        [IGS_INTEGER_T] = s_model_write_bool_to_int,
+        [IGS_DOUBLE_T] = s_model_write_bool_to_double,
+        [IGS_STRING_T] = s_model_write_bool_to_string,
+        [IGS_BOOL_T] = s_model_write_bool_to_bool,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_bool_to_data,
+    },
+    [IGS_IMPULSION_T] = {
+        [IGS_INTEGER_T] = s_model_write_impulsion_to_int,
+        [IGS_DOUBLE_T] = s_model_write_impulsion_to_double,
+        [IGS_STRING_T] = s_model_write_impulsion_to_string,
+        [IGS_BOOL_T] = s_model_write_impulsion_to_bool,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_impulsion_to_data,
+    },
+    [IGS_DATA_T] = {
+        [IGS_INTEGER_T] = s_model_refuse_data,
+        [IGS_DOUBLE_T] = s_model_refuse_data,
+        [IGS_STRING_T] = s_model_refuse_data,
+        [IGS_BOOL_T] = s_model_refuse_data,
+        [IGS_IMPULSION_T] = s_model_write_to_impulsion,
+        [IGS_DATA_T] = s_model_write_data_to_data,
+    },
+};
+
+igs_iop_writer_fn *model_iop_writer (igs_iop_value_type_t value_type,
+                                     igs_iop_value_type_t iop_value_type)
+{
+    if (model_is_array_type (iop_value_type))
+        return s_model_write_array_locked;
+    if (model_is_array_type (value_type))
+        return NULL; //arrays are reduced by model_write_iop_locked
+    if (iop_value_type <= IGS_UNKNOWN_T || iop_value_type >= IGS_SCALAR_TYPES_NB)
+        return s_model_refuse_invalid_type;
+    if (value_type <= IGS_UNKNOWN_T || value_type >= IGS_SCALAR_TYPES_NB)
+        return s_model_ignore_value;
+    return s_model_writers[value_type][iop_value_type];
+}
+
+static void s_model_log_written_iop (igsagent_t *agent, igs_iop_t *iop, igs_iop_type_t type)
+{
+    // compose log entry
+    const char *log_iop_type = NULL;
+    switch (type) {
+        case IGS_INPUT_T:
+            log_iop_type = "input";
+            break;
+        case IGS_OUTPUT_T:
+            log_iop_type = "output";
+            break;
+        case IGS_PARAMETER_T:
+            log_iop_type = "parameter";
+            break;
+        default:
+            break;
+    }
+    char log_iop_value_buffer[MAX_IOP_VALUE_LOG_BUFFER_LENGTH] = "";
+    char *log_iop_value = NULL;
+    switch (iop->value_type) {
+        case IGS_IMPULSION_T:
+            log_iop_value = strdup ("impulsion (no value)");
+            break;
+        case IGS_BOOL_T:
+            snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
+                      "bool %d", iop->value.b);
+            log_iop_value = strdup (log_iop_value_buffer);
+            break;
+        case IGS_INTEGER_T:
+            snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
+                      "int %d", iop->value.i);
+            log_iop_value = strdup (log_iop_value_buffer);
+            break;
+        case IGS_DOUBLE_T:
+            snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
+                      "double %f", iop->value.d);
+            log_iop_value = strdup (log_iop_value_buffer);
+            break;
+        case IGS_STRING_T:
+            log_iop_value = zmalloc ((strlen (iop->value.s) + strlen ("string ") + 1) * sizeof (char));
+            sprintf (log_iop_value, "string %s", iop->value.s);
+            break;
+        case IGS_DATA_T: {
+            if (core_context->enable_data_logging) {
+                if (iop->value_size > 0) {
+                    zchunk_t *chunk = zchunk_new (iop->value.data, iop->value_size);
+                    char *hex_chunk = zchunk_strhex (chunk);
+                    log_iop_value = zmalloc ((strlen (hex_chunk) + strlen ("data ") + 1) * sizeof (char));
+                    sprintf (log_iop_value, "data %s", hex_chunk);
+                    free (hex_chunk);
+                    zchunk_destroy (&chunk);
+                }
+                else {
+                    log_iop_value = (void *) zmalloc ((strlen ("data 00") + 1) * sizeof (char));
+                    sprintf (log_iop_value, "data 00");
                 }
-                    out_size = iop->value_size = sizeof (bool);
-                    out_value = &(iop->value.b);
-                    break;
-                case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    if (value == NULL)
-                        iop->value.s = strdup ("");
-                    else
-                        iop->value.s = strdup ((char *) value);
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
-                    out_value = iop->value.s;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    size_t s = 0;
-                    if (value) {
-                        uint8_t *converted = s_model_string_to_bytes (value);
-                        if (converted){
-                            iop->value.data = converted;
-                            s = strlen (value) / 2;
-                        }else {
-                            igs_error ("string %s is not a valid hexadecimal-encoded string",
-                                       (char *) value);
-                            model_read_write_unlock (__FUNCTION__, __LINE__);
-                            return NULL;
-                        }
-                    }
-                    out_size = iop->value_size = s;
-                    out_value = iop->value.data;
-                } break;
-                default:
-                    igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
-                    ret = 0;
-                    break;
             }
-        } break;
-        case IGS_IMPULSION_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    out_size = iop->value_size = sizeof (int);
-                    iop->value.i = 0;
-                    out_value = &(iop->value.i);
-                    break;
-                case IGS_DOUBLE_T:
-                    out_size = iop->value_size = sizeof (double);
-                    iop->value.d = 0.0;
-                    out_value = &(iop->value.d);
-                    break;
-                case IGS_BOOL_T:
-                    out_size = iop->value_size = sizeof (bool);
-                    iop->value.b = false;
-                    out_value = &(iop->value.b);
-                    break;
-                case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    iop->value.s = strdup ("");
-                    out_size = iop->value_size = sizeof (char);
-                    out_value = iop->value.s;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value_size = 0;
-                } break;
-                default:
-                    igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
-                    ret = 0;
-                    break;
+            else {
+                snprintf (log_iop_value_buffer,
+                          MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
+                          "data |size: %zu bytes", iop->value_size);
+                log_iop_value = strdup (log_iop_value_buffer);
             }
         } break;
-        case IGS_DATA_T: {
-            switch (iop->value_type) {
-                case IGS_INTEGER_T:
-                    igsagent_warn (
-                      agent, "Raw data is not allowed into integer IOP %s",
-                      name);
-                    ret = 0;
-                    break;
-                case IGS_DOUBLE_T:
-                    igsagent_warn (
-                      agent, "Raw data is not allowed into double IOP %s",
-                      name);
-                    ret = 0;
-                    break;
-                case IGS_BOOL_T:
-                    igsagent_warn (
-                      agent, "Raw data is not allowed into boolean IOP %s",
-                      name);
-                    ret = 0;
-                    break;
-                case IGS_STRING_T: {
-                    igsagent_warn (
-                      agent, "Raw data is not allowed into string IOP %s",
-                      name);
-                    ret = 0;
-                } break;
-                case IGS_IMPULSION_T:
-                    iop->value_size = 0;
-                    break;
-                case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (size);
-                    memcpy (iop->value.data, value, size);
-                    out_size = iop->value_size = size;
-                    out_value = iop->value.data;
-                } break;
-                default:
-                    igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
-                    ret = 0;
-                    break;
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T: {
+            const char *log_array_type = (iop->value_type == IGS_INTEGER_ARRAY_T)
+                                           ? "int_array"
+                                           : ((iop->value_type == IGS_FLOAT_ARRAY_T)
+                                                ? "float_array" : "double_array");
+            if (core_context->enable_data_logging) {
+                char *text = model_array_to_string (iop->value_type, iop->value.data,
+                                                    iop->value_size);
+                log_iop_value = zmalloc (strlen (log_array_type) + strlen (text) + 2);
+                sprintf (log_iop_value, "%s %s", log_array_type, text);
+                free (text);
+            }
+            else {
+                snprintf (log_iop_value_buffer,
+                          MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
+                          "%s |size: %zu bytes", log_array_type, iop->value_size);
+                log_iop_value = strdup (log_iop_value_buffer);
             }
         } break;
         default:
             break;
     }
+    igsagent_debug (agent, "set %s %s to %s", log_iop_type, iop->name,
+                    log_iop_value);
+    free (log_iop_value);
+}
 
+int model_write_iop_with (igs_iop_writer_fn *writer, igsagent_t *agent, igs_iop_t *iop,
+                          igs_iop_type_t type, igs_iop_value_type_t value_type,
+                          void *value, size_t size, igs_data_buffer_t *buffer,
+                          void **written_value, size_t *written_size)
+{
+    assert (writer);
+    assert (iop);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid))
+        return -1;
+    if (iop->constraint && agent->enforce_constraints
+        && !s_model_value_satisfies_constraint (agent, iop, value_type, value))
+        return -1;
+    void *out_value = NULL;
+    size_t out_size = 0;
+    int ret = writer (agent, iop, value_type, value, size, buffer, &out_value, &out_size);
+    if (ret < 0)
+        return ret;
     if (ret) {
-        // compose log entry
-        const char *log_iop_type = NULL;
-        switch (type) {
-            case IGS_INPUT_T:
-                log_iop_type = "input";
+        model_update_iop_snapshot (iop);
+        s_model_log_written_iop (agent, iop, type);
+    }
+    if (written_value)
+        *written_value = out_value;
+    if (written_size)
+        *written_size = out_size;
+    return ret;
+}
+
+int model_write_iop_locked (igsagent_t *agent, igs_iop_t *iop,
+                            igs_iop_type_t type, igs_iop_value_type_t value_type,
+                            void *value, size_t size, igs_data_buffer_t *buffer,
+                            void **written_value, size_t *written_size)
+{
+    assert (iop);
+    // arrays written into other iops are reduced to their first element,
+    // or to their text for strings and to their bytes for data
+    int first_int = 0;
+    double first_double = 0;
+    char *array_text = NULL;
+    if (model_is_array_type (value_type) && !model_is_array_type (iop->value_type)) {
+        size_t count = (value) ? size / model_array_element_size (value_type) : 0;
+        switch (iop->value_type) {
+            case IGS_STRING_T:
+                array_text = model_array_to_string (value_type, value, (value) ? size : 0);
+                value = array_text;
+                size = strlen (array_text) + 1;
+                value_type = IGS_STRING_T;
                 break;
-            case IGS_OUTPUT_T:
-                log_iop_type = "output";
+            case IGS_DATA_T:
+                value_type = IGS_DATA_T;
                 break;
-            case IGS_PARAMETER_T:
-                log_iop_type = "parameter";
+            case IGS_DOUBLE_T:
+                if (count)
+                    model_convert_array (IGS_DOUBLE_ARRAY_T, &first_double, value_type, value, 1);
+                value = &first_double;
+                size = sizeof (double);
+                value_type = IGS_DOUBLE_T;
                 break;
             default:
+                if (count)
+                    model_convert_array (IGS_INTEGER_ARRAY_T, &first_int, value_type, value, 1);
+                value = &first_int;
+                size = sizeof (int);
+                value_type = IGS_INTEGER_T;
                 break;
         }
-        char log_iop_value_buffer[MAX_IOP_VALUE_LOG_BUFFER_LENGTH] = "";
-        char *log_iop_value = NULL;
-        switch (iop->value_type) {
-            case IGS_IMPULSION_T:
-                log_iop_value = strdup ("impulsion (no value)");
-                break;
-            case IGS_BOOL_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "bool %d", iop->value.b);
-                log_iop_value = strdup (log_iop_value_buffer);
-                break;
-            case IGS_INTEGER_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "int %d", iop->value.i);
-                log_iop_value = strdup (log_iop_value_buffer);
-                break;
-            case IGS_DOUBLE_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "double %f", iop->value.d);
-                log_iop_value = strdup (log_iop_value_buffer);
+    }
+    int ret = model_write_iop_with (model_iop_writer (value_type, iop->value_type),
+                                    agent, iop, type, value_type, value, size,
+                                    buffer, written_value, written_size);
+    free (array_text);
+    return ret;
+}
+
+// numeric value compared by publication filters, false for
+// strings, data and arrays which are compared byte per byte
+static bool s_model_publication_filter_value (const igs_iop_t *iop, double *value)
+{
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            *value = iop->value.i;
+            return true;
+        case IGS_DOUBLE_T:
+            *value = iop->value.d;
+            return true;
+        case IGS_BOOL_T:
+            *value = (iop->value.b) ? 1 : 0;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// returns true if the new value of an output passes its publication
+// filter, agent write lock must be held
+static bool s_model_publication_filter_allows (igs_iop_t *iop)
+{
+    if (iop->publication_filter == IGS_PUBLICATION_FILTER_NONE)
+        return true;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+        case IGS_DOUBLE_T:
+        case IGS_BOOL_T:
+        case IGS_STRING_T:
+        case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            break;
+        default:
+            return true;
+    }
+    bool allowed = !iop->has_publication_reference
+                   || (iop->publication_refresh_interval > 0
+                       && zclock_usecs () - iop->last_unfiltered_publication
+                            >= iop->publication_refresh_interval);
+    double value = 0;
+    if (!allowed && s_model_publication_filter_value (iop, &value)) {
+        double difference = fabs (value - iop->publication_reference);
+        switch (iop->publication_filter) {
+            case IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE:
+                allowed = (difference > iop->publication_deadband);
                 break;
-            case IGS_STRING_T:
-                log_iop_value = zmalloc ((strlen (iop->value.s) + strlen ("string ") + 1) * sizeof (char));
-                sprintf (log_iop_value, "string %s", iop->value.s);
+            case IGS_PUBLICATION_FILTER_DEADBAND_RELATIVE:
+                allowed = (difference > iop->publication_deadband * fabs (iop->publication_reference));
                 break;
-            case IGS_DATA_T: {
-                if (core_context->enable_data_logging) {
-                    if (iop->value_size > 0) {
-                        zchunk_t *chunk = zchunk_new (iop->value.data, iop->value_size);
-                        char *hex_chunk = zchunk_strhex (chunk);
-                        log_iop_value = zmalloc ((strlen (hex_chunk) + strlen ("data ") + 1) * sizeof (char));
-                        sprintf (log_iop_value, "data %s", hex_chunk);
-                        free (hex_chunk);
-                        zchunk_destroy (&chunk);
-                    }
-                    else {
-                        log_iop_value = (void *) zmalloc ((strlen ("data 00") + 1) * sizeof (char));
-                        sprintf (log_iop_value, "data 00");
-                    }
-                }
-                else {
-                    snprintf (log_iop_value_buffer,
-                              MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                              "data |size: %zu bytes", iop->value_size);
-                    log_iop_value = strdup (log_iop_value_buffer);
-                }
-            } break;
             default:
+                allowed = (difference > 0);
                 break;
         }
-        igsagent_debug (agent, "set %s %s to %s", log_iop_type, name,
-                        log_iop_value);
-        free (log_iop_value);
-        
-        model_read_write_unlock (__FUNCTION__, __LINE__);
-        // handle iop callbacks
+    } else if (!allowed) {
+        igs_data_buffer_t *reference = iop->publication_reference_buffer;
+        size_t reference_size = (reference) ? reference->size : 0;
+        allowed = (reference_size != iop->value_size
+                   || (reference_size > 0
+                       && memcmp (reference->data, iop->value.data, reference_size) != 0));
+    }
+    if (!allowed)
+        iop->filtered_publications_nb++;
+    return allowed;
+}
+
+void model_set_publication_reference (igs_iop_t *iop)
+{
+    assert (iop);
+    if (iop->publication_filter == IGS_PUBLICATION_FILTER_NONE)
+        return;
+    double value = 0;
+    if (s_model_publication_filter_value (iop, &value))
+        iop->publication_reference = value;
+    else {
+        if (iop->publication_reference_buffer)
+            model_data_buffer_release (&iop->publication_reference_buffer);
+        if (iop->data_buffer)
+            iop->publication_reference_buffer = model_data_buffer_retain (iop->data_buffer);
+        else if (iop->value.data && iop->value_size > 0) {
+            void *copy = malloc (iop->value_size);
+            assert (copy);
+            memcpy (copy, iop->value.data, iop->value_size);
+            iop->publication_reference_buffer = model_data_buffer_new (copy, iop->value_size, NULL);
+        }
+    }
+    iop->has_publication_reference = true;
+    iop->last_unfiltered_publication = zclock_usecs ();
+}
+
+const igs_iop_t *model_write_resolved_iop (igsagent_t *agent, igs_iop_t *iop,
+                                           igs_iop_type_t type, igs_iop_value_type_t value_type,
+                                           void *value, size_t size, igs_data_buffer_t *buffer,
+                                           bool *publish)
+{
+    void *out_value = NULL;
+    size_t out_size = 0;
+    model_agent_write_lock (agent);
+    int ret = model_write_iop_locked (agent, iop, type, value_type, value, size,
+                                      buffer, &out_value, &out_size);
+    if (publish)
+        *publish = (ret <= 0 || type != IGS_OUTPUT_T || s_model_publication_filter_allows (iop));
+    model_agent_write_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
+    if (ret < 0)
+        return NULL;
+    // handle iop callbacks
+    if (ret > 0)
         s_model_run_observe_callbacks_for_iop (agent, iop, out_value, out_size);
-    }else
-        model_read_write_unlock (__FUNCTION__, __LINE__);
     return iop;
 }
 
+void model_defer_observe_callbacks (igs_deferred_observe_t **list,
+                                    igsagent_t *agent,
+                                    igs_iop_t *iop,
+                                    int64_t timestamp)
+{
+    assert (list);
+    assert (agent);
+    assert (iop);
+    if (!iop->callbacks)
+        return;
+    igs_deferred_observe_t *deferred = NULL;
+    LL_FOREACH (*list, deferred) {
+        if (deferred->agent == agent && deferred->iop == iop) {
+            // callbacks run once with the last value
+            deferred->timestamp = timestamp;
+            return;
+        }
+    }
+    deferred = (igs_deferred_observe_t *) zmalloc (sizeof (igs_deferred_observe_t));
+    deferred->agent = agent;
+    deferred->iop = iop;
+    deferred->timestamp = timestamp;
+    LL_APPEND (*list, deferred);
+}
+
+void model_run_deferred_observe_callbacks (igs_deferred_observe_t **list)
+{
+    assert (list);
+    igs_deferred_observe_t *deferred, *tmp;
+    LL_FOREACH_SAFE (*list, deferred, tmp) {
+        LL_DELETE (*list, deferred);
+        void *value = NULL;
+        size_t size = 0;
+        model_iop_value (deferred->iop, &value, &size);
+        deferred->agent->rt_current_timestamp_microseconds = deferred->timestamp;
+        s_model_run_observe_callbacks_for_iop (deferred->agent, deferred->iop, value, size);
+        deferred->agent->rt_current_timestamp_microseconds = INT64_MIN;
+        free (deferred);
+    }
+}
+
+void model_iop_value (igs_iop_t *iop, void **value, size_t *size)
+{
+    assert (iop);
+    assert (value);
+    assert (size);
+    *value = NULL;
+    *size = 0;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            *value = &(iop->value.i);
+            *size = sizeof (int);
+            break;
+        case IGS_DOUBLE_T:
+            *value = &(iop->value.d);
+            *size = sizeof (double);
+            break;
+        case IGS_BOOL_T:
+            *value = &(iop->value.b);
+            *size = sizeof (bool);
+            break;
+        case IGS_STRING_T:
+        case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            *value = iop->value.data;
+            *size = iop->value_size;
+            break;
+        default:
+            break;
+    }
+}
+
 igs_iop_t *s_model_find_input_by_name (igsagent_t *agent, const char *name)
 {
     igs_iop_t *found = NULL;
@@ -766,23 +1763,28 @@ void model_clear_iop (igsagent_t *agent, const char *name, igs_iop_type_t type)
 {
     assert (agent);
     assert (name);
+    model_read_lock (__FUNCTION__, __LINE__);
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (!iop)
+    if (!iop) {
+        model_read_unlock (__FUNCTION__, __LINE__);
         return;
+    }
+    model_agent_write_lock (agent);
     switch (iop->value_type) {
         case IGS_IMPULSION_T:
             break;
         case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
             if (iop->value.data) {
-                free (iop->value.data);
-                iop->value.data = NULL;
+                model_release_iop_data (iop);
                 iop->value_size = 0;
             }
             break;
         case IGS_STRING_T:
             if (iop->value.s) {
-                free (iop->value.s);
-                iop->value.s = NULL;
+                model_release_iop_data (iop);
                 iop->value_size = 0;
             }
             break;
@@ -801,6 +1803,9 @@ void model_clear_iop (igsagent_t *agent, const char *name, igs_iop_type_t type)
         default:
             break;
     }
+    model_update_iop_snapshot (iop);
+    model_agent_write_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -846,6 +1851,9 @@ s_model_get_value_for (igsagent_t *agent, const char *name, igs_iop_type_t type)
         case IGS_IMPULSION_T:
             return NULL;
         case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
             return iop->value.data;
         default:
             igsagent_error (agent, "Unknown value type for %s", name);
@@ -860,14 +1868,18 @@ igs_result_t s_read_iop (igsagent_t *agent,
                          void **value,
                          size_t *size)
 {
+    model_read_lock (__FUNCTION__, __LINE__);
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
     if (iop == NULL) {
         igsagent_error (agent, "%s not found", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
+    model_agent_read_lock (agent);
     if (iop->value_type == IGS_IMPULSION_T
         || (iop->value_type == IGS_STRING_T && iop->value.s == NULL)
-        || (iop->value_type == IGS_DATA_T && iop->value.data == NULL)) {
+        || ((iop->value_type == IGS_DATA_T || model_is_array_type (iop->value_type))
+            && iop->value.data == NULL)) {
         *value = NULL;
         *size = 0;
     }
@@ -877,6 +1889,8 @@ igs_result_t s_read_iop (igsagent_t *agent,
                 iop->value_size);
         *size = iop->value_size;
     }
+    model_agent_read_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -910,42 +1924,42 @@ igs_result_t igsagent_parameter_buffer (igsagent_t *agent,
     return s_read_iop (agent, name, IGS_PARAMETER_T, value, size);
 }
 
-bool s_model_read_iop_as_bool (igsagent_t *agent,
-                               const char *name,
-                               igs_iop_type_t type)
+// values read from iop snapshots, without locking their agent
+static bool s_model_is_snapshot_type (igs_iop_value_type_t value_type)
+{
+    return value_type == IGS_INTEGER_T || value_type == IGS_DOUBLE_T
+           || value_type == IGS_BOOL_T;
+}
+
+bool s_model_iop_as_bool (igsagent_t *agent, igs_iop_t *iop)
 {
     bool res = false;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return false;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             res = iop->value.b;
             return res;
         case IGS_INTEGER_T:
             igsagent_warn (
-              agent, "Implicit conversion from int to bool for %s", name);
+              agent, "Implicit conversion from int to bool for %s", iop->name);
             res = (iop->value.i == 0) ? false : true;
             return res;
         case IGS_DOUBLE_T:
             igsagent_warn (
-              agent, "Implicit conversion from double to bool for %s", name);
+              agent, "Implicit conversion from double to bool for %s", iop->name);
             res = (iop->value.d >= 0 && iop->value.d <= 0) ? false : true;
             return res;
         case IGS_STRING_T:
             if (streq (iop->value.s, "true")) {
                 igsagent_warn (
                   agent, "Implicit conversion from string to bool for %s",
-                  name);
+                  iop->name);
                 return true;
             }
             else
             if (streq (iop->value.s, "false")) {
                 igsagent_warn (
                   agent, "Implicit conversion from string to bool for %s",
-                  name);
+                  iop->name);
                 return false;
             }
             else {
@@ -953,18 +1967,43 @@ bool s_model_read_iop_as_bool (igsagent_t *agent,
                   agent,
                   "Implicit conversion from double to bool for %s (string "
                   "value is %s and false was returned)",
-                  name, iop->value.s);
+                  iop->name, iop->value.s);
                 return false;
             }
         default:
             igsagent_error (
               agent,
               "No implicit conversion possible for %s (false was returned)",
-              name);
+              iop->name);
             return false;
     }
 }
 
+bool s_model_read_iop_as_bool (igsagent_t *agent,
+                               const char *name,
+                               igs_iop_type_t type)
+{
+    bool res = false;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL)
+        igsagent_error (agent, "%s not found", name);
+    else
+    if (s_model_is_snapshot_type (iop->value_type)) {
+        igs_iop_t copy = {0};
+        copy.name = iop->name;
+        model_read_iop_snapshot (model_iop_snapshot (agent, iop), &copy);
+        res = s_model_iop_as_bool (agent, &copy);
+    }
+    else {
+        model_agent_read_lock (agent);
+        res = s_model_iop_as_bool (agent, iop);
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
 bool igsagent_input_bool (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -972,20 +2011,13 @@ bool igsagent_input_bool (igsagent_t *agent, const char *name)
     return s_model_read_iop_as_bool (agent, name, IGS_INPUT_T);
 }
 
-int s_model_read_iop_as_int (igsagent_t *agent,
-                             const char *name,
-                             igs_iop_type_t type)
+int s_model_iop_as_int (igsagent_t *agent, igs_iop_t *iop)
 {
     int res = 0;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return 0;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             igsagent_warn (
-              agent, "Implicit conversion from bool to int for %s", name);
+              agent, "Implicit conversion from bool to int for %s", iop->name);
             res = (iop->value.b) ? 1 : 0;
             return res;
         case IGS_INTEGER_T:
@@ -993,7 +2025,7 @@ int s_model_read_iop_as_int (igsagent_t *agent,
             return res;
         case IGS_DOUBLE_T:
             igsagent_warn (
-              agent, "Implicit conversion from double to int for %s", name);
+              agent, "Implicit conversion from double to int for %s", iop->name);
             if (iop->value.d < 0)
                 res = (int) (iop->value.d - 0.5);
             else
@@ -1002,17 +2034,42 @@ int s_model_read_iop_as_int (igsagent_t *agent,
         case IGS_STRING_T:
             igsagent_warn (agent,
                             "Implicit conversion from string %s to int for %s",
-                            iop->value.s, name);
+                            iop->value.s, iop->name);
             res = atoi (iop->value.s);
             return res;
         default:
             igsagent_error (
               agent, "No implicit conversion possible for %s (0 was returned)",
-              name);
+              iop->name);
             return 0;
     }
 }
 
+int s_model_read_iop_as_int (igsagent_t *agent,
+                             const char *name,
+                             igs_iop_type_t type)
+{
+    int res = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL)
+        igsagent_error (agent, "%s not found", name);
+    else
+    if (s_model_is_snapshot_type (iop->value_type)) {
+        igs_iop_t copy = {0};
+        copy.name = iop->name;
+        model_read_iop_snapshot (model_iop_snapshot (agent, iop), &copy);
+        res = s_model_iop_as_int (agent, &copy);
+    }
+    else {
+        model_agent_read_lock (agent);
+        res = s_model_iop_as_int (agent, iop);
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
 int igsagent_input_int (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1020,25 +2077,18 @@ int igsagent_input_int (igsagent_t *agent, const char *name)
     return s_model_read_iop_as_int (agent, name, IGS_INPUT_T);
 }
 
-double s_model_read_iop_as_double (igsagent_t *agent,
-                                   const char *name,
-                                   igs_iop_type_t type)
+double s_model_iop_as_double (igsagent_t *agent, igs_iop_t *iop)
 {
     double res = 0;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return 0;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             igsagent_warn (
-              agent, "Implicit conversion from bool to double for %s", name);
+              agent, "Implicit conversion from bool to double for %s", iop->name);
             res = (iop->value.b) ? 1 : 0;
             return res;
         case IGS_INTEGER_T:
             igsagent_warn (
-              agent, "Implicit conversion from int to double for %s", name);
+              agent, "Implicit conversion from int to double for %s", iop->name);
             res = iop->value.i;
             return res;
         case IGS_DOUBLE_T:
@@ -1047,17 +2097,42 @@ double s_model_read_iop_as_double (igsagent_t *agent,
         case IGS_STRING_T:
             igsagent_warn (
               agent, "Implicit conversion from string %s to double for %s",
-              iop->value.s, name);
+              iop->value.s, iop->name);
             res = atof (iop->value.s);
             return res;
         default:
             igsagent_error (
               agent, "No implicit conversion possible for %s (0 was returned)",
-              name);
+              iop->name);
             return 0;
     }
 }
 
+double s_model_read_iop_as_double (igsagent_t *agent,
+                                   const char *name,
+                                   igs_iop_type_t type)
+{
+    double res = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL)
+        igsagent_error (agent, "%s not found", name);
+    else
+    if (s_model_is_snapshot_type (iop->value_type)) {
+        igs_iop_t copy = {0};
+        copy.name = iop->name;
+        model_read_iop_snapshot (model_iop_snapshot (agent, iop), &copy);
+        res = s_model_iop_as_double (agent, &copy);
+    }
+    else {
+        model_agent_read_lock (agent);
+        res = s_model_iop_as_double (agent, iop);
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
 double igsagent_input_double (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1085,9 +2160,9 @@ char *s_model_double_to_string (const double value)
     return str;
 }
 
-char *s_model_read_iop_as_string (igsagent_t *agent,
-                                  const char *name,
-                                  igs_iop_type_t type)
+char *s_model_read_iop_as_string_locked (igsagent_t *agent,
+                                         const char *name,
+                                         igs_iop_type_t type)
 {
     char *res = NULL;
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
@@ -1114,6 +2189,13 @@ char *s_model_read_iop_as_string (igsagent_t *agent,
               agent, "Implicit conversion from double to string for %s", name);
             res = s_model_double_to_string (iop->value.d);
             return res;
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            igsagent_warn (
+              agent, "Implicit conversion from array to string for %s", name);
+            res = model_array_to_string (iop->value_type, iop->value.data, iop->value_size);
+            return res;
         default:
             igsagent_error (
               agent,
@@ -1123,6 +2205,18 @@ char *s_model_read_iop_as_string (igsagent_t *agent,
     }
 }
 
+char *s_model_read_iop_as_string (igsagent_t *agent,
+                                  const char *name,
+                                  igs_iop_type_t type)
+{
+    model_read_lock (__FUNCTION__, __LINE__);
+    model_agent_read_lock (agent);
+    char * res = s_model_read_iop_as_string_locked (agent, name, type);
+    model_agent_read_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
 char *igsagent_input_string (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1130,11 +2224,11 @@ char *igsagent_input_string (igsagent_t *agent, const char *name)
     return s_model_read_iop_as_string (agent, name, IGS_INPUT_T);
 }
 
-igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
-                                       const char *name,
-                                       igs_iop_type_t type,
-                                       void **value,
-                                       size_t *size)
+igs_result_t s_model_read_iop_as_data_locked (igsagent_t *agent,
+                                              const char *name,
+                                              igs_iop_type_t type,
+                                              void **value,
+                                              size_t *size)
 {
     assert (agent);
     assert (value);
@@ -1147,7 +2241,8 @@ igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
         return IGS_FAILURE;
     }
     if (iop->value_type == IGS_IMPULSION_T || iop->value_type == IGS_UNKNOWN_T
-        || (iop->value_type == IGS_DATA_T && iop->value.data == NULL)) {
+        || ((iop->value_type == IGS_DATA_T || model_is_array_type (iop->value_type))
+            && iop->value.data == NULL)) {
         *value = NULL;
         *size = 0;
     }else{
@@ -1158,6 +2253,20 @@ igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
     return IGS_SUCCESS;
 }
 
+igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
+                                       const char *name,
+                                       igs_iop_type_t type,
+                                       void **value,
+                                       size_t *size)
+{
+    model_read_lock (__FUNCTION__, __LINE__);
+    model_agent_read_lock (agent);
+    igs_result_t res = s_model_read_iop_as_data_locked (agent, name, type, value, size);
+    model_agent_read_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
 igs_result_t igsagent_input_data (igsagent_t *agent,
                                    const char *name,
                                    void **data,
@@ -1168,17 +2277,28 @@ igs_result_t igsagent_input_data (igsagent_t *agent,
     return s_model_read_iop_as_data (agent, name, IGS_INPUT_T, data, size);
 }
 
+static void s_model_pin_frame_destructor (void **hint)
+{
+    igs_value_pin_t *pin = (igs_value_pin_t *) *hint;
+    igsagent_value_unpin (&pin);
+    *hint = NULL;
+}
+
 igs_result_t
 igsagent_input_zmsg (igsagent_t *agent, const char *name, zmsg_t **msg)
 {
     assert (agent);
     assert (name);
-    void *data = NULL;
+    // the pinned value is decoded without being copied first
+    const void *data = NULL;
     size_t size = 0;
-    igs_result_t ret =
-      s_model_read_iop_as_data (agent, name, IGS_INPUT_T, &data, &size);
-    zframe_t *frame = zframe_new (data, size);
-    free (data);
+    igs_value_pin_t *pin = NULL;
+    igs_result_t ret = igsagent_input_pin (agent, name, &data, &size, &pin);
+    zframe_t *frame = NULL;
+    if (pin)
+        frame = zframe_frommem ((void *) data, size, s_model_pin_frame_destructor, pin);
+    else
+        frame = zframe_new (NULL, 0);
     *msg = zmsg_decode (frame);
     zframe_destroy (&frame);
     return ret;
@@ -1260,6 +2380,77 @@ igs_result_t igsagent_parameter_data (igsagent_t *agent,
     return s_model_read_iop_as_data (agent, name, IGS_PARAMETER_T, data, size);
 }
 
+// copies the elements of an array iop converted to array_type
+igs_result_t s_model_read_iop_as_array (igsagent_t *agent,
+                                        const char *name,
+                                        igs_iop_type_t type,
+                                        igs_iop_value_type_t array_type,
+                                        void **values,
+                                        size_t *count)
+{
+    assert (agent);
+    assert (name);
+    assert (values);
+    assert (count);
+    *values = NULL;
+    *count = 0;
+    if (!model_is_array_type (array_type)) {
+        igsagent_error (agent, "%d is not an array value type", array_type);
+        return IGS_FAILURE;
+    }
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    igs_result_t res = IGS_SUCCESS;
+    model_agent_read_lock (agent);
+    if (model_is_array_type (iop->value_type)) {
+        *count = iop->value_size / model_array_element_size (iop->value_type);
+        if (*count) {
+            *values = malloc (*count * model_array_element_size (array_type));
+            model_convert_array (array_type, *values, iop->value_type,
+                                 iop->value.data, *count);
+        }
+    }
+    else {
+        igsagent_error (agent, "%s is not an array", name);
+        res = IGS_FAILURE;
+    }
+    model_agent_read_unlock (agent);
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
+igs_result_t igsagent_input_array (igsagent_t *agent,
+                                    const char *name,
+                                    igs_iop_value_type_t array_type,
+                                    void **values,
+                                    size_t *count)
+{
+    return s_model_read_iop_as_array (agent, name, IGS_INPUT_T, array_type, values, count);
+}
+
+igs_result_t igsagent_output_array (igsagent_t *agent,
+                                     const char *name,
+                                     igs_iop_value_type_t array_type,
+                                     void **values,
+                                     size_t *count)
+{
+    return s_model_read_iop_as_array (agent, name, IGS_OUTPUT_T, array_type, values, count);
+}
+
+igs_result_t igsagent_parameter_array (igsagent_t *agent,
+                                        const char *name,
+                                        igs_iop_value_type_t array_type,
+                                        void **values,
+                                        size_t *count)
+{
+    return s_model_read_iop_as_array (agent, name, IGS_PARAMETER_T, array_type, values, count);
+}
+
 // --------------------------------  WRITE
 // ------------------------------------//
 
@@ -1322,16 +2513,51 @@ igs_result_t igsagent_input_set_data (igsagent_t *agent,
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
+igs_result_t igsagent_input_set_array (igsagent_t *agent,
+                                        const char *name,
+                                        igs_iop_value_type_t array_type,
+                                        const void *values,
+                                        size_t count)
+{
+    assert (agent);
+    assert (name);
+    if (!model_is_array_type (array_type)) {
+        igsagent_error (agent, "%d is not an array value type", array_type);
+        return IGS_FAILURE;
+    }
+    const igs_iop_t *iop = model_write_iop (agent, name, IGS_INPUT_T, array_type, (void *) values,
+                                            count * model_array_element_size (array_type));
+    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+}
+
+// writes an output and publishes it unless its publication filter
+// suppresses the new value
+static igs_result_t s_model_write_output (igsagent_t *agent, const char *name,
+                                          igs_iop_value_type_t value_type,
+                                          void *value, size_t size,
+                                          igs_data_buffer_t *buffer)
+{
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (!iop) {
+        igsagent_error (agent, "%s not found for writing", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    bool publish = true;
+    const igs_iop_t *written = model_write_resolved_iop (agent, iop, IGS_OUTPUT_T, value_type,
+                                                         value, size, buffer, &publish);
+    if (written && publish)
+        network_publish_output (agent, written);
+    return (written == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+}
+
 igs_result_t
 igsagent_output_set_bool (igsagent_t *agent, const char *name, bool value)
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_BOOL_T, &value, sizeof (bool));
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_BOOL_T, &value, sizeof (bool), NULL);
 }
 
 igs_result_t
@@ -1339,11 +2565,7 @@ igsagent_output_set_int (igsagent_t *agent, const char *name, int value)
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_INTEGER_T, &value, sizeof (int));
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_INTEGER_T, &value, sizeof (int), NULL);
 }
 
 igs_result_t
@@ -1351,11 +2573,7 @@ igsagent_output_set_double (igsagent_t *agent, const char *name, double value)
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_DOUBLE_T, &value, sizeof (double));
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_DOUBLE_T, &value, sizeof (double), NULL);
 }
 
 igs_result_t igsagent_output_set_string (igsagent_t *agent,
@@ -1365,11 +2583,7 @@ igs_result_t igsagent_output_set_string (igsagent_t *agent,
     assert (agent);
     assert (name);
     size_t length = (value == NULL) ? 0 : strlen (value) + 1;
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_STRING_T, (char *) value, length);
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_STRING_T, (char *) value, length, NULL);
 }
 
 igs_result_t igsagent_output_set_impulsion (igsagent_t *agent,
@@ -1377,10 +2591,7 @@ igs_result_t igsagent_output_set_impulsion (igsagent_t *agent,
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_IMPULSION_T, NULL, 0);
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_IMPULSION_T, NULL, 0, NULL);
 }
 
 igs_result_t igsagent_output_set_data (igsagent_t *agent,
@@ -1390,10 +2601,39 @@ igs_result_t igsagent_output_set_data (igsagent_t *agent,
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_DATA_T, value, size);
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_DATA_T, value, size, NULL);
+}
+
+igs_result_t igsagent_output_set_array (igsagent_t *agent,
+                                         const char *name,
+                                         igs_iop_value_type_t array_type,
+                                         const void *values,
+                                         size_t count)
+{
+    assert (agent);
+    assert (name);
+    if (!model_is_array_type (array_type)) {
+        igsagent_error (agent, "%d is not an array value type", array_type);
+        return IGS_FAILURE;
+    }
+    return s_model_write_output (agent, name, array_type, (void *) values,
+                                 count * model_array_element_size (array_type), NULL);
+}
+
+igs_result_t igsagent_output_set_data_owned (igsagent_t *agent,
+                                             const char *name,
+                                             void *value,
+                                             size_t size,
+                                             igs_data_free_fn free_fn)
+{
+    assert (agent);
+    assert (name);
+    // ownership of value is transferred even if writing fails
+    igs_data_buffer_t *buffer = model_data_buffer_new (value, size, free_fn);
+    igs_result_t result = s_model_write_output (agent, name, IGS_DATA_T,
+                                                buffer->data, buffer->size, buffer);
+    model_data_buffer_release (&buffer);
+    return result;
 }
 
 igs_result_t
@@ -1404,13 +2644,345 @@ igsagent_output_set_zmsg (igsagent_t *agent, const char *name, zmsg_t *msg)
     assert (msg);
     zframe_t *frame = zmsg_encode (msg);
     assert(frame);
-    void *value = zframe_data (frame);
-    size_t size = zframe_size (frame);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_DATA_T, value, size);
+    // the encoded frame becomes the output value without further copy
+    igs_data_buffer_t *buffer = model_data_buffer_from_frame (&frame);
+    igs_result_t result = s_model_write_output (agent, name, IGS_DATA_T,
+                                                buffer->data, buffer->size, buffer);
+    model_data_buffer_release (&buffer);
+    return result;
+}
+
+static igs_iop_t *s_model_resolve_output_handle (igsagent_output_handle_t *handle)
+{
+    // model lock must be held
+    igsagent_t *agent = handle->agent;
+    if (handle->definition_generation != agent->definition_generation) {
+        // outputs may have been added or freed since last resolution
+        handle->iop = NULL;
+        if (agent->definition)
+            HASH_FIND_STR (agent->definition->outputs_table, handle->name, handle->iop);
+        handle->definition_generation = agent->definition_generation;
+    }
+    return handle->iop;
+}
+
+static igs_result_t s_model_write_output_handle (igsagent_output_handle_t *handle,
+                                                 igs_iop_value_type_t value_type,
+                                                 void *value, size_t size)
+{
+    assert (handle);
+    igsagent_t *agent = handle->agent;
+    model_read_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    igs_iop_t *iop = s_model_resolve_output_handle (handle);
+    if (!iop) {
+        igsagent_error (agent, "%s not found for writing", handle->name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    bool publish = true;
+    const igs_iop_t *written = model_write_resolved_iop (agent, iop, IGS_OUTPUT_T,
+                                                         value_type, value, size, NULL, &publish);
+    if (written && publish)
+        network_publish_output_with_topic (agent, written, handle->topic);
+    return (written == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+}
+
+igsagent_output_handle_t *igsagent_output_handle_new (igsagent_t *agent,
+                                                      const char *name)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return NULL;
+    }
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (!iop) {
+        igsagent_error (agent, "The output %s could not be found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return NULL;
+    }
+    igsagent_output_handle_t *handle = (igsagent_output_handle_t *) zmalloc (sizeof (igsagent_output_handle_t));
+    handle->agent = agent;
+    handle->name = strdup (iop->name);
+    size_t topic_length = strlen (agent->uuid) + strlen (iop->name) + 2;
+    handle->topic = (char *) zmalloc (topic_length);
+    snprintf (handle->topic, topic_length, "%s-%s", agent->uuid, iop->name);
+    handle->iop = iop;
+    handle->definition_generation = agent->definition_generation;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return handle;
+}
+
+void igsagent_output_handle_destroy (igsagent_output_handle_t **handle)
+{
+    assert (handle);
+    if (*handle) {
+        free ((*handle)->name);
+        free ((*handle)->topic);
+        free (*handle);
+        *handle = NULL;
+    }
+}
+
+igs_result_t igsagent_output_handle_set_bool (igsagent_output_handle_t *handle,
+                                              bool value)
+{
+    return s_model_write_output_handle (handle, IGS_BOOL_T, &value, sizeof (bool));
+}
+
+igs_result_t igsagent_output_handle_set_int (igsagent_output_handle_t *handle,
+                                             int value)
+{
+    return s_model_write_output_handle (handle, IGS_INTEGER_T, &value, sizeof (int));
+}
+
+igs_result_t igsagent_output_handle_set_double (igsagent_output_handle_t *handle,
+                                                double value)
+{
+    return s_model_write_output_handle (handle, IGS_DOUBLE_T, &value, sizeof (double));
+}
+
+igs_result_t igsagent_output_handle_set_string (igsagent_output_handle_t *handle,
+                                                const char *value)
+{
+    size_t length = (value == NULL) ? 0 : strlen (value) + 1;
+    return s_model_write_output_handle (handle, IGS_STRING_T, (char *) value, length);
+}
+
+igs_result_t igsagent_output_handle_set_impulsion (igsagent_output_handle_t *handle)
+{
+    return s_model_write_output_handle (handle, IGS_IMPULSION_T, NULL, 0);
+}
+
+igs_result_t igsagent_output_handle_set_data (igsagent_output_handle_t *handle,
+                                              void *value,
+                                              size_t size)
+{
+    return s_model_write_output_handle (handle, IGS_DATA_T, value, size);
+}
+
+igsagent_read_handle_t *igsagent_read_handle_new (igsagent_t *agent,
+                                                  const char *name,
+                                                  igs_iop_type_t type)
+{
+    assert (agent);
+    assert (name);
+    model_read_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return NULL;
+    }
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (!iop) {
+        igsagent_error (agent, "%s could not be found", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return NULL;
+    }
+    igsagent_read_handle_t *handle = (igsagent_read_handle_t *) zmalloc (sizeof (igsagent_read_handle_t));
+    handle->agent = agent;
+    handle->name = strdup (iop->name);
+    handle->type = type;
+    handle->snapshot = model_iop_snapshot_retain (model_iop_snapshot (agent, iop));
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return handle;
+}
+
+void igsagent_read_handle_destroy (igsagent_read_handle_t **handle)
+{
+    assert (handle);
+    if (*handle) {
+        model_iop_snapshot_release (&(*handle)->snapshot);
+        free ((*handle)->name);
+        free (*handle);
+        *handle = NULL;
+    }
+}
+
+// copies the snapshot value of a handle, returns false when the value must
+// be read by name because the iop has been removed or is not a scalar
+static bool s_model_read_handle_snapshot (igsagent_read_handle_t *handle,
+                                          igs_iop_t *copy)
+{
+    assert (handle);
+    copy->name = handle->name;
+    if (handle->snapshot
+        && model_read_iop_snapshot (handle->snapshot, copy) == IGS_SUCCESS)
+        return s_model_is_snapshot_type (copy->value_type);
+
+    // our iop has been removed : look for an iop with the same name
+    model_iop_snapshot_release (&handle->snapshot);
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = NULL;
+    if (handle->agent->uuid)
+        iop = model_find_iop_by_name (handle->agent, handle->name, handle->type);
     if (iop)
-        network_publish_output (agent, iop);
-    zframe_destroy (&frame);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+        handle->snapshot = model_iop_snapshot_retain (model_iop_snapshot (handle->agent, iop));
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return handle->snapshot
+           && model_read_iop_snapshot (handle->snapshot, copy) == IGS_SUCCESS
+           && s_model_is_snapshot_type (copy->value_type);
+}
+
+bool igsagent_read_handle_bool (igsagent_read_handle_t *handle)
+{
+    igs_iop_t copy = {0};
+    if (s_model_read_handle_snapshot (handle, &copy))
+        return s_model_iop_as_bool (handle->agent, &copy);
+    return s_model_read_iop_as_bool (handle->agent, handle->name, handle->type);
+}
+
+int igsagent_read_handle_int (igsagent_read_handle_t *handle)
+{
+    igs_iop_t copy = {0};
+    if (s_model_read_handle_snapshot (handle, &copy))
+        return s_model_iop_as_int (handle->agent, &copy);
+    return s_model_read_iop_as_int (handle->agent, handle->name, handle->type);
+}
+
+double igsagent_read_handle_double (igsagent_read_handle_t *handle)
+{
+    igs_iop_t copy = {0};
+    if (s_model_read_handle_snapshot (handle, &copy))
+        return s_model_iop_as_double (handle->agent, &copy);
+    return s_model_read_iop_as_double (handle->agent, handle->name, handle->type);
+}
+
+/*
+ Pins are the data buffers holding the values of string, data and array
+ iops. Values that are not held by a buffer yet are adopted by a new one
+ on their first pin. Writers release the buffer of the previous value
+ instead of freeing it, so that pinned values stay valid until unpinned.
+ */
+static igs_result_t s_model_pin_iop (igsagent_t *agent, const char *name,
+                                     igs_iop_type_t type, const void **value,
+                                     size_t *size, igs_value_pin_t **pin)
+{
+    assert (agent);
+    assert (name);
+    assert (value);
+    assert (size);
+    assert (pin);
+    *value = NULL;
+    *size = 0;
+    *pin = NULL;
+    model_read_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent->uuid) {
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    if (iop->value_type != IGS_STRING_T && iop->value_type != IGS_DATA_T
+        && !model_is_array_type (iop->value_type)) {
+        igsagent_error (agent, "%s is not a string, data or array IOP and cannot be pinned", name);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    igs_data_buffer_t *buffer = NULL;
+    model_agent_read_lock (agent);
+    if (iop->data_buffer)
+        buffer = model_data_buffer_retain (iop->data_buffer);
+    model_agent_read_unlock (agent);
+    if (!buffer) {
+        model_agent_write_lock (agent);
+        if (!iop->data_buffer && iop->value.data) {
+            size_t value_size = (iop->value_type == IGS_STRING_T)
+                                  ? strlen (iop->value.s) + 1 : iop->value_size;
+            iop->data_buffer = model_data_buffer_new (iop->value.data, value_size, NULL);
+        }
+        if (iop->data_buffer)
+            buffer = model_data_buffer_retain (iop->data_buffer);
+        model_agent_write_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    if (buffer) {
+        *value = buffer->data;
+        *size = buffer->size;
+        *pin = (igs_value_pin_t *) buffer;
+    }
+    return IGS_SUCCESS;
+}
+
+igs_result_t igsagent_input_pin (igsagent_t *agent, const char *name,
+                                 const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    return s_model_pin_iop (agent, name, IGS_INPUT_T, value, size, pin);
+}
+
+igs_result_t igsagent_output_pin (igsagent_t *agent, const char *name,
+                                  const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    return s_model_pin_iop (agent, name, IGS_OUTPUT_T, value, size, pin);
+}
+
+igs_result_t igsagent_parameter_pin (igsagent_t *agent, const char *name,
+                                     const void **value, size_t *size, igs_value_pin_t **pin)
+{
+    return s_model_pin_iop (agent, name, IGS_PARAMETER_T, value, size, pin);
+}
+
+void igsagent_value_unpin (igs_value_pin_t **pin)
+{
+    assert (pin);
+    igs_data_buffer_t *buffer = (igs_data_buffer_t *) *pin;
+    model_data_buffer_release (&buffer);
+    *pin = NULL;
+}
+
+igs_result_t igsagent_output_batch_begin (igsagent_t *agent)
+{
+    assert (agent);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    if (agent->batch_in_progress) {
+        igsagent_error (agent, "an output batch is already in progress");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    agent->batch_in_progress = true;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_result_t igsagent_output_batch_commit (igsagent_t *agent)
+{
+    assert (agent);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    if (!agent->batch_in_progress) {
+        igsagent_error (agent, "no output batch in progress");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    agent->batch_in_progress = false;
+    igs_batched_output_t *outputs = agent->batched_outputs;
+    agent->batched_outputs = NULL;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    if (!outputs)
+        return IGS_SUCCESS;
+    return network_publish_output_batch (agent, &outputs);
 }
 
 igs_result_t
@@ -1468,6 +3040,23 @@ igs_result_t igsagent_parameter_set_data (igsagent_t *agent,
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
+igs_result_t igsagent_parameter_set_array (igsagent_t *agent,
+                                            const char *name,
+                                            igs_iop_value_type_t array_type,
+                                            const void *values,
+                                            size_t count)
+{
+    assert (agent);
+    assert (name);
+    if (!model_is_array_type (array_type)) {
+        igsagent_error (agent, "%d is not an array value type", array_type);
+        return IGS_FAILURE;
+    }
+    const igs_iop_t *iop = model_write_iop (agent, name, IGS_PARAMETER_T, array_type, (void *) values,
+                                            count * model_array_element_size (array_type));
+    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+}
+
 igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
                                            const char *expression,char **error){
     assert(expression);
@@ -1548,6 +3137,8 @@ igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
         *error = strdup(error_msg);
     }
     zrex_destroy(&rex);
+    if (c)
+        c->value_type = type;
     return c;
 }
 
@@ -1559,10 +3150,17 @@ igs_result_t s_model_add_constraint (igsagent_t *self, igs_iop_type_t type,
     assert(name);
     assert(constraint);
     igs_iop_t *iop = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!self || !(self->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (type == IGS_INPUT_T) {
         HASH_FIND_STR (self->definition->inputs_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Input %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return IGS_FAILURE;
         }
     }
@@ -1571,6 +3169,7 @@ igs_result_t s_model_add_constraint (igsagent_t *self, igs_iop_type_t type,
         HASH_FIND_STR (self->definition->outputs_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Output %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return IGS_FAILURE;
         }
     }
@@ -1579,11 +3178,13 @@ igs_result_t s_model_add_constraint (igsagent_t *self, igs_iop_type_t type,
         HASH_FIND_STR (self->definition->params_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Parameter %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return IGS_FAILURE;
         }
     }
     else {
         igsagent_error (self, "Unknown IOP type %d", type);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (iop->constraint){
@@ -1597,8 +3198,12 @@ igs_result_t s_model_add_constraint (igsagent_t *self, igs_iop_type_t type,
             igsagent_error (self, "%s", error);
             free(error);
         }
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
+    definition_touch_iop (self, type, iop->name);
+    network_schedule_definition_update (self);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -1610,10 +3215,17 @@ void s_model_set_description(igsagent_t *self, igs_iop_type_t type,
     assert(name);
     assert(description);
     igs_iop_t *iop = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!self || !(self->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return;
+    }
     if (type == IGS_INPUT_T) {
         HASH_FIND_STR (self->definition->inputs_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Input %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return;
         }
     }
@@ -1622,6 +3234,7 @@ void s_model_set_description(igsagent_t *self, igs_iop_type_t type,
         HASH_FIND_STR (self->definition->outputs_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Output %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return;
         }
     }
@@ -1630,16 +3243,21 @@ void s_model_set_description(igsagent_t *self, igs_iop_type_t type,
         HASH_FIND_STR (self->definition->params_table, name, iop);
         if (!iop) {
             igsagent_error (self, "Parameter %s cannot be found", name);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             return;
         }
     }
     else {
         igsagent_error (self, "Unknown IOP type %d", type);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return;
     }
     if (iop->description)
         free(iop->description);
     iop->description = s_strndup(description, IGS_MAX_LOG_LENGTH);
+    definition_touch_iop (self, type, iop->name);
+    network_schedule_definition_update (self);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
 void igsagent_constraints_enforce(igsagent_t *self, bool enforce)
@@ -2028,3 +3646,484 @@ bool igsagent_output_is_muted (igsagent_t *agent, const char *name)
     }
     return iop->is_muted;
 }
+
+// ------------------------  PUBLICATION POLICIES ----------------------------//
+
+igs_result_t s_model_set_min_interval (igsagent_t *agent, const char *name, int64_t interval)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    iop->publication_min_interval = interval;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_result_t igsagent_output_set_max_rate (igsagent_t *agent, const char *name, double rate)
+{
+    if (rate < 0) {
+        igsagent_error (agent, "max rate must be zero or higher");
+        return IGS_FAILURE;
+    }
+    return s_model_set_min_interval (agent, name, (rate > 0) ? (int64_t) (1000000 / rate) : 0);
+}
+
+igs_result_t igsagent_output_set_min_interval (igsagent_t *agent, const char *name, unsigned int interval)
+{
+    return s_model_set_min_interval (agent, name, (int64_t) interval * 1000);
+}
+
+double igsagent_output_max_rate (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    double rate = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else if (iop->publication_min_interval > 0)
+        rate = 1000000.0 / (double) iop->publication_min_interval;
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return rate;
+}
+
+igs_result_t igsagent_output_set_conflate (igsagent_t *agent, const char *name, bool conflate)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    iop->publication_conflate = conflate;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+bool igsagent_output_is_conflated (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    bool conflate = false;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else
+        conflate = iop->publication_conflate;
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return conflate;
+}
+
+void igsagent_output_publication_stats (igsagent_t *agent, const char *name,
+                                        size_t *suppressed, size_t *flushed)
+{
+    assert (agent);
+    assert (name);
+    if (suppressed)
+        *suppressed = 0;
+    if (flushed)
+        *flushed = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else {
+        model_agent_read_lock (agent);
+        if (suppressed)
+            *suppressed = iop->suppressed_publications_nb;
+        if (flushed)
+            *flushed = iop->flushed_publications_nb;
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+}
+
+igs_result_t igsagent_output_set_publication_filter (igsagent_t *agent, const char *name,
+                                                     igs_publication_filter_t filter, double deadband)
+{
+    assert (agent);
+    assert (name);
+    if (deadband < 0) {
+        igsagent_error (agent, "dead-band must be zero or higher");
+        return IGS_FAILURE;
+    }
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    if (filter != IGS_PUBLICATION_FILTER_NONE && iop->value_type == IGS_IMPULSION_T) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "impulsion output '%s' cannot be filtered", name);
+        return IGS_FAILURE;
+    }
+    if ((filter == IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE
+         || filter == IGS_PUBLICATION_FILTER_DEADBAND_RELATIVE)
+        && iop->value_type != IGS_INTEGER_T && iop->value_type != IGS_DOUBLE_T) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "dead-bands require integer or double outputs ('%s')", name);
+        return IGS_FAILURE;
+    }
+    iop->publication_filter = filter;
+    iop->publication_deadband = deadband;
+    iop->has_publication_reference = false;
+    if (iop->publication_reference_buffer)
+        model_data_buffer_release (&iop->publication_reference_buffer);
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_publication_filter_t igsagent_output_publication_filter (igsagent_t *agent, const char *name,
+                                                             double *deadband)
+{
+    assert (agent);
+    assert (name);
+    igs_publication_filter_t filter = IGS_PUBLICATION_FILTER_NONE;
+    if (deadband)
+        *deadband = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else {
+        filter = iop->publication_filter;
+        if (deadband)
+            *deadband = iop->publication_deadband;
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return filter;
+}
+
+igs_result_t igsagent_output_set_refresh_interval (igsagent_t *agent, const char *name,
+                                                   unsigned int interval)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    iop->publication_refresh_interval = (int64_t) interval * 1000;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+size_t igsagent_output_filtered_publications (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    size_t filtered = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else {
+        model_agent_read_lock (agent);
+        filtered = iop->filtered_publications_nb;
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return filtered;
+}
+
+igs_result_t igsagent_output_set_delta_encoding (igsagent_t *agent, const char *name,
+                                                 unsigned int keyframe_interval)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    if (keyframe_interval > 0 && iop->value_type != IGS_DATA_T) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "delta encoding requires a data output ('%s')", name);
+        return IGS_FAILURE;
+    }
+    iop->delta_keyframe_interval = keyframe_interval;
+    // next publication is a keyframe
+    if (iop->delta_reference)
+        model_data_buffer_release (&iop->delta_reference);
+    iop->deltas_since_keyframe = 0;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+unsigned int igsagent_output_delta_encoding (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    unsigned int keyframe_interval = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else
+        keyframe_interval = iop->delta_keyframe_interval;
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return keyframe_interval;
+}
+
+void igsagent_output_delta_stats (igsagent_t *agent, const char *name,
+                                  size_t *keyframes, size_t *deltas)
+{
+    assert (agent);
+    assert (name);
+    if (keyframes)
+        *keyframes = 0;
+    if (deltas)
+        *deltas = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else {
+        model_agent_read_lock (agent);
+        if (keyframes)
+            *keyframes = iop->published_keyframes_nb;
+        if (deltas)
+            *deltas = iop->published_deltas_nb;
+        model_agent_read_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+}
+
+igs_result_t igsagent_output_set_codec (igsagent_t *agent, const char *name,
+                                        igs_codec_t codec, size_t threshold)
+{
+    assert (agent);
+    assert (name);
+    if (codec != IGS_CODEC_NONE && codec != IGS_CODEC_LZ) {
+        igsagent_error (agent, "unknown codec %d", codec);
+        return IGS_FAILURE;
+    }
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    if (codec != IGS_CODEC_NONE && iop->value_type != IGS_DATA_T) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "compression requires a data output ('%s')", name);
+        return IGS_FAILURE;
+    }
+    iop->codec = codec;
+    iop->codec_threshold = threshold;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_codec_t igsagent_output_codec (igsagent_t *agent, const char *name, size_t *threshold)
+{
+    assert (agent);
+    assert (name);
+    igs_codec_t codec = IGS_CODEC_NONE;
+    if (threshold)
+        *threshold = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else {
+        codec = iop->codec;
+        if (threshold)
+            *threshold = iop->codec_threshold;
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return codec;
+}
+
+igs_result_t igsagent_output_set_chunk_size (igsagent_t *agent, const char *name, size_t chunk_size)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    if (chunk_size > 0 && iop->value_type != IGS_DATA_T) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "chunks require a data output ('%s')", name);
+        return IGS_FAILURE;
+    }
+    iop->chunk_size = chunk_size;
+    definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+size_t igsagent_output_chunk_size (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    size_t chunk_size = 0;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else
+        chunk_size = iop->chunk_size;
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return chunk_size;
+}
+
+igs_result_t igsagent_output_set_priority (igsagent_t *agent, const char *name, igs_output_priority_t priority)
+{
+    assert (agent);
+    assert (name);
+    if (priority < IGS_PRIORITY_NORMAL || priority >= IGS_OUTPUT_PRIORITIES_NB) {
+        igsagent_error (agent, "priority %d is not valid", priority);
+        return IGS_FAILURE;
+    }
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igsagent_error (agent, "Output '%s' not found", name);
+        return IGS_FAILURE;
+    }
+    if (iop->priority != priority) {
+        iop->priority = priority;
+        // subscribers need to move to the publisher of the new class
+        definition_touch_iop (agent, IGS_OUTPUT_T, iop->name);
+        network_schedule_definition_update (agent);
+    }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_output_priority_t igsagent_output_priority (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    igs_output_priority_t priority = IGS_PRIORITY_NORMAL;
+    model_read_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL)
+        igsagent_warn (agent, "Output '%s' not found", name);
+    else
+        priority = iop->priority;
+    model_read_unlock (__FUNCTION__, __LINE__);
+    return priority;
+}
+
+////////////////////////////////////////////////////////////////////////
+// SELFTEST
+////////////////////////////////////////////////////////////////////////
+
+void
+igs_model_test (bool verbose)
+{
+    IGS_UNUSED(verbose)
+    printf (" * igs_model: ");
+
+    //  @selftest
+    igsagent_t *agent = igsagent_new ("selftest_model", false);
+
+    //  Conversion table of iop writers, from each value type into each iop type
+    int written_int = 3;
+    double written_double = 3.7;
+    bool written_bool = true;
+    char written_string[] = "12";
+    uint8_t written_data[] = {0x12, 0x34};
+    uint8_t written_string_bytes[] = {0x12};
+    igs_iop_value_type_t written_types[] = {IGS_INTEGER_T, IGS_DOUBLE_T, IGS_BOOL_T,
+                                            IGS_STRING_T, IGS_IMPULSION_T, IGS_DATA_T};
+    void *written_values[] = {&written_int, &written_double, &written_bool,
+                              written_string, NULL, written_data};
+    size_t written_sizes[] = {sizeof (int), sizeof (double), sizeof (bool),
+                              sizeof (written_string), 0, sizeof (written_data)};
+    // expected values by written type
+    int expected_ints[] = {3, 3, 1, 12, 0};
+    double expected_doubles[] = {3, 3.7, 1, 12, 0};
+    bool expected_bools[] = {true, true, true, true, false};
+    const char *expected_strings[] = {"3", "3.700000", "1", "12", ""};
+    void *expected_data[] = {&written_int, &written_double, &written_bool,
+                             written_string_bytes, NULL, written_data};
+    size_t expected_data_sizes[] = {sizeof (int), sizeof (double), sizeof (bool),
+                                    sizeof (written_string_bytes), 0, sizeof (written_data)};
+    size_t types_nb = sizeof (written_types) / sizeof (written_types[0]);
+    for (size_t i = 0; i < types_nb; i++) {
+        for (size_t j = 0; j < types_nb; j++) {
+            igs_iop_t *converted = (igs_iop_t *) zmalloc (sizeof (igs_iop_t));
+            converted->name = (char *) "converted";
+            converted->value_type = written_types[j];
+            igs_iop_writer_fn *writer = model_iop_writer (written_types[i], written_types[j]);
+            assert (writer);
+            void *converted_value = NULL;
+            size_t converted_size = 0;
+            int written = writer (agent, converted, written_types[i], written_values[i],
+                                  written_sizes[i], NULL, &converted_value, &converted_size);
+            if (written_types[i] == IGS_DATA_T && written_types[j] != IGS_IMPULSION_T
+                && written_types[j] != IGS_DATA_T) {
+                assert (written == 0); // data is refused by scalar iops
+                free (converted);
+                continue;
+            }
+            assert (written == 1);
+            switch (written_types[j]) {
+                case IGS_INTEGER_T:
+                    assert (converted->value.i == expected_ints[i] && converted_size == sizeof (int));
+                    break;
+                case IGS_DOUBLE_T:
+                    assert (fabs (converted->value.d - expected_doubles[i]) < 0.000001);
+                    assert (converted_size == sizeof (double));
+                    break;
+                case IGS_BOOL_T:
+                    assert (converted->value.b == expected_bools[i] && converted_size == sizeof (bool));
+                    break;
+                case IGS_STRING_T:
+                    assert (streq (converted->value.s, expected_strings[i]));
+                    assert (converted_size == strlen (expected_strings[i]) + 1);
+                    break;
+                case IGS_IMPULSION_T:
+                    assert (converted->value_size == 0);
+                    break;
+                case IGS_DATA_T:
+                    assert (converted->value_size == expected_data_sizes[i]);
+                    assert (expected_data_sizes[i] == 0
+                            || memcmp (converted->value.data, expected_data[i], expected_data_sizes[i]) == 0);
+                    break;
+                default:
+                    break;
+            }
+            if (written_types[j] == IGS_STRING_T || written_types[j] == IGS_DATA_T)
+                model_release_iop_data (converted);
+            free (converted);
+        }
+    }
+
+    igsagent_destroy (&agent);
+    //  @end
+    printf ("OK\n");
+}
@@ -34,7 +34,16 @@
 #include <sys/resource.h>
 #endif
 
+#if defined(__UNIX__) && !defined(__UTYPE_IOS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define IGS_SHARED_MEMORY_ENABLED 1
+#endif
+
 #include "ingescape.h"
+#include "ingescape_classes.h"
 #include "ingescape_private.h"
 #include "uthash/uthash.h"
 #include "uthash/utlist.h"
@@ -76,6 +85,49 @@ PIP_ADAPTER_UNICAST_ADDRESS p_unicast = NULL;
 #define W_OK 02
 #endif
 
+// zyre headers giving the ports of our TCP publishers of priority classes
+static const char *s_network_priority_headers[IGS_OUTPUT_PRIORITIES_NB] = {
+    "publisher", "publisher_control", "publisher_bulk"};
+
+// returns the version number from a 'vX' protocol header, 0 if unknown
+int s_network_protocol_version (const char *protocol)
+{
+    if (protocol && protocol[0] == 'v')
+        return atoi (protocol + 1);
+    return 0;
+}
+
+// stores the protocol header of a new zyre peer, NULL if it sent none,
+// and counts the peers relying on uuid-name publications : those older
+// than v5 and those not telling their protocol
+void s_network_set_peer_protocol (igs_core_context_t *context,
+                                  igs_zyre_peer_t *zyre_peer,
+                                  const char *protocol)
+{
+    if (protocol)
+        zyre_peer->protocol = s_strndup (protocol, 16);
+    if (s_network_protocol_version (zyre_peer->protocol) < IGS_COMPACT_PUBLICATIONS_PROTOCOL) {
+        zyre_peer->uses_legacy_publications = true;
+        context->legacy_publications_peers_nb++;
+    }
+}
+
+// returns true if an output is published in uuid-name form : it has no id
+// for compact publications or some peers only understand this form
+bool s_network_needs_legacy_publication (igs_core_context_t *context, uint16_t output_id)
+{
+    return !output_id || context->legacy_publications_peers_nb > 0;
+}
+
+// returns true if a zyre peer uses a protocol knowing typed arrays
+bool s_network_peer_knows_arrays (igs_core_context_t *context, const char *peer_id)
+{
+    igs_zyre_peer_t *zyre_peer = NULL;
+    HASH_FIND_STR (context->zyre_peers, peer_id, zyre_peer);
+    return zyre_peer
+           && s_network_protocol_version (zyre_peer->protocol) >= IGS_COMPACT_PUBLICATIONS_PROTOCOL;
+}
+
 // Removes filter to 'subscribe' socket for a spectific output of a given remote
 // agent
 //FIXME UNUSED
@@ -89,11 +141,10 @@ void s_unsubscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
         DL_FOREACH (remote_agent->mapping_filters, filter)
         {
             if (streq (filter->filter, output_name)) {
-                assert (remote_agent->peer->subscriber);
+                assert (filter->subscriber);
                 igs_debug ("unsubscribe to agent %s output %s",
                            remote_agent->definition->name, output_name);
-                zsock_set_unsubscribe (remote_agent->peer->subscriber,
-                                       output_name);
+                zsock_set_unsubscribe (filter->subscriber, output_name);
                 free (filter->filter);
                 DL_DELETE (remote_agent->mapping_filters, filter);
                 free (filter);
@@ -107,6 +158,108 @@ void s_unsubscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
 // ZMQ callbacks
 ////////////////////////////////////////////////////////////////////////
 
+// writes a publication to all the inputs mapped on it, model lock must be
+// held (shared or exclusive) and is kept. Observe callbacks are deferred to
+// be run once the lock is released. DATA values held by a buffer are shared
+// with the inputs instead of being copied.
+void s_dispatch_publication (const char *publisher_name,
+                             const char *output,
+                             igs_iop_value_type_t value_type,
+                             void *data,
+                             size_t size,
+                             igs_data_buffer_t *buffer,
+                             int64_t timestamp,
+                             igs_deferred_observe_t **deferred)
+{
+    // Publication does not provide information about the targeted agents in our
+    // context. Our routes give us all the inputs mapped on this output for all
+    // our agents at once.
+    igs_route_t *route = mapping_find_route (publisher_name, output);
+    size_t i = 0;
+    for (i = 0; route && i < route->targets_nb; i++) {
+        igs_route_target_t *target = route->targets + i;
+        igsagent_t *agent = target->agent;
+        if (!agent->uuid || (strlen (agent->uuid) == 0)
+            || agent->context != core_context)
+            continue;
+        if (!target->input) {
+            igsagent_warn (agent,"Input %s is missing in our definition but expected in our mapping with %s.%s",
+                           target->map_elmt->from_input, target->map_elmt->to_agent, target->map_elmt->to_output);
+            continue;
+        }
+        // we have a fully matching route : write from received
+        // output to our input, using the writer chosen for this value
+        // type when the route was built
+        igs_iop_writer_fn *writer = ((unsigned) value_type < IGS_SCALAR_TYPES_NB)
+                                      ? target->writers[value_type] : NULL;
+        model_agent_write_lock (agent);
+        int written = (writer)
+                        ? model_write_iop_with (writer, agent, target->input, IGS_INPUT_T, value_type,
+                                                data, size, buffer, NULL, NULL)
+                        : model_write_iop_locked (agent, target->input, IGS_INPUT_T, value_type,
+                                                  data, size, buffer, NULL, NULL);
+        model_agent_write_unlock (agent);
+        if (written > 0)
+            model_defer_observe_callbacks (deferred, agent, target->input, timestamp);
+    }
+}
+
+/*
+ Timestamped values of uuid-name publications are bundles of the value and
+ its timestamp, encoded as by zmsg_encode : each part is preceded by its
+ size on one byte, or by 0xFF and its size on four bytes in network order.
+ Bundles are written in and read from a single frame, without building the
+ intermediate messages. Compact publications carry the timestamp in their
+ header instead.
+ */
+zframe_t *s_network_timestamped_frame (const void *data, size_t size, int64_t timestamp)
+{
+    size_t prefix_size = (size < 0xFF) ? 1 : 5;
+    zframe_t *frame = zframe_new (NULL, prefix_size + size + 1 + sizeof (int64_t));
+    byte *dest = zframe_data (frame);
+    if (size < 0xFF)
+        *dest++ = (byte) size;
+    else {
+        *dest++ = 0xFF;
+        *dest++ = (byte) ((size >> 24) & 0xFF);
+        *dest++ = (byte) ((size >> 16) & 0xFF);
+        *dest++ = (byte) ((size >> 8) & 0xFF);
+        *dest++ = (byte) (size & 0xFF);
+    }
+    if (size > 0)
+        memcpy (dest, data, size);
+    dest += size;
+    *dest++ = (byte) sizeof (int64_t);
+    memcpy (dest, &timestamp, sizeof (int64_t));
+    return frame;
+}
+
+// points data to the value of a timestamped bundle in frame, returns false
+// if the bundle is corrupted
+bool s_network_parse_timestamped_frame (zframe_t *frame, byte **data, size_t *size, int64_t *timestamp)
+{
+    byte *source = zframe_data (frame);
+    size_t remaining = zframe_size (frame);
+    if (remaining < 1)
+        return false;
+    size_t value_size = *source++;
+    remaining--;
+    if (value_size == 0xFF) {
+        if (remaining < 4)
+            return false;
+        value_size = ((size_t) source[0] << 24) | ((size_t) source[1] << 16)
+                     | ((size_t) source[2] << 8) | (size_t) source[3];
+        source += 4;
+        remaining -= 4;
+    }
+    if (remaining != value_size + 1 + sizeof (int64_t) || source[value_size] != sizeof (int64_t))
+        return false;
+    *data = source;
+    *size = value_size;
+    memcpy (timestamp, source + value_size + 1, sizeof (int64_t));
+    return true;
+}
+
 // function actually handling messages from one of the remote agents we
 // subscribed to
 void s_handle_publication (zmsg_t **msg, igs_remote_agent_t *remote_agent)
@@ -121,18 +274,22 @@ void s_handle_publication (zmsg_t **msg, igs_remote_agent_t *remote_agent)
         return;
     }
 
-    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_deferred_observe_t *deferred = NULL;
+    model_read_lock (__FUNCTION__, __LINE__);
     size_t msg_size = zmsg_size (*msg);
     char *output = NULL;
     char *v_type = NULL;
     igs_iop_value_type_t value_type = 0;
-    zframe_t *timestamp_f = NULL;
     int64_t timestamp = INT64_MIN;
     zframe_t *frame = NULL;
     void *data = NULL;
     size_t size = 0;
     char *value = NULL;
-    zmsg_t *bundle = NULL;
+    union {
+        int i;
+        double d;
+        bool b;
+    } scalar;
     size_t i = 0;
     
     for (i = 0; i < msg_size; i += 3) {
@@ -152,7 +309,8 @@ void s_handle_publication (zmsg_t **msg, igs_remote_agent_t *remote_agent)
             break;
         }
         value_type = atoi (v_type);
-        if (value_type < IGS_INTEGER_T || value_type > IGS_TIMESTAMPED_DATA_T) {
+        if ((value_type < IGS_INTEGER_T || value_type > IGS_TIMESTAMPED_DATA_T)
+            && !model_is_array_type (value_type)) {
             igs_error ("output value type is not valid (%d) in received publication : rejecting", value_type);
             free (output);
             free (v_type);
@@ -169,72 +327,33 @@ void s_handle_publication (zmsg_t **msg, igs_remote_agent_t *remote_agent)
                            remote_agent->definition->name, output);
                 break;
             }
-        } else if (value_type == IGS_TIMESTAMPED_STRING_T) {
-            bundle = zmsg_popmsg(*msg);
-            if (!bundle) {
-                igs_error ("value from %s.%s is NULL in received publication : rejecting",
-                           remote_agent->definition->name, output);
-                break;
-            }
-            size_t bundle_size = zmsg_size(bundle);
-            if (bundle_size != 2) {
+        } else if (value_type >= IGS_TIMESTAMPED_INTEGER_T
+                   && value_type <= IGS_TIMESTAMPED_DATA_T) {
+            // value and timestamp are read in place from their bundle
+            byte *bundle_data = NULL;
+            frame = zmsg_pop (*msg);
+            if (!frame
+                || !s_network_parse_timestamped_frame (frame, &bundle_data, &size, &timestamp)
+                || (value_type != IGS_TIMESTAMPED_STRING_T && value_type != IGS_TIMESTAMPED_DATA_T
+                    && value_type != IGS_TIMESTAMPED_IMPULSION_T && size > sizeof (scalar))) {
                 igs_error ("value from %s.%s is corrupted in received publication : rejecting",
                            remote_agent->definition->name, output);
-                zmsg_destroy(&bundle);
-                break;
-            }
-            value = zmsg_popstr (bundle);
-            if (!value) {
-                igs_error ("value from %s.%s is NULL in received publication : rejecting",
-                           remote_agent->definition->name, output);
-                zmsg_destroy(&bundle);
-                break;
-            }
-            timestamp_f = zmsg_pop(bundle);
-            if (!timestamp_f) {
-                igs_error ("timestamp from %s.%s is NULL in received publication : rejecting",
-                           remote_agent->definition->name, output);
-                zmsg_destroy(&bundle);
-                break;
-            }
-            timestamp = *((int64_t *)zframe_data(timestamp_f));
-            zframe_destroy(&timestamp_f);
-            zmsg_destroy(&bundle);
-            
-        } else if (value_type == IGS_TIMESTAMPED_INTEGER_T
-                   || value_type == IGS_TIMESTAMPED_DOUBLE_T
-                   || value_type == IGS_TIMESTAMPED_BOOL_T
-                   || value_type == IGS_TIMESTAMPED_IMPULSION_T
-                   || value_type == IGS_TIMESTAMPED_DATA_T){
-            bundle = zmsg_popmsg(*msg);
-            if (!bundle) {
-                igs_error ("value from %s is NULL in received publication : rejecting", output);
-                break;
-            }
-            size_t bundle_size = zmsg_size(bundle);
-            if (bundle_size != 2) {
-                igs_error ("value from %s is corrupted in received publication : rejecting", output);
-                zmsg_destroy(&bundle);
-                break;
-            }
-            frame = zmsg_pop (bundle);
-            if (!frame) {
-                igs_error ("value from %s is NULL in received publication : rejecting", output);
-                zmsg_destroy(&bundle);
+                if (frame)
+                    zframe_destroy (&frame);
+                free (output);
+                output = NULL;
                 break;
             }
-            data = zframe_data (frame);
-            size = zframe_size (frame);
-            timestamp_f = zmsg_pop(bundle);
-            if (!timestamp_f) {
-                igs_error ("timestamp from %s is NULL in received publication : rejecting", output);
-                zmsg_destroy(&bundle);
-                break;
+            if (value_type == IGS_TIMESTAMPED_STRING_T)
+                value = s_strndup ((char *) bundle_data, size);
+            else if (value_type == IGS_TIMESTAMPED_DATA_T || value_type == IGS_TIMESTAMPED_IMPULSION_T)
+                data = bundle_data;
+            else {
+                // scalars are copied to be properly aligned
+                memset (&scalar, 0, sizeof (scalar));
+                memcpy (&scalar, bundle_data, size);
+                data = &scalar;
             }
-            timestamp = *((int64_t *)zframe_data(timestamp_f));
-            zframe_destroy(&timestamp_f);
-            zmsg_destroy(&bundle);
-            
         } else {
             frame = zmsg_pop (*msg);
             if (!frame) {
@@ -249,71 +368,1035 @@ void s_handle_publication (zmsg_t **msg, igs_remote_agent_t *remote_agent)
             && value_type <= IGS_TIMESTAMPED_DATA_T)
             value_type -= IGS_DATA_T; //translate value type to non-timestamped value type
         
-        // Publication does not provide information about the targeted agents in our
-        // context. At this stage, we only know that one or more of our agents are
-        // targeted. We need to iterate through our agents and their mappings to check
-        // which inputs need to be updated on which agent.
-        igsagent_t *agent, *tmp_agent;
-        HASH_ITER (hh, remote_agent->context->agents, agent, tmp_agent){
-            if (!agent || !agent->uuid || (strlen (agent->uuid) == 0))
-                continue;
-            
-            // try to find mapping elements matching with this subscriber's output
-            // and update mapped input(s) value accordingly
-            // TODO : optimize mapping storage to avoid iterating
-            igs_map_t *elmt, *tmp;
-            // check that this agent has not been destroyed when we were locked
-            if (agent->mapping) {
-                HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp){
-                    if (streq (elmt->to_agent, remote_agent->definition->name)
-                        && streq (elmt->to_output, output)) {
-                        // we have a match on emitting agent name and its ouput name :
-                        // still need to check the targeted input existence in our
-                        // definition
-                        igs_iop_t *found_input = NULL;
-                        if (agent->definition->inputs_table)
-                            HASH_FIND_STR (agent->definition->inputs_table,
-                                           elmt->from_input, found_input);
-                        if (!found_input)
-                            igsagent_warn (agent,"Input %s is missing in our definition but expected in our mapping with %s.%s",
-                                           elmt->from_input, elmt->to_agent, elmt->to_output);
-                        else {
-                            // we have a fully matching mapping element : write from received
-                            // output to our input
-                            agent->rt_current_timestamp_microseconds = timestamp;
-                            if (value_type == IGS_STRING_T) {
-                                model_read_write_unlock (__FUNCTION__, __LINE__);
-                                model_write_iop (agent, elmt->from_input,
-                                                 IGS_INPUT_T, value_type, value,
-                                                 strlen (value) + 1);
-                                model_read_write_lock (__FUNCTION__, __LINE__);
-                                
-                            }
-                            else {
-                                model_read_write_unlock (__FUNCTION__, __LINE__);
-                                model_write_iop (agent, elmt->from_input,
-                                                 IGS_INPUT_T, value_type, data,
-                                                 size);
-                                model_read_write_lock (__FUNCTION__, __LINE__);
-                            }
-                            if (!agent->uuid)
-                                break;
-                            else
-                                agent->rt_current_timestamp_microseconds = INT64_MIN;
-                        }
-                    }
-                }
-            }
-        }
+        if (value_type == IGS_STRING_T)
+            s_dispatch_publication (remote_agent->definition->name, output, value_type,
+                                    value, strlen (value) + 1, NULL, timestamp, &deferred);
+        else
+            s_dispatch_publication (remote_agent->definition->name, output, value_type,
+                                    data, size, NULL, timestamp, &deferred);
         if (frame)
             zframe_destroy (&frame);
-        if (value)
+        if (value) {
             free (value);
+            value = NULL;
+        }
         free (output);
         output = NULL;
     }
     zmsg_destroy (msg);
+    model_read_unlock (__FUNCTION__, __LINE__);
+    model_run_deferred_observe_callbacks (&deferred);
+}
+
+/*
+ Delta encoding of data outputs : a delta is the XOR of a value with the
+ previous one, where runs of unchanged bytes are skipped. Each run of
+ changed bytes is preceded by the varint lengths of the skipped run and of
+ the changed run. Unchanged bytes at the end of the value are implicit.
+ */
+#define IGS_DELTA_MIN_SKIPPED_RUN 4
+#define IGS_DELTA_MAX_VARINT_LENGTH 10
+#define IGS_DELTA_KEYFRAME_REQUEST_INTERVAL 1000 //milliseconds
+
+static size_t s_network_put_varint (byte *buffer, uint64_t value)
+{
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (byte) (value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (byte) value;
+    return length;
+}
+
+static bool s_network_get_varint (const byte *buffer, size_t size, size_t *offset, uint64_t *value)
+{
+    *value = 0;
+    for (unsigned int shift = 0; shift < 64 && *offset < size; shift += 7) {
+        byte b = buffer[(*offset)++];
+        *value |= (uint64_t) (b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// returns the delta between two values of the same size, or NULL if it
+// would not be smaller than the value itself
+byte *s_network_xor_delta (const byte *previous, const byte *value, size_t size, size_t *delta_size)
+{
+    byte *delta = (byte *) malloc (size + 2 * IGS_DELTA_MAX_VARINT_LENGTH);
+    size_t offset = 0;
+    size_t position = 0;
+    while (position < size) {
+        size_t start = position;
+        while (start < size && previous[start] == value[start])
+            start++;
+        if (start == size)
+            break;
+        // changed runs absorb unchanged runs too short to be worth skipping
+        size_t end = start;
+        while (end < size) {
+            if (previous[end] != value[end]) {
+                end++;
+                continue;
+            }
+            size_t unchanged = 0;
+            while (end + unchanged < size && unchanged < IGS_DELTA_MIN_SKIPPED_RUN
+                   && previous[end + unchanged] == value[end + unchanged])
+                unchanged++;
+            if (unchanged == IGS_DELTA_MIN_SKIPPED_RUN || end + unchanged == size)
+                break;
+            end += unchanged;
+        }
+        if (offset + 2 * IGS_DELTA_MAX_VARINT_LENGTH + (end - start) >= size) {
+            free (delta);
+            return NULL;
+        }
+        offset += s_network_put_varint (delta + offset, start - position);
+        offset += s_network_put_varint (delta + offset, end - start);
+        for (size_t i = start; i < end; i++)
+            delta[offset++] = previous[i] ^ value[i];
+        position = end;
+    }
+    *delta_size = offset;
+    return delta;
+}
+
+// rebuilds a value from the previous one and a delta, returns NULL if the
+// delta is corrupted
+byte *s_network_apply_xor_delta (const byte *previous, size_t size,
+                                 const byte *delta, size_t delta_size)
+{
+    byte *value = (byte *) malloc ((size) ? size : 1);
+    if (size)
+        memcpy (value, previous, size);
+    size_t offset = 0;
+    size_t position = 0;
+    while (offset < delta_size) {
+        uint64_t unchanged = 0;
+        uint64_t changed = 0;
+        if (!s_network_get_varint (delta, delta_size, &offset, &unchanged)
+            || !s_network_get_varint (delta, delta_size, &offset, &changed)
+            || unchanged > size - position
+            || changed > size - position - unchanged
+            || changed > delta_size - offset) {
+            free (value);
+            return NULL;
+        }
+        position += unchanged;
+        for (size_t i = 0; i < changed; i++)
+            value[position + i] ^= delta[offset + i];
+        position += changed;
+        offset += changed;
+    }
+    return value;
+}
+
+void s_network_free_chunked_value (igs_chunked_value_t **chunked)
+{
+    igs_chunk_range_t *range, *tmp;
+    DL_FOREACH_SAFE ((*chunked)->ranges, range, tmp) {
+        DL_DELETE ((*chunked)->ranges, range);
+        free (range);
+    }
+    free ((*chunked)->data);
+    free (*chunked);
+    *chunked = NULL;
+}
+
+// discards or completes the value being reassembled for a remote output,
+// the expiry timer is cancelled with the last of these values
+void s_network_end_chunked_value (igs_core_context_t *context,
+                                  igs_remote_output_state_t *state)
+{
+    s_network_free_chunked_value (&state->chunked_value);
+    if (context->chunked_values_nb > 0)
+        context->chunked_values_nb--;
+    if (context->chunked_values_nb == 0 && context->chunked_values_timer_id > 0) {
+        if (context->loop)
+            zloop_timer_end (context->loop, context->chunked_values_timer_id);
+        context->chunked_values_timer_id = 0;
+    }
+}
+
+// reception state of a remote output, created on first use
+igs_remote_output_state_t *s_network_remote_output_state (igs_remote_agent_t *remote_agent,
+                                                          const char *output_name)
+{
+    igs_remote_output_state_t *state = NULL;
+    HASH_FIND_STR (remote_agent->output_states, output_name, state);
+    if (!state) {
+        state = (igs_remote_output_state_t *) zmalloc (sizeof (igs_remote_output_state_t));
+        state->name = strdup (output_name);
+        HASH_ADD_STR (remote_agent->output_states, name, state);
+    }
+    return state;
+}
+
+void s_network_free_remote_output_state (igs_remote_agent_t *remote_agent,
+                                         igs_remote_output_state_t **state)
+{
+    HASH_DEL (remote_agent->output_states, *state);
+    if ((*state)->delta_reference)
+        model_data_buffer_release (&(*state)->delta_reference);
+    if ((*state)->chunked_value)
+        s_network_end_chunked_value (remote_agent->context, *state);
+    free ((*state)->name);
+    free (*state);
+    *state = NULL;
+}
+
+void s_network_free_remote_output_states (igs_remote_agent_t *remote_agent)
+{
+    igs_remote_output_state_t *state, *tmp;
+    HASH_ITER (hh, remote_agent->output_states, state, tmp)
+        s_network_free_remote_output_state (remote_agent, &state);
+}
+
+// forgets the reception state of an output whose definition changed
+void s_network_reset_remote_output_state (igs_remote_agent_t *remote_agent,
+                                          const char *output_name)
+{
+    igs_remote_output_state_t *state = NULL;
+    HASH_FIND_STR (remote_agent->output_states, output_name, state);
+    if (state)
+        s_network_free_remote_output_state (remote_agent, &state);
+}
+
+// asks the publisher of a delta encoded output for a keyframe, at most
+// once per interval while waiting for it
+void s_network_request_keyframe (igs_remote_agent_t *remote_agent, igs_remote_output_state_t *state)
+{
+    int64_t now = zclock_mono ();
+    if (state->delta_keyframe_request
+        && now - state->delta_keyframe_request < IGS_DELTA_KEYFRAME_REQUEST_INTERVAL)
+        return;
+    state->delta_keyframe_request = now;
+    if (!remote_agent->context->node || !remote_agent->peer)
+        return;
+    igs_debug ("requesting keyframe for %s.%s", remote_agent->definition->name, state->name);
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, GET_OUTPUT_KEYFRAME_MSG);
+    zmsg_addstr (msg, remote_agent->uuid);
+    zmsg_addstr (msg, state->name);
+    zyre_whisper (remote_agent->context->node, remote_agent->peer->peer_id, &msg);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+}
+
+/*
+ Built-in LZ codec : an LZ77 scheme close to LZ4 blocks, made of sequences
+ of a token (4 bits for the literals length, 4 bits for the match length),
+ extra literals length bytes, literals, a 16-bit little endian match offset
+ and extra match length bytes. The last sequence has literals only.
+ */
+#define IGS_LZ_HASH_BITS 12
+#define IGS_LZ_MIN_MATCH 4
+#define IGS_LZ_MAX_OFFSET 65535
+// a corrupted size cannot make us allocate more than this ratio of the frame
+#define IGS_LZ_MAX_RATIO 256
+
+static size_t s_network_lz_put_length (byte *buffer, size_t length)
+{
+    size_t size = 0;
+    while (length >= 255) {
+        buffer[size++] = 255;
+        length -= 255;
+    }
+    buffer[size++] = (byte) length;
+    return size;
+}
+
+static bool s_network_lz_get_length (const byte *buffer, size_t size, size_t *offset, size_t *length)
+{
+    byte b = 0;
+    do {
+        if (*offset >= size)
+            return false;
+        b = buffer[(*offset)++];
+        *length += b;
+    } while (b == 255);
+    return true;
+}
+
+// match is 0 for the last sequence, returns false if out is too small
+static bool s_network_lz_put_sequence (byte *out, size_t capacity, size_t *out_size,
+                                       const byte *literals, size_t literals_size,
+                                       size_t offset, size_t match)
+{
+    size_t needed = 1 + literals_size + literals_size / 255 + 1 + 2 + match / 255 + 1;
+    if (*out_size + needed > capacity)
+        return false;
+    byte *token = out + (*out_size)++;
+    *token = (byte) (((literals_size >= 15) ? 15 : literals_size) << 4);
+    if (literals_size >= 15)
+        *out_size += s_network_lz_put_length (out + *out_size, literals_size - 15);
+    memcpy (out + *out_size, literals, literals_size);
+    *out_size += literals_size;
+    if (match) {
+        size_t extra = match - IGS_LZ_MIN_MATCH;
+        *token |= (byte) ((extra >= 15) ? 15 : extra);
+        out[(*out_size)++] = (byte) (offset & 0xff);
+        out[(*out_size)++] = (byte) (offset >> 8);
+        if (extra >= 15)
+            *out_size += s_network_lz_put_length (out + *out_size, extra - 15);
+    }
+    return true;
+}
+
+// returns the compressed size, or 0 if it would exceed capacity
+static size_t s_network_lz_compress (const byte *in, size_t size, byte *out, size_t capacity)
+{
+    size_t table[1 << IGS_LZ_HASH_BITS];
+    memset (table, 0, sizeof (table));
+    size_t out_size = 0;
+    size_t anchor = 0;
+    size_t position = 0;
+    while (size >= IGS_LZ_MIN_MATCH && position <= size - IGS_LZ_MIN_MATCH) {
+        uint32_t sequence = 0;
+        memcpy (&sequence, in + position, sizeof (uint32_t));
+        uint32_t hash = (sequence * 2654435761u) >> (32 - IGS_LZ_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = position;
+        if (candidate >= position || position - candidate > IGS_LZ_MAX_OFFSET
+            || memcmp (in + candidate, in + position, IGS_LZ_MIN_MATCH) != 0) {
+            position++;
+            continue;
+        }
+        size_t match = IGS_LZ_MIN_MATCH;
+        while (position + match < size && in[candidate + match] == in[position + match])
+            match++;
+        if (!s_network_lz_put_sequence (out, capacity, &out_size, in + anchor, position - anchor,
+                                        position - candidate, match))
+            return 0;
+        position += match;
+        anchor = position;
+    }
+    if (!s_network_lz_put_sequence (out, capacity, &out_size, in + anchor, size - anchor, 0, 0))
+        return 0;
+    return out_size;
+}
+
+static bool s_network_lz_decompress (const byte *in, size_t size, byte *out, size_t out_size)
+{
+    size_t offset = 0;
+    size_t position = 0;
+    while (offset < size) {
+        byte token = in[offset++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !s_network_lz_get_length (in, size, &offset, &literals))
+            return false;
+        if (literals > size - offset || literals > out_size - position)
+            return false;
+        memcpy (out + position, in + offset, literals);
+        offset += literals;
+        position += literals;
+        if (offset == size)
+            return position == out_size;
+        if (size - offset < 2)
+            return false;
+        size_t match_offset = (size_t) in[offset] | ((size_t) in[offset + 1] << 8);
+        offset += 2;
+        size_t match = token & 0x0f;
+        if (match == 15 && !s_network_lz_get_length (in, size, &offset, &match))
+            return false;
+        match += IGS_LZ_MIN_MATCH;
+        if (match_offset == 0 || match_offset > position || match > out_size - position)
+            return false;
+        // matches may overlap the bytes they produce
+        for (size_t i = 0; i < match; i++)
+            out[position + i] = out[position - match_offset + i];
+        position += match;
+    }
+    // the last sequence has literals only
+    return false;
+}
+
+zframe_t *network_compress_frame (igs_codec_t codec, size_t threshold, const void *data, size_t size)
+{
+    if (codec != IGS_CODEC_LZ || size == 0 || size < threshold)
+        return NULL;
+    byte *buffer = (byte *) malloc (size);
+    buffer[0] = (byte) codec;
+    size_t header_size = 1;
+    byte size_varint[IGS_DELTA_MAX_VARINT_LENGTH];
+    size_t varint_size = s_network_put_varint (size_varint, size);
+    zframe_t *frame = NULL;
+    if (header_size + varint_size < size) {
+        memcpy (buffer + header_size, size_varint, varint_size);
+        header_size += varint_size;
+        // compressed frame must be smaller than the value
+        size_t compressed_size = s_network_lz_compress ((const byte *) data, size,
+                                                        buffer + header_size, size - header_size - 1);
+        if (compressed_size > 0)
+            frame = zframe_new (buffer, header_size + compressed_size);
+    }
+    free (buffer);
+    return frame;
+}
+
+// returns NULL if the codec is unknown or the frame is corrupted
+zframe_t *s_network_decompress_frame (const byte *data, size_t size)
+{
+    size_t offset = 1;
+    uint64_t value_size = 0;
+    if (size < 1 || data[0] != IGS_CODEC_LZ
+        || !s_network_get_varint (data, size, &offset, &value_size)
+        || value_size == 0 || value_size > (uint64_t) (size - offset) * IGS_LZ_MAX_RATIO)
+        return NULL;
+    zframe_t *frame = zframe_new (NULL, (size_t) value_size);
+    if (!s_network_lz_decompress (data + offset, size - offset, zframe_data (frame), (size_t) value_size))
+        zframe_destroy (&frame);
+    return frame;
+}
+
+// pops the codecs frame of a compressed service call and decompresses the
+// following argument frames in place
+igs_result_t s_network_decompress_arguments (zmsg_t *msg)
+{
+    zframe_t *codecs = zmsg_pop (msg);
+    if (!codecs)
+        return IGS_FAILURE;
+    igs_result_t result = IGS_SUCCESS;
+    byte *codec = zframe_data (codecs);
+    zframe_t *frame = zmsg_first (msg);
+    for (size_t i = 0; i < zframe_size (codecs) && frame; i++) {
+        if (codec[i] != IGS_CODEC_NONE) {
+            zframe_t *value_frame = s_network_decompress_frame (zframe_data (frame), zframe_size (frame));
+            if (!value_frame) {
+                result = IGS_FAILURE;
+                break;
+            }
+            zframe_reset (frame, zframe_data (value_frame), zframe_size (value_frame));
+            zframe_destroy (&value_frame);
+        }
+        frame = zmsg_next (msg);
+    }
+    zframe_destroy (&codecs);
+    return result;
+}
+
+// value decoded from a compact publication header and its optional value frame
+typedef struct {
+    igs_iop_value_type_t value_type;
+    int64_t timestamp;
+    // scalar values are copied to be properly aligned
+    union {
+        int i;
+        double d;
+        bool b;
+    } scalar;
+    void *data;
+    size_t size;
+    char *string;
+    igs_data_buffer_t *buffer;
+    bool pending; //chunk of a value still being reassembled
+} igs_compact_value_t;
+
+void s_clear_compact_value (igs_compact_value_t *value);
+
+// keeps the keyframes of delta encoded outputs and rebuilds their value
+// from the following deltas, returns IGS_FAILURE when a delta cannot be
+// applied and a keyframe has to be requested
+igs_result_t s_network_receive_delta (igs_remote_agent_t *remote_agent,
+                                      const char *output_name,
+                                      byte flags,
+                                      uint32_t sequence,
+                                      igs_compact_value_t *value)
+{
+    igs_iop_t *output = NULL;
+    HASH_FIND_STR (remote_agent->definition->outputs_table, output_name, output);
+    if (!output) {
+        s_clear_compact_value (value);
+        return IGS_FAILURE;
+    }
+    igs_remote_output_state_t *state = s_network_remote_output_state (remote_agent, output_name);
+    if (flags & IGS_COMPACT_FLAG_KEYFRAME) {
+        if (state->delta_reference)
+            model_data_buffer_release (&state->delta_reference);
+        state->delta_reference = model_data_buffer_retain (value->buffer);
+        state->delta_sequence = sequence;
+        state->delta_keyframe_request = 0;
+        return IGS_SUCCESS;
+    }
+    if (state->delta_reference && sequence == state->delta_sequence + 1) {
+        igs_data_buffer_t *reference = state->delta_reference;
+        byte *rebuilt = s_network_apply_xor_delta (reference->data, reference->size,
+                                                   value->data, value->size);
+        if (rebuilt) {
+            model_data_buffer_release (&value->buffer);
+            value->buffer = model_data_buffer_new (rebuilt, reference->size, NULL);
+            value->data = value->buffer->data;
+            value->size = value->buffer->size;
+            model_data_buffer_release (&state->delta_reference);
+            state->delta_reference = model_data_buffer_retain (value->buffer);
+            state->delta_sequence = sequence;
+            return IGS_SUCCESS;
+        }
+        igs_warn ("delta from %s.%s is corrupted in received publication : rejecting",
+                  remote_agent->definition->name, output_name);
+    }
+    else
+        igs_debug ("missing keyframe or publication for %s.%s (sequence %u)",
+                   remote_agent->definition->name, output_name, sequence);
+    // we joined the stream, missed a publication or received a corrupted delta
+    if (state->delta_reference)
+        model_data_buffer_release (&state->delta_reference);
+    s_network_request_keyframe (remote_agent, state);
+    s_clear_compact_value (value);
+    return IGS_FAILURE;
+}
+
+/*
+ Chunked values : data values larger than the chunk size of their output
+ are streamed as one compact publication per chunk, so that publications
+ of other outputs interleave with them and subscribers never receive one
+ huge frame. Subscribers copy chunks in a buffer of the announced size and
+ write the value when all its bytes are received, chunks received twice
+ being counted once. A value whose stream is interrupted by the next one,
+ or that received no chunk for a while, is discarded.
+ */
+#define IGS_CHUNKED_VALUE_TIMEOUT 5000 //milliseconds
+// a corrupted size cannot make us allocate more than this number of times
+// the chunk starting a value
+#define IGS_CHUNKED_VALUE_MAX_CHUNKS 65536
+
+// adds the bytes of a chunk to the ranges of a value, merging the ranges it
+// overlaps or touches, and returns the number of bytes not received before
+uint64_t s_network_add_chunk_range (igs_chunked_value_t *chunked, uint64_t start, uint64_t end)
+{
+    uint64_t added = end - start;
+    uint64_t merged_start = start, merged_end = end;
+    igs_chunk_range_t *range, *tmp, *next = NULL;
+    DL_FOREACH_SAFE (chunked->ranges, range, tmp) {
+        if (range->end < start)
+            continue;
+        if (range->start > end) {
+            next = range;
+            break;
+        }
+        uint64_t overlap_start = (range->start > start) ? range->start : start;
+        uint64_t overlap_end = (range->end < end) ? range->end : end;
+        if (overlap_end > overlap_start)
+            added -= overlap_end - overlap_start;
+        if (range->start < merged_start)
+            merged_start = range->start;
+        if (range->end > merged_end)
+            merged_end = range->end;
+        DL_DELETE (chunked->ranges, range);
+        free (range);
+    }
+    igs_chunk_range_t *merged = (igs_chunk_range_t *) zmalloc (sizeof (igs_chunk_range_t));
+    merged->start = merged_start;
+    merged->end = merged_end;
+    if (next)
+        DL_PREPEND_ELEM (chunked->ranges, next, merged);
+    else
+        DL_APPEND (chunked->ranges, merged);
+    return added;
+}
+
+// one-shot timer callback discarding the values whose chunks stopped
+// arriving, armed again for the next value to expire if any
+int s_network_expire_chunked_values (zloop_t *loop, int timer_id, void *arg)
+{
+    IGS_UNUSED (timer_id)
+    igs_core_context_t *context = (igs_core_context_t *) arg;
+    context->chunked_values_timer_id = 0;
+    int64_t now = zclock_mono ();
+    int64_t next_expiry = INT64_MAX;
+    igs_remote_agent_t *remote_agent, *tmp;
+    HASH_ITER (hh, context->remote_agents, remote_agent, tmp) {
+        if (!remote_agent->definition)
+            continue;
+        igs_remote_output_state_t *state, *tmp_state;
+        HASH_ITER (hh, remote_agent->output_states, state, tmp_state) {
+            if (!state->chunked_value)
+                continue;
+            int64_t expiry = state->chunked_value->last_chunk + IGS_CHUNKED_VALUE_TIMEOUT;
+            if (now > expiry) {
+                igs_warn ("discarding incomplete value of %s.%s after timeout (%llu of %llu bytes received)",
+                          remote_agent->definition->name, state->name,
+                          (unsigned long long) state->chunked_value->received,
+                          (unsigned long long) state->chunked_value->size);
+                s_network_end_chunked_value (context, state);
+            } else if (expiry < next_expiry)
+                next_expiry = expiry;
+        }
+    }
+    if (context->chunked_values_nb > 0 && next_expiry != INT64_MAX)
+        context->chunked_values_timer_id =
+          zloop_timer (loop, (size_t) (next_expiry - now + 1), 1,
+                       s_network_expire_chunked_values, context);
+    return 0;
+}
+
+// the expiry timer only runs while values are being reassembled
+void s_network_start_chunked_value (igs_core_context_t *context,
+                                    igs_remote_output_state_t *state,
+                                    igs_chunked_value_t *chunked)
+{
+    state->chunked_value = chunked;
+    context->chunked_values_nb++;
+    if (context->chunked_values_timer_id == 0 && context->loop)
+        context->chunked_values_timer_id =
+          zloop_timer (context->loop, IGS_CHUNKED_VALUE_TIMEOUT, 1,
+                       s_network_expire_chunked_values, context);
+}
+
+// value is pending until its last chunk is received
+igs_result_t s_network_receive_chunk (igs_remote_agent_t *remote_agent,
+                                      const char *output_name,
+                                      uint32_t stream,
+                                      uint64_t offset,
+                                      uint64_t size,
+                                      igs_compact_value_t *value)
+{
+    igs_iop_t *output = NULL;
+    HASH_FIND_STR (remote_agent->definition->outputs_table, output_name, output);
+    if (!output || offset > size || value->size > size - offset || size > SIZE_MAX) {
+        igs_error ("chunk from %s.%s is corrupted in received publication : rejecting",
+                   remote_agent->definition->name, output_name);
+        s_clear_compact_value (value);
+        return IGS_FAILURE;
+    }
+    igs_remote_output_state_t *state = s_network_remote_output_state (remote_agent, output_name);
+    igs_chunked_value_t *chunked = state->chunked_value;
+    if (chunked && (chunked->stream != stream || chunked->size != size)) {
+        igs_warn ("discarding incomplete value of %s.%s (%llu of %llu bytes received)",
+                  remote_agent->definition->name, output_name,
+                  (unsigned long long) chunked->received, (unsigned long long) chunked->size);
+        s_network_end_chunked_value (remote_agent->context, state);
+        chunked = NULL;
+    }
+    if (!chunked) {
+        if (size == 0 || value->size == 0
+            || size / value->size >= IGS_CHUNKED_VALUE_MAX_CHUNKS) {
+            igs_error ("chunk from %s.%s announces an invalid size (%llu bytes for a chunk of %zu) : rejecting",
+                       remote_agent->definition->name, output_name,
+                       (unsigned long long) size, value->size);
+            s_clear_compact_value (value);
+            return IGS_FAILURE;
+        }
+        byte *data = (byte *) malloc ((size_t) size);
+        if (!data) {
+            igs_error ("could not allocate %llu bytes for %s.%s : rejecting",
+                       (unsigned long long) size, remote_agent->definition->name, output_name);
+            s_clear_compact_value (value);
+            return IGS_FAILURE;
+        }
+        chunked = (igs_chunked_value_t *) zmalloc (sizeof (igs_chunked_value_t));
+        chunked->stream = stream;
+        chunked->size = size;
+        chunked->data = data;
+        s_network_start_chunked_value (remote_agent->context, state, chunked);
+    }
+    if (value->size > 0) {
+        memcpy (chunked->data + offset, value->data, value->size);
+        chunked->received += s_network_add_chunk_range (chunked, offset, offset + value->size);
+    }
+    chunked->last_chunk = zclock_mono ();
+    s_clear_compact_value (value);
+    if (chunked->received < chunked->size) {
+        value->pending = true;
+        value->data = NULL;
+        value->size = 0;
+        return IGS_SUCCESS;
+    }
+    value->buffer = model_data_buffer_new (chunked->data, (size_t) chunked->size, NULL);
+    value->data = value->buffer->data;
+    value->size = value->buffer->size;
+    chunked->data = NULL;
+    s_network_end_chunked_value (remote_agent->context, state);
+    return IGS_SUCCESS;
+}
+
+/*
+ Shared memory : the publisher copies large data values in a ring it is
+ the only one to write, after announcing the end of the region it is about
+ to overwrite. Readers copy the value out of the ring and check that the
+ writer has not wrapped around onto it in the meantime.
+ */
+#define IGS_SHARED_MEMORY_MAGIC 0x69677353484d3130LL
+
+typedef struct {
+    int64_t magic;
+    int64_t capacity;
+    int64_t write_position; //end of the last region written or being written
+} igs_shared_memory_header_t;
+
+#if defined(IGS_SHARED_MEMORY_ENABLED)
+igs_shared_memory_t *s_network_create_shared_memory (const char *name, size_t capacity)
+{
+    shm_unlink (name);
+    int fd = shm_open (name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return NULL;
+    size_t size = sizeof (igs_shared_memory_header_t) + capacity;
+    void *region = MAP_FAILED;
+    if (ftruncate (fd, (off_t) size) == 0)
+        region = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (region == MAP_FAILED) {
+        shm_unlink (name);
+        return NULL;
+    }
+    igs_shared_memory_header_t *header = (igs_shared_memory_header_t *) region;
+    header->capacity = (int64_t) capacity;
+    IGS_ATOMIC_STORE64 (&header->write_position, 0);
+    IGS_ATOMIC_STORE64 (&header->magic, IGS_SHARED_MEMORY_MAGIC);
+    igs_shared_memory_t *shared_memory = (igs_shared_memory_t *) zmalloc (sizeof (igs_shared_memory_t));
+    shared_memory->name = strdup (name);
+    shared_memory->size = size;
+    shared_memory->region = (byte *) region;
+    return shared_memory;
+}
+
+igs_shared_memory_t *s_network_open_shared_memory (const char *name)
+{
+    int fd = shm_open (name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+    struct stat info;
+    void *region = MAP_FAILED;
+    if (fstat (fd, &info) == 0 && (size_t) info.st_size > sizeof (igs_shared_memory_header_t))
+        region = mmap (NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (region == MAP_FAILED)
+        return NULL;
+    igs_shared_memory_header_t *header = (igs_shared_memory_header_t *) region;
+    if (IGS_ATOMIC_LOAD64 (&header->magic) != IGS_SHARED_MEMORY_MAGIC
+        || header->capacity + (int64_t) sizeof (igs_shared_memory_header_t) != (int64_t) info.st_size) {
+        munmap (region, (size_t) info.st_size);
+        return NULL;
+    }
+    igs_shared_memory_t *shared_memory = (igs_shared_memory_t *) zmalloc (sizeof (igs_shared_memory_t));
+    shared_memory->name = strdup (name);
+    shared_memory->size = (size_t) info.st_size;
+    shared_memory->region = (byte *) region;
+    return shared_memory;
+}
+
+void s_network_close_shared_memory (igs_shared_memory_t **shared_memory, bool owner)
+{
+    munmap ((*shared_memory)->region, (*shared_memory)->size);
+    if (owner)
+        shm_unlink ((*shared_memory)->name);
+    free ((*shared_memory)->name);
+    free (*shared_memory);
+    *shared_memory = NULL;
+}
+#endif
+
+// values are contiguous in the ring, returns false if a value is larger
+// than half of it
+bool s_network_write_shared_memory (igs_shared_memory_t *shared_memory,
+                                    const void *data, size_t size, uint64_t *position)
+{
+    igs_shared_memory_header_t *header = (igs_shared_memory_header_t *) shared_memory->region;
+    uint64_t capacity = (uint64_t) header->capacity;
+    if (size == 0 || size > capacity / 2)
+        return false;
+    uint64_t start = (uint64_t) header->write_position;
+    uint64_t offset = start % capacity;
+    if (offset + size > capacity) {
+        start += capacity - offset;
+        offset = 0;
+    }
+    IGS_ATOMIC_STORE64 (&header->write_position, (int64_t) (start + size));
+    IGS_ATOMIC_FENCE ();
+    memcpy (shared_memory->region + sizeof (igs_shared_memory_header_t) + offset, data, size);
+    *position = start;
+    return true;
+}
+
+// returns false if the value has been overwritten while we were reading it
+bool s_network_read_shared_memory (igs_shared_memory_t *shared_memory,
+                                   uint64_t position, uint64_t size, void *data)
+{
+    igs_shared_memory_header_t *header = (igs_shared_memory_header_t *) shared_memory->region;
+    uint64_t capacity = (uint64_t) header->capacity;
+    uint64_t offset = position % capacity;
+    if (size > capacity / 2 || offset + size > capacity
+        || position + size > (uint64_t) IGS_ATOMIC_LOAD64 (&header->write_position))
+        return false;
+    memcpy (data, shared_memory->region + sizeof (igs_shared_memory_header_t) + offset, (size_t) size);
+    IGS_ATOMIC_FENCE ();
+    return (uint64_t) IGS_ATOMIC_LOAD64 (&header->write_position) <= position + capacity;
+}
+
+// copies a value out of the shared memory of the remote agent, the copy
+// being the buffer shared by the inputs it is written to
+igs_result_t s_network_receive_shared (igs_remote_agent_t *remote_agent,
+                                       const char *output_name,
+                                       igs_compact_value_t *value)
+{
+    igs_shared_memory_t *shared_memory = (remote_agent->peer) ? remote_agent->peer->shared_memory : NULL;
+    uint64_t descriptor[2];
+    if (!shared_memory || value->size != sizeof (descriptor)) {
+        igs_error ("shared value from %s.%s cannot be read : rejecting",
+                   remote_agent->definition->name, output_name);
+        s_clear_compact_value (value);
+        return IGS_FAILURE;
+    }
+    memcpy (descriptor, value->data, sizeof (descriptor));
+    s_clear_compact_value (value);
+    value->data = NULL;
+    value->size = 0;
+    byte *data = (descriptor[1] > 0 && descriptor[1] < shared_memory->size) ? (byte *) malloc ((size_t) descriptor[1]) : NULL;
+    if (!data || !s_network_read_shared_memory (shared_memory, descriptor[0], descriptor[1], data)) {
+        igs_warn ("shared value from %s.%s has been overwritten before being read : "
+                  "shared memory of this agent is too small", remote_agent->definition->name, output_name);
+        free (data);
+        return IGS_FAILURE;
+    }
+    value->buffer = model_data_buffer_new (data, (size_t) descriptor[1], NULL);
+    value->data = value->buffer->data;
+    value->size = value->buffer->size;
+    return IGS_SUCCESS;
+}
+
+// decodes a compact header, popping the value frame from msg for strings
+// and data, returns IGS_FAILURE if the publication is corrupted
+igs_result_t s_decode_compact_value (igs_remote_agent_t *remote_agent,
+                                     const char *output,
+                                     const byte *header_data,
+                                     size_t header_size,
+                                     zmsg_t *msg,
+                                     igs_compact_value_t *value)
+{
+    memset (value, 0, sizeof (igs_compact_value_t));
+    value->timestamp = INT64_MIN;
+    if (header_size < IGS_COMPACT_HEADER_LENGTH) {
+        igs_error ("header from %s.%s is missing in received publication : rejecting",
+                   remote_agent->definition->name, output);
+        return IGS_FAILURE;
+    }
+    value->value_type = header_data[0];
+    byte flags = header_data[1];
+    size_t offset = IGS_COMPACT_HEADER_LENGTH;
+    if ((value->value_type < IGS_INTEGER_T || value->value_type > IGS_DATA_T)
+        && !model_is_array_type (value->value_type)) {
+        igs_error ("output value type is not valid (%d) in received publication : rejecting", value->value_type);
+        return IGS_FAILURE;
+    }
+    if (flags & ~IGS_COMPACT_KNOWN_FLAGS) {
+        igs_error ("unknown flags %x from %s.%s in received publication : rejecting",
+                   flags, remote_agent->definition->name, output);
+        return IGS_FAILURE;
+    }
+    if (flags & IGS_COMPACT_FLAG_TIMESTAMP) {
+        if (header_size < offset + sizeof (int64_t)) {
+            igs_error ("timestamp from %s.%s is corrupted in received publication : rejecting",
+                       remote_agent->definition->name, output);
+            return IGS_FAILURE;
+        }
+        memcpy (&value->timestamp, header_data + offset, sizeof (int64_t));
+        offset += sizeof (int64_t);
+    }
+    uint32_t sequence = 0;
+    bool delta_encoded = (flags & (IGS_COMPACT_FLAG_KEYFRAME | IGS_COMPACT_FLAG_DELTA));
+    if (delta_encoded) {
+        if (value->value_type != IGS_DATA_T || header_size < offset + sizeof (uint32_t)) {
+            igs_error ("sequence from %s.%s is corrupted in received publication : rejecting",
+                       remote_agent->definition->name, output);
+            return IGS_FAILURE;
+        }
+        memcpy (&sequence, header_data + offset, sizeof (uint32_t));
+        offset += sizeof (uint32_t);
+    }
+    uint32_t stream = 0;
+    uint64_t chunk_offset = 0;
+    uint64_t chunked_size = 0;
+    bool chunked = (flags & IGS_COMPACT_FLAG_CHUNK);
+    if (chunked) {
+        if (value->value_type != IGS_DATA_T || delta_encoded
+            || header_size < offset + sizeof (uint32_t) + 2 * sizeof (uint64_t)) {
+            igs_error ("chunk from %s.%s is corrupted in received publication : rejecting",
+                       remote_agent->definition->name, output);
+            return IGS_FAILURE;
+        }
+        memcpy (&stream, header_data + offset, sizeof (uint32_t));
+        offset += sizeof (uint32_t);
+        memcpy (&chunk_offset, header_data + offset, sizeof (uint64_t));
+        offset += sizeof (uint64_t);
+        memcpy (&chunked_size, header_data + offset, sizeof (uint64_t));
+        offset += sizeof (uint64_t);
+    }
+    bool shared = (flags & IGS_COMPACT_FLAG_SHARED);
+    if (shared && (value->value_type != IGS_DATA_T || delta_encoded || chunked
+                   || (flags & IGS_COMPACT_FLAG_COMPRESSED))) {
+        igs_error ("shared value from %s.%s is corrupted in received publication : rejecting",
+                   remote_agent->definition->name, output);
+        return IGS_FAILURE;
+    }
+    size_t expected_size = 0;
+    zframe_t *frame = NULL;
+    switch (value->value_type) {
+        case IGS_INTEGER_T:
+            expected_size = sizeof (int);
+            break;
+        case IGS_DOUBLE_T:
+            expected_size = sizeof (double);
+            break;
+        case IGS_BOOL_T:
+            expected_size = sizeof (bool);
+            break;
+        case IGS_STRING_T:
+        case IGS_DATA_T:
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            frame = zmsg_pop (msg);
+            if (!frame) {
+                igs_error ("value from %s.%s is NULL in received publication : rejecting",
+                           remote_agent->definition->name, output);
+                return IGS_FAILURE;
+            }
+            if (flags & IGS_COMPACT_FLAG_COMPRESSED) {
+                zframe_t *value_frame = s_network_decompress_frame (zframe_data (frame), zframe_size (frame));
+                zframe_destroy (&frame);
+                if (!value_frame) {
+                    igs_error ("compressed value from %s.%s is corrupted in received publication : rejecting",
+                               remote_agent->definition->name, output);
+                    return IGS_FAILURE;
+                }
+                frame = value_frame;
+            }
+            if (value->value_type == IGS_STRING_T) {
+                value->string = zframe_strdup (frame);
+                zframe_destroy (&frame);
+                value->data = value->string;
+                value->size = strlen (value->string) + 1;
+            } else {
+                // received frame is shared by all the inputs mapped on it
+                value->buffer = model_data_buffer_from_frame (&frame);
+                value->data = value->buffer->data;
+                value->size = value->buffer->size;
+            }
+            break;
+        default:
+            break;
+    }
+    if (expected_size) {
+        if (header_size - offset != expected_size) {
+            igs_error ("value from %s.%s is corrupted in received publication : rejecting",
+                       remote_agent->definition->name, output);
+            return IGS_FAILURE;
+        }
+        memcpy (&value->scalar, header_data + offset, expected_size);
+        value->data = &value->scalar;
+        value->size = expected_size;
+    }
+    if (delta_encoded)
+        return s_network_receive_delta (remote_agent, output, flags, sequence, value);
+    if (chunked)
+        return s_network_receive_chunk (remote_agent, output, stream, chunk_offset, chunked_size, value);
+    if (shared)
+        return s_network_receive_shared (remote_agent, output, value);
+    return IGS_SUCCESS;
+}
+
+void s_clear_compact_value (igs_compact_value_t *value)
+{
+    if (value->buffer)
+        model_data_buffer_release (&value->buffer);
+    if (value->string) {
+        free (value->string);
+        value->string = NULL;
+    }
+}
+
+// function handling compact publications (protocol v5) once their topic
+// frame has been consumed and the publishing output has been identified
+void s_handle_compact_publication (zmsg_t **msg,
+                                   igs_remote_agent_t *remote_agent,
+                                   const char *output)
+{
+    assert (msg && *msg);
+    assert (remote_agent);
+    assert (remote_agent->context);
+    assert (output);
+    if (remote_agent->context->is_frozen == true) {
+        igs_debug ("Message received from %s but all traffic in our agent is currently frozen",
+                   remote_agent->definition->name);
+        zmsg_destroy (msg);
+        return;
+    }
+    zframe_t *header = zmsg_pop (*msg);
+    igs_compact_value_t value;
+    if (!header
+        || s_decode_compact_value (remote_agent, output, zframe_data (header),
+                                   zframe_size (header), *msg, &value) != IGS_SUCCESS) {
+        if (!header)
+            igs_error ("header from %s.%s is missing in received publication : rejecting",
+                       remote_agent->definition->name, output);
+        zframe_destroy (&header);
+        zmsg_destroy (msg);
+        return;
+    }
+    igs_deferred_observe_t *deferred = NULL;
+    if (!value.pending) {
+        model_read_lock (__FUNCTION__, __LINE__);
+        s_dispatch_publication (remote_agent->definition->name, output, value.value_type,
+                                value.data, value.size, value.buffer, value.timestamp,
+                                &deferred);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        model_run_deferred_observe_callbacks (&deferred);
+    }
+    s_clear_compact_value (&value);
+    zframe_destroy (&header);
+    zmsg_destroy (msg);
+}
+
+// function handling compact publication batches (protocol v5) : all the
+// inputs are written before any of their observe callbacks is called
+void s_handle_compact_batch (zmsg_t **msg, igs_remote_agent_t *remote_agent)
+{
+    assert (msg && *msg);
+    assert (remote_agent);
+    assert (remote_agent->context);
+    if (remote_agent->context->is_frozen == true) {
+        igs_debug ("Message received from %s but all traffic in our agent is currently frozen",
+                   remote_agent->definition->name);
+        zmsg_destroy (msg);
+        return;
+    }
+    igs_deferred_observe_t *deferred = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    zframe_t *entry = zmsg_pop (*msg);
+    while (entry) {
+        if (zframe_size (entry) < 2) {
+            igs_error ("entry from %s is corrupted in received batch : rejecting",
+                       remote_agent->definition->name);
+            zframe_destroy (&entry);
+            break;
+        }
+        byte *entry_data = zframe_data (entry);
+        uint16_t id = (uint16_t) ((entry_data[0] << 8) | entry_data[1]);
+        igs_iop_t *output = definition_find_output_by_id (remote_agent->definition, id);
+        const char *output_name = (output) ? output->name : "";
+        igs_compact_value_t value;
+        if (s_decode_compact_value (remote_agent, output_name, entry_data + 2,
+                                    zframe_size (entry) - 2, *msg, &value) != IGS_SUCCESS) {
+            zframe_destroy (&entry);
+            break;
+        }
+        if (output && !value.pending)
+            s_dispatch_publication (remote_agent->definition->name, output->name,
+                                    value.value_type, value.data, value.size,
+                                    value.buffer, value.timestamp, &deferred);
+        else
+            igs_error ("no output with id %u for %s(%s) in received batch",
+                       id, remote_agent->definition->name, remote_agent->uuid);
+        s_clear_compact_value (&value);
+        zframe_destroy (&entry);
+        entry = zmsg_pop (*msg);
+    }
     model_read_write_unlock (__FUNCTION__, __LINE__);
+    model_run_deferred_observe_callbacks (&deferred);
+    zmsg_destroy (msg);
 }
 
 // Timer callback to send GET_CURRENT_OUTPUTS notification for an agent we
@@ -342,24 +1425,119 @@ int s_trigger_outputs_request_to_newcomer (zloop_t *loop,
     return 0;
 }
 
+static const char s_network_hex_digits[] = "0123456789abcdef";
+
+uint16_t network_intern_topic_key (igs_core_context_t *context)
+{
+    assert (context);
+    // Keys are allocated in sequence, skipping the ones still in use, so that
+    // two of our agents never share a key, even when many agents are created
+    // and destroyed. Zero is kept for remote agents not announcing a key.
+    uint16_t key = context->last_topic_key;
+    for (uint32_t attempts = 0; attempts < UINT16_MAX; attempts++) {
+        key++;
+        if (key == 0)
+            key = 1;
+        bool is_used = false;
+        if (context->created_agents) {
+            igsagent_t *agent = (igsagent_t *) zhash_first (context->created_agents);
+            while (agent && !is_used) {
+                is_used = (agent->topic_key == key);
+                agent = (igsagent_t *) zhash_next (context->created_agents);
+            }
+        }
+        if (!is_used)
+            break;
+    }
+    context->last_topic_key = key;
+    return key;
+}
+
+// writes the IGS_COMPACT_TOPIC_LENGTH characters of a compact topic
+void s_network_compact_topic (uint16_t key, uint16_t id, char *topic)
+{
+    topic[0] = IGS_COMPACT_TOPIC_PREFIX;
+    for (int i = 0; i < 4; i++) {
+        topic[4 - i] = s_network_hex_digits[(key >> (4 * i)) & 0xf];
+        topic[8 - i] = s_network_hex_digits[(id >> (4 * i)) & 0xf];
+    }
+}
+
+// reads key and id from a compact topic, false if frame is not one
+bool s_network_parse_compact_topic (zframe_t *topic, uint16_t *key, uint16_t *id)
+{
+    if (zframe_size (topic) != IGS_COMPACT_TOPIC_LENGTH
+        || zframe_data (topic)[0] != IGS_COMPACT_TOPIC_PREFIX)
+        return false;
+    uint32_t values[2] = {0, 0};
+    const byte *digits = zframe_data (topic) + 1;
+    for (int i = 0; i < 8; i++) {
+        byte c = digits[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else
+            return false;
+        values[i / 4] = (values[i / 4] << 4) | digit;
+    }
+    *key = (uint16_t) values[0];
+    *id = (uint16_t) values[1];
+    return true;
+}
+
 // manage incoming messages from one of the remote agents we subscribed to
 int s_manage_received_publication (zloop_t *loop, zsock_t *socket, void *arg)
 {
     IGS_UNUSED (loop)
-    igs_core_context_t *context = (igs_core_context_t *) arg;
+    igs_zyre_peer_t *zyre_peer = (igs_zyre_peer_t *) arg;
+    igs_core_context_t *context = core_context;
     assert (socket);
+    assert (zyre_peer);
     assert (context);
 
     zmsg_t *msg = zmsg_recv (socket);
     assert(msg);
-    // The output name includes the publishing agent uuid as a prefix.
-    // We merged uuid and output to keep the ZeroMQ PUB/SUB filters working
-    // in a context where a publishing peer possibly hosts multiple agents.
-    char *publication = zmsg_popstr (msg);
-    if (publication == NULL) {
+    zframe_t *topic = zmsg_pop (msg);
+    if (topic == NULL) {
         igs_error ("output name is NULL in received publication : rejecting");
+        zmsg_destroy (&msg);
+        return 0;
+    }
+    uint16_t key = 0, id = 0;
+    if (s_network_parse_compact_topic (topic, &key, &id)) {
+        // compact publication : topic key of the publishing agent followed
+        // by the output id
+        zframe_destroy (&topic);
+        igs_remote_agent_t *remote_agent = NULL;
+        HASH_FIND (hh_topic_key, zyre_peer->remote_agents_by_topic_key,
+                   &key, sizeof (uint16_t), remote_agent);
+        if (remote_agent == NULL) {
+            igs_error ("no remote agent with topic key %04x on peer %s : rejecting",
+                       key, zyre_peer->name);
+            zmsg_destroy (&msg);
+            return 0;
+        }
+        if (id == IGS_COMPACT_BATCH_ID) {
+            s_handle_compact_batch (&msg, remote_agent);
+            return 0;
+        }
+        igs_iop_t *output = definition_find_output_by_id (remote_agent->definition, id);
+        if (output == NULL) {
+            igs_error ("no output with id %u for %s(%s) : rejecting",
+                       id, remote_agent->definition->name, remote_agent->uuid);
+            zmsg_destroy (&msg);
+            return 0;
+        }
+        s_handle_compact_publication (&msg, remote_agent, output->name);
         return 0;
     }
+    // The output name includes the publishing agent uuid as a prefix.
+    // We merged uuid and output to keep the ZeroMQ PUB/SUB filters working
+    // in a context where a publishing peer possibly hosts multiple agents.
+    char *publication = zframe_strdup (topic);
+    zframe_destroy (&topic);
     if (strlen (publication) < IGS_AGENT_UUID_LENGTH) {
         igs_error ("output name '%s' is missing information : rejecting", publication);
         free (publication);
@@ -396,59 +1574,108 @@ void s_clean_and_free_zyre_peer (igs_zyre_peer_t **zyre_peer, zloop_t *loop)
         free ((*zyre_peer)->name);
     if ((*zyre_peer)->protocol)
         free ((*zyre_peer)->protocol);
+    if ((*zyre_peer)->uses_legacy_publications && core_context->legacy_publications_peers_nb > 0)
+        core_context->legacy_publications_peers_nb--;
+    if ((*zyre_peer)->is_on_same_host)
+        IGS_ATOMIC_ADD64 (&core_context->same_host_peers_nb, -1);
+#if defined(IGS_SHARED_MEMORY_ENABLED)
+    if ((*zyre_peer)->shared_memory)
+        s_network_close_shared_memory (&((*zyre_peer)->shared_memory), false);
+#endif
     if ((*zyre_peer)->subscriber) {
         zloop_reader_end (loop, (*zyre_peer)->subscriber);
         zsock_destroy (&((*zyre_peer)->subscriber));
     }
+    for (int priority = IGS_PRIORITY_NORMAL + 1; priority < IGS_OUTPUT_PRIORITIES_NB; priority++) {
+        if ((*zyre_peer)->priority_subscribers[priority]) {
+            zloop_reader_end (loop, (*zyre_peer)->priority_subscribers[priority]);
+            zsock_destroy (&((*zyre_peer)->priority_subscribers[priority]));
+        }
+    }
     free (*zyre_peer);
     *zyre_peer = NULL;
 }
 
 #define NOTIFY_REMOTE_AGENT_TIMER 500
 
-// Adds proper filter to 'subscribe' socket for a spectific output of a given
-// remote agent
-void s_subscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
-                                         const char *output_name)
+// Adds a filter to a 'subscribe' socket of a given remote agent, unless it
+// already exists, moving it if it was set on another socket
+void s_add_remote_agent_filter (igs_remote_agent_t *remote_agent,
+                                const char *output_name,
+                                const char *filter_value,
+                                zsock_t *subscriber)
 {
-    assert (remote_agent);
-    assert (output_name);
-    if (strlen (output_name) > 0) {
-        char filter_value[IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1] =
-          "";
-        snprintf (filter_value,
-                  IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1, "%s-%s",
-                  remote_agent->uuid, output_name);
-        bool filter_already_exists = false;
-        igs_mapping_filter_t *filter = NULL;
-        DL_FOREACH (remote_agent->mapping_filters, filter)
-        {
-            if (streq (filter->filter, filter_value)) {
-                filter_already_exists = true;
-                break;
-            }
-        }
-        if (!filter_already_exists) {
-            // Set subscriber to the output filter
-            assert (remote_agent->peer->subscriber);
-            igs_debug ("subscribe to agent %s output %s (%s)",
-                       remote_agent->definition->name, output_name,
-                       filter_value);
-            zsock_set_subscribe (remote_agent->peer->subscriber, filter_value);
-            igs_mapping_filter_t *f = (igs_mapping_filter_t *) zmalloc (
-              sizeof (igs_mapping_filter_t));
-            f->filter = strdup (filter_value);
-            DL_APPEND (remote_agent->mapping_filters, f);
-        }
-        else {
-            // printf("\n****************\nFILTER BIS %s - %s\n***************\n",
-            // subscriber->agent->name, output_name);
+    assert (subscriber);
+    igs_mapping_filter_t *filter = NULL;
+    DL_FOREACH (remote_agent->mapping_filters, filter)
+    {
+        if (streq (filter->filter, filter_value))
+            break;
+    }
+    if (filter && filter->subscriber == subscriber)
+        return;
+    if (filter) {
+        // output priority has changed in the remote definition
+        zsock_set_unsubscribe (filter->subscriber, filter_value);
+    } else {
+        filter = (igs_mapping_filter_t *) zmalloc (sizeof (igs_mapping_filter_t));
+        filter->filter = strdup (filter_value);
+        DL_APPEND (remote_agent->mapping_filters, filter);
+    }
+    // Set subscriber to the output filter
+    igs_debug ("subscribe to agent %s output %s (%s)",
+               remote_agent->definition->name, output_name,
+               filter_value);
+    zsock_set_subscribe (subscriber, filter_value);
+    filter->subscriber = subscriber;
+}
+
+// Adds proper filter to 'subscribe' socket for a spectific output of a given
+// remote agent
+void s_subscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
+                                         const igs_iop_t *output)
+{
+    assert (remote_agent);
+    assert (output);
+    const char *output_name = output->name;
+    if (output_name && strlen (output_name) > 0) {
+        char filter_value[IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1] =
+          "";
+        if (output->id && remote_agent->topic_key
+            && s_network_protocol_version (remote_agent->peer->protocol) >= IGS_COMPACT_PUBLICATIONS_PROTOCOL) {
+            // remote agent publishes compact publications for this output,
+            // possibly grouped into batches
+            // outputs of a priority class are published on their own socket
+            // when we subscribe using TCP
+            zsock_t *subscriber = NULL;
+            if (output->priority > IGS_PRIORITY_NORMAL && output->priority < IGS_OUTPUT_PRIORITIES_NB)
+                subscriber = remote_agent->peer->priority_subscribers[output->priority];
+            if (!subscriber)
+                subscriber = remote_agent->peer->subscriber;
+            // filters have the fixed size of the topics and thus match
+            // exactly one output of this remote agent
+            s_network_compact_topic (remote_agent->topic_key, output->id, filter_value);
+            filter_value[IGS_COMPACT_TOPIC_LENGTH] = '\0';
+            s_add_remote_agent_filter (remote_agent, output_name, filter_value, subscriber);
+            s_network_compact_topic (remote_agent->topic_key, IGS_COMPACT_BATCH_ID, filter_value);
+            filter_value[IGS_COMPACT_TOPIC_LENGTH] = '\0';
+            s_add_remote_agent_filter (remote_agent, "batches", filter_value,
+                                       remote_agent->peer->subscriber);
+        } else {
+            snprintf (filter_value,
+                      IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1, "%s-%s",
+                      remote_agent->uuid, output_name);
+            s_add_remote_agent_filter (remote_agent, output_name, filter_value,
+                                       remote_agent->peer->subscriber);
         }
     }
 }
 
+// Subscribes to the outputs of a remote agent used by our mapping. When
+// output_name is not NULL, only mapping elements targeting this output
+// are checked.
 int s_network_configure_mapping_to_remote_agent (
-  igsagent_t *agent, igs_remote_agent_t *remote_agent)
+  igsagent_t *agent, igs_remote_agent_t *remote_agent, const char *output_name)
 {
     assert (agent);
     assert (remote_agent);
@@ -456,6 +1683,8 @@ int s_network_configure_mapping_to_remote_agent (
     if (agent->mapping) {
         HASH_ITER (hh, agent->mapping->map_elements, el, tmp)
         {
+            if (output_name && !streq (el->to_output, output_name))
+                continue;
             if (streq (remote_agent->definition->name, el->to_agent)
                 || streq (el->to_agent, "*")) {
                 // mapping element is compatible with subscriber name
@@ -481,7 +1710,7 @@ int s_network_configure_mapping_to_remote_agent (
                     // the remote agent ouput on several of its inputs. This should not
                     // have any consequence.
                     s_subscribe_to_remote_agent_output (remote_agent,
-                                                        el->to_output);
+                                                        found_output);
 
                     // mapping was successful : we set timer to notify remote agent if not
                     // already done
@@ -501,33 +1730,116 @@ int s_network_configure_mapping_to_remote_agent (
     return 0;
 }
 
+// content hash of an exported definition, allowing receivers to skip
+// definitions they already parsed
+char *s_network_definition_fingerprint (const char *definition, size_t size)
+{
+    zdigest_t *digest = zdigest_new ();
+    zdigest_update (digest, (const byte *) definition, size);
+    char *fingerprint = strdup (zdigest_string (digest));
+    zdigest_destroy (&digest);
+    return fingerprint;
+}
+
+// exports of our definitions depending on the protocol of our peers
+typedef enum {
+    IGS_DEFINITION_EXPORT_CURRENT = 0,
+    IGS_DEFINITION_EXPORT_WITHOUT_ARRAYS, //peers older than v5, arrays are DATA
+    IGS_DEFINITION_EXPORT_LEGACY //v2 and v3 peers
+} igs_definition_export_t;
+
+igs_definition_export_t s_network_definition_export_for (const igs_zyre_peer_t *peer)
+{
+    if (peer->protocol && (streq (peer->protocol, "v2") || streq (peer->protocol, "v3")))
+        return IGS_DEFINITION_EXPORT_LEGACY;
+    if (s_network_protocol_version (peer->protocol) < IGS_COMPACT_PUBLICATIONS_PROTOCOL)
+        return IGS_DEFINITION_EXPORT_WITHOUT_ARRAYS;
+    return IGS_DEFINITION_EXPORT_CURRENT;
+}
+
+// Exported definition of an agent, regenerated only when its definition
+// changed since the last export. The returned buffer is owned by the agent
+// and its data stays NUL-terminated so that it can be read as a string.
+// Model lock must be held.
+igs_data_buffer_t *s_network_definition_export (igsagent_t *agent, igs_definition_export_t kind)
+{
+    assert (agent);
+    igs_data_buffer_t **cache = &agent->definition_export;
+    uint64_t *revision = &agent->definition_export_revision;
+    if (kind == IGS_DEFINITION_EXPORT_LEGACY) {
+        cache = &agent->definition_export_legacy;
+        revision = &agent->definition_export_legacy_revision;
+    } else if (kind == IGS_DEFINITION_EXPORT_WITHOUT_ARRAYS) {
+        cache = &agent->definition_export_without_arrays;
+        revision = &agent->definition_export_without_arrays_revision;
+    }
+    if (*cache && *revision == agent->definition_revision)
+        return *cache;
+    if (*cache)
+        model_data_buffer_release (cache);
+    char *definition_str = NULL;
+    if (kind == IGS_DEFINITION_EXPORT_LEGACY)
+        definition_str = parser_export_definition_legacy (agent->definition);
+    else if (kind == IGS_DEFINITION_EXPORT_WITHOUT_ARRAYS)
+        definition_str = parser_export_definition_without_arrays (agent->definition);
+    else
+        definition_str = parser_export_definition (agent->definition);
+    if (definition_str) {
+        *cache = model_data_buffer_new (definition_str, strlen (definition_str), NULL);
+        *revision = agent->definition_revision;
+        if (kind == IGS_DEFINITION_EXPORT_CURRENT) {
+            if (agent->definition_export_fingerprint)
+                free (agent->definition_export_fingerprint);
+            agent->definition_export_fingerprint =
+              s_network_definition_fingerprint (definition_str, (*cache)->size);
+        }
+    }
+    return *cache;
+}
+
 void s_send_definition_to_zyre_peer (igsagent_t *agent,
-                                     const char *peer,
-                                     const char *def,
+                                     igs_zyre_peer_t *peer,
                                      bool notif)
 {
     assert (agent);
     assert (agent->context);
     assert (agent->context->node);
     assert (peer);
-    assert (def);
+    igs_data_buffer_t *definition = s_network_definition_export (agent, s_network_definition_export_for (peer));
     s_lock_zyre_peer (__FUNCTION__, __LINE__);
     zmsg_t *msg = zmsg_new ();
     zmsg_addstr (msg, EXTERNAL_DEFINITION_MSG);
-    zmsg_addstr (msg, def);
+    if (definition) {
+        // all peers share the same export, each message sent through zyre
+        // holding its own copy because zyre may send it after the export
+        // has been regenerated
+        zmsg_addmem (msg, definition->data, definition->size);
+    } else
+        zmsg_addstr (msg, "");
     zmsg_addstr (msg, agent->uuid);
     zmsg_addstr (msg, agent->definition->name);
-    if (notif) {
+    if (s_network_protocol_version (peer->protocol) >= IGS_COMPACT_PUBLICATIONS_PROTOCOL) {
+        // notification flag is always present for recent peers and
+        // followed by the topic key of our compact publications,
+        // the fingerprint of our definition and its revision, on
+        // which the next definition deltas will be based
+        zmsg_addstr (msg, (notif) ? "1" : "0");
+        zmsg_addstrf (msg, "%04x", agent->topic_key);
+        zmsg_addstr (msg, (definition && agent->definition_export_fingerprint)
+                            ? agent->definition_export_fingerprint : "");
+        if (s_network_protocol_version (peer->protocol) >= IGS_DEFINITION_DELTAS_PROTOCOL)
+            zmsg_addstrf (msg, "%llu", (unsigned long long) agent->definition_revision);
+    } else if (notif) {
         // Agent has been activated during runtime: we must
         // indicate that our peer already knows the distant peer
         zmsg_addstr (msg, "1");
     }
-    zyre_whisper (core_context->node, peer, &msg);
+    zyre_whisper (core_context->node, peer->peer_id, &msg);
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 }
 
 void s_send_mapping_to_zyre_peer (igsagent_t *agent,
-                                  const char *peer,
+                                  igs_zyre_peer_t *peer,
                                   const char *mapping)
 {
     assert (agent);
@@ -540,7 +1852,9 @@ void s_send_mapping_to_zyre_peer (igsagent_t *agent,
     zmsg_addstr (msg, EXTERNAL_MAPPING_MSG);
     zmsg_addstr (msg, mapping);
     zmsg_addstr (msg, agent->uuid);
-    zyre_whisper (core_context->node, peer, &msg);
+    if (s_network_protocol_version (peer->protocol) >= IGS_DEFINITION_DELTAS_PROTOCOL)
+        zmsg_addstrf (msg, "%llu", (unsigned long long) agent->mapping_revision);
+    zyre_whisper (core_context->node, peer->peer_id, &msg);
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 }
 
@@ -670,6 +1984,122 @@ void s_send_state_to (igsagent_t *agent,
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 }
 
+// Indexes a remote agent by the topic key of its compact publications.
+// Keys are unique among the agents of a peer but a key may be reused after
+// an agent left: the stale owner is then removed from the index.
+void s_network_register_topic_key (igs_remote_agent_t *remote_agent, uint16_t topic_key)
+{
+    assert (remote_agent);
+    assert (remote_agent->peer);
+    igs_zyre_peer_t *peer = remote_agent->peer;
+    if (remote_agent->topic_key)
+        HASH_DELETE (hh_topic_key, peer->remote_agents_by_topic_key, remote_agent);
+    igs_remote_agent_t *previous = NULL;
+    HASH_FIND (hh_topic_key, peer->remote_agents_by_topic_key,
+               &topic_key, sizeof (uint16_t), previous);
+    if (previous) {
+        igs_debug ("topic key %04x moves from %s to %s on peer %s", topic_key,
+                   previous->uuid, remote_agent->uuid, peer->name);
+        HASH_DELETE (hh_topic_key, peer->remote_agents_by_topic_key, previous);
+        previous->topic_key = 0;
+    }
+    remote_agent->topic_key = topic_key;
+    HASH_ADD (hh_topic_key, peer->remote_agents_by_topic_key,
+              topic_key, sizeof (uint16_t), remote_agent);
+}
+
+/*
+ Shared definitions : remote agents announcing the same definition, such as
+ clones of a same agent, share a single parsed definition. Definitions are
+ identified by their fingerprint, sent by recent peers or computed when
+ received otherwise, so that an unchanged definition is never parsed twice.
+ Definitions modified by deltas have no fingerprint anymore and are private
+ to their remote agent.
+ */
+igs_shared_definition_t *s_network_share_definition (igs_core_context_t *context,
+                                                     const char *fingerprint,
+                                                     igs_definition_t *definition)
+{
+    igs_shared_definition_t *shared = (igs_shared_definition_t *) zmalloc (sizeof (igs_shared_definition_t));
+    shared->definition = definition;
+    if (fingerprint) {
+        shared->fingerprint = strdup (fingerprint);
+        HASH_ADD_STR (context->shared_definitions, fingerprint, shared);
+    }
+    return shared;
+}
+
+void s_network_release_definition (igs_core_context_t *context, igs_shared_definition_t **shared)
+{
+    assert (shared);
+    assert (*shared);
+    if (--(*shared)->refcount == 0) {
+        if ((*shared)->fingerprint) {
+            HASH_DEL (context->shared_definitions, *shared);
+            free ((*shared)->fingerprint);
+        }
+        definition_free_definition (&(*shared)->definition);
+        free (*shared);
+    }
+    *shared = NULL;
+}
+
+// Gives a remote agent its own copy of its definition before it is
+// modified by a delta, so that agents sharing it are not affected.
+igs_result_t s_network_make_definition_private (igs_remote_agent_t *remote_agent)
+{
+    assert (remote_agent);
+    assert (remote_agent->shared_definition);
+    igs_core_context_t *context = remote_agent->context;
+    igs_shared_definition_t *shared = remote_agent->shared_definition;
+    if (shared->refcount == 1) {
+        if (shared->fingerprint) {
+            HASH_DEL (context->shared_definitions, shared);
+            free (shared->fingerprint);
+            shared->fingerprint = NULL;
+        }
+        return IGS_SUCCESS;
+    }
+    char *definition_str = parser_export_definition (shared->definition);
+    igs_definition_t *copy = (definition_str) ? parser_load_definition (definition_str) : NULL;
+    if (definition_str)
+        free (definition_str);
+    if (!copy) {
+        igs_error ("definition of remote agent %s(%s) could not be copied",
+                   remote_agent->definition->name, remote_agent->uuid);
+        return IGS_FAILURE;
+    }
+    remote_agent->shared_definition = s_network_share_definition (context, NULL, copy);
+    remote_agent->shared_definition->refcount++;
+    remote_agent->definition = copy;
+    s_network_release_definition (context, &shared);
+    return IGS_SUCCESS;
+}
+
+// full exports attached to agent events are only worth producing
+// when a local agent observes these events
+bool s_network_has_agent_event_callbacks (igs_core_context_t *context)
+{
+    igsagent_t *agent, *tmp;
+    HASH_ITER (hh, context->agents, agent, tmp){
+        if (agent->agent_event_callbacks)
+            return true;
+    }
+    return false;
+}
+
+// asks a peer for the full definition or mapping of one of its agents,
+// when we missed some of its deltas
+void s_network_request_resync (const char *peer_id, const char *request, const char *uuid)
+{
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, request);
+    zmsg_addstr (msg, uuid);
+    zyre_whisper (core_context->node, peer_id, &msg);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+}
+
 void s_clean_and_free_remote_agent (igs_remote_agent_t **remote_agent)
 {
     assert (remote_agent);
@@ -678,9 +2108,15 @@ void s_clean_and_free_remote_agent (igs_remote_agent_t **remote_agent)
     igs_debug ("cleaning remote agent %s (%s)",
                (*remote_agent)->definition->name, (*remote_agent)->uuid);
 
+    if ((*remote_agent)->topic_key && (*remote_agent)->peer)
+        HASH_DELETE (hh_topic_key, (*remote_agent)->peer->remote_agents_by_topic_key,
+                     *remote_agent);
+
     // clean the agent definition & mapping
-    if ((*remote_agent)->definition)
-        definition_free_definition (&(*remote_agent)->definition);
+    (*remote_agent)->definition = NULL;
+    if ((*remote_agent)->shared_definition)
+        s_network_release_definition ((*remote_agent)->context, &(*remote_agent)->shared_definition);
+    s_network_free_remote_output_states (*remote_agent);
     if ((*remote_agent)->mapping)
         mapping_free_mapping (&(*remote_agent)->mapping);
 
@@ -688,7 +2124,7 @@ void s_clean_and_free_remote_agent (igs_remote_agent_t **remote_agent)
     igs_mapping_filter_t *elt, *tmp;
     DL_FOREACH_SAFE ((*remote_agent)->mapping_filters, elt, tmp)
     {
-        zsock_set_unsubscribe ((*remote_agent)->peer->subscriber, elt->filter);
+        zsock_set_unsubscribe (elt->subscriber, elt->filter);
         DL_DELETE ((*remote_agent)->mapping_filters, elt);
         free (elt->filter);
         free (elt);
@@ -753,9 +2189,8 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             }
 
             const char *peer_public_key = zyre_event_header (zyre_event, "X-PUBLICKEY");
-            const char *protocol_version = zyre_event_header (zyre_event, "protocol");
-            if (protocol_version)
-                zyre_peer->protocol = s_strndup (protocol_version, 16);
+            s_network_set_peer_protocol (context, zyre_peer,
+                                         zyre_event_header (zyre_event, "protocol"));
 
             const char *publisher_port = zyre_event_header (zyre_event, "publisher");
             if (publisher_port) {
@@ -814,11 +2249,30 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                                 useIPC = true;
                                 igs_debug ("Use address %s to subscribe to %s", ipc_address, name);
                             }
+                            if (ipc_address
+                                && s_network_protocol_version (zyre_peer->protocol) >= IGS_COMPACT_PUBLICATIONS_PROTOCOL) {
+                                // this peer may read large values from our shared memory
+                                zyre_peer->is_on_same_host = true;
+                                IGS_ATOMIC_ADD64 (&context->same_host_peers_nb, 1);
+                            }
                         }
                     }
                     *insert = ':';
                     // add port to the endpoint to compose it fully
                     strcat (endpoint_address, publisher_port);
+#if defined(IGS_SHARED_MEMORY_ENABLED)
+                    const char *shared_memory_name = zyre_event_header (zyre_event, "shm");
+                    if (context->network_allow_ipc && useIPC && !use_inproc && shared_memory_name) {
+                        // large values published to us using ipc are in the shared memory
+                        // of this peer : we use tcp if we cannot read it
+                        zyre_peer->shared_memory = s_network_open_shared_memory (shared_memory_name);
+                        if (!zyre_peer->shared_memory) {
+                            igs_warn ("could not open shared memory '%s' of %s (%s) : using tcp",
+                                      shared_memory_name, name, strerror (errno));
+                            useIPC = false;
+                        }
+                    }
+#endif
                     if (context->network_allow_inproc && use_inproc) {
                         zyre_peer->subscriber = zsock_new_sub (inproc_address, NULL);
                         zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
@@ -837,6 +2291,33 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                         zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
                         igs_debug ("Subscription created for %s at %s (tcp)",
                                    zyre_peer->name, endpoint_address);
+                        // publishers of the priority classes of this peer
+                        *(insert + 1) = '\0';
+                        for (int priority = IGS_PRIORITY_NORMAL + 1; priority < IGS_OUTPUT_PRIORITIES_NB; priority++) {
+                            const char *priority_port = zyre_event_header (zyre_event, s_network_priority_headers[priority]);
+                            if (!priority_port)
+                                continue;
+                            char priority_endpoint[512];
+                            snprintf (priority_endpoint, 512, "%s%s", endpoint_address, priority_port);
+                            zsock_t *priority_subscriber = zsock_new_sub (priority_endpoint, NULL);
+                            if (!priority_subscriber) {
+                                // its publisher also sends this class on its normal socket
+                                igs_warn ("could not subscribe to %s at %s (%s) : using its normal publisher for this class",
+                                          zyre_peer->name, priority_endpoint, s_network_priority_headers[priority]);
+                                continue;
+                            }
+                            zsock_set_rcvhwm (priority_subscriber, context->network_hwm_value);
+                            if (context->security_is_enabled && peer_public_key) {
+                                zcert_apply (context->security_cert, priority_subscriber);
+                                zsock_set_curve_serverkey (priority_subscriber, peer_public_key);
+                            }
+                            zloop_reader (loop, priority_subscriber, s_manage_received_publication, zyre_peer);
+                            zloop_reader_set_tolerant (loop, priority_subscriber);
+                            zyre_peer->priority_subscribers[priority] = priority_subscriber;
+                            igs_debug ("Subscription created for %s at %s (tcp, %s)",
+                                       zyre_peer->name, priority_endpoint, s_network_priority_headers[priority]);
+                        }
+                        strcat (endpoint_address, publisher_port);
                     }
                     assert (zyre_peer->subscriber);
 
@@ -844,7 +2325,7 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                         zcert_apply (context->security_cert, zyre_peer->subscriber);
                         zsock_set_curve_serverkey (zyre_peer->subscriber, peer_public_key);
                     }
-                    zloop_reader (loop, zyre_peer->subscriber, s_manage_received_publication, context);
+                    zloop_reader (loop, zyre_peer->subscriber, s_manage_received_publication, zyre_peer);
                     zloop_reader_set_tolerant (loop, zyre_peer->subscriber);
                 }
             }
@@ -869,40 +2350,28 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             assert (zyre_peer);
 
             igsagent_t *agent, *tmp;
-            char *definition_str = NULL;
             char *mapping_str = NULL;
+            model_read_write_lock (__FUNCTION__, __LINE__);
             HASH_ITER (hh, context->agents, agent, tmp){
                 // definition is sent to every newcomer on the channel (whether it is a
                 // ingescape agent or not)
-                if (zyre_peer->protocol
-                    && (streq (zyre_peer->protocol, "v2")
-                        || streq (zyre_peer->protocol, "v3")))
-                    definition_str = parser_export_definition_legacy (agent->definition);
-                else
-                    definition_str = parser_export_definition (agent->definition);
-                if (definition_str) {
-                    s_send_definition_to_zyre_peer (agent, peerUUID,
-                                                    definition_str, false);
-                    free (definition_str);
-                    definition_str = NULL;
-                }
-                else
-                    s_send_definition_to_zyre_peer (agent, peerUUID, "", false);
+                s_send_definition_to_zyre_peer (agent, zyre_peer, false);
                 // and so is our mapping
                 if (zyre_peer->protocol && streq (zyre_peer->protocol, "v2"))
                     mapping_str = parser_export_mapping_legacy (agent->mapping);
                 else
                     mapping_str = parser_export_mapping (agent->mapping);
                 if (mapping_str) {
-                    s_send_mapping_to_zyre_peer (agent, peerUUID, mapping_str);
+                    s_send_mapping_to_zyre_peer (agent, zyre_peer, mapping_str);
                     free (mapping_str);
                     mapping_str = NULL;
                 }
                 else
-                    s_send_mapping_to_zyre_peer (agent, peerUUID, "");
+                    s_send_mapping_to_zyre_peer (agent, zyre_peer, "");
                 // and so is the state of our internal variables
                 s_send_state_to (agent, peerUUID, true);
             }
+            model_read_write_unlock (__FUNCTION__, __LINE__);
             zyre_peer->has_joined_private_channel = true;
         }
     }
@@ -1099,11 +2568,51 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 zyre_event_destroy (&zyre_event);
                 return 0;
             }
-
-            // Load definition from string content
-            igs_definition_t *new_definition = parser_load_definition (str_definition);
+            igs_zyre_peer_t *zyre_peer = NULL;
+            HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
+            assert (zyre_peer);
+            // Additonal notification flag means that the remote agent has been
+            // started during runtime. Recent peers always send it, followed by
+            // the topic key of the compact publications of this agent.
+            bool knows_us = false;
+            uint16_t topic_key = 0;
+            char *fingerprint = NULL;
+            uint64_t definition_revision = 0;
+            char *notification = zmsg_popstr (msg_duplicate);
+            if (notification) {
+                knows_us = !streq (notification, "0");
+                free (notification);
+            }
+            if (s_network_protocol_version (zyre_peer->protocol) >= IGS_COMPACT_PUBLICATIONS_PROTOCOL) {
+                char *key_str = zmsg_popstr (msg_duplicate);
+                if (key_str) {
+                    topic_key = (uint16_t) strtoul (key_str, NULL, 16);
+                    free (key_str);
+                }
+                fingerprint = zmsg_popstr (msg_duplicate);
+                if (fingerprint && strlen (fingerprint) == 0) {
+                    free (fingerprint);
+                    fingerprint = NULL;
+                }
+                char *revision_str = zmsg_popstr (msg_duplicate);
+                if (revision_str) {
+                    definition_revision = strtoull (revision_str, NULL, 10);
+                    free (revision_str);
+                }
+            }
+            if (fingerprint == NULL)
+                fingerprint = s_network_definition_fingerprint (str_definition, strlen (str_definition));
+
+            // Load definition from string content, unless already known
+            igs_shared_definition_t *shared_definition = NULL;
+            HASH_FIND_STR (context->shared_definitions, fingerprint, shared_definition);
+            igs_definition_t *new_definition = (shared_definition) ? shared_definition->definition
+                                                                   : parser_load_definition (str_definition);
             if (new_definition && new_definition->name) {
+                if (shared_definition == NULL)
+                    shared_definition = s_network_share_definition (context, fingerprint, new_definition);
                 bool is_agent_new = false;
+                bool is_definition_unchanged = false;
                 igs_remote_agent_t *remote_agent = NULL;
                 HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
                 if (remote_agent == NULL) {
@@ -1111,15 +2620,20 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                       sizeof (igs_remote_agent_t));
                     remote_agent->context = context;
                     remote_agent->uuid = strdup (uuid);
-                    igs_zyre_peer_t *zyre_peer = NULL;
-                    HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
-                    assert (zyre_peer);
                     remote_agent->peer = zyre_peer;
                     remote_agent->definition = new_definition;
+                    remote_agent->shared_definition = shared_definition;
+                    shared_definition->refcount++;
                     HASH_ADD_STR (context->remote_agents, uuid, remote_agent);
                     igs_debug ("registering agent %s(%s)", uuid,
                                remote_agent_name);
                     is_agent_new = true;
+                } else if (remote_agent->shared_definition == shared_definition) {
+                    // we already know this agent and its definition did not change,
+                    // e.g. after a reconnection
+                    igs_debug ("definition of remote agent %s(%s) is unchanged",
+                               remote_agent->definition->name, remote_agent->uuid);
+                    is_definition_unchanged = true;
                 } else {
                     // else we already know this agent, its definition (possibly including name)
                     // has been updated
@@ -1133,11 +2647,18 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                           "Remote agent is changing name from %s to %s",
                           remote_agent->definition->name, new_definition->name);
 
-                    igs_definition_t *old_def = remote_agent->definition;
+                    igs_shared_definition_t *old_def = remote_agent->shared_definition;
                     remote_agent->definition = new_definition;
-                    definition_free_definition (&old_def);
+                    remote_agent->shared_definition = shared_definition;
+                    shared_definition->refcount++;
+                    s_network_release_definition (context, &old_def);
+                    // reception state of outputs belongs to the previous definition
+                    s_network_free_remote_output_states (remote_agent);
                 }
                 assert (remote_agent);
+                remote_agent->definition_revision = definition_revision;
+                if (topic_key && topic_key != remote_agent->topic_key)
+                    s_network_register_topic_key (remote_agent, topic_key);
 
                 igs_debug ("store definition for remote agent %s(%s)",
                            remote_agent->definition->name, remote_agent->uuid);
@@ -1146,22 +2667,18 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 // remote agent definition is required to handle received data.
                 igsagent_t *agent, *tmp;
                 HASH_ITER (hh, context->agents, agent, tmp)
-                    s_network_configure_mapping_to_remote_agent (agent, remote_agent);
+                    s_network_configure_mapping_to_remote_agent (agent, remote_agent, NULL);
 
                 if (is_agent_new) {
                     s_agent_propagate_agent_event (IGS_AGENT_ENTERED, uuid,
                                                    remote_agent_name, str_definition);
 
-                    // Additonal notification flag below means that the remote agent has been
-                    // started during runtime: remote peer init has already been done and
-                    // this remote agent knows our agents already => propagate to our
-                    // agents immediately.
-                    char *notification = zmsg_popstr (msg_duplicate);
-                    if (notification) {
+                    // When the remote agent has been started during runtime, remote
+                    // peer init has already been done and this remote agent knows our
+                    // agents already => propagate to our agents immediately.
+                    if (knows_us)
                         s_agent_propagate_agent_event (IGS_AGENT_KNOWS_US, uuid,
                                                        remote_agent_name, NULL);
-                        free (notification);
-                    }
 
                     // notify remote agent that our agents knows it
                     s_lock_zyre_peer (__FUNCTION__, __LINE__);
@@ -1206,7 +2723,7 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                         }
                     }
                 }
-                else
+                else if (!is_definition_unchanged)
                     s_agent_propagate_agent_event (IGS_AGENT_UPDATED_DEFINITION,
                                                    uuid, remote_agent_name, str_definition);
             }
@@ -1221,8 +2738,12 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                                "is empty or "
                                "invalid : agent will not be registered",
                                remote_agent_name, uuid);
+                // shared definitions always have a name
+                if (new_definition)
+                    definition_free_definition (&new_definition);
             }
             free (str_definition);
+            free (fingerprint);
             free (uuid);
             free (remote_agent_name);
         }
@@ -1259,6 +2780,12 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 zyre_event_destroy (&zyre_event);
                 return 0;
             }
+            // recent peers send the revision on which their next mapping
+            // deltas will be based
+            char *revision_str = zmsg_popstr (msg_duplicate);
+            remote_agent->mapping_revision = (revision_str) ? strtoull (revision_str, NULL, 10) : 0;
+            if (revision_str)
+                free (revision_str);
 
             igs_mapping_t *new_mapping = NULL;
             if (strlen (str_mapping) > 0) {
@@ -1298,6 +2825,166 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             free (uuid);
         }
         else
+        if (streq (title, EXTERNAL_DEFINITION_DELTA_MSG)) {
+            // Changes of a remote agent definition since a revision we should
+            // know, applied in place. Frames are the agent uuid, the base and
+            // new revisions, the JSON fragment of added or changed elements
+            // and the kind and name of each removed element.
+            char *uuid = zmsg_popstr (msg_duplicate);
+            char *base_str = zmsg_popstr (msg_duplicate);
+            char *revision_str = zmsg_popstr (msg_duplicate);
+            char *fragment_str = zmsg_popstr (msg_duplicate);
+            if (!uuid || !base_str || !revision_str || !fragment_str) {
+                igs_error ("invalid %s message received from %s(%s): rejecting",
+                           title, name, peerUUID);
+                free (uuid);
+                free (base_str);
+                free (revision_str);
+                free (fragment_str);
+                zmsg_destroy (&msg_duplicate);
+                zyre_event_destroy (&zyre_event);
+                return 0;
+            }
+            uint64_t base = strtoull (base_str, NULL, 10);
+            uint64_t revision = strtoull (revision_str, NULL, 10);
+            igs_remote_agent_t *remote_agent = NULL;
+            HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+            bool needs_resync = false;
+            if (remote_agent && revision <= remote_agent->definition_revision)
+                igs_debug ("ignoring outdated definition delta for %s(%s)",
+                           remote_agent->definition->name, uuid);
+            else if (!remote_agent || base != remote_agent->definition_revision)
+                needs_resync = true;
+            else {
+                igs_definition_t *fragment = NULL;
+                if (strlen (fragment_str) > 0) {
+                    fragment = parser_load_definition (fragment_str);
+                    if (!fragment)
+                        needs_resync = true;
+                }
+                if (!needs_resync && s_network_make_definition_private (remote_agent) == IGS_SUCCESS) {
+                    char *kind = NULL;
+                    while ((kind = zmsg_popstr (msg_duplicate))) {
+                        char *element = zmsg_popstr (msg_duplicate);
+                        if (element) {
+                            if (kind[0] == IGS_DELTA_OUTPUT)
+                                s_network_reset_remote_output_state (remote_agent, element);
+                            definition_remove_element (remote_agent->definition, kind[0], element);
+                            free (element);
+                        }
+                        free (kind);
+                    }
+                    // only added or changed outputs need their subscriptions
+                    // to be checked again
+                    zlist_t *touched_outputs = zlist_new ();
+                    zlist_autofree (touched_outputs);
+                    if (fragment) {
+                        igs_iop_t *iop, *tmp_iop;
+                        HASH_ITER (hh, fragment->outputs_table, iop, tmp_iop){
+                            s_network_reset_remote_output_state (remote_agent, iop->name);
+                            zlist_append (touched_outputs, iop->name);
+                        }
+                        definition_merge (remote_agent->definition, &fragment);
+                    }
+                    remote_agent->definition_revision = revision;
+                    igs_debug ("definition of remote agent %s(%s) updated to revision %llu",
+                               remote_agent->definition->name, uuid, (unsigned long long) revision);
+                    igsagent_t *agent, *tmp;
+                    HASH_ITER (hh, context->agents, agent, tmp){
+                        char *output = zlist_first (touched_outputs);
+                        while (output) {
+                            s_network_configure_mapping_to_remote_agent (agent, remote_agent, output);
+                            output = zlist_next (touched_outputs);
+                        }
+                    }
+                    zlist_destroy (&touched_outputs);
+                    if (s_network_has_agent_event_callbacks (context)) {
+                        char *definition_str = parser_export_definition (remote_agent->definition);
+                        s_agent_propagate_agent_event (IGS_AGENT_UPDATED_DEFINITION, uuid,
+                                                       remote_agent->definition->name, definition_str);
+                        if (definition_str)
+                            free (definition_str);
+                    }
+                } else
+                    needs_resync = true;
+                if (fragment)
+                    definition_free_definition (&fragment);
+            }
+            if (needs_resync) {
+                igs_debug ("missed definition changes for agent %s : requesting its full definition", uuid);
+                s_network_request_resync (peerUUID, GET_DEFINITION_MSG, uuid);
+            }
+            free (uuid);
+            free (base_str);
+            free (revision_str);
+            free (fragment_str);
+        }
+        else
+        if (streq (title, EXTERNAL_MAPPING_DELTA_MSG)) {
+            // Changes of a remote agent mapping since a revision we should
+            // know. Frames are the agent uuid, the base and new revisions,
+            // the JSON fragment of added elements and the id of each
+            // removed element.
+            char *uuid = zmsg_popstr (msg_duplicate);
+            char *base_str = zmsg_popstr (msg_duplicate);
+            char *revision_str = zmsg_popstr (msg_duplicate);
+            char *fragment_str = zmsg_popstr (msg_duplicate);
+            if (!uuid || !base_str || !revision_str || !fragment_str) {
+                igs_error ("invalid %s message received from %s(%s): rejecting",
+                           title, name, peerUUID);
+                free (uuid);
+                free (base_str);
+                free (revision_str);
+                free (fragment_str);
+                zmsg_destroy (&msg_duplicate);
+                zyre_event_destroy (&zyre_event);
+                return 0;
+            }
+            uint64_t base = strtoull (base_str, NULL, 10);
+            uint64_t revision = strtoull (revision_str, NULL, 10);
+            igs_remote_agent_t *remote_agent = NULL;
+            HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+            igs_mapping_t *fragment = NULL;
+            bool needs_resync = false;
+            if (remote_agent && revision <= remote_agent->mapping_revision)
+                igs_debug ("ignoring outdated mapping delta for %s(%s)",
+                           remote_agent->definition->name, uuid);
+            else if (!remote_agent || base != remote_agent->mapping_revision)
+                needs_resync = true;
+            else if (strlen (fragment_str) > 0
+                     && (fragment = parser_load_mapping (fragment_str)) == NULL)
+                needs_resync = true;
+            else {
+                if (!remote_agent->mapping)
+                    remote_agent->mapping = (igs_mapping_t *) zmalloc (sizeof (igs_mapping_t));
+                char *id_str = NULL;
+                while ((id_str = zmsg_popstr (msg_duplicate))) {
+                    mapping_remove_element (remote_agent->mapping, strtoull (id_str, NULL, 10));
+                    free (id_str);
+                }
+                if (fragment)
+                    mapping_merge (remote_agent->mapping, &fragment);
+                remote_agent->mapping_revision = revision;
+                igs_debug ("mapping of remote agent %s(%s) updated to revision %llu",
+                           remote_agent->definition->name, uuid, (unsigned long long) revision);
+                if (s_network_has_agent_event_callbacks (context)) {
+                    char *mapping_str = parser_export_mapping (remote_agent->mapping);
+                    s_agent_propagate_agent_event (IGS_AGENT_UPDATED_MAPPING, uuid,
+                                                   remote_agent->definition->name, mapping_str);
+                    if (mapping_str)
+                        free (mapping_str);
+                }
+            }
+            if (needs_resync) {
+                igs_debug ("missed mapping changes for agent %s : requesting its full mapping", uuid);
+                s_network_request_resync (peerUUID, GET_MAPPING_MSG, uuid);
+            }
+            free (uuid);
+            free (base_str);
+            free (revision_str);
+            free (fragment_str);
+        }
+        else
         if (streq (title, LOAD_DEFINITION_MSG)) {
             // identify agent
             char *str_definition = zmsg_popstr (msg_duplicate);
@@ -1342,7 +3029,7 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 HASH_ITER (hh, context->remote_agents, remote, tmp)
                 {
                     s_network_configure_mapping_to_remote_agent (agent,
-                                                                  remote);
+                                                                  remote, NULL);
                 }
             }
             free (str_definition);
@@ -1388,17 +3075,21 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             // Load mapping from string content
             igs_mapping_t *new_mapping = parser_load_mapping (str_mapping);
             if (new_mapping) {
+                model_read_write_lock (__FUNCTION__, __LINE__);
                 if (agent->mapping)
                     mapping_free_mapping (&agent->mapping);
                 agent->mapping = new_mapping;
+                mapping_update_routes (agent);
+                mapping_touch (agent);
+                model_read_write_unlock (__FUNCTION__, __LINE__);
                 // check and activate mapping
                 igs_remote_agent_t *remote, *tmp;
                 HASH_ITER (hh, context->remote_agents, remote, tmp)
                 {
                     s_network_configure_mapping_to_remote_agent (agent,
-                                                                  remote);
+                                                                  remote, NULL);
                 }
-                agent->network_need_to_send_mapping_update = true;
+                network_schedule_mapping_update (agent);
             }
             free (str_mapping);
             free (uuid);
@@ -1407,6 +3098,38 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             //
             // OTHER SUPPORTED MESSAGES
             //
+            if (streq (title, GET_DEFINITION_MSG) || streq (title, GET_MAPPING_MSG)) {
+                // a peer missed some of our deltas and needs a full resync
+                char *uuid = zmsg_popstr (msg_duplicate);
+                if (uuid == NULL) {
+                    igs_error ("no valid uuid in %s message received from "
+                               "%s(%s): rejecting",
+                               title, name, peerUUID);
+                    zmsg_destroy (&msg_duplicate);
+                    zyre_event_destroy (&zyre_event);
+                    return 0;
+                }
+                igs_zyre_peer_t *zyre_peer = NULL;
+                HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
+                model_read_write_lock (__FUNCTION__, __LINE__);
+                igsagent_t *agent = NULL;
+                HASH_FIND_STR (context->agents, uuid, agent);
+                if (agent && zyre_peer) {
+                    if (streq (title, GET_DEFINITION_MSG))
+                        s_send_definition_to_zyre_peer (agent, zyre_peer, false);
+                    else {
+                        char *mapping_str = parser_export_mapping (agent->mapping);
+                        s_send_mapping_to_zyre_peer (agent, zyre_peer, (mapping_str) ? mapping_str : "");
+                        if (mapping_str)
+                            free (mapping_str);
+                    }
+                } else
+                    igs_debug ("no agent with uuid '%s' for %s message received from %s(%s)",
+                               uuid, title, name, peerUUID);
+                model_read_write_unlock (__FUNCTION__, __LINE__);
+                free (uuid);
+            }
+            else
             if (streq (title, GET_CURRENT_OUTPUTS_MSG)) {
                 // identify agent
                 char *uuid = zmsg_popstr (msg_duplicate);
@@ -1441,6 +3164,8 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 zmsg_t *msg_to_send = zmsg_new ();
                 zmsg_addstr (msg_to_send, CURRENT_OUTPUTS_MSG);
                 zmsg_addstr (msg_to_send, agent->uuid);
+                // typed arrays are unknown to peers older than v5
+                bool peer_knows_arrays = s_network_peer_knows_arrays (context, peerUUID);
                 igs_iop_t *outputs = agent->definition->outputs_table;
                 igs_iop_t *current = NULL;
                 for (current = outputs; current;
@@ -1493,6 +3218,16 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                             //                                    (found_iop->value.data),
                             //                                    found_iop->value_size);
                             break;
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
+                            // older peers know arrays as DATA from our definition
+                            zmsg_addstr (msg_to_send, current->name);
+                            zmsg_addstrf (msg_to_send, "%d",
+                                          (peer_knows_arrays) ? (int) current->value_type : (int) IGS_DATA_T);
+                            zmsg_addmem (msg_to_send, (current->value.data),
+                                         current->value_size);
+                            break;
 
                         default:
                             break;
@@ -1569,6 +3304,8 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 zmsg_t *msg_to_send = zmsg_new ();
                 zmsg_addstr (msg_to_send, CURRENT_INPUTS_MSG);
                 zmsg_addstr (msg_to_send, agent->uuid);
+                // typed arrays are unknown to peers older than v5
+                bool peer_knows_arrays = s_network_peer_knows_arrays (context, peerUUID);
                 igs_iop_t *outputs = agent->definition->inputs_table;
                 igs_iop_t *current = NULL;
                 for (current = outputs; current;
@@ -1614,6 +3351,16 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                             zmsg_addmem (msg_to_send, (current->value.data),
                                          current->value_size);
                             break;
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
+                            // older peers know arrays as DATA from our definition
+                            zmsg_addstr (msg_to_send, current->name);
+                            zmsg_addstrf (msg_to_send, "%d",
+                                          (peer_knows_arrays) ? (int) current->value_type : (int) IGS_DATA_T);
+                            zmsg_addmem (msg_to_send, (current->value.data),
+                                         current->value_size);
+                            break;
 
                         default:
                             break;
@@ -1661,6 +3408,8 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 zmsg_t *msg_to_send = zmsg_new ();
                 zmsg_addstr (msg_to_send, CURRENT_PARAMETERS_MSG);
                 zmsg_addstr (msg_to_send, agent->uuid);
+                // typed arrays are unknown to peers older than v5
+                bool peer_knows_arrays = s_network_peer_knows_arrays (context, peerUUID);
                 igs_iop_t *outputs = agent->definition->params_table;
                 igs_iop_t *current = NULL;
                 for (current = outputs; current;
@@ -1706,6 +3455,16 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                             zmsg_addmem (msg_to_send, (current->value.data),
                                          current->value_size);
                             break;
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
+                            // older peers know arrays as DATA from our definition
+                            zmsg_addstr (msg_to_send, current->name);
+                            zmsg_addstrf (msg_to_send, "%d",
+                                          (peer_knows_arrays) ? (int) current->value_type : (int) IGS_DATA_T);
+                            zmsg_addmem (msg_to_send, (current->value.data),
+                                         current->value_size);
+                            break;
 
                         default:
                             break;
@@ -1719,6 +3478,42 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                 free (uuid);
             }
             else
+            if (streq (title, GET_OUTPUT_KEYFRAME_MSG)) {
+                char *uuid = zmsg_popstr (msg_duplicate);
+                char *output_name = zmsg_popstr (msg_duplicate);
+                igsagent_t *agent = NULL;
+                if (uuid)
+                    HASH_FIND_STR (context->agents, uuid, agent);
+                if (agent == NULL || output_name == NULL) {
+                    igs_error ("no valid agent or output in %s message received from "
+                               "%s(%s): rejecting",
+                               title, name, peerUUID);
+                    if (uuid)
+                        free (uuid);
+                    if (output_name)
+                        free (output_name);
+                    zmsg_destroy (&msg_duplicate);
+                    zyre_event_destroy (&zyre_event);
+                    return 0;
+                }
+                model_read_lock (__FUNCTION__, __LINE__);
+                // check that this agent has not been destroyed when we were locked
+                if (agent->uuid) {
+                    igs_iop_t *output = model_find_iop_by_name (agent, output_name, IGS_OUTPUT_T);
+                    if (output && output->delta_keyframe_interval > 0) {
+                        // sent with the next publication of this output
+                        igs_debug ("%s(%s) asks keyframe for %s.%s", name, peerUUID,
+                                   agent->definition->name, output_name);
+                        model_agent_write_lock (agent);
+                        output->delta_keyframe_requested = true;
+                        model_agent_write_unlock (agent);
+                    }
+                }
+                model_read_unlock (__FUNCTION__, __LINE__);
+                free (uuid);
+                free (output_name);
+            }
+            else
             if (streq (title, START_AGENT_MSG)) {
                 char *agent_name = zmsg_popstr (msg_duplicate);
                 if (agent_name == NULL) {
@@ -2533,7 +4328,8 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
             }
             else
             if (streq (title, CALL_SERVICE_MSG)
-                || streq (title, CALL_SERVICE_MSG_DEPRECATED)) {
+                || streq (title, CALL_SERVICE_MSG_DEPRECATED)
+                || streq (title, CALL_SERVICE_COMPRESSED_MSG)) {
 
                 // identify agent
                 char *caller_uuid = zmsg_popstr (msg_duplicate);
@@ -2594,6 +4390,19 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                     return 0;
                 }
 
+                if (streq (title, CALL_SERVICE_COMPRESSED_MSG)
+                    && s_network_decompress_arguments (msg_duplicate) != IGS_SUCCESS) {
+                    igs_error ("compressed arguments are corrupted in %s message received from %s(%s): rejecting",
+                               title, name, peerUUID);
+                    free (caller_uuid);
+                    free (callee_uuid);
+                    free (service_name);
+                    free (token);
+                    zmsg_destroy (&msg_duplicate);
+                    zyre_event_destroy (&zyre_event);
+                    return 0;
+                }
+
                 if (callee_agent->definition
                     && callee_agent->definition->services_table) {
                     igs_service_t *service = NULL;
@@ -2822,7 +4631,67 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
     return 0;
 }
 
-// Timer callback to (re)send our definition to agents present on the private channel
+// Delta of an agent definition since the last one sent to peers, made of the
+// elements that changed and still exist and of the elements that were removed.
+// Model lock must be held.
+zmsg_t *s_network_definition_delta (igsagent_t *agent)
+{
+    assert (agent);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, EXTERNAL_DEFINITION_DELTA_MSG);
+    zmsg_addstr (msg, agent->uuid);
+    zmsg_addstrf (msg, "%llu", (unsigned long long) agent->definition_sent_revision);
+    zmsg_addstrf (msg, "%llu", (unsigned long long) agent->definition_revision);
+    char *fragment = parser_export_definition_fragment (agent->definition, agent->definition_changes);
+    zmsg_addstr (msg, (fragment) ? fragment : "");
+    if (fragment)
+        free (fragment);
+    igs_delta_change_t *change = NULL;
+    LL_FOREACH (agent->definition_changes, change){
+        igs_iop_t *iop = NULL;
+        igs_service_t *service = NULL;
+        if (change->kind == IGS_DELTA_INPUT)
+            HASH_FIND_STR (agent->definition->inputs_table, change->name, iop);
+        else if (change->kind == IGS_DELTA_OUTPUT)
+            HASH_FIND_STR (agent->definition->outputs_table, change->name, iop);
+        else if (change->kind == IGS_DELTA_PARAMETER)
+            HASH_FIND_STR (agent->definition->params_table, change->name, iop);
+        else if (change->kind == IGS_DELTA_SERVICE)
+            HASH_FIND_STR (agent->definition->services_table, change->name, service);
+        if (!iop && !service) {
+            zmsg_addstrf (msg, "%c", change->kind);
+            zmsg_addstr (msg, change->name);
+        }
+    }
+    return msg;
+}
+
+// Delta of an agent mapping since the last one sent to peers.
+// Model lock must be held.
+zmsg_t *s_network_mapping_delta (igsagent_t *agent)
+{
+    assert (agent);
+    assert (agent->mapping);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, EXTERNAL_MAPPING_DELTA_MSG);
+    zmsg_addstr (msg, agent->uuid);
+    zmsg_addstrf (msg, "%llu", (unsigned long long) agent->mapping_sent_revision);
+    zmsg_addstrf (msg, "%llu", (unsigned long long) agent->mapping_revision);
+    char *fragment = parser_export_mapping_fragment (agent->mapping, agent->mapping_changes);
+    zmsg_addstr (msg, (fragment) ? fragment : "");
+    if (fragment)
+        free (fragment);
+    igs_delta_change_t *change = NULL;
+    LL_FOREACH (agent->mapping_changes, change){
+        igs_map_t *elmt = NULL;
+        HASH_FIND (hh, agent->mapping->map_elements, &change->id, sizeof (uint64_t), elmt);
+        if (!elmt)
+            zmsg_addstrf (msg, "%llu", (unsigned long long) change->id);
+    }
+    return msg;
+}
+
+// (Re)sends our changed definitions to agents present on the private channel
 int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
@@ -2838,22 +4707,42 @@ int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
             if (!agent || !(agent->uuid))
                 continue;
             
-            char *definition_str = parser_export_definition (agent->definition);
-            char *definition_str_legacy = parser_export_definition_legacy (agent->definition);
+            // Peers knowing our last sent revision only receive what changed
+            // since then. Others, and all peers after changes that deltas
+            // cannot describe, receive our whole definition. Exports are
+            // generated at most once per change and shared by all peers.
+            bool full_update = agent->definition_sent_revision == 0
+                               || agent->definition_needs_full_update
+                               || agent->network_activation_during_runtime;
+            zmsg_t *delta = NULL;
             igs_zyre_peer_t *p, *ptmp;
             HASH_ITER (hh, context->zyre_peers, p, ptmp){
-                if (p->has_joined_private_channel) {
-                    if (p->protocol && (streq (p->protocol, "v2") || streq (p->protocol, "v3"))){
-                        if (definition_str_legacy)
-                            s_send_definition_to_zyre_peer (agent, p->peer_id, definition_str_legacy,
-                                                            agent->network_activation_during_runtime);
-                    }else{
-                        if (definition_str)
-                            s_send_definition_to_zyre_peer (agent, p->peer_id, definition_str,
-                                                            agent->network_activation_during_runtime);
-                    }
+                if (!p->has_joined_private_channel)
+                    continue;
+                if (full_update
+                    || s_network_protocol_version (p->protocol) < IGS_DEFINITION_DELTAS_PROTOCOL)
+                    s_send_definition_to_zyre_peer (agent, p,
+                                                    agent->network_activation_during_runtime);
+                else {
+                    if (!delta)
+                        delta = s_network_definition_delta (agent);
+                    zmsg_t *msg = zmsg_dup (delta);
+                    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+                    zyre_whisper (context->node, p->peer_id, &msg);
+                    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
                 }
             }
+            if (delta)
+                zmsg_destroy (&delta);
+            definition_free_changes (&agent->definition_changes);
+            agent->definition_needs_full_update = false;
+            agent->definition_sent_revision = agent->definition_revision;
+            igs_data_buffer_t *definition = NULL;
+            if (s_network_has_agent_event_callbacks (context)) {
+                definition = s_network_definition_export (agent, IGS_DEFINITION_EXPORT_CURRENT);
+                if (definition)
+                    model_data_buffer_retain (definition);
+            }
             agent->network_activation_during_runtime = false; // reset flag
             // NB: this is not optimal to resend state details on definition change
             // but it is the cleanest way to send state on after-start agent
@@ -2864,22 +4753,21 @@ int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
             model_read_write_unlock (__FUNCTION__, __LINE__);
             //propagate definition update to other agents in the same process (if any)
             s_agent_propagate_agent_event (IGS_AGENT_UPDATED_DEFINITION,
-                                           agent->uuid, agent->definition->name, definition_str);
+                                           agent->uuid, agent->definition->name,
+                                           (definition) ? (char *) definition->data : NULL);
             model_read_write_lock (__FUNCTION__, __LINE__);
             // when definition changes, mapping may need to be updated as well
             agent->network_need_to_send_mapping_update = true;
             
-            if (definition_str)
-                free(definition_str);
-            if (definition_str_legacy)
-                free(definition_str_legacy);
+            if (definition)
+                model_data_buffer_release (&definition);
         }
     }
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return 0;
 }
 
-// Timer callback to update and (re)send our mapping to agents on the private
+// Updates and (re)sends our changed mappings to agents on the private
 // channel
 int s_trigger_mapping_update (zloop_t *loop, int timer_id, void *arg)
 {
@@ -2897,28 +4785,55 @@ int s_trigger_mapping_update (zloop_t *loop, int timer_id, void *arg)
                 model_read_write_unlock (__FUNCTION__, __LINE__);
                 return 0;
             }
-            char *mapping_str = parser_export_mapping (agent->mapping);
-            char *mapping_str_legacy = parser_export_mapping_legacy (agent->mapping);
+            // Definition changes also trigger this update but peers only
+            // need our mapping when it changed. Like definitions, mappings
+            // are sent as deltas to the peers supporting them.
+            bool mapping_changed = agent->mapping_revision != agent->mapping_sent_revision;
+            bool full_update = agent->mapping_sent_revision == 0
+                               || agent->mapping_needs_full_update;
+            char *mapping_str = NULL;
+            char *mapping_str_legacy = NULL;
+            zmsg_t *delta = NULL;
             igs_zyre_peer_t *p, *ptmp;
             HASH_ITER (hh, context->zyre_peers, p, ptmp){
-                if (p->has_joined_private_channel) {
-                    if (p->protocol && streq (p->protocol, "v2")){
-                        if (mapping_str_legacy)
-                            s_send_mapping_to_zyre_peer (agent, p->peer_id, mapping_str_legacy);
-                    }else{
-                        if (mapping_str)
-                            s_send_mapping_to_zyre_peer (agent, p->peer_id, mapping_str);
-                    }
+                if (!mapping_changed || !p->has_joined_private_channel)
+                    continue;
+                if (p->protocol && streq (p->protocol, "v2")){
+                    if (!mapping_str_legacy)
+                        mapping_str_legacy = parser_export_mapping_legacy (agent->mapping);
+                    if (mapping_str_legacy)
+                        s_send_mapping_to_zyre_peer (agent, p, mapping_str_legacy);
+                }else if (full_update
+                          || s_network_protocol_version (p->protocol) < IGS_DEFINITION_DELTAS_PROTOCOL){
+                    if (!mapping_str)
+                        mapping_str = parser_export_mapping (agent->mapping);
+                    if (mapping_str)
+                        s_send_mapping_to_zyre_peer (agent, p, mapping_str);
+                }else{
+                    if (!delta)
+                        delta = s_network_mapping_delta (agent);
+                    zmsg_t *msg = zmsg_dup (delta);
+                    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+                    zyre_whisper (context->node, p->peer_id, &msg);
+                    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
                 }
             }
+            if (delta)
+                zmsg_destroy (&delta);
+            definition_free_changes (&agent->mapping_changes);
+            agent->mapping_needs_full_update = false;
+            agent->mapping_sent_revision = agent->mapping_revision;
             igs_remote_agent_t *remote, *rtmp;
             HASH_ITER (hh, context->remote_agents, remote, rtmp){
-                s_network_configure_mapping_to_remote_agent (agent, remote);
+                s_network_configure_mapping_to_remote_agent (agent, remote, NULL);
             }
             agent->network_need_to_send_mapping_update = false;
+            if (mapping_changed && !mapping_str && s_network_has_agent_event_callbacks (context))
+                mapping_str = parser_export_mapping (agent->mapping);
             model_read_write_unlock (__FUNCTION__, __LINE__);
-            s_agent_propagate_agent_event (IGS_AGENT_UPDATED_MAPPING,agent->uuid,
-                                           agent->definition->name, mapping_str);
+            if (mapping_changed)
+                s_agent_propagate_agent_event (IGS_AGENT_UPDATED_MAPPING,agent->uuid,
+                                               agent->definition->name, mapping_str);
             if (mapping_str)
                 free (mapping_str);
             if (mapping_str_legacy)
@@ -2928,6 +4843,14 @@ int s_trigger_mapping_update (zloop_t *loop, int timer_id, void *arg)
     return 0;
 }
 
+/*
+ Publisher mutex serializes publications from application threads, which
+ only share the model lock while publishing, on our publisher sockets and
+ in our shared memory.
+ */
+igs_mutex_t s_network_publisher_mutex;
+static bool s_network_publisher_mutex_initialized = false;
+
 /*
  Network mutex is used to avoid collisions between starting and stopping
  an agent, and between the s_manage_zyre_incoming, s_init_loop and start/stop
@@ -2951,11 +4874,93 @@ void s_network_unlock (void)
     IGS_MUTEX_UNLOCK (s_network_mutex);
 }
 
+/*
+ Updates mutex protects the pending flag of definition and mapping updates
+ and the notifications sent for them through the pipe of our network actor,
+ which may come from any thread, including application threads holding
+ the model lock.
+ */
+igs_mutex_t s_network_updates_mutex;
+static bool s_network_updates_mutex_initialized = false;
+
+void s_network_updates_lock (void)
+{
+    if (!s_network_updates_mutex_initialized) {
+        IGS_MUTEX_INIT (s_network_updates_mutex);
+        s_network_updates_mutex_initialized = true;
+    }
+    IGS_MUTEX_LOCK (s_network_updates_mutex);
+}
+
+void s_network_updates_unlock (void)
+{
+    assert (s_network_updates_mutex_initialized);
+    IGS_MUTEX_UNLOCK (s_network_updates_mutex);
+}
+
+// Wakes our loop up to flush definition and mapping updates. Only the first
+// notification after a flush is sent : the following ones are coalesced
+// into the flush it schedules.
+void s_network_notify_updates (igs_core_context_t *context)
+{
+    s_network_updates_lock ();
+    if (!context->network_updates_pending && context->network_actor) {
+        context->network_updates_pending = true;
+        zstr_send (context->network_actor, "FLUSH_UPDATES");
+    }
+    s_network_updates_unlock ();
+}
+
+void network_schedule_definition_update (igsagent_t *agent)
+{
+    assert (agent);
+    agent->network_need_to_send_definition_update = true;
+    if (core_context)
+        s_network_notify_updates (core_context);
+}
+
+void network_schedule_mapping_update (igsagent_t *agent)
+{
+    assert (agent);
+    agent->network_need_to_send_mapping_update = true;
+    if (core_context)
+        s_network_notify_updates (core_context);
+}
+
+// Timer callback flushing all the definition and mapping updates
+// accumulated since the notification that armed it
+int s_network_flush_updates (zloop_t *loop, int timer_id, void *arg)
+{
+    igs_core_context_t *context = (igs_core_context_t *) arg;
+    assert (context);
+    // changes made from now on need a new flush
+    s_network_updates_lock ();
+    context->network_updates_pending = false;
+    s_network_updates_unlock ();
+    trigger_definition_update (loop, timer_id, context);
+    // definition updates may also require mapping updates
+    s_trigger_mapping_update (loop, timer_id, context);
+    return 0;
+}
+
+// applies the HWM and the drop policy of a priority class to its TCP publisher
+void s_network_configure_priority_publisher (igs_core_context_t *context,
+                                             igs_output_priority_t priority)
+{
+    zsock_t *publisher = (priority == IGS_PRIORITY_NORMAL) ? context->publisher
+                                                           : context->priority_publishers[priority];
+    if (!publisher)
+        return;
+    int hwm_value = context->network_priority_hwm_values[priority];
+    zsock_set_sndhwm (publisher, (hwm_value < 0) ? context->network_hwm_value : hwm_value);
+    zsock_set_xpub_nodrop (publisher, context->network_priority_policies[priority] == IGS_PUBLICATION_QUEUE_BLOCK);
+}
+
 // manage messages from the parent thread
 int s_manage_parent (zloop_t *loop, zsock_t *pipe, void *arg)
 {
-    IGS_UNUSED (loop)
-    IGS_UNUSED (arg)
+    igs_core_context_t *context = (igs_core_context_t *) arg;
+    assert (context);
 
     zmsg_t *msg = zmsg_recv (pipe);
     assert (msg);
@@ -2970,7 +4975,9 @@ int s_manage_parent (zloop_t *loop, zsock_t *pipe, void *arg)
         zmsg_destroy (&msg);
         return -1;
     }
-    //else: nothing to do so far
+    if (streq (command, "FLUSH_UPDATES"))
+        zloop_timer (loop, context->network_update_debounce, 1,
+                     s_network_flush_updates, context);
     free (command);
     zmsg_destroy (&msg);
     return 0;
@@ -3034,8 +5041,9 @@ static void s_run_loop (zsock_t *mypipe, void *args)
     zloop_reader (context->loop, zyre_socket (context->node),
                   s_manage_zyre_incoming, context);
     zloop_reader_set_tolerant (context->loop, zyre_socket (context->node));
-    zloop_timer (context->loop, 1000, 0, trigger_definition_update, context);
-    zloop_timer (context->loop, 1000, 0, s_trigger_mapping_update, context);
+    // flushes the updates notified while we were starting, if any
+    zloop_timer (context->loop, context->network_update_debounce, 1,
+                 s_network_flush_updates, context);
 
     zsock_signal (mypipe, 0);
     s_network_unlock ();
@@ -3060,6 +5068,21 @@ static void s_run_loop (zsock_t *mypipe, void *args)
         HASH_DEL (context->zyre_peers, zyre_peer);
         s_clean_and_free_zyre_peer (&zyre_peer, context->loop);
     }
+
+    // conflated values waiting for their timer are dropped
+    igs_publication_flush_t *flush, *tmp_flush;
+    DL_FOREACH_SAFE (context->publication_flushes, flush, tmp_flush){
+        DL_DELETE (context->publication_flushes, flush);
+        igsagent_t *flushed_agent = (igsagent_t *) zhash_lookup (context->created_agents,
+                                                                 flush->agent_uuid);
+        igs_iop_t *output = NULL;
+        if (flushed_agent == flush->agent)
+            output = model_find_iop_by_name (flushed_agent, flush->output, IGS_OUTPUT_T);
+        if (output)
+            output->publication_flush_pending = false;
+        free (flush->output);
+        free (flush);
+    }
     model_read_write_unlock(__FUNCTION__, __LINE__);
     
     zloop_destroy (&context->loop);
@@ -3073,9 +5096,21 @@ static void s_run_loop (zsock_t *mypipe, void *args)
     // zmq stack cleaning
     zyre_stop (context->node);
     zyre_destroy (&context->node);
+    network_stop_publication_queue (context);
     zsock_destroy (&context->publisher);
+    for (int priority = IGS_PRIORITY_NORMAL + 1; priority < IGS_OUTPUT_PRIORITIES_NB; priority++) {
+        if (context->priority_publishers[priority])
+            zsock_destroy (&context->priority_publishers[priority]);
+    }
     zsock_destroy (&context->ipc_publisher);
 #if defined(__UNIX__) && !defined(__UTYPE_IOS)
+    if (context->shared_memory_publisher) {
+        if (s_network_publisher_mutex_initialized)
+            IGS_MUTEX_LOCK (s_network_publisher_mutex);
+        s_network_close_shared_memory (&context->shared_memory_publisher, true);
+        if (s_network_publisher_mutex_initialized)
+            IGS_MUTEX_UNLOCK (s_network_publisher_mutex);
+    }
     zsys_file_delete (context->network_ipc_full_path); // destroy ipc_path in file system
     // NB: ipc_path is based on peer id which is unique. It will never be used
     // again.
@@ -3276,6 +5311,28 @@ void s_init_loop (igs_core_context_t *context)
     s_lock_zyre_peer (__FUNCTION__, __LINE__);
     zyre_set_header (context->node, "publisher", "%s", insert + 1);
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    s_network_configure_priority_publisher (context, IGS_PRIORITY_NORMAL);
+
+    // start TCP publishers of the other priority classes
+    for (int priority = IGS_PRIORITY_NORMAL + 1; priority < IGS_OUTPUT_PRIORITIES_NB; priority++) {
+        char priority_endpoint[512];
+        snprintf (priority_endpoint, 512, "tcp://%s:*", context->ip_address);
+        zsock_t *priority_publisher = zsock_new_pub (priority_endpoint);
+        if (!priority_publisher) {
+            igs_error ("zsock_new_pub(%s): %s", priority_endpoint, strerror (errno));
+            continue;
+        }
+        if (context->security_is_enabled) {
+            zcert_apply (context->security_cert, priority_publisher);
+            zsock_set_curve_server (priority_publisher, 1);
+        }
+        context->priority_publishers[priority] = priority_publisher;
+        s_network_configure_priority_publisher (context, (igs_output_priority_t) priority);
+        const char *priority_port = strrchr (zsock_endpoint (priority_publisher), ':');
+        s_lock_zyre_peer (__FUNCTION__, __LINE__);
+        zyre_set_header (context->node, s_network_priority_headers[priority], "%s", priority_port + 1);
+        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    }
 
     // start ipc publisher
 #if defined(__UNIX__) && !defined(__UTYPE_IOS)
@@ -3313,6 +5370,25 @@ void s_init_loop (igs_core_context_t *context)
     zyre_set_header (context->node, "ipc", "%s", context->network_ipc_endpoint);
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 
+    // create our shared memory for large values published to ipc subscribers
+    if (context->network_shared_memory_size > 0) {
+        char shared_memory_name[32];
+        s_lock_zyre_peer (__FUNCTION__, __LINE__);
+        const char *uuid = zyre_uuid (context->node);
+        snprintf (shared_memory_name, 32, "/igs-%.24s", uuid);
+        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+        igs_shared_memory_t *shared_memory =
+          s_network_create_shared_memory (shared_memory_name, context->network_shared_memory_size);
+        if (shared_memory) {
+            context->shared_memory_publisher = shared_memory;
+            s_lock_zyre_peer (__FUNCTION__, __LINE__);
+            zyre_set_header (context->node, "shm", "%s", shared_memory_name);
+            s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+        } else
+            igs_warn ("could not create shared memory '%s' (%s) : large values will not use it",
+                      shared_memory_name, strerror (errno));
+    }
+
 #elif defined(__WINDOWS__)
     context->network_ipc_endpoint = strdup ("tcp://127.0.0.1:*");
     zsock_t *ipc_publisher = context->ipc_publisher =
@@ -3415,55 +5491,946 @@ void s_init_loop (igs_core_context_t *context)
         || (strlen (context->command_line) == 0)) {
         // command line was not set manually : we try to get exec path instead
 
-        // Use GetModuleFileName() to get exec path
-        char exe_file_path[IGS_MAX_PATH_LENGTH];
-#ifdef UNICODE
-        WCHAR temp[IGS_MAX_PATH_LENGTH];
-        GetModuleFileName (NULL, temp, IGS_MAX_PATH_LENGTH);
-        // Conversion in char *
-        wcstombs_s (NULL, exe_file_path, sizeof (exe_file_path), temp,
-                    sizeof (temp));
-#else
-        GetModuleFileName (NULL, exe_file_path, IGS_MAX_PATH_LENGTH);
-#endif
-        s_lock_zyre_peer (__FUNCTION__, __LINE__);
-        zyre_set_header (context->node, "commandline", "%s", exe_file_path);
-        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+        // Use GetModuleFileName() to get exec path
+        char exe_file_path[IGS_MAX_PATH_LENGTH];
+#ifdef UNICODE
+        WCHAR temp[IGS_MAX_PATH_LENGTH];
+        GetModuleFileName (NULL, temp, IGS_MAX_PATH_LENGTH);
+        // Conversion in char *
+        wcstombs_s (NULL, exe_file_path, sizeof (exe_file_path), temp,
+                    sizeof (temp));
+#else
+        GetModuleFileName (NULL, exe_file_path, IGS_MAX_PATH_LENGTH);
+#endif
+        s_lock_zyre_peer (__FUNCTION__, __LINE__);
+        zyre_set_header (context->node, "commandline", "%s", exe_file_path);
+        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    }
+    else {
+        s_lock_zyre_peer (__FUNCTION__, __LINE__);
+        zyre_set_header (context->node, "commandline", "%s",
+                         context->command_line);
+        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    }
+    DWORD pid = GetCurrentProcessId ();
+    context->process_id = (int) pid;
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    zyre_set_header (context->node, "pid", "%i", (int) pid);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+#endif
+
+    // hostname
+    char hostname[1024];
+    hostname[1023] = '\0';
+    gethostname (hostname, 1023);
+#if defined(__WINDOWS__)
+    WSACleanup ();
+#endif
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    zyre_set_header (context->node, "hostname", "%s", hostname);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    s_network_unlock ();
+
+    if (can_continue) {
+        network_start_publication_queue (context);
+        // updates made until our loop runs are flushed when it starts
+        s_network_updates_lock ();
+        context->network_updates_pending = true;
+        s_network_updates_unlock ();
+        context->network_actor = zactor_new (s_run_loop, context);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// PRIVATE API
+////////////////////////////////////////////////////////////////////////
+
+// value types are published as decimal strings: keep them
+// prebuilt to avoid formatting them at each publication
+static const char *s_network_value_type_strings[] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12"
+};
+
+static void s_network_add_value_type (zmsg_t *msg, int value_type)
+{
+    if (value_type >= IGS_UNKNOWN_T && value_type <= IGS_TIMESTAMPED_DATA_T)
+        zmsg_addstr (msg, s_network_value_type_strings[value_type]);
+    else
+        zmsg_addstrf (msg, "%d", value_type);
+}
+
+igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
+{
+    return network_publish_output_with_topic (agent, iop, NULL);
+}
+
+void s_network_data_buffer_frame_destructor (void **hint)
+{
+    igs_data_buffer_t *buffer = (igs_data_buffer_t *) *hint;
+    model_data_buffer_release (&buffer);
+    *hint = NULL;
+}
+
+// frame publishing the value of a DATA or array iop : when the value is held
+// by a buffer, the frame only references it and s_network_send_frames hands
+// it to zmq without copy, otherwise the value is copied in the frame
+zframe_t *s_network_data_frame (const igs_iop_t *iop)
+{
+    if (iop->data_buffer && iop->value_size > 0)
+        return zframe_frommem (iop->value.data, iop->value_size,
+                               s_network_data_buffer_frame_destructor,
+                               model_data_buffer_retain (iop->data_buffer));
+    return zframe_new (iop->value.data, iop->value_size);
+}
+
+// builds a uuid-name publication, as understood by all protocol versions
+zmsg_t *s_network_legacy_publication (igsagent_t *agent,
+                                      const igs_iop_t *iop,
+                                      const char *topic,
+                                      int64_t current_microseconds)
+{
+    zmsg_t *msg = zmsg_new ();
+    if (topic)
+        zmsg_addstr (msg, topic);
+    else
+        zmsg_addstrf (msg, "%s-%s", agent->uuid, iop->name);
+    // peers older than v5 do not know typed arrays and receive their bytes
+    igs_iop_value_type_t value_type = (model_is_array_type (iop->value_type))
+                                        ? IGS_DATA_T : iop->value_type;
+    if (current_microseconds == INT64_MIN)
+        s_network_add_value_type (msg, value_type);
+    switch (value_type) {
+        case IGS_INTEGER_T:
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_INTEGER_T);
+                zframe_t *bundle = s_network_timestamped_frame (&(iop->value.i), sizeof (int), current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes %s int with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, current_microseconds);
+            } else {
+                zmsg_addmem (msg, &(iop->value.i), sizeof (int));
+                igsagent_debug (agent, "%s(%s) publishes %s int",
+                                agent->definition->name, agent->uuid,
+                                iop->name);
+            }
+            break;
+        case IGS_DOUBLE_T:
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_DOUBLE_T);
+                zframe_t *bundle = s_network_timestamped_frame (&(iop->value.d), sizeof (double), current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes %s double with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, current_microseconds);
+            } else {
+                zmsg_addmem (msg, &(iop->value.d), sizeof (double));
+                igsagent_debug (agent, "%s(%s) publishes %s double",
+                                agent->definition->name, agent->uuid,
+                                iop->name);
+            }
+            break;
+        case IGS_BOOL_T:
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_BOOL_T);
+                zframe_t *bundle = s_network_timestamped_frame (&(iop->value.b), sizeof (bool), current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes %s bool with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, current_microseconds);
+            } else {
+                zmsg_addmem (msg, &(iop->value.b), sizeof (bool));
+                igsagent_debug (agent, "%s(%s) publishes %s bool",
+                                agent->definition->name, agent->uuid,
+                                iop->name);
+            }
+            break;
+        case IGS_STRING_T:
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_STRING_T);
+                zframe_t *bundle = s_network_timestamped_frame (iop->value.s,
+                                                                (iop->value.s) ? strlen (iop->value.s) : 0,
+                                                                current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes %s string with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, current_microseconds);
+            } else {
+                zmsg_addstr (msg, iop->value.s);
+                igsagent_debug (agent, "%s(%s) publishes %s string",
+                                agent->definition->name, agent->uuid,
+                                iop->name);
+            }
+            break;
+        case IGS_IMPULSION_T:
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_IMPULSION_T);
+                zframe_t *bundle = s_network_timestamped_frame (NULL, 0, current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes %s impulsion with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, current_microseconds);
+            } else {
+                zmsg_addmem (msg, NULL, 0);
+                igsagent_debug (agent, "%s(%s) publishes %s impulsion",
+                                agent->definition->name, agent->uuid,
+                                iop->name);
+            }
+            break;
+        case IGS_DATA_T: {
+            if (current_microseconds != INT64_MIN){
+                s_network_add_value_type (msg, IGS_TIMESTAMPED_DATA_T);
+                zframe_t *bundle = s_network_timestamped_frame (iop->value.data, iop->value_size,
+                                                                current_microseconds);
+                zmsg_append (msg, &bundle);
+                igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes) with timestamp %lld",
+                                agent->definition->name, agent->uuid,
+                                iop->name, iop->value_size, current_microseconds);
+            } else {
+                zframe_t *frame = s_network_data_frame (iop);
+                zmsg_append (msg, &frame);
+                igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes)",
+                                agent->definition->name, agent->uuid,
+                                iop->name, iop->value_size);
+            }
+        } break;
+        default:
+            break;
+    }
+    return msg;
+}
+
+// adds the compact header of an output and its value frame for strings and
+// data, the header is prefixed with the output id for batch entries, the
+// optional record gives the delta encoding of the value, data frames are
+// compressed with the codec of the output
+void s_network_add_compact_value (zmsg_t *msg,
+                                  const igs_iop_t *iop,
+                                  int64_t current_microseconds,
+                                  bool batch_entry,
+                                  const igs_publication_record_t *record)
+{
+    byte header[2 + IGS_COMPACT_HEADER_LENGTH + sizeof (int64_t)
+                + sizeof (uint32_t) + sizeof (double)];
+    size_t header_size = 0;
+    if (batch_entry) {
+        header[header_size++] = (byte) (iop->id >> 8);
+        header[header_size++] = (byte) (iop->id & 0xff);
+    }
+    header[header_size++] = (byte) iop->value_type;
+    byte *flags = header + header_size++;
+    *flags = 0;
+    if (current_microseconds != INT64_MIN) {
+        *flags |= IGS_COMPACT_FLAG_TIMESTAMP;
+        memcpy (header + header_size, &current_microseconds, sizeof (int64_t));
+        header_size += sizeof (int64_t);
+    }
+    if (record && record->delta_flags) {
+        *flags |= record->delta_flags;
+        memcpy (header + header_size, &record->delta_sequence, sizeof (uint32_t));
+        header_size += sizeof (uint32_t);
+    }
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            memcpy (header + header_size, &(iop->value.i), sizeof (int));
+            header_size += sizeof (int);
+            break;
+        case IGS_DOUBLE_T:
+            memcpy (header + header_size, &(iop->value.d), sizeof (double));
+            header_size += sizeof (double);
+            break;
+        case IGS_BOOL_T:
+            memcpy (header + header_size, &(iop->value.b), sizeof (bool));
+            header_size += sizeof (bool);
+            break;
+        default:
+            break;
+    }
+    zframe_t *frame = NULL;
+    if (iop->value_type == IGS_DATA_T && iop->codec != IGS_CODEC_NONE) {
+        if (record && (record->delta_flags & IGS_COMPACT_FLAG_DELTA))
+            frame = network_compress_frame (iop->codec, iop->codec_threshold,
+                                            record->delta, record->delta_size);
+        else
+            frame = network_compress_frame (iop->codec, iop->codec_threshold,
+                                            iop->value.data, iop->value_size);
+        if (frame)
+            *flags |= IGS_COMPACT_FLAG_COMPRESSED;
+    }
+    zmsg_addmem (msg, header, header_size);
+    if (frame)
+        zmsg_append (msg, &frame);
+    else if (iop->value_type == IGS_STRING_T)
+        zmsg_addstr (msg, (iop->value.s) ? iop->value.s : "");
+    else if (record && (record->delta_flags & IGS_COMPACT_FLAG_DELTA))
+        zmsg_addmem (msg, record->delta, record->delta_size);
+    else if (batch_entry && (iop->value_type == IGS_DATA_T || model_is_array_type (iop->value_type)))
+        // a batch mixes the buffers of several outputs and is sent without
+        // any of them (see s_network_send_frames)
+        zmsg_addmem (msg, iop->value.data, iop->value_size);
+    else if (iop->value_type == IGS_DATA_T || model_is_array_type (iop->value_type)) {
+        frame = s_network_data_frame (iop);
+        zmsg_append (msg, &frame);
+    }
+}
+
+// builds a compact publication (protocol v5) for a record of an output
+// having an id
+zmsg_t *s_network_compact_publication (igsagent_t *agent,
+                                       const igs_publication_record_t *record)
+{
+    const igs_iop_t *iop = &record->output;
+    assert (iop->id);
+    char topic[IGS_COMPACT_TOPIC_LENGTH];
+    s_network_compact_topic (agent->topic_key, iop->id, topic);
+
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addmem (msg, topic, IGS_COMPACT_TOPIC_LENGTH);
+    s_network_add_compact_value (msg, iop, record->timestamp, false, record);
+    if (record->delta_flags & IGS_COMPACT_FLAG_DELTA)
+        igsagent_debug (agent, "%s(%s) publishes %s with id %u as delta %u (%zu bytes)",
+                        agent->definition->name, agent->uuid, iop->name, iop->id,
+                        record->delta_sequence, record->delta_size);
+    else
+        igsagent_debug (agent, "%s(%s) publishes %s with id %u",
+                        agent->definition->name, agent->uuid, iop->name, iop->id);
+    return msg;
+}
+
+// called by zmq once it does not need a value sent from a data buffer anymore
+void s_network_data_buffer_msg_free (void *data, void *hint)
+{
+    IGS_UNUSED (data)
+    igs_data_buffer_t *buffer = (igs_data_buffer_t *) hint;
+    model_data_buffer_release (&buffer);
+}
+
+// sends the frames of msg without copying them : zmq shares their content
+// by reference between all the sockets they are sent to. Frames pointing
+// into data_buffer are sent as zmq messages keeping the buffer alive until
+// zmq has sent them, because zmq may still read them after the buffer has
+// been released by its output and by msg.
+int s_network_send_frames (zsock_t *socket, zmsg_t *msg, igs_data_buffer_t *data_buffer)
+{
+    size_t remaining = zmsg_size (msg);
+    zframe_t *frame = zmsg_first (msg);
+    while (frame) {
+        remaining--;
+        byte *data = zframe_data (frame);
+        size_t size = zframe_size (frame);
+        if (data_buffer && size > 0 && data >= (byte *) data_buffer->data
+            && data + size <= (byte *) data_buffer->data + data_buffer->size) {
+            zmq_msg_t zmq_msg;
+            zmq_msg_init_data (&zmq_msg, data, size, s_network_data_buffer_msg_free,
+                               model_data_buffer_retain (data_buffer));
+            if (zmq_msg_send (&zmq_msg, zsock_resolve (socket), (remaining > 0) ? ZMQ_SNDMORE : 0) == -1) {
+                zmq_msg_close (&zmq_msg);
+                return -1;
+            }
+        } else if (zframe_send (&frame, socket, ZFRAME_REUSE | ((remaining > 0) ? ZFRAME_MORE : 0)) != 0)
+            return -1;
+        frame = zmsg_next (msg);
+    }
+    return 0;
+}
+
+#define IGS_PUBLISHER_TCP 0x01
+#define IGS_PUBLISHER_IPC 0x02
+#define IGS_PUBLISHER_INPROC 0x04
+#define IGS_PUBLISHER_ALL (IGS_PUBLISHER_TCP | IGS_PUBLISHER_IPC | IGS_PUBLISHER_INPROC)
+
+// TCP publishers of a priority class : its own publisher if it has one, and
+// the normal publisher for the peers that could not connect to it and thus
+// subscribe to the outputs of this class on the normal one. Subscriptions
+// are filtered on our side, so each peer receives a publication only once.
+size_t s_network_tcp_publishers (igs_core_context_t *context,
+                                 igs_output_priority_t priority,
+                                 zsock_t *publishers[2])
+{
+    size_t count = 0;
+    if (priority > IGS_PRIORITY_NORMAL && priority < IGS_OUTPUT_PRIORITIES_NB
+        && context->priority_publishers[priority])
+        publishers[count++] = context->priority_publishers[priority];
+    if (context->publisher)
+        publishers[count++] = context->publisher;
+    return count;
+}
+
+// sends a publication to some of our publishers, using the TCP publishers
+// of its priority class, msg remains owned by the caller, data_buffer is the
+// optional buffer of the published value (see s_network_send_frames)
+igs_result_t s_network_send_publication_to (igsagent_t *agent,
+                                            const char *name,
+                                            zmsg_t *msg,
+                                            igs_data_buffer_t *data_buffer,
+                                            int publishers,
+                                            igs_output_priority_t priority)
+{
+    igs_result_t result = IGS_SUCCESS;
+    if (!s_network_publisher_mutex_initialized) {
+        IGS_MUTEX_INIT (s_network_publisher_mutex);
+        s_network_publisher_mutex_initialized = true;
+    }
+    IGS_MUTEX_LOCK (s_network_publisher_mutex);
+    // 1- publish to TCP
+    if (publishers & IGS_PUBLISHER_TCP) {
+        zsock_t *tcp_publishers[2];
+        size_t tcp_publishers_nb = s_network_tcp_publishers (core_context, priority, tcp_publishers);
+        for (size_t i = 0; i < tcp_publishers_nb; i++) {
+            if (s_network_send_frames (tcp_publishers[i], msg, data_buffer) != 0) {
+                igsagent_error (agent, "Could not publish output %s on the network\n", name);
+                result = IGS_FAILURE;
+            }
+        }
+    }
+    // 2- publish to IPC
+    if ((publishers & IGS_PUBLISHER_IPC) && core_context->ipc_publisher) {
+        // publisher can be NULL on IOS or for read/write problems with assigned
+        // IPC path in both cases, an error message has been issued at start
+        if (s_network_send_frames (core_context->ipc_publisher, msg, data_buffer) != 0) {
+            igsagent_error (agent, "Could not publish output %s using IPC\n", name);
+            result = IGS_FAILURE;
+        }
+    }
+    // 3- publish to inproc
+    if ((publishers & IGS_PUBLISHER_INPROC) && core_context->inproc_publisher) {
+        if (s_network_send_frames (core_context->inproc_publisher, msg, data_buffer) != 0) {
+            igsagent_error (agent, "Could not publish output %s using inproc\n", name);
+            result = IGS_FAILURE;
+        }
+    }
+    IGS_MUTEX_UNLOCK (s_network_publisher_mutex);
+    return result;
+}
+
+// sends a publication to all our publishers, msg remains owned by the caller
+igs_result_t s_network_send_publication (igsagent_t *agent,
+                                         const char *name,
+                                         zmsg_t *msg,
+                                         igs_data_buffer_t *data_buffer)
+{
+    return s_network_send_publication_to (agent, name, msg, data_buffer,
+                                          IGS_PUBLISHER_ALL, IGS_PRIORITY_NORMAL);
+}
+
+static int64_t s_network_chunk_streams = 0;
+
+bool s_network_is_chunked (const igs_iop_t *iop)
+{
+    return iop->value_type == IGS_DATA_T && iop->chunk_size > 0 && iop->value_size > iop->chunk_size;
+}
+
+// streams a data value as one compact publication per chunk, chunks
+// referencing the buffer of the value are sent without copy
+igs_result_t s_network_publish_chunks (igsagent_t *agent,
+                                       const igs_publication_record_t *record,
+                                       int publishers)
+{
+    const igs_iop_t *iop = &record->output;
+    char topic[IGS_COMPACT_TOPIC_LENGTH];
+    s_network_compact_topic (agent->topic_key, iop->id, topic);
+    uint32_t stream = (uint32_t) IGS_ATOMIC_ADD64 (&s_network_chunk_streams, 1);
+    uint64_t value_size = iop->value_size;
+    igsagent_debug (agent, "%s(%s) streams %s with id %u (%zu bytes in chunks of %zu)",
+                    agent->definition->name, agent->uuid, iop->name, iop->id,
+                    iop->value_size, iop->chunk_size);
+    igs_result_t result = IGS_SUCCESS;
+    for (uint64_t chunk_offset = 0; chunk_offset < value_size; chunk_offset += iop->chunk_size) {
+        size_t chunk_size = (value_size - chunk_offset < iop->chunk_size)
+                              ? (size_t) (value_size - chunk_offset) : iop->chunk_size;
+        byte header[IGS_COMPACT_HEADER_LENGTH + sizeof (int64_t) + sizeof (uint32_t) + 2 * sizeof (uint64_t)];
+        size_t header_size = 0;
+        header[header_size++] = (byte) IGS_DATA_T;
+        byte *flags = header + header_size++;
+        *flags = IGS_COMPACT_FLAG_CHUNK;
+        if (record->timestamp != INT64_MIN) {
+            *flags |= IGS_COMPACT_FLAG_TIMESTAMP;
+            memcpy (header + header_size, &record->timestamp, sizeof (int64_t));
+            header_size += sizeof (int64_t);
+        }
+        memcpy (header + header_size, &stream, sizeof (uint32_t));
+        header_size += sizeof (uint32_t);
+        memcpy (header + header_size, &chunk_offset, sizeof (uint64_t));
+        header_size += sizeof (uint64_t);
+        memcpy (header + header_size, &value_size, sizeof (uint64_t));
+        header_size += sizeof (uint64_t);
+        byte *chunk = (byte *) iop->value.data + chunk_offset;
+        zframe_t *frame = network_compress_frame (iop->codec, iop->codec_threshold, chunk, chunk_size);
+        if (frame)
+            *flags |= IGS_COMPACT_FLAG_COMPRESSED;
+        else if (iop->data_buffer)
+            frame = zframe_frommem (chunk, chunk_size, NULL, NULL);
+        else
+            frame = zframe_new (chunk, chunk_size);
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addmem (msg, topic, IGS_COMPACT_TOPIC_LENGTH);
+        zmsg_addmem (msg, header, header_size);
+        zmsg_append (msg, &frame);
+        // publisher mutex is released between chunks
+        if (s_network_send_publication_to (agent, iop->name, msg, iop->data_buffer,
+                                           publishers, iop->priority) != IGS_SUCCESS)
+            result = IGS_FAILURE;
+        zmsg_destroy (&msg);
+    }
+    return result;
+}
+
+// writes a large data value in our shared memory and builds the compact
+// publication describing it for our IPC subscribers, returns NULL when
+// the value has to be published normally
+zmsg_t *s_network_shared_publication (igsagent_t *agent, const igs_publication_record_t *record)
+{
+    const igs_iop_t *iop = &record->output;
+    if (!core_context->shared_memory_publisher
+        || IGS_ATOMIC_LOAD64 (&core_context->same_host_peers_nb) == 0
+        || iop->value_type != IGS_DATA_T
+        || iop->value_size < core_context->network_shared_memory_threshold
+        || record->delta_flags)
+        return NULL;
+    uint64_t descriptor[2] = {0, iop->value_size};
+    if (!s_network_publisher_mutex_initialized) {
+        IGS_MUTEX_INIT (s_network_publisher_mutex);
+        s_network_publisher_mutex_initialized = true;
+    }
+    // shared memory is written like our sockets and destroyed under the
+    // same mutex when stopping
+    IGS_MUTEX_LOCK (s_network_publisher_mutex);
+    bool written = (core_context->shared_memory_publisher
+                    && s_network_write_shared_memory (core_context->shared_memory_publisher,
+                                                      iop->value.data, iop->value_size, descriptor));
+    IGS_MUTEX_UNLOCK (s_network_publisher_mutex);
+    if (!written)
+        return NULL;
+
+    char topic[IGS_COMPACT_TOPIC_LENGTH];
+    s_network_compact_topic (agent->topic_key, iop->id, topic);
+    byte header[IGS_COMPACT_HEADER_LENGTH + sizeof (int64_t)];
+    size_t header_size = 0;
+    header[header_size++] = (byte) IGS_DATA_T;
+    byte *flags = header + header_size++;
+    *flags = IGS_COMPACT_FLAG_SHARED;
+    if (record->timestamp != INT64_MIN) {
+        *flags |= IGS_COMPACT_FLAG_TIMESTAMP;
+        memcpy (header + header_size, &record->timestamp, sizeof (int64_t));
+        header_size += sizeof (int64_t);
+    }
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addmem (msg, topic, IGS_COMPACT_TOPIC_LENGTH);
+    zmsg_addmem (msg, header, header_size);
+    zmsg_addmem (msg, descriptor, sizeof (descriptor));
+    igsagent_debug (agent, "%s(%s) publishes %s with id %u in shared memory at %llu (%zu bytes)",
+                    agent->definition->name, agent->uuid, iop->name, iop->id,
+                    (unsigned long long) descriptor[0], iop->value_size);
+    return msg;
+}
+
+// sends the compact publication of a record, as chunks for large data and
+// through our shared memory to our IPC subscribers when possible
+igs_result_t s_network_publish_compact (igsagent_t *agent, const igs_publication_record_t *record)
+{
+    igs_result_t result = IGS_SUCCESS;
+    int publishers = IGS_PUBLISHER_ALL;
+    zmsg_t *shared_msg = s_network_shared_publication (agent, record);
+    if (shared_msg) {
+        result = s_network_send_publication_to (agent, record->output.name, shared_msg, NULL,
+                                                IGS_PUBLISHER_IPC, record->output.priority);
+        zmsg_destroy (&shared_msg);
+        publishers &= ~IGS_PUBLISHER_IPC;
+    }
+    if (s_network_is_chunked (&record->output)) {
+        if (s_network_publish_chunks (agent, record, publishers) != IGS_SUCCESS)
+            result = IGS_FAILURE;
+        return result;
+    }
+    zmsg_t *msg = s_network_compact_publication (agent, record);
+    if (s_network_send_publication_to (agent, record->output.name, msg,
+                                       record->output.data_buffer, publishers, record->output.priority) != IGS_SUCCESS)
+        result = IGS_FAILURE;
+    zmsg_destroy (&msg);
+    return result;
+}
+
+/*
+ Publication policies : an output having a minimum interval is published
+ at most once per interval while the agent is started. A single timer per
+ conflated output coalesces all the values suppressed during an interval
+ and publishes the latest one when the interval has elapsed.
+ */
+// returns true if the output can be published now, sets delay in
+// milliseconds when a timer must be armed for its conflated value,
+// agent write lock must be held
+bool s_network_apply_publication_policy (igs_iop_t *output, int64_t *delay)
+{
+    int64_t now = zclock_usecs ();
+    int64_t elapsed = now - output->last_publication;
+    if (elapsed >= output->publication_min_interval) {
+        output->last_publication = now;
+        return true;
+    }
+    output->suppressed_publications_nb++;
+    if (output->publication_conflate && !output->publication_flush_pending) {
+        output->publication_flush_pending = true;
+        *delay = (output->publication_min_interval - elapsed + 999) / 1000;
+    }
+    return false;
+}
+
+int s_network_flush_publication (zloop_t *loop, int timer_id, void *arg)
+{
+    IGS_UNUSED (loop)
+    IGS_UNUSED (timer_id)
+    igs_publication_flush_t *flush = (igs_publication_flush_t *) arg;
+    s_network_lock ();
+    DL_DELETE (core_context->publication_flushes, flush);
+    s_network_unlock ();
+
+    igs_iop_t *output = NULL;
+    model_read_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed since the timer was armed
+    igsagent_t *agent = (igsagent_t *) zhash_lookup (core_context->created_agents,
+                                                     flush->agent_uuid);
+    if (agent == flush->agent && agent->uuid)
+        output = model_find_iop_by_name (agent, flush->output, IGS_OUTPUT_T);
+    if (output) {
+        model_agent_write_lock (agent);
+        output->publication_flush_pending = false;
+        output->last_publication = 0; // our conflated value cannot be suppressed
+        output->flushed_publications_nb++;
+        model_agent_write_unlock (agent);
+    }
+    model_read_unlock (__FUNCTION__, __LINE__);
+    if (output)
+        network_publish_output (agent, output);
+    free (flush->output);
+    free (flush);
+    return 0;
+}
+
+void s_network_arm_publication_flush (igsagent_t *agent, const char *output, int64_t delay)
+{
+    bool armed = false;
+    s_network_lock ();
+    if (core_context->loop) {
+        igs_publication_flush_t *flush =
+          (igs_publication_flush_t *) zmalloc (sizeof (igs_publication_flush_t));
+        flush->agent = agent;
+        memcpy (flush->agent_uuid, agent->uuid, IGS_AGENT_UUID_LENGTH);
+        flush->output = strdup (output);
+        flush->timer_id = zloop_timer (core_context->loop, (size_t) delay, 1,
+                                       s_network_flush_publication, flush);
+        DL_APPEND (core_context->publication_flushes, flush);
+        armed = true;
+    }
+    s_network_unlock ();
+    if (!armed) {
+        // we have been stopped in the meantime
+        model_read_lock (__FUNCTION__, __LINE__);
+        igs_iop_t *iop = NULL;
+        if (agent->uuid)
+            iop = model_find_iop_by_name (agent, output, IGS_OUTPUT_T);
+        if (iop) {
+            model_agent_write_lock (agent);
+            iop->publication_flush_pending = false;
+            model_agent_write_unlock (agent);
+        }
+        model_read_unlock (__FUNCTION__, __LINE__);
+    }
+}
+
+/*
+ Queued publications : application threads copy the published values in
+ records pushed to a bounded lock-free queue, the publisher thread pops
+ them to build and send the publication messages. Each slot of the queue
+ has a sequence telling if it is free for the producer reaching this
+ position or filled for the consumer reaching it.
+ */
+// copies an output and its value into a record, agent read lock must be held
+void s_network_init_publication_record (igs_publication_record_t *record,
+                                        igsagent_t *agent,
+                                        const igs_iop_t *iop,
+                                        int64_t timestamp)
+{
+    memset (record, 0, sizeof (igs_publication_record_t));
+    record->agent = agent;
+    memcpy (record->agent_uuid, agent->uuid, IGS_AGENT_UUID_LENGTH);
+    record->timestamp = timestamp;
+    size_t name_length = strlen (iop->name);
+    if (name_length < IGS_PUBLICATION_RECORD_NAME_LENGTH) {
+        memcpy (record->name, iop->name, name_length + 1);
+        record->output.name = record->name;
+    } else
+        record->output.name = strdup (iop->name);
+    record->output.type = IGS_OUTPUT_T;
+    record->output.id = iop->id;
+    record->output.value_type = iop->value_type;
+    record->output.value_size = iop->value_size;
+    record->output.codec = iop->codec;
+    record->output.codec_threshold = iop->codec_threshold;
+    record->output.chunk_size = iop->chunk_size;
+    record->output.priority = iop->priority;
+    if (iop->value_type == IGS_STRING_T) {
+        record->output.value.s = strdup ((iop->value.s) ? iop->value.s : "");
+        record->output.value_size = strlen (record->output.value.s) + 1;
+    } else if (iop->value_type == IGS_DATA_T || model_is_array_type (iop->value_type)) {
+        if (iop->data_buffer) {
+            record->output.data_buffer = model_data_buffer_retain (iop->data_buffer);
+            record->output.value.data = iop->value.data;
+        } else if (iop->value_size > 0) {
+            // our copy becomes a buffer shared by publication frames and inputs
+            void *data = malloc (iop->value_size);
+            memcpy (data, iop->value.data, iop->value_size);
+            record->output.data_buffer = model_data_buffer_new (data, iop->value_size, NULL);
+            record->output.value.data = data;
+        }
+    } else
+        record->output.value = iop->value;
+}
+
+void s_network_clear_publication_record (igs_publication_record_t *record)
+{
+    if (record->output.name != record->name)
+        free (record->output.name);
+    record->output.name = NULL;
+    if (record->output.value_type == IGS_STRING_T) {
+        free (record->output.value.s);
+        record->output.value.s = NULL;
+    } else if (record->output.value_type == IGS_DATA_T
+               || model_is_array_type (record->output.value_type))
+        model_release_iop_data (&record->output);
+    if (record->delta) {
+        free (record->delta);
+        record->delta = NULL;
+    }
+}
+
+// publishes a delta encoded output as a keyframe or as the changes since
+// its previous publication, agent write lock must be held
+void s_network_encode_delta (igs_iop_t *output, igs_publication_record_t *record)
+{
+    igs_data_buffer_t *reference = output->delta_reference;
+    size_t size = record->output.value_size;
+    if (reference && !output->delta_keyframe_requested && size > 0 && reference->size == size
+        && output->deltas_since_keyframe + 1 < output->delta_keyframe_interval)
+        record->delta = s_network_xor_delta (reference->data, record->output.value.data,
+                                             size, &record->delta_size);
+    record->delta_sequence = ++output->delta_sequence;
+    if (record->delta) {
+        record->delta_flags = IGS_COMPACT_FLAG_DELTA;
+        output->deltas_since_keyframe++;
+        output->published_deltas_nb++;
+    } else {
+        record->delta_flags = IGS_COMPACT_FLAG_KEYFRAME;
+        output->deltas_since_keyframe = 0;
+        output->delta_keyframe_requested = false;
+        output->published_keyframes_nb++;
+    }
+    if (reference)
+        model_data_buffer_release (&output->delta_reference);
+    if (record->output.data_buffer)
+        output->delta_reference = model_data_buffer_retain (record->output.data_buffer);
+}
+
+// writes a record to the inputs of agents inside our context mapped on it,
+// model lock must be held
+void s_network_dispatch_publication_record (igsagent_t *agent,
+                                            igs_publication_record_t *record,
+                                            igs_deferred_observe_t **deferred)
+{
+    if (agent->is_virtual)
+        return;
+    void *value = NULL;
+    size_t size = 0;
+    model_iop_value (&record->output, &value, &size);
+    s_dispatch_publication (agent->definition->name, record->output.name,
+                            record->output.value_type, value, size,
+                            record->output.data_buffer, record->timestamp, deferred);
+}
+
+// records are moved with this function because their output name may
+// point to their own storage
+void s_network_move_publication_record (igs_publication_record_t *to,
+                                        igs_publication_record_t *from)
+{
+    *to = *from;
+    if (from->output.name == from->name)
+        to->output.name = to->name;
+}
+
+// takes ownership of the record content on success
+bool s_network_enqueue_publication (igs_publication_queue_t *queue,
+                                    igs_publication_record_t *record)
+{
+    igs_publication_slot_t *slot = NULL;
+    int64_t position = IGS_ATOMIC_LOAD64 (&queue->enqueue_position);
+    while (true) {
+        slot = queue->slots + (position & (queue->depth - 1));
+        int64_t diff = IGS_ATOMIC_LOAD64 (&slot->sequence) - position;
+        if (diff == 0) {
+            if (IGS_ATOMIC_CAS64 (&queue->enqueue_position, position, position + 1))
+                break;
+        } else if (diff < 0)
+            return false; // queue is full
+        position = IGS_ATOMIC_LOAD64 (&queue->enqueue_position);
+    }
+    s_network_move_publication_record (&slot->record, record);
+    IGS_ATOMIC_STORE64 (&slot->sequence, position + 1);
+    int64_t occupancy = position + 1 - IGS_ATOMIC_LOAD64 (&queue->dequeue_position);
+    int64_t high_water_mark = IGS_ATOMIC_LOAD64 (&queue->high_water_mark);
+    while (occupancy > high_water_mark
+           && !IGS_ATOMIC_CAS64 (&queue->high_water_mark, high_water_mark, occupancy))
+        high_water_mark = IGS_ATOMIC_LOAD64 (&queue->high_water_mark);
+    return true;
+}
+
+// gives ownership of the record content on success
+bool s_network_dequeue_publication (igs_publication_queue_t *queue,
+                                    igs_publication_record_t *record)
+{
+    igs_publication_slot_t *slot = NULL;
+    int64_t position = IGS_ATOMIC_LOAD64 (&queue->dequeue_position);
+    while (true) {
+        slot = queue->slots + (position & (queue->depth - 1));
+        int64_t diff = IGS_ATOMIC_LOAD64 (&slot->sequence) - (position + 1);
+        if (diff == 0) {
+            if (IGS_ATOMIC_CAS64 (&queue->dequeue_position, position, position + 1))
+                break;
+        } else if (diff < 0)
+            return false; // queue is empty
+        position = IGS_ATOMIC_LOAD64 (&queue->dequeue_position);
+    }
+    s_network_move_publication_record (record, &slot->record);
+    IGS_ATOMIC_STORE64 (&slot->sequence, position + queue->depth);
+    return true;
+}
+
+// wakes the publisher thread up if it is waiting for records
+void s_network_wake_publisher (igs_publication_queue_t *queue)
+{
+    if (IGS_ATOMIC_CAS64 (&queue->sleeping, 1, 0)) {
+        IGS_MUTEX_LOCK (queue->wakeup_mutex);
+        if (queue->publisher)
+            zstr_send (zactor_sock (queue->publisher), "WAKEUP");
+        IGS_MUTEX_UNLOCK (queue->wakeup_mutex);
+    }
+}
+
+// applies the queue policy when pushing a record, takes ownership of the
+// record content in all cases
+void s_network_push_publication (igs_publication_queue_t *queue,
+                                 igs_publication_record_t *record)
+{
+    igs_publication_record_t oldest;
+    while (!s_network_enqueue_publication (queue, record)) {
+        if (queue->policy == IGS_PUBLICATION_QUEUE_DROP_NEWEST
+            || !IGS_ATOMIC_LOAD64 (&queue->running)) {
+            s_network_clear_publication_record (record);
+            IGS_ATOMIC_ADD64 (&queue->dropped, 1);
+            return;
+        }
+        if (queue->policy == IGS_PUBLICATION_QUEUE_DROP_OLDEST) {
+            if (s_network_dequeue_publication (queue, &oldest)) {
+                s_network_clear_publication_record (&oldest);
+                IGS_ATOMIC_ADD64 (&queue->dropped, 1);
+            }
+        } else {
+            // IGS_PUBLICATION_QUEUE_BLOCK
+            s_network_wake_publisher (queue);
+            zclock_sleep (0);
+        }
+    }
+    s_network_wake_publisher (queue);
+}
+
+// sends all the queued records, from the publisher thread
+void s_network_drain_publication_queue (igs_publication_queue_t *queue)
+{
+    igs_publication_record_t record;
+    while (s_network_dequeue_publication (queue, &record)) {
+        model_read_lock (__FUNCTION__, __LINE__);
+        // check that this agent has not been destroyed since the record was queued
+        igsagent_t *agent = (igsagent_t *) zhash_lookup (core_context->created_agents,
+                                                         record.agent_uuid);
+        if (agent == record.agent && agent->uuid && core_context->publisher) {
+            if (record.output.id)
+                s_network_publish_compact (agent, &record);
+            if (s_network_needs_legacy_publication (core_context, record.output.id)) {
+                zmsg_t *legacy_msg = s_network_legacy_publication (agent, &record.output, NULL,
+                                                                   record.timestamp);
+                s_network_send_publication (agent, record.output.name, legacy_msg,
+                                            record.output.data_buffer);
+                zmsg_destroy (&legacy_msg);
+            }
+        }
+        model_read_unlock (__FUNCTION__, __LINE__);
+        s_network_clear_publication_record (&record);
+        IGS_ATOMIC_ADD64 (&queue->published, 1);
     }
-    else {
-        s_lock_zyre_peer (__FUNCTION__, __LINE__);
-        zyre_set_header (context->node, "commandline", "%s",
-                         context->command_line);
-        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+}
+
+static void s_network_publisher_actor (zsock_t *pipe, void *args)
+{
+    igs_publication_queue_t *queue = (igs_publication_queue_t *) args;
+    zsock_signal (pipe, 0);
+    bool terminated = false;
+    while (!terminated) {
+        s_network_drain_publication_queue (queue);
+        IGS_ATOMIC_STORE64 (&queue->sleeping, 1);
+        IGS_ATOMIC_FENCE ();
+        // a record may have been pushed before producers could see us sleeping
+        if (IGS_ATOMIC_LOAD64 (&queue->enqueue_position)
+            != IGS_ATOMIC_LOAD64 (&queue->dequeue_position)
+            && IGS_ATOMIC_CAS64 (&queue->sleeping, 1, 0))
+            continue;
+        char *command = zstr_recv (pipe);
+        if (!command || streq (command, "$TERM"))
+            terminated = true;
+        zstr_free (&command);
     }
-    DWORD pid = GetCurrentProcessId ();
-    context->process_id = (int) pid;
-    s_lock_zyre_peer (__FUNCTION__, __LINE__);
-    zyre_set_header (context->node, "pid", "%i", (int) pid);
-    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-#endif
+    s_network_drain_publication_queue (queue);
+}
 
-    // hostname
-    char hostname[1024];
-    hostname[1023] = '\0';
-    gethostname (hostname, 1023);
-#if defined(__WINDOWS__)
-    WSACleanup ();
-#endif
-    s_lock_zyre_peer (__FUNCTION__, __LINE__);
-    zyre_set_header (context->node, "hostname", "%s", hostname);
-    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-    s_network_unlock ();
+void network_start_publication_queue (igs_core_context_t *context)
+{
+    igs_publication_queue_t *queue = context->publication_queue;
+    if (!queue || queue->publisher)
+        return;
+    IGS_ATOMIC_STORE64 (&queue->sleeping, 0);
+    IGS_ATOMIC_STORE64 (&queue->running, 1);
+    IGS_MUTEX_LOCK (queue->wakeup_mutex);
+    queue->publisher = zactor_new (s_network_publisher_actor, queue);
+    IGS_MUTEX_UNLOCK (queue->wakeup_mutex);
+}
 
-    if (can_continue)
-        context->network_actor = zactor_new (s_run_loop, context);
+// queued records are sent before returning, publisher sockets must still exist
+void network_stop_publication_queue (igs_core_context_t *context)
+{
+    igs_publication_queue_t *queue = context->publication_queue;
+    if (!queue || !queue->publisher)
+        return;
+    IGS_ATOMIC_STORE64 (&queue->running, 0);
+    IGS_MUTEX_LOCK (queue->wakeup_mutex);
+    zactor_destroy (&queue->publisher);
+    IGS_MUTEX_UNLOCK (queue->wakeup_mutex);
 }
 
-////////////////////////////////////////////////////////////////////////
-// PRIVATE API
-////////////////////////////////////////////////////////////////////////
+void network_free_publication_queue (igs_publication_queue_t **queue)
+{
+    assert (queue);
+    if (!*queue)
+        return;
+    assert (!(*queue)->publisher);
+    igs_publication_record_t record;
+    while (s_network_dequeue_publication (*queue, &record))
+        s_network_clear_publication_record (&record);
+    IGS_MUTEX_DESTROY ((*queue)->wakeup_mutex);
+    free ((*queue)->slots);
+    free (*queue);
+    *queue = NULL;
+}
 
-igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
+igs_result_t network_publish_output_with_topic (igsagent_t *agent,
+                                                 const igs_iop_t *iop,
+                                                 const char *topic)
 {
     assert (agent);
     assert (agent->context);
@@ -3475,13 +6442,51 @@ igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
 
     if (!agent->is_whole_agent_muted && !iop->is_muted
         && !agent->context->is_frozen) {
-        model_read_write_lock (__FUNCTION__, __LINE__);
-        split_add_work_to_queue (agent->context, agent->uuid, iop);
+        model_read_lock (__FUNCTION__, __LINE__);
         // check that this agent has not been destroyed when we were locked
         if (!agent || !(agent->uuid)) {
-            model_read_write_unlock (__FUNCTION__, __LINE__);
+            model_read_unlock (__FUNCTION__, __LINE__);
+            return IGS_SUCCESS;
+        }
+        if (agent->batch_in_progress) {
+            // published at batch commit
+            model_agent_write_lock (agent);
+            igs_batched_output_t *batched = NULL;
+            LL_FOREACH (agent->batched_outputs, batched) {
+                if (streq (batched->name, iop->name))
+                    break;
+            }
+            if (!batched) {
+                batched = (igs_batched_output_t *) zmalloc (sizeof (igs_batched_output_t));
+                batched->name = strdup (iop->name);
+                LL_APPEND (agent->batched_outputs, batched);
+            }
+            model_agent_write_unlock (agent);
+            model_read_unlock (__FUNCTION__, __LINE__);
             return IGS_SUCCESS;
         }
+        if (iop->publication_min_interval > 0 && agent->context->loop) {
+            igs_iop_t *output = model_find_iop_by_name (agent, iop->name, IGS_OUTPUT_T);
+            int64_t flush_delay = 0;
+            model_agent_write_lock (agent);
+            bool can_publish = !output || s_network_apply_publication_policy (output, &flush_delay);
+            model_agent_write_unlock (agent);
+            if (!can_publish) {
+                model_read_unlock (__FUNCTION__, __LINE__);
+                if (flush_delay > 0)
+                    s_network_arm_publication_flush (agent, iop->name, flush_delay);
+                return IGS_SUCCESS;
+            }
+        }
+        if (iop->publication_filter != IGS_PUBLICATION_FILTER_NONE) {
+            // the filter compares next values to this published one
+            igs_iop_t *output = model_find_iop_by_name (agent, iop->name, IGS_OUTPUT_T);
+            if (output) {
+                model_agent_write_lock (agent);
+                model_set_publication_reference (output);
+                model_agent_write_unlock (agent);
+            }
+        }
         int64_t current_microseconds = INT64_MIN;
         if (agent->rt_timestamps_enabled){
             if (agent->context->rt_current_microseconds != INT64_MIN)
@@ -3489,167 +6494,60 @@ igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
             else
                 current_microseconds = zclock_usecs();
         }
-        zmsg_t *msg = zmsg_new ();
-        zmsg_addstrf (msg, "%s-%s", agent->uuid, iop->name);
-        if (current_microseconds == INT64_MIN)
-            zmsg_addstrf (msg, "%d", iop->value_type);
-        switch (iop->value_type) {
-            case IGS_INTEGER_T:
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_INTEGER_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_addmem (packaged_value, &(iop->value.i), sizeof (int));
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes %s int with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, current_microseconds);
-                } else {
-                    zmsg_addmem (msg, &(iop->value.i), sizeof (int));
-                    igsagent_debug (agent, "%s(%s) publishes %s int",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name);
-                }
-                break;
-            case IGS_DOUBLE_T:
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_DOUBLE_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_addmem (packaged_value, &(iop->value.d), sizeof (double));
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes %s double with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, current_microseconds);
-                } else {
-                    zmsg_addmem (msg, &(iop->value.d), sizeof (double));
-                    igsagent_debug (agent, "%s(%s) publishes %s double",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name);
-                }
-                break;
-            case IGS_BOOL_T:
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_BOOL_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_addmem (packaged_value, &(iop->value.b), sizeof (bool));
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes %s bool with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, current_microseconds);
-                } else {
-                    zmsg_addmem (msg, &(iop->value.b), sizeof (bool));
-                    igsagent_debug (agent, "%s(%s) publishes %s bool",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name);
-                }
-                break;
-            case IGS_STRING_T:
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_STRING_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_addstr (packaged_value, iop->value.s);
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes %s string with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, current_microseconds);
-                } else {
-                    zmsg_addstr (msg, iop->value.s);
-                    igsagent_debug (agent, "%s(%s) publishes %s string",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name);
-                }
-                break;
-            case IGS_IMPULSION_T:
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_IMPULSION_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_addmem (packaged_value, NULL, 0);
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes %s impulsion with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, current_microseconds);
-                } else {
-                    zmsg_addmem (msg, NULL, 0);
-                    igsagent_debug (agent, "%s(%s) publishes %s impulsion",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name);
-                }
-                break;
-            case IGS_DATA_T: {
-                zframe_t *frame = zframe_new (iop->value.data, iop->value_size);
-                if (current_microseconds != INT64_MIN){
-                    zmsg_addstrf (msg, "%d", IGS_TIMESTAMPED_DATA_T);
-                    zmsg_t *packaged_value = zmsg_new();
-                    zmsg_append (packaged_value, &frame);
-                    zmsg_addmem(packaged_value, &current_microseconds, sizeof(int64_t));
-                    zmsg_addmsg(msg, &packaged_value);
-                    igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes) with timestamp %lld",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, iop->value_size, current_microseconds);
-                } else {
-                    zmsg_append (msg, &frame);
-                    igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes)",
-                                    agent->definition->name, agent->uuid,
-                                    iop->name, iop->value_size);
-                }
-            } break;
-            default:
-                break;
+        // The value is copied once : messages for all our publishers and
+        // the inputs of agents inside our context are built from this copy.
+        igs_publication_record_t record;
+        igs_deferred_observe_t *deferred = NULL;
+        igs_publication_queue_t *queue = agent->context->publication_queue;
+        // delta encoding only applies to compact publications sent by us
+        igs_iop_t *delta_output = NULL;
+        if (!topic && iop->value_type == IGS_DATA_T && iop->delta_keyframe_interval > 0 && iop->id
+            && !s_network_is_chunked (iop)
+            && ((queue && IGS_ATOMIC_LOAD64 (&queue->running))
+                || (agent->context->network_actor && agent->context->publisher)))
+            delta_output = model_find_iop_by_name (agent, iop->name, IGS_OUTPUT_T);
+        if (delta_output)
+            model_agent_write_lock (agent);
+        else
+            model_agent_read_lock (agent);
+        split_add_work_to_queue (agent->context, agent->uuid, iop);
+        s_network_init_publication_record (&record, agent, iop, current_microseconds);
+        if (delta_output) {
+            s_network_encode_delta (delta_output, &record);
+            model_agent_write_unlock (agent);
+        } else
+            model_agent_read_unlock (agent);
+        if (!topic && queue && IGS_ATOMIC_LOAD64 (&queue->running)) {
+            // the publisher thread builds and sends the messages
+            s_network_dispatch_publication_record (agent, &record, &deferred);
+            model_read_unlock (__FUNCTION__, __LINE__);
+            s_network_push_publication (queue, &record);
+            model_run_deferred_observe_callbacks (&deferred);
+            return IGS_SUCCESS;
         }
-
-        // 1- publish to TCP
         if (agent->context->network_actor && agent->context->publisher) {
-            if (zsock_send (core_context->publisher, "m", msg) != 0) {
-                igsagent_error (agent, "Could not publish output %s on the network\n", iop->name);
-                zmsg_destroy (&msg);
+            // Outputs having an id are published in compact form. The legacy
+            // form is still needed when some peers use a protocol older than v5.
+            if (record.output.id && s_network_publish_compact (agent, &record) != IGS_SUCCESS)
                 result = IGS_FAILURE;
-            }
-            // 2- publish to IPC
-            if (core_context->ipc_publisher) {
-                // publisher can be NULL on IOS or for read/write problems with assigned
-                // IPC path in both cases, an error message has been issued at start
-                if (zsock_send (core_context->ipc_publisher, "m", msg) != 0) {
-                    igsagent_error (agent, "Could not publish output %s using IPC\n", iop->name);
-                    zmsg_destroy (&msg);
-                    result = IGS_FAILURE;
-                }
-            }
-            // 3- publish to inproc
-            if (core_context->inproc_publisher) {
-                if (zsock_send (core_context->inproc_publisher, "m", msg) != 0) {
-                    igsagent_error (agent, "Could not publish output %s using inproc\n", iop->name);
-                    zmsg_destroy (&msg);
+            if (s_network_needs_legacy_publication (core_context, record.output.id)) {
+                zmsg_t *legacy_msg = s_network_legacy_publication (agent, &record.output, topic,
+                                                                   current_microseconds);
+                if (s_network_send_publication (agent, iop->name, legacy_msg,
+                                                record.output.data_buffer) != IGS_SUCCESS)
                     result = IGS_FAILURE;
-                }
+                zmsg_destroy (&legacy_msg);
             }
         } else {
             igsagent_warn (agent, "agent not started : could not publish output %s to the "
                            "network (published to agents in same process only)", iop->name);
         }
-        // 4- distribute publication message to other agents inside our context
+        // 4- distribute publication to other agents inside our context
         // without using the network
-        if (!agent->is_virtual) {
-            free (zmsg_popstr (msg)); // remove composite uuid/iop name from message
-            zmsg_pushstr (msg, iop->name); // replace it by simple iop name
-            // Generate a temporary fake remote agent, containing only
-            // necessary information for s_handle_publication.
-            igs_remote_agent_t *fake_remote = (igs_remote_agent_t *) zmalloc (sizeof (igs_remote_agent_t));
-            fake_remote->context = core_context;
-            fake_remote->definition = (igs_definition_t *) zmalloc (sizeof (igs_definition_t));
-            fake_remote->definition->name = agent->definition->name;
-            model_read_write_unlock (__FUNCTION__, __LINE__); // to avoid deadlock inside s_handle_publication
-            s_handle_publication (&msg, fake_remote);
-            free (fake_remote->definition);
-            free (fake_remote);
-        }
-        else {
-            model_read_write_unlock (__FUNCTION__, __LINE__);
-            zmsg_destroy (&msg);
-        }
+        s_network_dispatch_publication_record (agent, &record, &deferred);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        s_network_clear_publication_record (&record);
+        model_run_deferred_observe_callbacks (&deferred);
     } else {
         if (agent->is_whole_agent_muted)
             igsagent_debug (
@@ -3667,6 +6565,121 @@ igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
     return result;
 }
 
+// Outputs grouped in a batch publication : small values having an id and
+// no publication policy. The batch topic reaches all our v5 subscribers and
+// bypasses rate limits, delta encoding, chunks, shared memory and the
+// publication queue, so the other outputs are published individually.
+bool s_network_is_batchable (igsagent_t *agent, const igs_iop_t *iop)
+{
+    igs_publication_queue_t *queue = agent->context->publication_queue;
+    return iop->id
+           && iop->value_type != IGS_DATA_T
+           && !model_is_array_type (iop->value_type)
+           && iop->publication_min_interval == 0
+           && !(queue && IGS_ATOMIC_LOAD64 (&queue->running));
+}
+
+igs_result_t network_publish_output_batch (igsagent_t *agent,
+                                           igs_batched_output_t **outputs)
+{
+    assert (agent);
+    assert (outputs);
+    int result = IGS_SUCCESS;
+    igs_deferred_observe_t *deferred = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid) || !agent->context
+        || agent->is_whole_agent_muted || agent->context->is_frozen) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        igs_batched_output_t *batched, *tmp;
+        LL_FOREACH_SAFE (*outputs, batched, tmp) {
+            LL_DELETE (*outputs, batched);
+            free (batched->name);
+            free (batched);
+        }
+        return IGS_SUCCESS;
+    }
+    int64_t current_microseconds = INT64_MIN;
+    if (agent->rt_timestamps_enabled){
+        if (agent->context->rt_current_microseconds != INT64_MIN)
+            current_microseconds = agent->context->rt_current_microseconds;
+        else
+            current_microseconds = zclock_usecs();
+    }
+    bool can_publish = agent->context->network_actor && agent->context->publisher;
+    if (!can_publish)
+        igsagent_warn (agent, "agent not started : could not publish output batch to the "
+                       "network (published to agents in same process only)");
+
+    // Outputs having an id are grouped in a single compact message using the
+    // batch id as topic. Outputs without id and legacy peers rely on
+    // individual legacy publications.
+    char topic[IGS_COMPACT_TOPIC_LENGTH];
+    s_network_compact_topic (agent->topic_key, IGS_COMPACT_BATCH_ID, topic);
+    zmsg_t *batch_msg = zmsg_new ();
+    zmsg_addmem (batch_msg, topic, IGS_COMPACT_TOPIC_LENGTH);
+    igs_batched_output_t *individual_outputs = NULL;
+    igs_batched_output_t *batched, *tmp;
+    LL_FOREACH_SAFE (*outputs, batched, tmp) {
+        LL_DELETE (*outputs, batched);
+        igs_iop_t *iop = model_find_iop_by_name (agent, batched->name, IGS_OUTPUT_T);
+        if (iop && iop->id && !s_network_is_batchable (agent, iop)) {
+            LL_APPEND (individual_outputs, batched);
+            continue;
+        }
+        if (iop && !iop->is_muted) {
+            model_set_publication_reference (iop);
+            if (iop->id)
+                s_network_add_compact_value (batch_msg, iop, current_microseconds, true, NULL);
+            if (can_publish
+                && s_network_needs_legacy_publication (core_context, iop->id)) {
+                zmsg_t *legacy_msg = s_network_legacy_publication (agent, iop, NULL,
+                                                                   current_microseconds);
+                if (s_network_send_publication (agent, iop->name, legacy_msg,
+                                                iop->data_buffer) != IGS_SUCCESS)
+                    result = IGS_FAILURE;
+                zmsg_destroy (&legacy_msg);
+            }
+            // distribute to other agents inside our context without using
+            // the network, callbacks run once all inputs are written
+            if (!agent->is_virtual) {
+                void *value = NULL;
+                size_t size = 0;
+                model_iop_value (iop, &value, &size);
+                s_dispatch_publication (agent->definition->name, iop->name,
+                                        iop->value_type, value, size,
+                                        iop->data_buffer, current_microseconds,
+                                        &deferred);
+            }
+        }
+        free (batched->name);
+        free (batched);
+    }
+    if (can_publish && zmsg_size (batch_msg) > 1) {
+        igsagent_debug (agent, "%s(%s) publishes a batch of %zu frames",
+                        agent->definition->name, agent->uuid, zmsg_size (batch_msg) - 1);
+        if (s_network_send_publication (agent, "batch", batch_msg, NULL) != IGS_SUCCESS)
+            result = IGS_FAILURE;
+    }
+    zmsg_destroy (&batch_msg);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    model_run_deferred_observe_callbacks (&deferred);
+
+    LL_FOREACH_SAFE (individual_outputs, batched, tmp) {
+        LL_DELETE (individual_outputs, batched);
+        model_read_lock (__FUNCTION__, __LINE__);
+        // check that this agent has not been destroyed when we were unlocked
+        igs_iop_t *iop = (agent->uuid)
+                           ? model_find_iop_by_name (agent, batched->name, IGS_OUTPUT_T) : NULL;
+        model_read_unlock (__FUNCTION__, __LINE__);
+        if (iop && network_publish_output (agent, iop) != IGS_SUCCESS)
+            result = IGS_FAILURE;
+        free (batched->name);
+        free (batched);
+    }
+    return result;
+}
+
 int network_timer_callback (zloop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
@@ -3917,11 +6930,15 @@ void igs_stop (void)
     if (core_context->network_actor) {
         // interrupting and destroying ingescape thread and zyre layer
         // this will also clean all agent->subscribers
+        s_network_updates_lock ();
+        // no more update notifications to an actor being destroyed
+        core_context->network_updates_pending = true;
         if (!core_context->external_stop) {
             // NB: if agent has been forcibly stopped, actor is already stopping
             // and this command would deadlock.
             zstr_send (core_context->network_actor, "STOP_LOOP");
         }
+        s_network_updates_unlock ();
         zactor_destroy (&core_context->network_actor);
 #if defined(__WINDOWS__)
         // On Windows, if we don't call zsys_shutdown, the application will crash on
@@ -3997,9 +7014,18 @@ void igsagent_set_name (igsagent_t *agent, const char *name)
         igsagent_warn (agent,
                        "Spaces and dots are not allowed in an agent name: '%s' has been changed to '%s'",
                        name, n);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        free (n);
+        return;
+    }
     char *previous = agent->definition->name;
     agent->definition->name = n;
-    agent->network_need_to_send_definition_update = true;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     
     if (agent->igs_channel)
         free (agent->igs_channel);
@@ -4704,6 +7730,18 @@ void igs_net_set_timeout (unsigned int duration)
     core_context->network_agent_timeout = duration;
 }
 
+void igs_net_set_update_debounce (unsigned int delay)
+{
+    core_init_context ();
+    core_context->network_update_debounce = delay;
+}
+
+unsigned int igs_net_update_debounce (void)
+{
+    core_init_context ();
+    return core_context->network_update_debounce;
+}
+
 void igs_net_set_publishing_port (unsigned int port)
 {
     core_init_context ();
@@ -4753,6 +7791,32 @@ const char *igs_ipc_dir (void)
     core_init_context ();
     return strdup (core_context->network_ipc_folder_path);
 }
+
+igs_result_t igs_net_set_shared_memory (size_t size, size_t threshold)
+{
+    core_init_context ();
+    if (core_context->network_actor) {
+        igs_error ("agent is already started : stop it first to change its shared memory");
+        return IGS_FAILURE;
+    }
+#if defined(__UTYPE_IOS)
+    if (size > 0) {
+        igs_error ("shared memory is not available on this platform");
+        return IGS_FAILURE;
+    }
+#endif
+    core_context->network_shared_memory_size = size;
+    core_context->network_shared_memory_threshold = threshold;
+    return IGS_SUCCESS;
+}
+
+size_t igs_net_shared_memory (size_t *threshold)
+{
+    core_init_context ();
+    if (threshold)
+        *threshold = core_context->network_shared_memory_threshold;
+    return core_context->network_shared_memory_size;
+}
 #endif
 
 void igs_set_allow_inproc (bool allow)
@@ -4786,9 +7850,12 @@ void igs_net_set_high_water_marks (int hwm_value)
         igs_error ("HWM value must be zero or higher");
         return;
     }
+    core_context->network_hwm_value = hwm_value;
     if (core_context->network_actor
         && core_context->publisher) {
-        zsock_set_sndhwm (core_context->publisher, hwm_value);
+        // TCP publishers keep the HWM of their priority class if it is set
+        for (int priority = IGS_PRIORITY_NORMAL; priority < IGS_OUTPUT_PRIORITIES_NB; priority++)
+            s_network_configure_priority_publisher (core_context, (igs_output_priority_t) priority);
         if (core_context->ipc_publisher)
             zsock_set_sndhwm (core_context->ipc_publisher, hwm_value);
         if (core_context->inproc_publisher)
@@ -4798,9 +7865,109 @@ void igs_net_set_high_water_marks (int hwm_value)
         HASH_ITER (hh, core_context->zyre_peers, peer, tmp)
         {
             zsock_set_rcvhwm (peer->subscriber, hwm_value);
+            for (int priority = IGS_PRIORITY_NORMAL + 1; priority < IGS_OUTPUT_PRIORITIES_NB; priority++) {
+                if (peer->priority_subscribers[priority])
+                    zsock_set_rcvhwm (peer->priority_subscribers[priority], hwm_value);
+            }
         }
     }
-    core_context->network_hwm_value = hwm_value;
+}
+
+igs_result_t igs_net_set_priority_policy (igs_output_priority_t priority, int hwm_value,
+                                          igs_publication_queue_policy_t policy)
+{
+    core_init_context ();
+    if (priority < IGS_PRIORITY_NORMAL || priority >= IGS_OUTPUT_PRIORITIES_NB) {
+        igs_error ("priority %d is not valid", priority);
+        return IGS_FAILURE;
+    }
+    if (hwm_value < 0) {
+        igs_error ("HWM value must be zero or higher");
+        return IGS_FAILURE;
+    }
+    if (policy != IGS_PUBLICATION_QUEUE_BLOCK && policy != IGS_PUBLICATION_QUEUE_DROP_NEWEST) {
+        igs_error ("publisher sockets can only block or drop new publications");
+        return IGS_FAILURE;
+    }
+    core_context->network_priority_hwm_values[priority] = hwm_value;
+    core_context->network_priority_policies[priority] = policy;
+    if (core_context->network_actor && core_context->publisher)
+        s_network_configure_priority_publisher (core_context, priority);
+    return IGS_SUCCESS;
+}
+
+int igs_net_priority_policy (igs_output_priority_t priority, igs_publication_queue_policy_t *policy)
+{
+    core_init_context ();
+    if (priority < IGS_PRIORITY_NORMAL || priority >= IGS_OUTPUT_PRIORITIES_NB) {
+        igs_error ("priority %d is not valid", priority);
+        return -1;
+    }
+    if (policy)
+        *policy = core_context->network_priority_policies[priority];
+    int hwm_value = core_context->network_priority_hwm_values[priority];
+    return (hwm_value < 0) ? core_context->network_hwm_value : hwm_value;
+}
+
+igs_result_t igs_net_set_publication_queue (size_t depth,
+                                            igs_publication_queue_policy_t policy)
+{
+    core_init_context ();
+    if (core_context->network_actor) {
+        igs_error ("publication queue must be configured before starting the agent");
+        return IGS_FAILURE;
+    }
+    if (policy != IGS_PUBLICATION_QUEUE_BLOCK
+        && policy != IGS_PUBLICATION_QUEUE_DROP_OLDEST
+        && policy != IGS_PUBLICATION_QUEUE_DROP_NEWEST) {
+        igs_error ("invalid publication queue policy %d", policy);
+        return IGS_FAILURE;
+    }
+    if (depth > ((size_t) 1 << 24)) {
+        igs_error ("publication queue depth must be %zu or lower", (size_t) 1 << 24);
+        return IGS_FAILURE;
+    }
+    network_free_publication_queue (&core_context->publication_queue);
+    if (depth == 0)
+        return IGS_SUCCESS;
+    int64_t rounded_depth = 1;
+    while ((size_t) rounded_depth < depth)
+        rounded_depth <<= 1;
+    igs_publication_queue_t *queue =
+      (igs_publication_queue_t *) zmalloc (sizeof (igs_publication_queue_t));
+    queue->slots = (igs_publication_slot_t *) zmalloc (
+      (size_t) rounded_depth * sizeof (igs_publication_slot_t));
+    for (int64_t i = 0; i < rounded_depth; i++)
+        queue->slots[i].sequence = i;
+    queue->depth = rounded_depth;
+    queue->policy = policy;
+    IGS_MUTEX_INIT (queue->wakeup_mutex);
+    core_context->publication_queue = queue;
+    return IGS_SUCCESS;
+}
+
+void igs_net_publication_queue_stats (size_t *occupancy,
+                                      size_t *high_water_mark,
+                                      size_t *dropped,
+                                      size_t *published)
+{
+    core_init_context ();
+    igs_publication_queue_t *queue = core_context->publication_queue;
+    if (occupancy) {
+        *occupancy = 0;
+        if (queue) {
+            int64_t dequeue_position = IGS_ATOMIC_LOAD64 (&queue->dequeue_position);
+            int64_t enqueue_position = IGS_ATOMIC_LOAD64 (&queue->enqueue_position);
+            if (enqueue_position > dequeue_position)
+                *occupancy = (size_t) (enqueue_position - dequeue_position);
+        }
+    }
+    if (high_water_mark)
+        *high_water_mark = (queue) ? (size_t) IGS_ATOMIC_LOAD64 (&queue->high_water_mark) : 0;
+    if (dropped)
+        *dropped = (queue) ? (size_t) IGS_ATOMIC_LOAD64 (&queue->dropped) : 0;
+    if (published)
+        *published = (queue) ? (size_t) IGS_ATOMIC_LOAD64 (&queue->published) : 0;
 }
 
 void igs_net_raise_sockets_limit (void)
@@ -4904,3 +8071,749 @@ void igs_timer_stop (int timer_id)
         igs_error ("could not find timer with id %d", timer_id);
     s_network_unlock ();
 }
+
+////////////////////////////////////////////////////////////////////////
+// SELFTEST
+////////////////////////////////////////////////////////////////////////
+
+// microbenchmark of timestamped publications : a value and its timestamp
+// bundled in a single frame for uuid-name publications, compared to the
+// same value without timestamp
+#define IGS_TIMESTAMP_BENCHMARK_ITERATIONS 1000000
+void s_network_timestamp_benchmark (void)
+{
+    const char *topic = "0123456789abcdef0123456789abcdef-my_int";
+    int value = 42;
+    int64_t timestamp = zclock_usecs ();
+    int64_t checksum = 0;
+
+    int64_t start = zclock_usecs ();
+    for (int i = 0; i < IGS_TIMESTAMP_BENCHMARK_ITERATIONS; i++) {
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstr (msg, topic);
+        zmsg_addmem (msg, &value, sizeof (int));
+        zframe_t *topic_frame = zmsg_pop (msg);
+        zframe_t *value_frame = zmsg_pop (msg);
+        int received_int = 0;
+        memcpy (&received_int, zframe_data (value_frame), sizeof (int));
+        checksum += received_int;
+        zframe_destroy (&topic_frame);
+        zframe_destroy (&value_frame);
+        zmsg_destroy (&msg);
+    }
+    int64_t plain = zclock_usecs () - start;
+
+    start = zclock_usecs ();
+    for (int i = 0; i < IGS_TIMESTAMP_BENCHMARK_ITERATIONS; i++) {
+        zmsg_t *msg = zmsg_new ();
+        zmsg_addstr (msg, topic);
+        zframe_t *bundle = s_network_timestamped_frame (&value, sizeof (int), timestamp);
+        zmsg_append (msg, &bundle);
+        zframe_t *topic_frame = zmsg_pop (msg);
+        bundle = zmsg_pop (msg);
+        byte *received_value = NULL;
+        size_t received_size = 0;
+        int64_t received_timestamp = 0;
+        bool parsed = s_network_parse_timestamped_frame (bundle, &received_value, &received_size,
+                                                         &received_timestamp);
+        assert (parsed && received_size == sizeof (int));
+        int received_int = 0;
+        if (parsed)
+            memcpy (&received_int, received_value, sizeof (int));
+        checksum += received_int + received_timestamp;
+        zframe_destroy (&topic_frame);
+        zframe_destroy (&bundle);
+        zmsg_destroy (&msg);
+    }
+    int64_t bundled = zclock_usecs () - start;
+
+    printf ("\n   timestamp benchmark (%d publications, checksum %lld):\n",
+            IGS_TIMESTAMP_BENCHMARK_ITERATIONS, (long long) checksum);
+    printf ("     no timestamp     : %.1f ns per publication\n",
+            (double) plain * 1000.0 / IGS_TIMESTAMP_BENCHMARK_ITERATIONS);
+    printf ("     timestamp bundle : %.1f ns per publication\n   ",
+            (double) bundled * 1000.0 / IGS_TIMESTAMP_BENCHMARK_ITERATIONS);
+}
+
+// stands for the network actor of a started agent and counts the flushes
+// of definition and mapping updates it is asked to schedule
+static void s_network_test_flush_requests_actor (zsock_t *pipe, void *args)
+{
+    int *flush_requests = (int *) args;
+    zsock_signal (pipe, 0);
+    while (true) {
+        char *command = zstr_recv (pipe);
+        if (!command)
+            break;
+        bool terminate = streq (command, "$TERM");
+        if (streq (command, "FLUSH_UPDATES"))
+            (*flush_requests)++;
+        free (command);
+        if (terminate)
+            break;
+    }
+}
+
+// definition updates of an agent received by another one
+typedef struct {
+    const char *uuid;
+    int updates_nb;
+    char *definition;
+} igs_test_definition_updates_t;
+
+static void s_network_test_agent_event (igsagent_t *agent, igs_agent_event_t event,
+                                        const char *uuid, const char *name,
+                                        void *event_data, void *my_data)
+{
+    IGS_UNUSED (agent)
+    IGS_UNUSED (name)
+    igs_test_definition_updates_t *updates = (igs_test_definition_updates_t *) my_data;
+    if (event != IGS_AGENT_UPDATED_DEFINITION || !streq (uuid, updates->uuid))
+        return;
+    updates->updates_nb++;
+    if (updates->definition)
+        free (updates->definition);
+    updates->definition = (event_data) ? strdup ((char *) event_data) : NULL;
+}
+
+// compact value received for a delta encoded publication record
+static igs_compact_value_t s_network_test_received_value (const igs_publication_record_t *record)
+{
+    igs_compact_value_t value;
+    memset (&value, 0, sizeof (igs_compact_value_t));
+    value.value_type = IGS_DATA_T;
+    if (record->delta_flags & IGS_COMPACT_FLAG_DELTA) {
+        void *delta = malloc ((record->delta_size) ? record->delta_size : 1);
+        memcpy (delta, record->delta, record->delta_size);
+        value.buffer = model_data_buffer_new (delta, record->delta_size, NULL);
+    } else
+        value.buffer = model_data_buffer_retain (record->output.data_buffer);
+    value.data = value.buffer->data;
+    value.size = value.buffer->size;
+    return value;
+}
+
+// next event of a type received by a zyre node, NULL after a timeout
+static zyre_event_t *s_network_test_zyre_event (zyre_t *node, const char *type, int timeout)
+{
+    zpoller_t *poller = zpoller_new (zyre_socket (node), NULL);
+    zyre_event_t *event = NULL;
+    while (!event && zpoller_wait (poller, timeout)) {
+        event = zyre_event_new (node);
+        if (event && !streq (zyre_event_type (event), type))
+            zyre_event_destroy (&event);
+    }
+    zpoller_destroy (&poller);
+    return event;
+}
+
+static int s_network_test_end_loop (zloop_t *loop, int timer_id, void *arg)
+{
+    IGS_UNUSED (loop)
+    IGS_UNUSED (timer_id)
+    IGS_UNUSED (arg)
+    return -1;
+}
+
+void
+igs_network_test (bool verbose)
+{
+    IGS_UNUSED(verbose)
+    printf (" * igs_network: ");
+
+    //  @selftest
+    //  Chunked values reassembly
+    igs_chunked_value_t *chunked = (igs_chunked_value_t *) zmalloc (sizeof (igs_chunked_value_t));
+    assert (s_network_add_chunk_range (chunked, 0, 10) == 10);
+    assert (s_network_add_chunk_range (chunked, 0, 10) == 0); // duplicated chunk
+    assert (s_network_add_chunk_range (chunked, 20, 30) == 10);
+    assert (s_network_add_chunk_range (chunked, 5, 25) == 10); // overlaps both ranges
+    assert (chunked->ranges && !chunked->ranges->next);
+    assert (chunked->ranges->start == 0 && chunked->ranges->end == 30);
+    assert (s_network_add_chunk_range (chunked, 40, 50) == 10);
+    assert (s_network_add_chunk_range (chunked, 60, 70) == 10);
+    assert (chunked->ranges->next && chunked->ranges->next->start == 40);
+    assert (s_network_add_chunk_range (chunked, 30, 40) == 10); // adjacent ranges are merged
+    assert (chunked->ranges->start == 0 && chunked->ranges->end == 50);
+    assert (chunked->ranges->next->start == 60 && !chunked->ranges->next->next);
+    s_network_free_chunked_value (&chunked);
+    assert (chunked == NULL);
+
+    //  Priority classes use their own TCP publisher and the normal one for
+    //  the peers that could not subscribe to it
+    core_init_context ();
+    zsock_t *tcp_publishers[2] = {NULL, NULL};
+    assert (s_network_tcp_publishers (core_context, IGS_PRIORITY_CONTROL, tcp_publishers) == 0);
+    zsock_t *normal_publisher = zsock_new_pub ("inproc://selftest_normal_publisher");
+    zsock_t *control_publisher = zsock_new_pub ("inproc://selftest_control_publisher");
+    assert (normal_publisher && control_publisher);
+    core_context->publisher = normal_publisher;
+    core_context->priority_publishers[IGS_PRIORITY_CONTROL] = control_publisher;
+    assert (s_network_tcp_publishers (core_context, IGS_PRIORITY_NORMAL, tcp_publishers) == 1);
+    assert (tcp_publishers[0] == normal_publisher);
+    assert (s_network_tcp_publishers (core_context, IGS_PRIORITY_CONTROL, tcp_publishers) == 2);
+    assert (tcp_publishers[0] == control_publisher && tcp_publishers[1] == normal_publisher);
+    assert (s_network_tcp_publishers (core_context, IGS_PRIORITY_BULK, tcp_publishers) == 1); // no bulk publisher
+    assert (tcp_publishers[0] == normal_publisher);
+    core_context->publisher = NULL;
+    core_context->priority_publishers[IGS_PRIORITY_CONTROL] = NULL;
+    zsock_destroy (&normal_publisher);
+    zsock_destroy (&control_publisher);
+
+    //  Outputs without id always use uuid-name publications, the others
+    //  only when a peer is older than v5 or does not tell its protocol
+    const char *peer_protocols[] = {"v5", "v6", NULL, "v4", "v2"};
+    igs_zyre_peer_t protocol_peers[5];
+    memset (protocol_peers, 0, sizeof (protocol_peers));
+    assert (core_context->legacy_publications_peers_nb == 0);
+    assert (s_network_needs_legacy_publication (core_context, 0));
+    assert (!s_network_needs_legacy_publication (core_context, 3));
+    for (size_t i = 0; i < 2; i++)
+        s_network_set_peer_protocol (core_context, &protocol_peers[i], peer_protocols[i]);
+    assert (core_context->legacy_publications_peers_nb == 0);
+    assert (!protocol_peers[0].uses_legacy_publications && streq (protocol_peers[1].protocol, "v6"));
+    assert (!s_network_needs_legacy_publication (core_context, 3));
+    s_network_set_peer_protocol (core_context, &protocol_peers[2], peer_protocols[2]);
+    assert (protocol_peers[2].protocol == NULL && protocol_peers[2].uses_legacy_publications);
+    assert (core_context->legacy_publications_peers_nb == 1);
+    assert (s_network_needs_legacy_publication (core_context, 3));
+    for (size_t i = 3; i < 5; i++)
+        s_network_set_peer_protocol (core_context, &protocol_peers[i], peer_protocols[i]);
+    assert (core_context->legacy_publications_peers_nb == 3);
+    for (size_t i = 0; i < 5; i++)
+        free (protocol_peers[i].protocol);
+    core_context->legacy_publications_peers_nb = 0;
+
+    //  Timestamped bundles, with one and five bytes size prefixes
+    size_t bundled_sizes[] = {sizeof (int), 0xFF, 1000};
+    byte bundled_value[1000];
+    for (size_t i = 0; i < sizeof (bundled_value); i++)
+        bundled_value[i] = (byte) i;
+    for (size_t i = 0; i < sizeof (bundled_sizes) / sizeof (bundled_sizes[0]); i++) {
+        zframe_t *bundle = s_network_timestamped_frame (bundled_value, bundled_sizes[i], 123456789);
+        byte *value = NULL;
+        size_t value_size = 0;
+        int64_t timestamp = 0;
+        bool parsed = s_network_parse_timestamped_frame (bundle, &value, &value_size, &timestamp);
+        assert (parsed && value_size == bundled_sizes[i] && timestamp == 123456789);
+        assert (memcmp (value, bundled_value, value_size) == 0);
+        zframe_t *truncated = zframe_new (zframe_data (bundle), zframe_size (bundle) - 1);
+        assert (!s_network_parse_timestamped_frame (truncated, &value, &value_size, &timestamp));
+        zframe_destroy (&truncated);
+        zframe_destroy (&bundle);
+    }
+    if (verbose)
+        s_network_timestamp_benchmark ();
+
+    //  LZ codec round trips : runs, text, overlapping matches and noise
+    size_t lz_size = 100000;
+    byte *lz_value = (byte *) zmalloc (lz_size);
+    byte *lz_compressed = (byte *) malloc (2 * lz_size);
+    byte *lz_decompressed = (byte *) malloc (lz_size);
+    const char *lz_text = "the quick brown fox jumps over the lazy dog, ";
+    uint32_t lz_seed = 12345;
+    for (int round = 0; round < 4; round++) {
+        for (size_t i = 0; i < lz_size && round > 0; i++) {
+            lz_seed = lz_seed * 1103515245u + 12345u;
+            if (round == 1)
+                lz_value[i] = (byte) lz_text[i % strlen (lz_text)];
+            else if (round == 2)
+                lz_value[i] = (byte) (i % 3);
+            else
+                lz_value[i] = (byte) (lz_seed >> 16);
+        }
+        size_t compressed_size = s_network_lz_compress (lz_value, lz_size, lz_compressed, 2 * lz_size);
+        assert (compressed_size > 0);
+        assert (s_network_lz_decompress (lz_compressed, compressed_size, lz_decompressed, lz_size));
+        assert (memcmp (lz_value, lz_decompressed, lz_size) == 0);
+        //  wrong output sizes are rejected
+        assert (!s_network_lz_decompress (lz_compressed, compressed_size, lz_decompressed, lz_size - 1));
+        assert (!s_network_lz_decompress (lz_compressed, compressed_size, lz_decompressed, lz_size + 1));
+        zframe_t *compressed = network_compress_frame (IGS_CODEC_LZ, 0, lz_value, lz_size);
+        if (round < 3) {
+            assert (compressed && zframe_size (compressed) < lz_size / 2);
+            zframe_t *decompressed = s_network_decompress_frame (zframe_data (compressed),
+                                                                 zframe_size (compressed));
+            assert (decompressed && zframe_size (decompressed) == lz_size);
+            assert (memcmp (zframe_data (decompressed), lz_value, lz_size) == 0);
+            zframe_destroy (&decompressed);
+            //  truncated frames are rejected
+            for (size_t size = 0; size < zframe_size (compressed); size++)
+                assert (!s_network_decompress_frame (zframe_data (compressed), size));
+        } else
+            assert (!compressed); // noise does not compress
+        zframe_destroy (&compressed);
+    }
+    //  values under the threshold and small values are not compressed
+    assert (!network_compress_frame (IGS_CODEC_LZ, lz_size + 1, lz_value, lz_size));
+    assert (!network_compress_frame (IGS_CODEC_NONE, 0, lz_value, lz_size));
+    assert (!network_compress_frame (IGS_CODEC_LZ, 0, lz_value, 1));
+    size_t lz_empty = s_network_lz_compress (lz_value, 0, lz_compressed, 2 * lz_size);
+    assert (lz_empty == 1 && s_network_lz_decompress (lz_compressed, lz_empty, lz_decompressed, 0));
+    assert (s_network_lz_compress (lz_value, lz_size, lz_compressed, 16) == 0); // too small output
+
+    //  LZ codec corrupted inputs
+    byte lz_zero_offset[] = {0x10, 'a', 0x00, 0x00, 0x00};
+    byte lz_far_offset[] = {0x10, 'a', 0x02, 0x00, 0x00};
+    byte lz_overlong_literals[] = {0xf0, 0xff, 0xff, 0x10, 'a'};
+    byte lz_unterminated_length[] = {0x1f, 'a', 0x01, 0x00, 0xff};
+    byte lz_missing_offset[] = {0x10, 'a', 0x01};
+    byte lz_overlong_match[] = {0x1f, 'a', 0x01, 0x00, 0xff, 0x10, 0x00};
+    byte lz_valid[] = {0x10, 'a', 0x01, 0x00, 0x00}; // 'a' then a match of 4 'a'
+    assert (!s_network_lz_decompress (lz_zero_offset, sizeof (lz_zero_offset), lz_decompressed, 5));
+    assert (!s_network_lz_decompress (lz_far_offset, sizeof (lz_far_offset), lz_decompressed, 5));
+    assert (!s_network_lz_decompress (lz_overlong_literals, sizeof (lz_overlong_literals), lz_decompressed, 5));
+    assert (!s_network_lz_decompress (lz_unterminated_length, sizeof (lz_unterminated_length), lz_decompressed, 300));
+    assert (!s_network_lz_decompress (lz_missing_offset, sizeof (lz_missing_offset), lz_decompressed, 5));
+    assert (!s_network_lz_decompress (lz_overlong_match, sizeof (lz_overlong_match), lz_decompressed, 100));
+    assert (s_network_lz_decompress (lz_valid, sizeof (lz_valid), lz_decompressed, 5));
+    assert (memcmp (lz_decompressed, "aaaaa", 5) == 0);
+    assert (!s_network_lz_decompress (lz_valid, sizeof (lz_valid), lz_decompressed, 4));
+    assert (!s_network_lz_decompress (lz_valid, sizeof (lz_valid), lz_decompressed, 6));
+    byte lz_frame[] = {IGS_CODEC_LZ, 0x05, 0x10, 'a', 0x01, 0x00, 0x00};
+    zframe_t *lz_decompressed_frame = s_network_decompress_frame (lz_frame, sizeof (lz_frame));
+    assert (lz_decompressed_frame && zframe_size (lz_decompressed_frame) == 5);
+    zframe_destroy (&lz_decompressed_frame);
+    lz_frame[1] = 0x06; // wrong value size
+    assert (!s_network_decompress_frame (lz_frame, sizeof (lz_frame)));
+    lz_frame[1] = 0x00; // empty value
+    assert (!s_network_decompress_frame (lz_frame, sizeof (lz_frame)));
+    lz_frame[0] = IGS_CODEC_NONE; // unknown codec
+    lz_frame[1] = 0x05;
+    assert (!s_network_decompress_frame (lz_frame, sizeof (lz_frame)));
+    byte lz_huge_frame[] = {IGS_CODEC_LZ, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x10, 'a', 0x01, 0x00, 0x00};
+    assert (!s_network_decompress_frame (lz_huge_frame, sizeof (lz_huge_frame))); // size beyond ratio
+    byte lz_unterminated_size[] = {IGS_CODEC_LZ, 0x85};
+    assert (!s_network_decompress_frame (lz_unterminated_size, sizeof (lz_unterminated_size)));
+
+    //  Compressed service arguments are decompressed in place
+    lz_frame[0] = IGS_CODEC_LZ;
+    byte lz_codecs[] = {IGS_CODEC_NONE, IGS_CODEC_LZ};
+    zmsg_t *arguments = zmsg_new ();
+    zmsg_addmem (arguments, lz_codecs, sizeof (lz_codecs));
+    zmsg_addstr (arguments, "plain");
+    zmsg_addmem (arguments, lz_frame, sizeof (lz_frame));
+    assert (s_network_decompress_arguments (arguments) == IGS_SUCCESS);
+    assert (zmsg_size (arguments) == 2);
+    assert (zframe_streq (zmsg_first (arguments), "plain"));
+    assert (zframe_streq (zmsg_next (arguments), "aaaaa"));
+    zmsg_destroy (&arguments);
+    arguments = zmsg_new ();
+    zmsg_addmem (arguments, lz_codecs, sizeof (lz_codecs));
+    zmsg_addstr (arguments, "plain");
+    zmsg_addmem (arguments, lz_frame, sizeof (lz_frame) - 1);
+    assert (s_network_decompress_arguments (arguments) == IGS_FAILURE);
+    zmsg_destroy (&arguments);
+    free (lz_value);
+    free (lz_compressed);
+    free (lz_decompressed);
+
+    //  XOR deltas : unchanged values, round trip and short unchanged runs
+    byte delta_previous[1000];
+    byte delta_value[1000];
+    for (size_t i = 0; i < sizeof (delta_previous); i++)
+        delta_previous[i] = delta_value[i] = (byte) (i * 7);
+    size_t delta_size = 0;
+    byte *delta = s_network_xor_delta (delta_previous, delta_value, sizeof (delta_value), &delta_size);
+    assert (delta && delta_size == 0); // unchanged bytes at the end are implicit
+    byte *rebuilt = s_network_apply_xor_delta (delta_previous, sizeof (delta_previous), delta, delta_size);
+    assert (rebuilt && memcmp (rebuilt, delta_value, sizeof (delta_value)) == 0);
+    free (delta);
+    free (rebuilt);
+    delta_value[0] ^= 1;
+    delta_value[10] ^= 2;
+    delta_value[12] ^= 3; // merged with the run of byte 10
+    delta_value[999] ^= 4;
+    delta = s_network_xor_delta (delta_previous, delta_value, sizeof (delta_value), &delta_size);
+    assert (delta && delta_size == 12);
+    rebuilt = s_network_apply_xor_delta (delta_previous, sizeof (delta_previous), delta, delta_size);
+    assert (rebuilt && memcmp (rebuilt, delta_value, sizeof (delta_value)) == 0);
+    free (rebuilt);
+    //  deltas applied to a value of another size or truncated within a run
+    //  are rejected
+    assert (!s_network_apply_xor_delta (delta_previous, 500, delta, delta_size));
+    assert (!s_network_apply_xor_delta (delta_previous, sizeof (delta_previous), delta, 6));
+    free (delta);
+    byte delta_overlong_unchanged[] = {0xe8, 0x07, 0x01, 0xff}; // skips 1000 bytes
+    byte delta_overlong_changed[] = {0x00, 0xe9, 0x07}; // changes 1001 bytes
+    byte delta_missing_changes[] = {0x00, 0x02, 0xff};
+    byte delta_unterminated_varint[] = {0x80};
+    assert (!s_network_apply_xor_delta (delta_previous, sizeof (delta_previous),
+                                        delta_overlong_unchanged, sizeof (delta_overlong_unchanged)));
+    assert (!s_network_apply_xor_delta (delta_previous, sizeof (delta_previous),
+                                        delta_overlong_changed, sizeof (delta_overlong_changed)));
+    assert (!s_network_apply_xor_delta (delta_previous, sizeof (delta_previous),
+                                        delta_missing_changes, sizeof (delta_missing_changes)));
+    assert (!s_network_apply_xor_delta (delta_previous, sizeof (delta_previous),
+                                        delta_unterminated_varint, sizeof (delta_unterminated_varint)));
+    //  values changing completely are sent as keyframes
+    for (size_t i = 0; i < sizeof (delta_value); i++)
+        delta_value[i] = (byte) ~delta_previous[i];
+    assert (!s_network_xor_delta (delta_previous, delta_value, sizeof (delta_value), &delta_size));
+
+    //  Compact topics
+    char compact_topic[IGS_COMPACT_TOPIC_LENGTH + 1] = "";
+    s_network_compact_topic (0xa1b2, 0x00ff, compact_topic);
+    assert (streq (compact_topic, "#a1b200ff"));
+    zframe_t *topic_frame = zframe_new (compact_topic, IGS_COMPACT_TOPIC_LENGTH);
+    uint16_t topic_key = 0, output_id = 0;
+    assert (s_network_parse_compact_topic (topic_frame, &topic_key, &output_id));
+    assert (topic_key == 0xa1b2 && output_id == 0x00ff);
+    zframe_destroy (&topic_frame);
+    const char *invalid_topics[] = {"#a1b200f", "#a1b200ff0", "xa1b200ff", "#A1B200FF", "#a1b2-0ff"};
+    for (size_t i = 0; i < sizeof (invalid_topics) / sizeof (invalid_topics[0]); i++) {
+        topic_frame = zframe_new (invalid_topics[i], strlen (invalid_topics[i]));
+        assert (!s_network_parse_compact_topic (topic_frame, &topic_key, &output_id));
+        zframe_destroy (&topic_frame);
+    }
+
+    //  Topic keys of remote agents, reused after their owner left
+    igs_zyre_peer_t *remote_peer = (igs_zyre_peer_t *) zmalloc (sizeof (igs_zyre_peer_t));
+    remote_peer->name = (char *) "remote_peer";
+    igs_remote_agent_t *remote_agents[2];
+    for (int i = 0; i < 2; i++) {
+        remote_agents[i] = (igs_remote_agent_t *) zmalloc (sizeof (igs_remote_agent_t));
+        remote_agents[i]->uuid = (char *) ((i == 0) ? "remote_agent_1" : "remote_agent_2");
+        remote_agents[i]->peer = remote_peer;
+    }
+    igs_remote_agent_t *key_owner = NULL;
+    topic_key = 1;
+    s_network_register_topic_key (remote_agents[0], 1);
+    HASH_FIND (hh_topic_key, remote_peer->remote_agents_by_topic_key, &topic_key, sizeof (uint16_t), key_owner);
+    assert (key_owner == remote_agents[0] && remote_agents[0]->topic_key == 1);
+    s_network_register_topic_key (remote_agents[1], 1);
+    HASH_FIND (hh_topic_key, remote_peer->remote_agents_by_topic_key, &topic_key, sizeof (uint16_t), key_owner);
+    assert (key_owner == remote_agents[1] && remote_agents[0]->topic_key == 0);
+    assert (HASH_CNT (hh_topic_key, remote_peer->remote_agents_by_topic_key) == 1);
+    s_network_register_topic_key (remote_agents[0], 2);
+    s_network_register_topic_key (remote_agents[1], 3); // previous key of an agent is released
+    HASH_FIND (hh_topic_key, remote_peer->remote_agents_by_topic_key, &topic_key, sizeof (uint16_t), key_owner);
+    assert (key_owner == NULL);
+    topic_key = 3;
+    HASH_FIND (hh_topic_key, remote_peer->remote_agents_by_topic_key, &topic_key, sizeof (uint16_t), key_owner);
+    assert (key_owner == remote_agents[1] && remote_agents[1]->topic_key == 3);
+    assert (HASH_CNT (hh_topic_key, remote_peer->remote_agents_by_topic_key) == 2);
+    HASH_CLEAR (hh_topic_key, remote_peer->remote_agents_by_topic_key);
+    free (remote_agents[0]);
+    free (remote_agents[1]);
+    free (remote_peer);
+
+    //  Agents in same process, receiver input being mapped on publisher output
+    igsagent_t *publisher = igsagent_new ("selftest_publisher", true);
+    igsagent_t *receiver = igsagent_new ("selftest_receiver", true);
+    assert (igsagent_output_create (publisher, "out", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+    assert (igsagent_input_create (receiver, "in", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+    assert (igsagent_mapping_add (receiver, "in", "selftest_publisher", "out") != 0);
+
+    //  Exported definition is regenerated only after a change
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_data_buffer_t *definition_export =
+      model_data_buffer_retain (s_network_definition_export (publisher, IGS_DEFINITION_EXPORT_CURRENT));
+    assert (definition_export
+            && s_network_definition_export (publisher, IGS_DEFINITION_EXPORT_CURRENT) == definition_export);
+    assert (s_network_definition_export (publisher, IGS_DEFINITION_EXPORT_LEGACY) != definition_export);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    igsagent_definition_set_description (publisher, "exported description");
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_data_buffer_t *changed_export = s_network_definition_export (publisher, IGS_DEFINITION_EXPORT_CURRENT);
+    assert (changed_export && changed_export != definition_export);
+    assert (strstr ((char *) changed_export->data, "exported description"));
+    assert (s_network_definition_export (publisher, IGS_DEFINITION_EXPORT_CURRENT) == changed_export);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    model_data_buffer_release (&definition_export);
+
+    //  Remote agents announcing the same definition share it
+    char *announced_definition = parser_export_definition (publisher->definition);
+    char *announced_fingerprint = s_network_definition_fingerprint (announced_definition,
+                                                                    strlen (announced_definition));
+    igs_shared_definition_t *first_shared = NULL, *second_shared = NULL, *found_shared = NULL;
+    igs_definition_t *remote_definition = parser_load_definition (announced_definition);
+    assert (remote_definition);
+    first_shared = s_network_share_definition (core_context, announced_fingerprint, remote_definition);
+    first_shared->refcount++;
+    HASH_FIND_STR (core_context->shared_definitions, announced_fingerprint, second_shared);
+    assert (second_shared == first_shared && second_shared->definition == remote_definition);
+    second_shared->refcount++;
+    s_network_release_definition (core_context, &first_shared);
+    assert (first_shared == NULL && second_shared->refcount == 1);
+    HASH_FIND_STR (core_context->shared_definitions, announced_fingerprint, found_shared);
+    assert (found_shared == second_shared && found_shared->definition == remote_definition);
+    s_network_release_definition (core_context, &second_shared);
+    HASH_FIND_STR (core_context->shared_definitions, announced_fingerprint, found_shared);
+    assert (found_shared == NULL);
+    free (announced_fingerprint);
+
+    //  A delta for a shared definition is applied to a private copy
+    igs_shared_definition_t *delta_shared =
+      s_network_share_definition (core_context, "delta fingerprint",
+                                  parser_load_definition (announced_definition));
+    delta_shared->refcount = 2;
+    igs_remote_agent_t first_remote = {.uuid = (char *) "first remote", .context = core_context,
+                                       .definition = delta_shared->definition,
+                                       .shared_definition = delta_shared};
+    igs_remote_agent_t second_remote = first_remote;
+    second_remote.uuid = (char *) "second remote";
+    assert (s_network_make_definition_private (&first_remote) == IGS_SUCCESS);
+    assert (first_remote.shared_definition != delta_shared
+            && first_remote.shared_definition->fingerprint == NULL);
+    assert (first_remote.definition != delta_shared->definition);
+    assert (delta_shared->refcount == 1 && second_remote.definition == delta_shared->definition);
+    assert (definition_remove_element (first_remote.definition, IGS_DELTA_OUTPUT, "out") == IGS_SUCCESS);
+    igs_iop_t *shared_output = NULL;
+    HASH_FIND_STR (second_remote.definition->outputs_table, "out", shared_output);
+    assert (shared_output);
+    HASH_FIND_STR (core_context->shared_definitions, "delta fingerprint", found_shared);
+    assert (found_shared == delta_shared);
+    // the last holder keeps its definition, which is not shared anymore
+    assert (s_network_make_definition_private (&second_remote) == IGS_SUCCESS);
+    assert (second_remote.shared_definition == delta_shared
+            && second_remote.definition == delta_shared->definition);
+    assert (delta_shared->fingerprint == NULL);
+    HASH_FIND_STR (core_context->shared_definitions, "delta fingerprint", found_shared);
+    assert (found_shared == NULL);
+    s_network_release_definition (core_context, &first_remote.shared_definition);
+    s_network_release_definition (core_context, &second_remote.shared_definition);
+    free (announced_definition);
+
+    //  Publication queue with a stalled publisher thread
+    size_t occupancy = 0, high_water_mark = 0, dropped = 0, published = 0;
+    igs_publication_queue_policy_t drop_policies[] = {IGS_PUBLICATION_QUEUE_DROP_NEWEST,
+                                                      IGS_PUBLICATION_QUEUE_DROP_OLDEST};
+    for (size_t i = 0; i < sizeof (drop_policies) / sizeof (drop_policies[0]); i++) {
+        assert (igs_net_set_publication_queue (4, drop_policies[i]) == IGS_SUCCESS);
+        igs_publication_queue_t *queue = core_context->publication_queue;
+        IGS_ATOMIC_STORE64 (&queue->running, 1); // no publisher thread empties the queue
+        for (int j = 0; j < 6; j++)
+            igsagent_output_set_int (publisher, "out", 100 + j);
+        // agents in same process do not wait for the queue
+        assert (igsagent_input_int (receiver, "in") == 105);
+        igs_net_publication_queue_stats (&occupancy, &high_water_mark, &dropped, &published);
+        assert (occupancy == 4 && high_water_mark == 4 && dropped == 2 && published == 0);
+        igs_publication_record_t *oldest =
+          &queue->slots[queue->dequeue_position & (queue->depth - 1)].record;
+        if (drop_policies[i] == IGS_PUBLICATION_QUEUE_DROP_NEWEST)
+            assert (oldest->output.value.i == 100);
+        else
+            assert (oldest->output.value.i == 102);
+        assert (streq (oldest->output.name, "out") && oldest->output.name == oldest->name);
+        network_start_publication_queue (core_context);
+        network_stop_publication_queue (core_context);
+        igs_net_publication_queue_stats (&occupancy, &high_water_mark, &dropped, &published);
+        assert (occupancy == 0 && high_water_mark == 4 && dropped == 2 && published == 4);
+    }
+    assert (igs_net_set_publication_queue (4, IGS_PUBLICATION_QUEUE_BLOCK) == IGS_SUCCESS);
+    network_start_publication_queue (core_context);
+    for (int j = 0; j < 64; j++)
+        igsagent_output_set_int (publisher, "out", 200 + j);
+    network_stop_publication_queue (core_context);
+    igs_net_publication_queue_stats (&occupancy, &high_water_mark, &dropped, &published);
+    assert (occupancy == 0 && dropped == 0 && published == 64);
+    assert (high_water_mark >= 1 && high_water_mark <= 4);
+    assert (igsagent_input_int (receiver, "in") == 263);
+    assert (igs_net_set_publication_queue (0, IGS_PUBLICATION_QUEUE_BLOCK) == IGS_SUCCESS);
+
+    //  Values published faster than the max rate are suppressed, the last
+    //  one of a conflated output is published when the interval elapses
+    core_context->loop = zloop_new ();
+    assert (igsagent_output_set_max_rate (publisher, "out", 20) == IGS_SUCCESS);
+    assert (igsagent_output_set_conflate (publisher, "out", true) == IGS_SUCCESS);
+    for (int j = 0; j < 5; j++)
+        igsagent_output_set_int (publisher, "out", 300 + j);
+    assert (igsagent_input_int (receiver, "in") == 300);
+    size_t suppressed = 0, flushed = 0;
+    igsagent_output_publication_stats (publisher, "out", &suppressed, &flushed);
+    assert (suppressed == 4 && flushed == 0);
+    assert (core_context->publication_flushes && !core_context->publication_flushes->next);
+    zloop_timer (core_context->loop, 200, 1, s_network_test_end_loop, NULL);
+    zloop_start (core_context->loop);
+    assert (core_context->publication_flushes == NULL);
+    assert (igsagent_input_int (receiver, "in") == 304);
+    igsagent_output_publication_stats (publisher, "out", &suppressed, &flushed);
+    assert (suppressed == 4 && flushed == 1);
+    assert (igsagent_output_set_max_rate (publisher, "out", 0) == IGS_SUCCESS);
+    zloop_destroy (&core_context->loop);
+
+    //  Definition changes made within one debounce window reach the other
+    //  agents as a single update, sent when the debounce timer fires
+    int flush_requests = 0;
+    zactor_t *flush_actor = zactor_new (s_network_test_flush_requests_actor, &flush_requests);
+    igs_test_definition_updates_t updates = {publisher->uuid, 0, NULL};
+    igsagent_observe_agent_events (receiver, s_network_test_agent_event, &updates);
+    core_context->network_actor = flush_actor;
+    core_context->node = zyre_new ("debounce"); // never started
+    s_network_flush_updates (NULL, 0, core_context); // changes made before the actor existed
+    updates.updates_nb = 0;
+    igsagent_definition_set_description (publisher, "debounced description");
+    igsagent_definition_set_version (publisher, "2.0");
+    assert (igsagent_output_create (publisher, "debounced_output", IGS_INTEGER_T, NULL, 0) == IGS_SUCCESS);
+    assert (core_context->network_updates_pending);
+    assert (updates.updates_nb == 0);
+    s_network_flush_updates (NULL, 0, core_context);
+    assert (!core_context->network_updates_pending);
+    assert (updates.updates_nb == 1);
+    assert (updates.definition && strstr (updates.definition, "debounced description"));
+    assert (strstr (updates.definition, "2.0") && strstr (updates.definition, "debounced_output"));
+    // nothing changed : nothing is sent
+    s_network_flush_updates (NULL, 0, core_context);
+    assert (updates.updates_nb == 1);
+    // a change after a flush opens a new window
+    assert (igsagent_output_remove (publisher, "debounced_output") == IGS_SUCCESS);
+    assert (core_context->network_updates_pending);
+    s_network_flush_updates (NULL, 0, core_context);
+    assert (updates.updates_nb == 2);
+    assert (!strstr (updates.definition, "debounced_output"));
+    core_context->network_actor = NULL;
+    zactor_destroy (&flush_actor); // handles the pending requests first
+    assert (flush_requests == 2);
+    zyre_destroy (&core_context->node);
+    free (updates.definition);
+    updates.definition = NULL;
+
+    //  Delta encoded outputs : keyframes are sent first, every keyframe
+    //  interval, when a keyframe is requested and when the size changes
+    byte delta_frame[1000];
+    for (size_t i = 0; i < sizeof (delta_frame); i++)
+        delta_frame[i] = (byte) i;
+    assert (igsagent_output_create (publisher, "delta_out", IGS_DATA_T, NULL, 0) == IGS_SUCCESS);
+    assert (igsagent_output_set_delta_encoding (publisher, "delta_out", 3) == IGS_SUCCESS);
+    igs_iop_t *delta_output = model_find_iop_by_name (publisher, "delta_out", IGS_OUTPUT_T);
+    byte expected_flags[] = {IGS_COMPACT_FLAG_KEYFRAME, IGS_COMPACT_FLAG_DELTA, IGS_COMPACT_FLAG_DELTA,
+                             IGS_COMPACT_FLAG_KEYFRAME, IGS_COMPACT_FLAG_DELTA, IGS_COMPACT_FLAG_KEYFRAME,
+                             IGS_COMPACT_FLAG_KEYFRAME, IGS_COMPACT_FLAG_DELTA};
+    igs_publication_record_t delta_records[sizeof (expected_flags)];
+    for (size_t i = 0; i < sizeof (expected_flags); i++) {
+        delta_frame[i * 10] ^= 0xff;
+        if (i == 5)
+            delta_output->delta_keyframe_requested = true;
+        size_t size = (i < 6) ? sizeof (delta_frame) : 500;
+        assert (igsagent_output_set_data (publisher, "delta_out", delta_frame, size) == IGS_SUCCESS);
+        model_read_lock (__FUNCTION__, __LINE__);
+        model_agent_write_lock (publisher);
+        s_network_init_publication_record (&delta_records[i], publisher, delta_output, INT64_MIN);
+        s_network_encode_delta (delta_output, &delta_records[i]);
+        model_agent_write_unlock (publisher);
+        model_read_unlock (__FUNCTION__, __LINE__);
+        assert (delta_records[i].delta_flags == expected_flags[i]);
+        assert (delta_records[i].delta_sequence == i + 1);
+        assert (delta_records[i].output.value_size == size);
+    }
+    assert (!delta_output->delta_keyframe_requested);
+    assert (delta_output->published_keyframes_nb == 4 && delta_output->published_deltas_nb == 4);
+
+    //  Delta encoded outputs on the receiving side : deltas rebuild the value
+    //  from the previous one, a gap in the sequence asks the publisher for a
+    //  keyframe using GET_OUTPUT_KEYFRAME and the next keyframe resets the stream
+    zyre_t *keyframe_publisher = zyre_new ("keyframe_publisher");
+    zyre_t *keyframe_requester = zyre_new ("keyframe_requester");
+    assert (zyre_set_endpoint (keyframe_publisher, "inproc://selftest_keyframe_publisher") == 0);
+    zyre_gossip_bind (keyframe_publisher, "inproc://selftest_keyframe_gossip");
+    assert (zyre_set_endpoint (keyframe_requester, "inproc://selftest_keyframe_requester") == 0);
+    zyre_gossip_connect (keyframe_requester, "inproc://selftest_keyframe_gossip");
+    assert (zyre_start (keyframe_publisher) == 0 && zyre_start (keyframe_requester) == 0);
+    zyre_event_t *keyframe_event = s_network_test_zyre_event (keyframe_publisher, "ENTER", 5000);
+    assert (keyframe_event);
+    zyre_event_destroy (&keyframe_event);
+    keyframe_event = s_network_test_zyre_event (keyframe_requester, "ENTER", 5000);
+    assert (keyframe_event);
+    zyre_event_destroy (&keyframe_event);
+    core_context->node = keyframe_requester;
+    igs_zyre_peer_t *keyframe_peer = (igs_zyre_peer_t *) zmalloc (sizeof (igs_zyre_peer_t));
+    keyframe_peer->peer_id = (char *) zyre_uuid (keyframe_publisher);
+    keyframe_peer->name = (char *) "keyframe_publisher";
+    igs_remote_agent_t *delta_remote = (igs_remote_agent_t *) zmalloc (sizeof (igs_remote_agent_t));
+    delta_remote->uuid = publisher->uuid;
+    delta_remote->peer = keyframe_peer;
+    delta_remote->context = core_context;
+    char *delta_definition = parser_export_definition (publisher->definition);
+    delta_remote->definition = parser_load_definition (delta_definition);
+    free (delta_definition);
+    assert (delta_remote->definition);
+
+    igs_compact_value_t received = s_network_test_received_value (&delta_records[0]);
+    assert (s_network_receive_delta (delta_remote, "delta_out", delta_records[0].delta_flags,
+                                     delta_records[0].delta_sequence, &received) == IGS_SUCCESS);
+    s_clear_compact_value (&received);
+    received = s_network_test_received_value (&delta_records[1]);
+    assert (s_network_receive_delta (delta_remote, "delta_out", delta_records[1].delta_flags,
+                                     delta_records[1].delta_sequence, &received) == IGS_SUCCESS);
+    assert (received.size == sizeof (delta_frame));
+    assert (memcmp (received.data, delta_records[1].output.value.data, received.size) == 0);
+    s_clear_compact_value (&received);
+    // records 2 and 3 are missed
+    igs_remote_output_state_t *delta_state = s_network_remote_output_state (delta_remote, "delta_out");
+    received = s_network_test_received_value (&delta_records[4]);
+    assert (s_network_receive_delta (delta_remote, "delta_out", delta_records[4].delta_flags,
+                                     delta_records[4].delta_sequence, &received) == IGS_FAILURE);
+    assert (!received.buffer && !delta_state->delta_reference);
+    int64_t keyframe_request = delta_state->delta_keyframe_request;
+    assert (keyframe_request);
+    keyframe_event = s_network_test_zyre_event (keyframe_publisher, "WHISPER", 5000);
+    assert (keyframe_event);
+    zmsg_t *keyframe_msg = zyre_event_msg (keyframe_event);
+    assert (keyframe_msg && zmsg_size (keyframe_msg) == 3);
+    assert (zframe_streq (zmsg_first (keyframe_msg), GET_OUTPUT_KEYFRAME_MSG));
+    assert (zframe_streq (zmsg_next (keyframe_msg), publisher->uuid));
+    assert (zframe_streq (zmsg_next (keyframe_msg), "delta_out"));
+    zyre_event_destroy (&keyframe_event);
+    // deltas received while waiting for the keyframe are not requested again
+    received = s_network_test_received_value (&delta_records[4]);
+    assert (s_network_receive_delta (delta_remote, "delta_out", delta_records[4].delta_flags,
+                                     delta_records[4].delta_sequence, &received) == IGS_FAILURE);
+    assert (delta_state->delta_keyframe_request == keyframe_request);
+    keyframe_event = s_network_test_zyre_event (keyframe_publisher, "WHISPER", 100);
+    assert (!keyframe_event);
+    // the requested keyframe resets the stream
+    for (size_t i = 5; i < sizeof (expected_flags); i++) {
+        received = s_network_test_received_value (&delta_records[i]);
+        assert (s_network_receive_delta (delta_remote, "delta_out", delta_records[i].delta_flags,
+                                         delta_records[i].delta_sequence, &received) == IGS_SUCCESS);
+        assert (delta_state->delta_keyframe_request == 0 && delta_state->delta_reference);
+        assert (received.size == delta_records[i].output.value_size);
+        assert (memcmp (received.data, delta_records[i].output.value.data, received.size) == 0);
+        s_clear_compact_value (&received);
+    }
+    assert (delta_state->delta_sequence == sizeof (expected_flags));
+
+    //  Values received in chunks arm the expiry timer, which is cancelled
+    //  when no value is being reassembled anymore
+    core_context->loop = zloop_new ();
+    byte chunk_bytes[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    igs_compact_value_t chunk;
+    uint64_t chunk_offsets[] = {0, 0, 10, 0};
+    uint32_t chunk_streams[] = {1, 2, 2, 3}; // stream 2 interrupts stream 1
+    for (size_t i = 0; i < sizeof (chunk_offsets) / sizeof (chunk_offsets[0]); i++) {
+        memset (&chunk, 0, sizeof (igs_compact_value_t));
+        chunk.value_type = IGS_DATA_T;
+        chunk.data = chunk_bytes;
+        chunk.size = sizeof (chunk_bytes);
+        assert (s_network_receive_chunk (delta_remote, "delta_out", chunk_streams[i],
+                                         chunk_offsets[i], 20, &chunk) == IGS_SUCCESS);
+        if (chunk_offsets[i] == 0) {
+            assert (chunk.pending && core_context->chunked_values_nb == 1);
+            assert (core_context->chunked_values_timer_id > 0);
+        } else {
+            assert (!chunk.pending && chunk.buffer && chunk.size == 20);
+            assert (core_context->chunked_values_nb == 0);
+            assert (core_context->chunked_values_timer_id == 0);
+        }
+        s_clear_compact_value (&chunk);
+    }
+    s_network_free_remote_output_states (delta_remote);
+    assert (core_context->chunked_values_nb == 0 && core_context->chunked_values_timer_id == 0);
+    zloop_destroy (&core_context->loop);
+    definition_free_definition (&delta_remote->definition);
+    free (delta_remote);
+    free (keyframe_peer);
+    core_context->node = NULL;
+    zyre_stop (keyframe_requester);
+    zyre_stop (keyframe_publisher);
+    zyre_destroy (&keyframe_requester);
+    zyre_destroy (&keyframe_publisher);
+    for (size_t i = 0; i < sizeof (expected_flags); i++)
+        s_network_clear_publication_record (&delta_records[i]);
+
+    igsagent_destroy (&receiver);
+    igsagent_destroy (&publisher);
+    //  @end
+    printf ("OK\n");
+}
@@ -32,6 +32,24 @@
 #define STR_TYPE "type"
 #define STR_VALUE "value"
 #define STR_CONSTRAINT "constraint"
+#define STR_ID "id"
+#define STR_MAX_RATE "max_rate"
+#define STR_MIN_INTERVAL "min_interval"
+#define STR_CONFLATE "conflate"
+#define STR_PUBLICATION_FILTER "publication_filter"
+#define STR_DEADBAND "deadband"
+#define STR_REFRESH_INTERVAL "refresh_interval"
+#define STR_KEYFRAME_INTERVAL "keyframe_interval"
+#define STR_CODEC "codec"
+#define STR_CHUNK_SIZE "chunk_size"
+#define STR_PRIORITY "priority"
+#define STR_PRIORITY_CONTROL "control"
+#define STR_PRIORITY_BULK "bulk"
+#define STR_CODEC_THRESHOLD "codec_threshold"
+#define STR_CODEC_LZ "lz"
+#define STR_FILTER_CHANGE "change"
+#define STR_FILTER_DEADBAND "deadband"
+#define STR_FILTER_RELATIVE_DEADBAND "relative_deadband"
 
 #define STR_MAPPINGS "mappings"
 #define STR_SPLITS "splits"
@@ -61,6 +79,12 @@ igs_iop_value_type_t s_string_to_value_type (const char *str)
             return IGS_IMPULSION_T;
         if (streq (str, "DATA"))
             return IGS_DATA_T;
+        if (streq (str, "INTEGER_ARRAY"))
+            return IGS_INTEGER_ARRAY_T;
+        if (streq (str, "FLOAT_ARRAY"))
+            return IGS_FLOAT_ARRAY_T;
+        if (streq (str, "DOUBLE_ARRAY"))
+            return IGS_DOUBLE_ARRAY_T;
         if (streq (str, "UNKNOWN"))
             return IGS_UNKNOWN_T;
     }
@@ -97,6 +121,12 @@ const char *s_value_type_to_string (igs_iop_value_type_t type)
             return "IMPULSION";
         case IGS_DATA_T:
             return "DATA";
+        case IGS_INTEGER_ARRAY_T:
+            return "INTEGER_ARRAY";
+        case IGS_FLOAT_ARRAY_T:
+            return "FLOAT_ARRAY";
+        case IGS_DOUBLE_ARRAY_T:
+            return "DOUBLE_ARRAY";
         case IGS_UNKNOWN_T:
             return "UNKNOWN";
         default:
@@ -106,6 +136,110 @@ const char *s_value_type_to_string (igs_iop_value_type_t type)
     return NULL;
 }
 
+// peers older than protocol v5 do not know typed arrays and get them as DATA
+const char *s_exported_value_type (igs_iop_value_type_t type, bool arrays_as_data)
+{
+    if (arrays_as_data && model_is_array_type (type))
+        return s_value_type_to_string (IGS_DATA_T);
+    return s_value_type_to_string (type);
+}
+
+// data values are stored as hexa strings
+void s_add_data_value_to_json (igs_json_t *json, igs_iop_t *iop)
+{
+    if (iop->value_size && iop->value.data){
+        char *data_to_store = (char *) zmalloc ((2 * iop->value_size + 1) * sizeof (char));
+        for (size_t i = 0; i < iop->value_size; i++)
+            sprintf (data_to_store + 2 * i, "%02X",
+                     *((uint8_t *) ((char *) iop->value.data + i)));
+        igs_json_add_string (json, data_to_store);
+        free (data_to_store);
+    }else{
+        igs_json_add_null(json);
+    }
+}
+
+// arrays are stored as JSON arrays of numbers, arrays having other elements
+// are rejected and leave the iop without value
+bool s_array_value_from_node (igs_iop_t *iop, igs_json_node_t *node)
+{
+    if (!node || node->type == IGS_JSON_NULL)
+        return true;
+    if (node->type != IGS_JSON_ARRAY)
+        return false;
+    if (node->u.array.len == 0)
+        return true;
+    size_t count = node->u.array.len;
+    for (size_t i = 0; i < count; i++) {
+        igs_json_node_t *element = node->u.array.values[i];
+        if (!igs_json_node_is_integer (element) && !igs_json_node_is_double (element))
+            return false;
+    }
+    double *values = (double *) zmalloc (count * sizeof (double));
+    for (size_t i = 0; i < count; i++) {
+        igs_json_node_t *element = node->u.array.values[i];
+        if (igs_json_node_is_integer (element))
+            values[i] = (double) element->u.number.i;
+        else
+            values[i] = element->u.number.d;
+    }
+    iop->value_size = count * model_array_element_size (iop->value_type);
+    iop->value.data = malloc (iop->value_size);
+    model_convert_array (iop->value_type, iop->value.data, IGS_DOUBLE_ARRAY_T, values, count);
+    free (values);
+    return true;
+}
+
+void s_add_array_value_to_json (igs_json_t *json, igs_iop_t *iop)
+{
+    size_t count = (iop->value.data) ? iop->value_size / model_array_element_size (iop->value_type) : 0;
+    igs_json_open_array (json);
+    for (size_t i = 0; i < count; i++) {
+        switch (iop->value_type) {
+            case IGS_INTEGER_ARRAY_T:
+                igs_json_add_int (json, ((int *) iop->value.data)[i]);
+                break;
+            case IGS_FLOAT_ARRAY_T:
+                igs_json_add_double (json, ((float *) iop->value.data)[i]);
+                break;
+            default:
+                igs_json_add_double (json, ((double *) iop->value.data)[i]);
+                break;
+        }
+    }
+    igs_json_close_array (json);
+}
+
+// codecs of data outputs and service arguments
+void s_parse_codec (igs_json_node_t *node, const char **codec_path, const char **threshold_path,
+                    igs_codec_t *codec, size_t *threshold)
+{
+    igs_json_node_t *codec_node = igs_json_node_find (node, codec_path);
+    if (!codec_node || codec_node->type != IGS_JSON_STRING || !codec_node->u.string)
+        return;
+    if (!streq (codec_node->u.string, STR_CODEC_LZ)) {
+        igs_warn ("unknown codec '%s' : ignoring", codec_node->u.string);
+        return;
+    }
+    *codec = IGS_CODEC_LZ;
+    igs_json_node_t *threshold_node = igs_json_node_find (node, threshold_path);
+    if (threshold_node && igs_json_node_is_integer (threshold_node)
+        && IGSYAJL_GET_INTEGER (threshold_node) > 0)
+        *threshold = (size_t) IGSYAJL_GET_INTEGER (threshold_node);
+}
+
+void s_add_codec_to_json (igs_json_t *json, igs_codec_t codec, size_t threshold)
+{
+    if (codec != IGS_CODEC_LZ)
+        return;
+    igs_json_add_string (json, STR_CODEC);
+    igs_json_add_string (json, STR_CODEC_LZ);
+    if (threshold > 0) {
+        igs_json_add_string (json, STR_CODEC_THRESHOLD);
+        igs_json_add_int (json, (int64_t) threshold);
+    }
+}
+
 //
 // Definition parsing
 //
@@ -130,6 +264,18 @@ igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json)
     const char *family_path[] = {STR_DEFINITION, STR_FAMILY, NULL};
     const char *type_path[] = {STR_TYPE, NULL};
     const char *value_path[] = {STR_VALUE, NULL};
+    const char *id_path[] = {STR_ID, NULL};
+    const char *max_rate_path[] = {STR_MAX_RATE, NULL};
+    const char *min_interval_path[] = {STR_MIN_INTERVAL, NULL};
+    const char *conflate_path[] = {STR_CONFLATE, NULL};
+    const char *publication_filter_path[] = {STR_PUBLICATION_FILTER, NULL};
+    const char *deadband_path[] = {STR_DEADBAND, NULL};
+    const char *refresh_interval_path[] = {STR_REFRESH_INTERVAL, NULL};
+    const char *keyframe_interval_path[] = {STR_KEYFRAME_INTERVAL, NULL};
+    const char *codec_path[] = {STR_CODEC, NULL};
+    const char *codec_threshold_path[] = {STR_CODEC_THRESHOLD, NULL};
+    const char *chunk_size_path[] = {STR_CHUNK_SIZE, NULL};
+    const char *priority_path[] = {STR_PRIORITY, NULL};
     const char *replies_path[] = {STR_REPLIES, NULL};
 
     // name is mandatory
@@ -332,11 +478,80 @@ igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json)
                                 ? strlen (iop_value->u.string) / 2
                                 : 0;
                             break;
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
+                            if (!s_array_value_from_node (iop, iop_value))
+                                igs_warn ("array value of '%s' is not made of numbers : ignoring it",
+                                          iop->name);
+                            break;
                         default:
                             break;
                     }
                 }
+                igs_json_node_t *iop_id = igs_json_node_find (outputs->u.array.values[i], id_path);
+                if (iop_id && igs_json_node_is_integer (iop_id)
+                    && IGSYAJL_GET_INTEGER (iop_id) > 0 && IGSYAJL_GET_INTEGER (iop_id) <= UINT16_MAX)
+                    iop->id = (uint16_t) IGSYAJL_GET_INTEGER (iop_id);
+                // publication policy : max rate in Hz or min interval in milliseconds
+                igs_json_node_t *max_rate = igs_json_node_find (outputs->u.array.values[i], max_rate_path);
+                igs_json_node_t *min_interval = igs_json_node_find (outputs->u.array.values[i], min_interval_path);
+                if (max_rate && max_rate->type == IGS_JSON_NUMBER && IGSYAJL_GET_DOUBLE (max_rate) > 0)
+                    iop->publication_min_interval = (int64_t) (1000000 / IGSYAJL_GET_DOUBLE (max_rate));
+                else if (min_interval && min_interval->type == IGS_JSON_NUMBER
+                         && IGSYAJL_GET_DOUBLE (min_interval) > 0)
+                    iop->publication_min_interval = (int64_t) (IGSYAJL_GET_DOUBLE (min_interval) * 1000);
+                igs_json_node_t *conflate = igs_json_node_find (outputs->u.array.values[i], conflate_path);
+                if (conflate && conflate->type == IGS_JSON_TRUE)
+                    iop->publication_conflate = true;
+                // publication filter, dead-band and refresh interval in milliseconds
+                igs_json_node_t *filter = igs_json_node_find (outputs->u.array.values[i], publication_filter_path);
+                if (filter && filter->type == IGS_JSON_STRING && filter->u.string) {
+                    bool numeric = (iop->value_type == IGS_INTEGER_T || iop->value_type == IGS_DOUBLE_T);
+                    if (streq (filter->u.string, STR_FILTER_CHANGE) && iop->value_type != IGS_IMPULSION_T)
+                        iop->publication_filter = IGS_PUBLICATION_FILTER_CHANGE;
+                    else if (streq (filter->u.string, STR_FILTER_DEADBAND) && numeric)
+                        iop->publication_filter = IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE;
+                    else if (streq (filter->u.string, STR_FILTER_RELATIVE_DEADBAND) && numeric)
+                        iop->publication_filter = IGS_PUBLICATION_FILTER_DEADBAND_RELATIVE;
+                    else
+                        igs_warn ("invalid publication filter '%s' for output %s : ignoring",
+                                  filter->u.string, iop->name);
+                }
+                igs_json_node_t *deadband = igs_json_node_find (outputs->u.array.values[i], deadband_path);
+                if (deadband && deadband->type == IGS_JSON_NUMBER && IGSYAJL_GET_DOUBLE (deadband) > 0)
+                    iop->publication_deadband = IGSYAJL_GET_DOUBLE (deadband);
+                igs_json_node_t *refresh_interval = igs_json_node_find (outputs->u.array.values[i], refresh_interval_path);
+                if (refresh_interval && igs_json_node_is_integer (refresh_interval)
+                    && IGSYAJL_GET_INTEGER (refresh_interval) > 0)
+                    iop->publication_refresh_interval = IGSYAJL_GET_INTEGER (refresh_interval) * 1000;
+                igs_json_node_t *keyframe_interval = igs_json_node_find (outputs->u.array.values[i], keyframe_interval_path);
+                if (keyframe_interval && igs_json_node_is_integer (keyframe_interval)
+                    && IGSYAJL_GET_INTEGER (keyframe_interval) > 0) {
+                    if (iop->value_type == IGS_DATA_T)
+                        iop->delta_keyframe_interval = (unsigned int) IGSYAJL_GET_INTEGER (keyframe_interval);
+                    else
+                        igs_warn ("delta encoding requires a data output (%s) : ignoring", iop->name);
+                }
+                if (iop->value_type == IGS_DATA_T) {
+                    s_parse_codec (outputs->u.array.values[i], codec_path, codec_threshold_path,
+                                   &iop->codec, &iop->codec_threshold);
+                    igs_json_node_t *chunk_size = igs_json_node_find (outputs->u.array.values[i], chunk_size_path);
+                    if (chunk_size && igs_json_node_is_integer (chunk_size) && IGSYAJL_GET_INTEGER (chunk_size) > 0)
+                        iop->chunk_size = (size_t) IGSYAJL_GET_INTEGER (chunk_size);
+                }
+                igs_json_node_t *priority = igs_json_node_find (outputs->u.array.values[i], priority_path);
+                if (priority && priority->type == IGS_JSON_STRING && priority->u.string) {
+                    if (streq (priority->u.string, STR_PRIORITY_CONTROL))
+                        iop->priority = IGS_PRIORITY_CONTROL;
+                    else if (streq (priority->u.string, STR_PRIORITY_BULK))
+                        iop->priority = IGS_PRIORITY_BULK;
+                    else
+                        igs_warn ("invalid priority '%s' for output %s : ignoring",
+                                  priority->u.string, iop->name);
+                }
                 HASH_ADD_STR (definition->outputs_table, name, iop);
+                definition_index_output (definition, iop);
             }
         }
     }
@@ -436,6 +651,13 @@ igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json)
                                  ? s_model_string_to_bytes (iop_value->u.string)
                                  : NULL);
                             break;
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
+                            if (!s_array_value_from_node (iop, iop_value))
+                                igs_warn ("array value of '%s' is not made of numbers : ignoring it",
+                                          iop->name);
+                            break;
                         default:
                             break;
                     }
@@ -490,6 +712,8 @@ igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json)
                                                   description_path);
                 if (description && description->type == IGS_JSON_STRING && description->u.string)
                     service->description = strdup (description->u.string);
+                s_parse_codec (services->u.array.values[i], codec_path, codec_threshold_path,
+                               &service->codec, &service->codec_threshold);
 
                 igs_json_node_t *arguments = igs_json_node_find (
                   services->u.array.values[i], arguments_path);
@@ -955,7 +1179,289 @@ igs_mapping_t *parser_load_mapping_from_path (const char *path)
     return parser_parse_mapping_from_node (&json); // will free json tree node
 }
 
-char *parser_export_definition (igs_definition_t *def)
+void s_add_constraint_to_json (igs_json_t *json, igs_constraint_t *constraint)
+{
+    char constraint_expression[IGS_MAX_LOG_LENGTH] = "";
+    if (constraint->type == IGS_CONSTRAINT_MIN){
+        if (constraint->value_type == IGS_INTEGER_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %d",
+                     constraint->min_int.min);
+            igs_json_add_string(json, constraint_expression);
+        }else if (constraint->value_type == IGS_DOUBLE_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %f",
+                     constraint->min_double.min);
+            igs_json_add_string(json, constraint_expression);
+        }
+    }else if (constraint->type == IGS_CONSTRAINT_MAX){
+        if (constraint->value_type == IGS_INTEGER_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %d",
+                     constraint->max_int.max);
+            igs_json_add_string(json, constraint_expression);
+        }else if (constraint->value_type == IGS_DOUBLE_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %f",
+                     constraint->max_double.max);
+            igs_json_add_string(json, constraint_expression);
+        }
+    }else if (constraint->type == IGS_CONSTRAINT_RANGE){
+        if (constraint->value_type == IGS_INTEGER_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%d, %d]",
+                     constraint->range_int.min,
+                     constraint->range_int.max);
+            igs_json_add_string(json, constraint_expression);
+        }else if (constraint->value_type == IGS_DOUBLE_T){
+            igs_json_add_string (json, STR_CONSTRAINT);
+            snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%f, %f]",
+                     constraint->range_double.min,
+                     constraint->range_double.max);
+            igs_json_add_string(json, constraint_expression);
+        }
+    }else if (constraint->type == IGS_CONSTRAINT_REGEXP){
+        igs_json_add_string (json, STR_CONSTRAINT);
+        snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "~ %s",
+                 constraint->regexp.string);
+        igs_json_add_string(json, constraint_expression);
+    }
+}
+
+void s_add_input_to_json (igs_json_t *json, igs_iop_t *iop, bool arrays_as_data)
+{
+    igs_json_open_map (json);
+    if (iop->name) {
+        igs_json_add_string (json, STR_NAME);
+        igs_json_add_string (json, iop->name);
+    }
+    if (iop->constraint)
+        s_add_constraint_to_json (json, iop->constraint);
+    if (iop->description){
+        igs_json_add_string (json, STR_DESCRIPTION);
+        igs_json_add_string (json, iop->description);
+    }
+    igs_json_add_string (json, STR_TYPE);
+    igs_json_add_string (json, s_exported_value_type (iop->value_type, arrays_as_data));
+    //NB: inputs do not have intial values
+    igs_json_close_map (json);
+}
+
+void s_add_output_to_json (igs_json_t *json, igs_iop_t *iop, bool arrays_as_data)
+{
+    igs_json_open_map (json);
+    if (iop->name) {
+        igs_json_add_string (json, STR_NAME);
+        igs_json_add_string (json, iop->name);
+    }
+    if (iop->id) {
+        igs_json_add_string (json, STR_ID);
+        igs_json_add_int (json, iop->id);
+    }
+    if (iop->publication_min_interval > 0) {
+        igs_json_add_string (json, STR_MAX_RATE);
+        igs_json_add_double (json, 1000000.0 / (double) iop->publication_min_interval);
+    }
+    if (iop->publication_conflate) {
+        igs_json_add_string (json, STR_CONFLATE);
+        igs_json_add_bool (json, true);
+    }
+    if (iop->publication_filter != IGS_PUBLICATION_FILTER_NONE) {
+        igs_json_add_string (json, STR_PUBLICATION_FILTER);
+        if (iop->publication_filter == IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE)
+            igs_json_add_string (json, STR_FILTER_DEADBAND);
+        else if (iop->publication_filter == IGS_PUBLICATION_FILTER_DEADBAND_RELATIVE)
+            igs_json_add_string (json, STR_FILTER_RELATIVE_DEADBAND);
+        else
+            igs_json_add_string (json, STR_FILTER_CHANGE);
+        if (iop->publication_deadband > 0) {
+            igs_json_add_string (json, STR_DEADBAND);
+            igs_json_add_double (json, iop->publication_deadband);
+        }
+    }
+    if (iop->publication_refresh_interval > 0) {
+        igs_json_add_string (json, STR_REFRESH_INTERVAL);
+        igs_json_add_int (json, iop->publication_refresh_interval / 1000);
+    }
+    if (iop->delta_keyframe_interval > 0) {
+        igs_json_add_string (json, STR_KEYFRAME_INTERVAL);
+        igs_json_add_int (json, iop->delta_keyframe_interval);
+    }
+    s_add_codec_to_json (json, iop->codec, iop->codec_threshold);
+    if (iop->chunk_size > 0) {
+        igs_json_add_string (json, STR_CHUNK_SIZE);
+        igs_json_add_int (json, (int64_t) iop->chunk_size);
+    }
+    if (iop->priority != IGS_PRIORITY_NORMAL) {
+        igs_json_add_string (json, STR_PRIORITY);
+        igs_json_add_string (json, (iop->priority == IGS_PRIORITY_CONTROL) ? STR_PRIORITY_CONTROL : STR_PRIORITY_BULK);
+    }
+    igs_json_add_string (json, STR_TYPE);
+    igs_json_add_string (json, s_exported_value_type (iop->value_type, arrays_as_data));
+    igs_json_add_string (json, STR_VALUE);
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            igs_json_add_int (json, iop->value.i);
+            break;
+        case IGS_DOUBLE_T:
+            igs_json_add_double (json, iop->value.d);
+            break;
+        case IGS_BOOL_T:
+            igs_json_add_bool (json, iop->value.b);
+            break;
+        case IGS_STRING_T:
+            igs_json_add_string (json, iop->value.s);
+            break;
+        case IGS_IMPULSION_T:
+            igs_json_add_null (json);
+            break;
+        case IGS_DATA_T:
+            s_add_data_value_to_json (json, iop);
+            break;
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            if (arrays_as_data)
+                s_add_data_value_to_json (json, iop);
+            else
+                s_add_array_value_to_json (json, iop);
+            break;
+        default:
+            igs_json_add_string (json, "");
+            break;
+    }
+    if (iop->constraint)
+        s_add_constraint_to_json (json, iop->constraint);
+    if (iop->description){
+        igs_json_add_string (json, STR_DESCRIPTION);
+        igs_json_add_string (json, iop->description);
+    }
+    igs_json_close_map (json);
+}
+
+void s_add_parameter_to_json (igs_json_t *json, igs_iop_t *iop, bool arrays_as_data)
+{
+    igs_json_open_map (json);
+    if (iop->name) {
+        igs_json_add_string (json, STR_NAME);
+        igs_json_add_string (json, iop->name);
+    }
+    igs_json_add_string (json, STR_TYPE);
+    igs_json_add_string (json, s_exported_value_type (iop->value_type, arrays_as_data));
+    igs_json_add_string (json, STR_VALUE);
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            igs_json_add_int (json, iop->value.i);
+            break;
+        case IGS_DOUBLE_T:
+            igs_json_add_double (json, iop->value.d);
+            break;
+        case IGS_BOOL_T:
+            igs_json_add_bool (json, iop->value.b);
+            break;
+        case IGS_STRING_T:
+            igs_json_add_string (json, iop->value.s);
+            break;
+        case IGS_IMPULSION_T:
+            igs_json_add_null (json);
+            break;
+        case IGS_DATA_T:
+            s_add_data_value_to_json (json, iop);
+            break;
+        case IGS_INTEGER_ARRAY_T:
+        case IGS_FLOAT_ARRAY_T:
+        case IGS_DOUBLE_ARRAY_T:
+            if (arrays_as_data)
+                s_add_data_value_to_json (json, iop);
+            else
+                s_add_array_value_to_json (json, iop);
+            break;
+        default:
+            igs_json_add_string (json, "");
+            break;
+    }
+    if (iop->constraint)
+        s_add_constraint_to_json (json, iop->constraint);
+    if (iop->description){
+        igs_json_add_string (json, STR_DESCRIPTION);
+        igs_json_add_string (json, iop->description);
+    }
+    igs_json_close_map (json);
+}
+
+void s_add_service_to_json (igs_json_t *json, igs_service_t *service, bool arrays_as_data)
+{
+    igs_json_open_map (json);
+    if (service->name) {
+        igs_json_add_string (json, STR_NAME);
+        igs_json_add_string (json, service->name);
+        if (service->description) {
+            igs_json_add_string (json, STR_DESCRIPTION);
+            igs_json_add_string (json, service->description);
+        }
+        s_add_codec_to_json (json, service->codec, service->codec_threshold);
+
+        if (service->arguments) {
+            igs_json_add_string (json, STR_ARGUMENTS);
+            igs_json_open_array (json);
+            igs_service_arg_t *argument = NULL;
+            LL_FOREACH (service->arguments, argument)
+            {
+                if (argument->name) {
+                    igs_json_open_map (json);
+                    igs_json_add_string (json, STR_NAME);
+                    igs_json_add_string (json, argument->name);
+                    igs_json_add_string (json, STR_TYPE);
+                    igs_json_add_string (
+                      json, s_exported_value_type (argument->type, arrays_as_data));
+                    igs_json_close_map (json);
+                }
+            }
+            igs_json_close_array (json);
+        }
+
+        if (service->replies) {
+            igs_service_t *r, *r_tmp;
+            igs_json_add_string (json, STR_REPLIES);
+            igs_json_open_array (json);
+            HASH_ITER(hh, service->replies, r, r_tmp){
+                if (r->name) {
+                    igs_json_open_map (json);
+                    igs_json_add_string (json, STR_NAME);
+                    igs_json_add_string (json, r->name);
+                    if (r->description) {
+                        igs_json_add_string (json, STR_DESCRIPTION);
+                        igs_json_add_string (json, r->description);
+                    }
+                    if (r->arguments) {
+                        igs_json_add_string (json, STR_ARGUMENTS);
+                        igs_json_open_array (json);
+                        igs_service_arg_t *argument = NULL;
+                        LL_FOREACH (r->arguments, argument){
+                            if (argument->name) {
+                                igs_json_open_map (json);
+                                igs_json_add_string (json, STR_NAME);
+                                igs_json_add_string (json, argument->name);
+                                igs_json_add_string (json, STR_TYPE);
+                                igs_json_add_string (
+                                  json,
+                                  s_exported_value_type (argument->type, arrays_as_data));
+                                igs_json_close_map (json);
+                            }
+                        }
+                        igs_json_close_array (json);
+                    }
+                    igs_json_close_map (json);
+                }
+            }
+            igs_json_close_array (json);
+        }
+    }
+    igs_json_close_map (json);
+}
+
+// exports a definition for peers knowing typed arrays, or having them as DATA
+static char *s_export_definition (igs_definition_t *def, bool arrays_as_data)
 {
     assert (def);
     igs_json_t *json = igs_json_new ();
@@ -983,341 +1489,100 @@ char *parser_export_definition (igs_definition_t *def)
     igs_json_open_array (json);
     igs_iop_t *iop, *tmp_iop;
     HASH_ITER (hh, def->inputs_table, iop, tmp_iop)
-    {
-        igs_json_open_map (json);
-        if (iop->name) {
-            igs_json_add_string (json, STR_NAME);
-            igs_json_add_string (json, iop->name);
-        }
-        char constraint_expression[IGS_MAX_LOG_LENGTH] = "";
-        if (iop->constraint){
-            if (iop->constraint->type == IGS_CONSTRAINT_MIN){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %d",
-                             iop->constraint->min_int.min);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %f",
-                             iop->constraint->min_double.min);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_MAX){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %d",
-                             iop->constraint->max_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %f",
-                             iop->constraint->max_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_RANGE){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%d, %d]",
-                             iop->constraint->range_int.min,
-                             iop->constraint->range_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%f, %f]",
-                             iop->constraint->range_double.min,
-                             iop->constraint->range_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_REGEXP){
-                igs_json_add_string (json, STR_CONSTRAINT);
-                snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "~ %s",
-                         iop->constraint->regexp.string);
-                igs_json_add_string(json, constraint_expression);
-            }
-        }
-        if (iop->description){
-            igs_json_add_string (json, STR_DESCRIPTION);
-            igs_json_add_string (json, iop->description);
-        }
-        igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
-        //NB: inputs do not have intial values
-        igs_json_close_map (json);
-    }
+        s_add_input_to_json (json, iop, arrays_as_data);
     igs_json_close_array (json);
 
     igs_json_add_string (json, STR_OUTPUTS);
     igs_json_open_array (json);
     HASH_ITER (hh, def->outputs_table, iop, tmp_iop)
-    {
-        igs_json_open_map (json);
-        if (iop->name) {
-            igs_json_add_string (json, STR_NAME);
-            igs_json_add_string (json, iop->name);
-        }
-        igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
-        igs_json_add_string (json, STR_VALUE);
-        switch (iop->value_type) {
-            case IGS_INTEGER_T:
-                igs_json_add_int (json, iop->value.i);
-                break;
-            case IGS_DOUBLE_T:
-                igs_json_add_double (json, iop->value.d);
-                break;
-            case IGS_BOOL_T:
-                igs_json_add_bool (json, iop->value.b);
-                break;
-            case IGS_STRING_T:
-                igs_json_add_string (json, iop->value.s);
-                break;
-            case IGS_IMPULSION_T:
-                igs_json_add_null (json);
-                break;
-            case IGS_DATA_T: {
-                if (iop->value_size){
-                    char *data_to_store = (char *) zmalloc ((2 * iop->value_size + 1) * sizeof (char));
-                    for (size_t i = 0; i < iop->value_size; i++)
-                        sprintf (data_to_store + 2 * i, "%02X",
-                                 *((uint8_t *) ((char *) iop->value.data + i)));
-                    igs_json_add_string (json, data_to_store);
-                    free (data_to_store);
-                }else{
-                    igs_json_add_null(json);
-                }
-                break;
-            }
-            default:
-                igs_json_add_string (json, "");
-                break;
-        }
-        char constraint_expression[IGS_MAX_LOG_LENGTH] = "";
-        if (iop->constraint){
-            if (iop->constraint->type == IGS_CONSTRAINT_MIN){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %d",
-                             iop->constraint->min_int.min);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %f",
-                             iop->constraint->min_double.min);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_MAX){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %d",
-                             iop->constraint->max_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %f",
-                             iop->constraint->max_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_RANGE){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%d, %d]",
-                             iop->constraint->range_int.min,
-                             iop->constraint->range_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%f, %f]",
-                             iop->constraint->range_double.min,
-                             iop->constraint->range_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_REGEXP){
-                igs_json_add_string (json, STR_CONSTRAINT);
-                snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "~ %s",
-                         iop->constraint->regexp.string);
-                igs_json_add_string(json, constraint_expression);
-            }
-        }
-        if (iop->description){
-            igs_json_add_string (json, STR_DESCRIPTION);
-            igs_json_add_string (json, iop->description);
-        }
-        igs_json_close_map (json);
-    }
+        s_add_output_to_json (json, iop, arrays_as_data);
     igs_json_close_array (json);
 
     igs_json_add_string (json, STR_PARAMETERS);
     igs_json_open_array (json);
     HASH_ITER (hh, def->params_table, iop, tmp_iop)
-    {
-        igs_json_open_map (json);
-        if (iop->name) {
-            igs_json_add_string (json, STR_NAME);
-            igs_json_add_string (json, iop->name);
-        }
-        igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
-        igs_json_add_string (json, STR_VALUE);
-        switch (iop->value_type) {
-            case IGS_INTEGER_T:
-                igs_json_add_int (json, iop->value.i);
-                break;
-            case IGS_DOUBLE_T:
-                igs_json_add_double (json, iop->value.d);
-                break;
-            case IGS_BOOL_T:
-                igs_json_add_bool (json, iop->value.b);
-                break;
-            case IGS_STRING_T:
-                igs_json_add_string (json, iop->value.s);
-                break;
-            case IGS_IMPULSION_T:
-                igs_json_add_null (json);
-                break;
-            case IGS_DATA_T: {
-                if (iop->value_size){
-                    char *data_to_store = (char *) zmalloc ((2 * iop->value_size + 1) * sizeof (char));
-                    for (size_t i = 0; i < iop->value_size; i++)
-                        sprintf (data_to_store + 2 * i, "%02X",
-                                 *((uint8_t *) ((char *) iop->value.data + i)));
-                    igs_json_add_string (json, data_to_store);
-                    free (data_to_store);
-                }else{
-                    igs_json_add_null(json);
-                }
-                break;
-            }
-            default:
-                igs_json_add_string (json, "");
-                break;
-        }
-        char constraint_expression[IGS_MAX_LOG_LENGTH] = "";
-        if (iop->constraint){
-            if (iop->constraint->type == IGS_CONSTRAINT_MIN){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %d",
-                             iop->constraint->min_int.min);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "min %f",
-                             iop->constraint->min_double.min);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_MAX){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %d",
-                             iop->constraint->max_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "max %f",
-                             iop->constraint->max_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_RANGE){
-                if (iop->value_type == IGS_INTEGER_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%d, %d]",
-                             iop->constraint->range_int.min,
-                             iop->constraint->range_int.max);
-                    igs_json_add_string(json, constraint_expression);
-                }else if (iop->value_type == IGS_DOUBLE_T){
-                    igs_json_add_string (json, STR_CONSTRAINT);
-                    snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "[%f, %f]",
-                             iop->constraint->range_double.min,
-                             iop->constraint->range_double.max);
-                    igs_json_add_string(json, constraint_expression);
-                }
-            }else if (iop->constraint->type == IGS_CONSTRAINT_REGEXP){
-                igs_json_add_string (json, STR_CONSTRAINT);
-                snprintf(constraint_expression, IGS_MAX_LOG_LENGTH, "~ %s",
-                         iop->constraint->regexp.string);
-                igs_json_add_string(json, constraint_expression);
-            }
-        }
-        if (iop->description){
-            igs_json_add_string (json, STR_DESCRIPTION);
-            igs_json_add_string (json, iop->description);
-        }
-        igs_json_close_map (json);
-    }
+        s_add_parameter_to_json (json, iop, arrays_as_data);
     igs_json_close_array (json);
 
     igs_json_add_string (json, STR_SERVICES);
     igs_json_open_array (json);
     igs_service_t *service, *tmp_service;
     HASH_ITER (hh, def->services_table, service, tmp_service)
-    {
-        igs_json_open_map (json);
-        if (service->name) {
-            igs_json_add_string (json, STR_NAME);
-            igs_json_add_string (json, service->name);
-            if (service->description) {
-                igs_json_add_string (json, STR_DESCRIPTION);
-                igs_json_add_string (json, service->description);
-            }
+        s_add_service_to_json (json, service, arrays_as_data);
+    igs_json_close_array (json);
 
-            if (service->arguments) {
-                igs_json_add_string (json, STR_ARGUMENTS);
-                igs_json_open_array (json);
-                igs_service_arg_t *argument = NULL;
-                LL_FOREACH (service->arguments, argument)
-                {
-                    if (argument->name) {
-                        igs_json_open_map (json);
-                        igs_json_add_string (json, STR_NAME);
-                        igs_json_add_string (json, argument->name);
-                        igs_json_add_string (json, STR_TYPE);
-                        igs_json_add_string (
-                          json, s_value_type_to_string (argument->type));
-                        igs_json_close_map (json);
-                    }
-                }
-                igs_json_close_array (json);
-            }
+    igs_json_close_map (json);
+    igs_json_close_map (json);
+    char *res = igs_json_dump (json);
+    igs_json_destroy (&json);
+    return res;
+}
 
-            if (service->replies) {
-                igs_service_t *r, *r_tmp;
-                igs_json_add_string (json, STR_REPLIES);
-                igs_json_open_array (json);
-                HASH_ITER(hh, service->replies, r, r_tmp){
-                    if (r->name) {
-                        igs_json_open_map (json);
-                        igs_json_add_string (json, STR_NAME);
-                        igs_json_add_string (json, r->name);
-                        if (r->description) {
-                            igs_json_add_string (json, STR_DESCRIPTION);
-                            igs_json_add_string (json, r->description);
-                        }
-                        if (r->arguments) {
-                            igs_json_add_string (json, STR_ARGUMENTS);
-                            igs_json_open_array (json);
-                            igs_service_arg_t *argument = NULL;
-                            LL_FOREACH (r->arguments, argument){
-                                if (argument->name) {
-                                    igs_json_open_map (json);
-                                    igs_json_add_string (json, STR_NAME);
-                                    igs_json_add_string (json, argument->name);
-                                    igs_json_add_string (json, STR_TYPE);
-                                    igs_json_add_string (
-                                      json,
-                                      s_value_type_to_string (argument->type));
-                                    igs_json_close_map (json);
-                                }
-                            }
-                            igs_json_close_array (json);
-                        }
-                        igs_json_close_map (json);
-                    }
-                }
-                igs_json_close_array (json);
-            }
-        }
-        igs_json_close_map (json);
+char *parser_export_definition (igs_definition_t *def)
+{
+    return s_export_definition (def, false);
+}
+
+char *parser_export_definition_without_arrays (igs_definition_t *def)
+{
+    return s_export_definition (def, true);
+}
+
+char *parser_export_definition_fragment (igs_definition_t *def, igs_delta_change_t *changes)
+{
+    assert (def);
+    igs_json_t *json = igs_json_new ();
+    igs_json_open_map (json);
+    igs_json_add_string (json, STR_DEFINITION);
+    igs_json_open_map (json);
+    if (def->name) {
+        igs_json_add_string (json, STR_NAME);
+        igs_json_add_string (json, def->name);
+    }
+    igs_delta_change_t *change = NULL;
+    igs_iop_t *iop = NULL;
+    igs_json_add_string (json, STR_INPUTS);
+    igs_json_open_array (json);
+    LL_FOREACH (changes, change){
+        if (change->kind != IGS_DELTA_INPUT)
+            continue;
+        HASH_FIND_STR (def->inputs_table, change->name, iop);
+        if (iop)
+            s_add_input_to_json (json, iop, false);
+    }
+    igs_json_close_array (json);
+
+    igs_json_add_string (json, STR_OUTPUTS);
+    igs_json_open_array (json);
+    LL_FOREACH (changes, change){
+        if (change->kind != IGS_DELTA_OUTPUT)
+            continue;
+        HASH_FIND_STR (def->outputs_table, change->name, iop);
+        if (iop)
+            s_add_output_to_json (json, iop, false);
+    }
+    igs_json_close_array (json);
+
+    igs_json_add_string (json, STR_PARAMETERS);
+    igs_json_open_array (json);
+    LL_FOREACH (changes, change){
+        if (change->kind != IGS_DELTA_PARAMETER)
+            continue;
+        HASH_FIND_STR (def->params_table, change->name, iop);
+        if (iop)
+            s_add_parameter_to_json (json, iop, false);
+    }
+    igs_json_close_array (json);
+
+    igs_json_add_string (json, STR_SERVICES);
+    igs_json_open_array (json);
+    LL_FOREACH (changes, change){
+        if (change->kind != IGS_DELTA_SERVICE)
+            continue;
+        igs_service_t *service = NULL;
+        HASH_FIND_STR (def->services_table, change->name, service);
+        if (service)
+            s_add_service_to_json (json, service, false);
     }
     igs_json_close_array (json);
 
@@ -1363,7 +1628,7 @@ char *parser_export_definition_legacy (igs_definition_t *def)
             igs_json_add_string (json, iop->name);
         }
         igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
+        igs_json_add_string (json, s_exported_value_type (iop->value_type, true));
         // NB: inputs do not have intial values
         igs_json_close_map (json);
     }
@@ -1379,7 +1644,7 @@ char *parser_export_definition_legacy (igs_definition_t *def)
             igs_json_add_string (json, iop->name);
         }
         igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
+        igs_json_add_string (json, s_exported_value_type (iop->value_type, true));
         igs_json_add_string (json, STR_VALUE);
         switch (iop->value_type) {
             case IGS_INTEGER_T:
@@ -1397,19 +1662,13 @@ char *parser_export_definition_legacy (igs_definition_t *def)
             case IGS_IMPULSION_T:
                 igs_json_add_null (json);
                 break;
-            case IGS_DATA_T: {
-                if (iop->value_size){
-                    char *data_to_store = (char *) zmalloc ((2 * iop->value_size + 1) * sizeof (char));
-                    for (size_t i = 0; i < iop->value_size; i++)
-                        sprintf (data_to_store + 2 * i, "%02X",
-                                 *((uint8_t *) ((char *) iop->value.data + i)));
-                    igs_json_add_string (json, data_to_store);
-                    free (data_to_store);
-                }else{
-                    igs_json_add_null(json);
-                }
+            case IGS_DATA_T:
+            case IGS_INTEGER_ARRAY_T:
+            case IGS_FLOAT_ARRAY_T:
+            case IGS_DOUBLE_ARRAY_T:
+                // legacy peers know arrays as DATA
+                s_add_data_value_to_json (json, iop);
                 break;
-            }
             default:
                 igs_json_add_string (json, "");
                 break;
@@ -1428,7 +1687,7 @@ char *parser_export_definition_legacy (igs_definition_t *def)
             igs_json_add_string (json, iop->name);
         }
         igs_json_add_string (json, STR_TYPE);
-        igs_json_add_string (json, s_value_type_to_string (iop->value_type));
+        igs_json_add_string (json, s_exported_value_type (iop->value_type, true));
         igs_json_add_string (json, STR_VALUE);
         switch (iop->value_type) {
             case IGS_INTEGER_T:
@@ -1446,19 +1705,13 @@ char *parser_export_definition_legacy (igs_definition_t *def)
             case IGS_IMPULSION_T:
                 igs_json_add_null (json);
                 break;
-            case IGS_DATA_T: {
-                if (iop->value_size){
-                    char *data_to_store = (char *) zmalloc ((2 * iop->value_size + 1) * sizeof (char));
-                    for (size_t i = 0; i < iop->value_size; i++)
-                        sprintf (data_to_store + 2 * i, "%02X",
-                                 *((uint8_t *) ((char *) iop->value.data + i)));
-                    igs_json_add_string (json, data_to_store);
-                    free (data_to_store);
-                }else{
-                    igs_json_add_null(json);
-                }
+            case IGS_DATA_T:
+            case IGS_INTEGER_ARRAY_T:
+            case IGS_FLOAT_ARRAY_T:
+            case IGS_DOUBLE_ARRAY_T:
+                // legacy peers know arrays as DATA
+                s_add_data_value_to_json (json, iop);
                 break;
-            }
             default:
                 igs_json_add_string (json, "");
                 break;
@@ -1493,7 +1746,7 @@ char *parser_export_definition_legacy (igs_definition_t *def)
                         igs_json_add_string (json, argument->name);
                         igs_json_add_string (json, STR_TYPE);
                         igs_json_add_string (
-                          json, s_value_type_to_string (argument->type));
+                          json, s_exported_value_type (argument->type, true));
                         igs_json_close_map (json);
                     }
                 }
@@ -1525,7 +1778,7 @@ char *parser_export_definition_legacy (igs_definition_t *def)
                                     igs_json_add_string (json, STR_TYPE);
                                     igs_json_add_string (
                                       json,
-                                      s_value_type_to_string (argument->type));
+                                      s_exported_value_type (argument->type, true));
                                     igs_json_close_map (json);
                                 }
                             }
@@ -1548,6 +1801,24 @@ char *parser_export_definition_legacy (igs_definition_t *def)
     return res;
 }
 
+void s_add_mapping_element_to_json (igs_json_t *json, igs_map_t *elmt)
+{
+    igs_json_open_map (json);
+    if (elmt->from_input) {
+        igs_json_add_string (json, STR_FROM_INPUT);
+        igs_json_add_string (json, elmt->from_input);
+    }
+    if (elmt->to_agent) {
+        igs_json_add_string (json, STR_TO_AGENT);
+        igs_json_add_string (json, elmt->to_agent);
+    }
+    if (elmt->to_output) {
+        igs_json_add_string (json, STR_TO_OUTPUT);
+        igs_json_add_string (json, elmt->to_output);
+    }
+    igs_json_close_map (json);
+}
+
 char *parser_export_mapping (igs_mapping_t *mapping)
 {
     assert (mapping);
@@ -1557,22 +1828,7 @@ char *parser_export_mapping (igs_mapping_t *mapping)
     igs_json_open_array (json);
     igs_map_t *elmt, *tmp;
     HASH_ITER (hh, mapping->map_elements, elmt, tmp)
-    {
-        igs_json_open_map (json);
-        if (elmt->from_input) {
-            igs_json_add_string (json, STR_FROM_INPUT);
-            igs_json_add_string (json, elmt->from_input);
-        }
-        if (elmt->to_agent) {
-            igs_json_add_string (json, STR_TO_AGENT);
-            igs_json_add_string (json, elmt->to_agent);
-        }
-        if (elmt->to_output) {
-            igs_json_add_string (json, STR_TO_OUTPUT);
-            igs_json_add_string (json, elmt->to_output);
-        }
-        igs_json_close_map (json);
-    }
+        s_add_mapping_element_to_json (json, elmt);
     igs_json_close_array (json);
 
     igs_json_add_string (json, STR_SPLITS);
@@ -1603,6 +1859,27 @@ char *parser_export_mapping (igs_mapping_t *mapping)
     return res;
 }
 
+char *parser_export_mapping_fragment (igs_mapping_t *mapping, igs_delta_change_t *changes)
+{
+    assert (mapping);
+    igs_json_t *json = igs_json_new ();
+    igs_json_open_map (json);
+    igs_json_add_string (json, STR_MAPPINGS);
+    igs_json_open_array (json);
+    igs_delta_change_t *change = NULL;
+    LL_FOREACH (changes, change){
+        igs_map_t *elmt = NULL;
+        HASH_FIND (hh, mapping->map_elements, &change->id, sizeof (uint64_t), elmt);
+        if (elmt)
+            s_add_mapping_element_to_json (json, elmt);
+    }
+    igs_json_close_array (json);
+    igs_json_close_map (json);
+    char *res = igs_json_dump (json);
+    igs_json_destroy (&json);
+    return res;
+}
+
 // legacy mapping export
 char *parser_export_mapping_legacy (igs_mapping_t *mapping)
 {
@@ -1654,16 +1931,21 @@ igs_result_t igsagent_definition_load_str (igsagent_t *agent,
         igsagent_debug (agent, "json string caused an error and was ignored");
         return IGS_FAILURE;
     }
+    // renaming takes the model lock and joins the new agent channel
+    igsagent_set_name (agent, tmp->name);
     model_read_write_lock (__FUNCTION__, __LINE__);
     // check that this agent has not been destroyed when we were locked
     if (!agent || !(agent->uuid)) {
         model_read_write_unlock (__FUNCTION__, __LINE__);
+        definition_free_definition (&tmp);
         return IGS_FAILURE;
     }
-    igsagent_set_name (agent, tmp->name);
     definition_free_definition (&agent->definition);
     agent->definition = tmp;
-    agent->network_need_to_send_definition_update = true;
+    mapping_update_routes (agent);
+    agent->definition_generation++;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -1681,17 +1963,22 @@ igs_result_t igsagent_definition_load_file (igsagent_t *agent,
           file_path);
         return IGS_FAILURE;
     }
+    // renaming takes the model lock and joins the new agent channel
+    igsagent_set_name (agent, tmp->name);
     model_read_write_lock (__FUNCTION__, __LINE__);
     // check that this agent has not been destroyed when we were locked
     if (!agent || !(agent->uuid)) {
         model_read_write_unlock (__FUNCTION__, __LINE__);
+        definition_free_definition (&tmp);
         return IGS_FAILURE;
     }
-    igsagent_set_name (agent, tmp->name);
     definition_free_definition (&agent->definition);
     agent->definition_path = s_strndup (file_path, IGS_MAX_PATH_LENGTH - 1);
     agent->definition = tmp;
-    agent->network_need_to_send_definition_update = true;
+    mapping_update_routes (agent);
+    agent->definition_generation++;
+    definition_touch (agent);
+    network_schedule_definition_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -66,7 +66,8 @@ long long s_execute_current_and_find_next_action (void)
     if (s_current_action_type
         && (streq (s_replay_agent, "")
             || streq (s_current_agent, s_replay_agent))) {
-        if (s_current_data_type == IGS_DATA_T && s_current_iop_data[0] == '|') {
+        if ((s_current_data_type == IGS_DATA_T || model_is_array_type (s_current_data_type))
+            && s_current_iop_data[0] == '|') {
             // ignore this data entry because it is a size and not actual binary data
         } else {
             igsagent_t *agent, *tmp;
@@ -169,6 +170,12 @@ long long s_execute_current_and_find_next_action (void)
                 s_current_data_type = IGS_STRING_T;
             else if (streq (s_current_data_types, "data"))
                 s_current_data_type = IGS_DATA_T;
+            else if (streq (s_current_data_types, "int_array"))
+                s_current_data_type = IGS_INTEGER_ARRAY_T;
+            else if (streq (s_current_data_types, "float_array"))
+                s_current_data_type = IGS_FLOAT_ARRAY_T;
+            else if (streq (s_current_data_types, "double_array"))
+                s_current_data_type = IGS_DOUBLE_ARRAY_T;
             else
                 s_current_data_type = IGS_UNKNOWN_T;
 
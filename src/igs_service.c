@@ -374,6 +374,12 @@ igs_result_t igsagent_service_init (igsagent_t *agent,
     assert (name && strlen (name) > 0);
     assert (cb);
     igs_service_t *t = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL)
         agent->definition =
         (igs_definition_t *) zmalloc (sizeof (igs_definition_t));
@@ -383,11 +389,13 @@ igs_result_t igsagent_service_init (igsagent_t *agent,
         igsagent_error (
                         agent, "service with name %s already exists and has a callback",
                         name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (cb == NULL) {
         igsagent_error (agent,
                         "non-NULL callback is mandatory at service creation");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (t == NULL) {
@@ -401,10 +409,12 @@ igs_result_t igsagent_service_init (igsagent_t *agent,
             t->name = s_strndup (name, IGS_MAX_STRING_MSG_LENGTH);
         }
         HASH_ADD_STR (agent->definition->services_table, name, t);
-        agent->network_need_to_send_definition_update = true;
+        definition_touch_service (agent, t->name);
+        network_schedule_definition_update (agent);
     }
     t->cb = cb;
     t->cb_data = my_data;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -413,18 +423,28 @@ igs_result_t igsagent_service_remove (igsagent_t *agent, const char *name)
     assert (agent);
     assert (name);
     igs_service_t *t = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, name, t);
     if (t == NULL) {
         igsagent_error (agent, "service with name '%s' does not exist", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_DEL (agent->definition->services_table, t);
     service_free_service (t);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch_service (agent, name);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -437,21 +457,31 @@ igs_result_t igsagent_service_arg_add (igsagent_t *agent,
     assert (service_name);
     assert (arg_name && strlen (arg_name) > 0);
     igs_service_t *t = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, t);
     if (type == IGS_IMPULSION_T) {
         igsagent_error (agent, "impulsion type is not allowed as a service argument");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (type == IGS_UNKNOWN_T) {
         igsagent_error (agent, "unknown type is not allowed as a service argument");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (!t) {
         igsagent_error (agent, "service with name %s does not exist", service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_arg_t *a = (igs_service_arg_t *) zmalloc (sizeof (igs_service_arg_t));
@@ -482,7 +512,9 @@ igs_result_t igsagent_service_arg_add (igsagent_t *agent,
     }
     a->type = type;
     LL_APPEND (t->arguments, a);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch_service (agent, service_name);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -494,14 +526,22 @@ igs_result_t igsagent_service_arg_remove (igsagent_t *agent,
     assert (service_name);
     assert (arg_name);
     igs_service_t *t = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, t);
     if (t == NULL) {
         igsagent_error (agent, "service with name %s does not exist",
                         service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_arg_t *arg = NULL, *tmp = NULL;
@@ -517,13 +557,15 @@ igs_result_t igsagent_service_arg_remove (igsagent_t *agent,
                     free (arg->c);
             free (arg);
             found = true;
-            agent->network_need_to_send_definition_update = true;
+            definition_touch_service (agent, service_name);
+            network_schedule_definition_update (agent);
             break;
         }
     }
     if (!found)
         igsagent_debug (agent, "no argument named %s for service %s", arg_name,
                         service_name);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -533,20 +575,29 @@ igs_result_t igsagent_service_reply_add(igsagent_t *agent, const char *service_n
     assert (reply_name);
     igs_service_t *s = NULL;
     igs_service_t *r = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, s);
     if (!s) {
         igsagent_error (agent, "service with name %s does not exist",
                         service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (s->replies, reply_name, r);
     if (r) {
         igsagent_error (agent, "service reply with name %s already exists",
                         reply_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     r = (igs_service_t *) zmalloc (sizeof (igs_service_t));
@@ -556,7 +607,9 @@ igs_result_t igsagent_service_reply_add(igsagent_t *agent, const char *service_n
     } else
         r->name = s_strndup (reply_name, IGS_MAX_STRING_MSG_LENGTH);
     HASH_ADD_STR(s->replies, name, r);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch_service (agent, service_name);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -565,13 +618,21 @@ igs_result_t igsagent_service_reply_remove(igsagent_t *agent, const char *servic
     assert(service_name);
     assert(reply_name);
     igs_service_t *s = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, s);
     if (!s) {
         igsagent_error (agent, "service with name %s does not exist", service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_t *r = NULL;
@@ -579,10 +640,13 @@ igs_result_t igsagent_service_reply_remove(igsagent_t *agent, const char *servic
     if (r){
         HASH_DEL(s->replies, r);
         service_free_service (r);
-        agent->network_need_to_send_definition_update = true;
+        definition_touch_service (agent, service_name);
+        network_schedule_definition_update (agent);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }else{
         igsagent_error (agent, "service with name %s  has no reply named %s", service_name, reply_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
 }
@@ -594,27 +658,38 @@ igs_result_t igsagent_service_reply_arg_add(igsagent_t *agent, const char *servi
     assert(reply_name);
     assert(arg_name);
     igs_service_t *s = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, s);
     if (!s) {
         igsagent_error (agent, "service with name %s does not exist", service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_t *r = NULL;
     HASH_FIND_STR(s->replies, reply_name, r);
     if (!r){
         igsagent_error (agent, "service with name %s  has no reply named %s", service_name, reply_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (type == IGS_IMPULSION_T) {
         igsagent_error (agent, "impulsion type is not allowed as a service argument");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     if (type == IGS_UNKNOWN_T) {
         igsagent_error (agent, "unknown type is not allowed as a service argument");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_arg_t *a = (igs_service_arg_t *) zmalloc (sizeof (igs_service_arg_t));
@@ -644,7 +719,9 @@ igs_result_t igsagent_service_reply_arg_add(igsagent_t *agent, const char *servi
     }
     a->type = type;
     LL_APPEND (r->arguments, a);
-    agent->network_need_to_send_definition_update = true;
+    definition_touch_service (agent, service_name);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
@@ -655,19 +732,28 @@ igs_result_t igsagent_service_reply_arg_remove(igsagent_t *agent, const char *se
     assert(reply_name);
     assert(arg_name);
     igs_service_t *s = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
     if (agent->definition == NULL) {
         igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     HASH_FIND_STR (agent->definition->services_table, service_name, s);
     if (!s) {
         igsagent_error (agent, "service with name %s does not exist", service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_t *r = NULL;
     HASH_FIND_STR(s->replies, reply_name, r);
     if (!r){
         igsagent_error (agent, "service with name %s  has no reply named %s", service_name, reply_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
     igs_service_arg_t *arg = NULL, *tmp = NULL;
@@ -683,17 +769,74 @@ igs_result_t igsagent_service_reply_arg_remove(igsagent_t *agent, const char *se
                     free (arg->c);
             free (arg);
             found = true;
-            agent->network_need_to_send_definition_update = true;
+            definition_touch_service (agent, service_name);
+            network_schedule_definition_update (agent);
             break;
         }
     }
     if (!found) {
         igsagent_debug (agent, "no argument named %s for reply %s in service %s", arg_name, reply_name, service_name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
 
+igs_result_t igsagent_service_set_codec (igsagent_t *agent, const char *name,
+                                         igs_codec_t codec, size_t threshold)
+{
+    assert (agent);
+    assert (name);
+    igs_service_t *s = NULL;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    if (agent->definition == NULL) {
+        igsagent_error (agent, "No definition available yet");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    if (codec != IGS_CODEC_NONE && codec != IGS_CODEC_LZ) {
+        igsagent_error (agent, "unknown codec %d", codec);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    HASH_FIND_STR (agent->definition->services_table, name, s);
+    if (!s) {
+        igsagent_error (agent, "service with name %s does not exist", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    s->codec = codec;
+    s->codec_threshold = threshold;
+    definition_touch_service (agent, name);
+    network_schedule_definition_update (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_codec_t igsagent_service_codec (igsagent_t *agent, const char *name, size_t *threshold)
+{
+    assert (agent);
+    assert (name);
+    if (threshold)
+        *threshold = 0;
+    igs_service_t *s = NULL;
+    if (agent->definition)
+        HASH_FIND_STR (agent->definition->services_table, name, s);
+    if (!s) {
+        igsagent_warn (agent, "service with name %s does not exist", name);
+        return IGS_CODEC_NONE;
+    }
+    if (threshold)
+        *threshold = s->codec_threshold;
+    return s->codec;
+}
+
 void s_service_log_sent_service (igsagent_t *agent,
                                  const char *target_agent_name,
                                  const char *target_agentuuid,
@@ -833,27 +976,19 @@ igs_result_t igsagent_service_call (igsagent_t *agent,
                  }
                  }
                  */
-                zmsg_t *msg = zmsg_new ();
-                if (remote_agent->peer->protocol
-                    && (streq (remote_agent->peer->protocol, "v2")
-                        || streq (remote_agent->peer->protocol, "v3"))) {
-                    igs_warn ("Remote agent %s(%s) uses an older version of Ingescape with deprecated protocol. Please upgrade this agent.", remote_agent->definition->name, remote_agent->uuid);
-                    zmsg_addstr (msg, CALL_SERVICE_MSG_DEPRECATED);
-                }
-                else
-                    zmsg_addstr (msg, CALL_SERVICE_MSG);
-                
-                zmsg_addstr (msg, agent->uuid);
-                zmsg_addstr (msg, remote_agent->uuid);
-                zmsg_addstr (msg, service_name);
-                if (token)
-                    zmsg_addstr (msg, token);
-                else
-                    zmsg_addstr (msg, "");
+                // data arguments are compressed when the callee asks for it
+                // in its definition, which older peers never do
+                igs_service_t *service = NULL;
+                if (remote_agent->definition)
+                    HASH_FIND_STR (remote_agent->definition->services_table, service_name, service);
+                zmsg_t *args_msg = zmsg_new ();
+                zchunk_t *codecs = zchunk_new (NULL, 0);
+                bool compressed = false;
                 if (list) {
                     LL_FOREACH (*list, arg)
                     {
                         zframe_t *frame = NULL;
+                        byte codec = IGS_CODEC_NONE;
                         switch (arg->type) {
                             case IGS_BOOL_T:
                                 frame = zframe_new (&arg->b, sizeof (int));
@@ -873,15 +1008,51 @@ igs_result_t igsagent_service_call (igsagent_t *agent,
                                 break;
                             }
                             case IGS_DATA_T:
-                                frame = zframe_new (arg->data, arg->size);
+                                if (service && service->codec != IGS_CODEC_NONE)
+                                    frame = network_compress_frame (service->codec, service->codec_threshold,
+                                                                    arg->data, arg->size);
+                                if (frame) {
+                                    codec = (byte) service->codec;
+                                    compressed = true;
+                                } else
+                                    frame = zframe_new (arg->data, arg->size);
                                 break;
                             default:
                                 break;
                         }
                         assert (frame);
-                        zmsg_add (msg, frame);
+                        zmsg_add (args_msg, frame);
+                        zchunk_extend (codecs, &codec, 1);
                     }
                 }
+                zmsg_t *msg = zmsg_new ();
+                if (compressed)
+                    zmsg_addstr (msg, CALL_SERVICE_COMPRESSED_MSG);
+                else if (remote_agent->peer->protocol
+                    && (streq (remote_agent->peer->protocol, "v2")
+                        || streq (remote_agent->peer->protocol, "v3"))) {
+                    igs_warn ("Remote agent %s(%s) uses an older version of Ingescape with deprecated protocol. Please upgrade this agent.", remote_agent->definition->name, remote_agent->uuid);
+                    zmsg_addstr (msg, CALL_SERVICE_MSG_DEPRECATED);
+                }
+                else
+                    zmsg_addstr (msg, CALL_SERVICE_MSG);
+                
+                zmsg_addstr (msg, agent->uuid);
+                zmsg_addstr (msg, remote_agent->uuid);
+                zmsg_addstr (msg, service_name);
+                if (token)
+                    zmsg_addstr (msg, token);
+                else
+                    zmsg_addstr (msg, "");
+                if (compressed)
+                    zmsg_addmem (msg, zchunk_data (codecs), zchunk_size (codecs));
+                zchunk_destroy (&codecs);
+                zframe_t *arg_frame = zmsg_pop (args_msg);
+                while (arg_frame) {
+                    zmsg_append (msg, &arg_frame);
+                    arg_frame = zmsg_pop (args_msg);
+                }
+                zmsg_destroy (&args_msg);
                 if (agent->rt_timestamps_enabled)
                     zmsg_addmem(msg, &current_microseconds, sizeof(int64_t));
                 s_lock_zyre_peer (__FUNCTION__, __LINE__);
@@ -61,7 +61,7 @@ void split_remove_worker (igs_core_context_t *context, char *uuid, char *input_n
             igs_queued_work_t *work_elt, *work_tmp;
             LL_FOREACH_SAFE(splitter->queued_works, work_elt, work_tmp){
                 LL_DELETE(splitter->queued_works, work_elt);
-                if(work_elt->value_type == IGS_DATA_T){
+                if(work_elt->value_type == IGS_DATA_T || model_is_array_type(work_elt->value_type)){
                     free(work_elt->value.data);
                     work_elt->value.data = NULL;
                 }else if(work_elt->value_type == IGS_STRING_T){
@@ -135,7 +135,10 @@ void s_split_trigger_send_message_to_worker (igs_core_context_t *context, char *
                         case IGS_IMPULSION_T:
                             zmsg_addmem(readyMessage, NULL, 0);
                             break;
-                        case IGS_DATA_T:{
+                        case IGS_DATA_T:
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:{
                             zframe_t *frame = zframe_new (work->value.data, work->value_size);
                             zmsg_append(readyMessage, &frame);}
                             break;
@@ -172,6 +175,9 @@ void s_split_trigger_send_message_to_worker (igs_core_context_t *context, char *
                             work->value.s = NULL;
                             break;
                         case IGS_DATA_T:
+                        case IGS_INTEGER_ARRAY_T:
+                        case IGS_FLOAT_ARRAY_T:
+                        case IGS_DOUBLE_ARRAY_T:
                             free(work->value.data);
                             work->value.data = NULL;
                             break;
@@ -188,6 +194,14 @@ void s_split_trigger_send_message_to_worker (igs_core_context_t *context, char *
     }
 }
 
+/*
+ Queue mutex serializes outputs published concurrently by application
+ threads, which only share the model lock while publishing. Other split
+ functions hold the exclusive model lock.
+ */
+igs_mutex_t s_split_queue_mutex;
+static bool s_split_queue_mutex_initialized = false;
+
 void split_add_work_to_queue (igs_core_context_t *context, char* agent_uuid, const igs_iop_t *output)
 {
     assert(context);
@@ -196,6 +210,11 @@ void split_add_work_to_queue (igs_core_context_t *context, char* agent_uuid, con
     assert(output->name);
 
     if(context->splitters){
+        if (!s_split_queue_mutex_initialized) {
+            IGS_MUTEX_INIT (s_split_queue_mutex);
+            s_split_queue_mutex_initialized = true;
+        }
+        IGS_MUTEX_LOCK (s_split_queue_mutex);
         igs_splitter_t *splitter = NULL;
         LL_FOREACH(context->splitters, splitter){
             if(splitter->workers_list
@@ -221,6 +240,9 @@ void split_add_work_to_queue (igs_core_context_t *context, char* agent_uuid, con
                     case IGS_IMPULSION_T:
                         break;
                     case IGS_DATA_T:
+                    case IGS_INTEGER_ARRAY_T:
+                    case IGS_FLOAT_ARRAY_T:
+                    case IGS_DOUBLE_ARRAY_T:
                         new_work->value.data = (void *)zmalloc( output->value_size);
                         memcpy(new_work->value.data, output->value.data, output->value_size);
                         break;
@@ -231,6 +253,7 @@ void split_add_work_to_queue (igs_core_context_t *context, char* agent_uuid, con
             }
         }
         s_split_trigger_send_message_to_worker(context, agent_uuid, output);
+        IGS_MUTEX_UNLOCK (s_split_queue_mutex);
     }
 }
 
@@ -408,7 +431,7 @@ int split_message_from_splitter (zmsg_t *msg, igs_core_context_t *context)
 
     free(vType);
     vType = NULL;
-    if (valueType < IGS_INTEGER_T || valueType > IGS_DATA_T){
+    if ((valueType < IGS_INTEGER_T || valueType > IGS_DATA_T) && !model_is_array_type(valueType)){
         igs_error("input type is not valid (%d) in received publication : rejecting", valueType);
         free(agent_uuid);
         free(inputName);
@@ -608,7 +631,8 @@ uint64_t igsagent_split_add (igsagent_t *agent,
         new->id = hash;
         HASH_ADD (hh, agent->mapping->split_elements, id,
                   sizeof (uint64_t), new);
-        agent->network_need_to_send_mapping_update = true;
+        mapping_touch (agent);
+        network_schedule_mapping_update (agent);
 
         // If agent is already known send HELLO message immediately
         igs_remote_agent_t *elt_agent, *tmp_agent;
@@ -668,7 +692,8 @@ igs_result_t igsagent_split_remove_with_id (igsagent_t *agent,
         zmsg_addstr (goodbye_message, el->to_output);
         igs_channel_whisper_zmsg (el->to_agent, &goodbye_message);
         split_free_split_element(&el);
-        agent->network_need_to_send_mapping_update = true;
+        mapping_touch (agent);
+        network_schedule_mapping_update (agent);
         model_read_write_unlock (__FUNCTION__, __LINE__);
     }
     return IGS_SUCCESS;
@@ -725,7 +750,8 @@ igs_result_t igsagent_split_remove_with_name (igsagent_t *agent,
     zmsg_addstr (goodbye_message, tmp->to_output);
     igs_channel_whisper_zmsg (tmp->to_agent, &goodbye_message);
     split_free_split_element (&tmp);
-    agent->network_need_to_send_mapping_update = true;
+    mapping_touch (agent);
+    network_schedule_mapping_update (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -36,6 +36,7 @@ igsagent_t *igsagent_new (const char *name, bool activate_immediately)
     assert (name);
     core_init_context ();
     igsagent_t *agent = (igsagent_t *) zmalloc (sizeof (igsagent_t));
+    IGS_RWLOCK_INIT (agent->values_lock);
     zuuid_t *uuid = zuuid_new ();
     agent->uuid = strdup (zuuid_str (uuid));
     zuuid_destroy (&uuid);
@@ -43,7 +44,10 @@ igsagent_t *igsagent_new (const char *name, bool activate_immediately)
     igsagent_set_name (agent, name);
     assert (agent->definition);
     igsagent_clear_mappings (agent); // set valid but empty mapping
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    agent->topic_key = network_intern_topic_key (core_context);
     zhash_insert (core_context->created_agents, agent->uuid, agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
     if (activate_immediately)
         igsagent_activate (agent);
     return agent;
@@ -89,10 +93,29 @@ void igsagent_destroy (igsagent_t **agent)
         DL_DELETE ((*agent)->agent_event_callbacks, event_cb);
         free (event_cb);
     }
+    igs_batched_output_t *batched, *batchedtmp;
+    LL_FOREACH_SAFE ((*agent)->batched_outputs, batched, batchedtmp)
+    {
+        LL_DELETE ((*agent)->batched_outputs, batched);
+        free (batched->name);
+        free (batched);
+    }
+    mapping_remove_routes (*agent);
     if ((*agent)->mapping)
         mapping_free_mapping (&(*agent)->mapping);
     if ((*agent)->definition)
         definition_free_definition (&(*agent)->definition);
+    if ((*agent)->definition_export)
+        model_data_buffer_release (&(*agent)->definition_export);
+    if ((*agent)->definition_export_legacy)
+        model_data_buffer_release (&(*agent)->definition_export_legacy);
+    if ((*agent)->definition_export_without_arrays)
+        model_data_buffer_release (&(*agent)->definition_export_without_arrays);
+    if ((*agent)->definition_export_fingerprint)
+        free ((*agent)->definition_export_fingerprint);
+    definition_free_changes (&(*agent)->definition_changes);
+    definition_free_changes (&(*agent)->mapping_changes);
+    IGS_RWLOCK_DESTROY ((*agent)->values_lock);
     free (*agent);
     *agent = NULL;
     model_read_write_unlock (__FUNCTION__, __LINE__);
@@ -111,9 +134,12 @@ igs_result_t igsagent_activate (igsagent_t *agent)
                         agent->definition->name, agent->uuid);
         return IGS_FAILURE;
     }
-    agent->network_need_to_send_definition_update = true; // will also trigger mapping update
     agent->network_activation_during_runtime = true;
+    // peers may have forgotten this agent : next updates are complete ones
+    agent->definition_sent_revision = 0;
+    agent->mapping_sent_revision = 0;
     HASH_ADD_STR (core_context->agents, uuid, agent);
+    network_schedule_definition_update (agent); // will also trigger mapping update
     igsagent_wrapper_t *agent_wrapper_cb;
     DL_FOREACH (agent->activate_callbacks, agent_wrapper_cb)
         agent_wrapper_cb->callback_ptr (agent, true, agent_wrapper_cb->my_data);
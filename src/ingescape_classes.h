@@ -42,6 +42,20 @@
 
 //  Internal API
 
+//  Self tests of the classes, run by ingescape_selftest
+INGESCAPE_PRIVATE void
+    igs_json_test (bool verbose);
+INGESCAPE_PRIVATE void
+    igs_json_node_test (bool verbose);
+INGESCAPE_PRIVATE void
+    igs_definition_test (bool verbose);
+INGESCAPE_PRIVATE void
+    igs_mapping_test (bool verbose);
+INGESCAPE_PRIVATE void
+    igs_model_test (bool verbose);
+INGESCAPE_PRIVATE void
+    igs_network_test (bool verbose);
+
 
 //  *** To avoid double-definitions, only define if building without draft ***
 #ifndef INGESCAPE_BUILD_DRAFT_API
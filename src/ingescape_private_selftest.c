@@ -29,6 +29,15 @@
 void
 ingescape_private_selftest (bool verbose, const char *subtest)
 {
+// Tests for stable private classes:
+    if (streq (subtest, "$ALL") || streq (subtest, "igs_definition_test"))
+        igs_definition_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "igs_mapping_test"))
+        igs_mapping_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "igs_model_test"))
+        igs_model_test (verbose);
+    if (streq (subtest, "$ALL") || streq (subtest, "igs_network_test"))
+        igs_network_test (verbose);
 }
 /*
 ################################################################################
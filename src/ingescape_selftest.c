@@ -34,9 +34,11 @@ all_tests [] = {
 // Tests for stable public classes:
     { "igs_json", igs_json_test, true, true, NULL },
     { "igs_json_node", igs_json_node_test, true, true, NULL },
-    { "igs_service_arg", igs_service_arg_test, true, true, NULL },
-    { "igs", igs_test, true, true, NULL },
-    { "igsagent", igsagent_test, true, true, NULL },
+// Tests for stable private classes:
+    { "igs_definition", igs_definition_test, true, false, NULL },
+    { "igs_mapping", igs_mapping_test, true, false, NULL },
+    { "igs_model", igs_model_test, true, false, NULL },
+    { "igs_network", igs_network_test, true, false, NULL },
     {NULL, NULL, 0, 0, NULL}          //  Sentinel
 };
 
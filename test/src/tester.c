@@ -4,6 +4,7 @@
 #include <getopt.h> //command line options at statrtup
 #include <stdlib.h> //standard C functions such as getenv, atoi, exit, etc.
 #include <string.h> //C string handling functions
+#include <math.h>
 #include <signal.h> //catching interruptions
 #include <czmq.h>
 #include <igsagent.h>
@@ -366,6 +367,40 @@ void testerIOPCallback(igs_iop_type_t iopType, const char* name, igs_iop_value_t
 }
 
 
+int testerFreedDataCount = 0;
+void testerFreeData(void *data){
+    free(data);
+    testerFreedDataCount++;
+}
+
+//writer thread for the model locks stress test, writes outputs of
+//firstAgent and reads the inputs of secondAgent mapped on them
+#define TESTER_STRESS_WRITERS 4
+#define TESTER_STRESS_ITERATIONS 2000
+void testerStressWriter(zsock_t *pipe, void *args){
+    int offset = *(int *)args;
+    igsagent_read_handle_t *doubleHandle = igsagent_read_handle_new(secondAgent, "second_double", IGS_INPUT_T);
+    assert(doubleHandle);
+    zsock_signal(pipe, 0);
+    for (int i = 0; i < TESTER_STRESS_ITERATIONS; i++){
+        int value = offset * TESTER_STRESS_ITERATIONS + i;
+        igsagent_output_set_int(firstAgent, "first_int", value);
+        igsagent_output_set_double(firstAgent, "first_double", value);
+        igsagent_output_set_string(firstAgent, "first_string", (i % 2) ? "odd" : "even");
+        int received = igsagent_input_int(secondAgent, "second_int");
+        assert(received >= 0 && received < TESTER_STRESS_WRITERS * TESTER_STRESS_ITERATIONS);
+        char *str = igsagent_input_string(secondAgent, "second_string");
+        assert(str && (streq(str, "odd") || streq(str, "even") || streq(str, "test string mapping")));
+        free(str);
+        double polled = igsagent_read_handle_double(doubleHandle);
+        assert(polled >= 0 && polled < TESTER_STRESS_WRITERS * TESTER_STRESS_ITERATIONS);
+    }
+    igsagent_read_handle_destroy(&doubleHandle);
+    zsock_signal(pipe, 0);
+    char *command = zstr_recv(pipe); //wait for $TERM from zactor_destroy
+    zstr_free(&command);
+}
+
 // static tests function
 void run_static_tests (int argc, const char * argv[]){
     igs_log_set_syslog(true);
@@ -508,6 +543,33 @@ void run_static_tests (int argc, const char * argv[]){
     assert(!igs_mapping_outputs_request());
     igs_mapping_set_outputs_request(true);
     assert(igs_mapping_outputs_request());
+    assert(igs_net_update_debounce() == 5);
+    igs_net_set_update_debounce(20);
+    assert(igs_net_update_debounce() == 20);
+    igs_net_set_update_debounce(5);
+    size_t queueOccupancy = 1, queueHighWaterMark = 1, queueDropped = 1, queuePublished = 1;
+    igs_net_publication_queue_stats(&queueOccupancy, &queueHighWaterMark, &queueDropped, &queuePublished);
+    assert(queueOccupancy == 0 && queueHighWaterMark == 0 && queueDropped == 0 && queuePublished == 0);
+    assert(igs_net_set_publication_queue(100, 42) == IGS_FAILURE);
+    assert(igs_net_set_publication_queue(100, IGS_PUBLICATION_QUEUE_DROP_OLDEST) == IGS_SUCCESS);
+    igs_net_publication_queue_stats(&queueOccupancy, NULL, NULL, NULL);
+    assert(queueOccupancy == 0);
+    assert(igs_net_set_publication_queue(0, IGS_PUBLICATION_QUEUE_BLOCK) == IGS_SUCCESS);
+    igs_publication_queue_policy_t priorityPolicy = IGS_PUBLICATION_QUEUE_BLOCK;
+    assert(igs_net_priority_policy(IGS_PRIORITY_CONTROL, &priorityPolicy) == 1000);
+    assert(priorityPolicy == IGS_PUBLICATION_QUEUE_DROP_NEWEST);
+    assert(igs_net_set_priority_policy(IGS_PRIORITY_CONTROL, 10000, IGS_PUBLICATION_QUEUE_BLOCK) == IGS_SUCCESS);
+    assert(igs_net_set_priority_policy(IGS_PRIORITY_BULK, 10, IGS_PUBLICATION_QUEUE_DROP_OLDEST) == IGS_FAILURE);
+    assert(igs_net_priority_policy(IGS_PRIORITY_CONTROL, &priorityPolicy) == 10000);
+    assert(priorityPolicy == IGS_PUBLICATION_QUEUE_BLOCK);
+    assert(igs_net_set_priority_policy(IGS_PRIORITY_CONTROL, 1000, IGS_PUBLICATION_QUEUE_DROP_NEWEST) == IGS_SUCCESS);
+#if defined (__UNIX__)
+    size_t sharedMemoryThreshold = 1;
+    assert(igs_net_shared_memory(&sharedMemoryThreshold) == 0 && sharedMemoryThreshold == 0);
+    assert(igs_net_set_shared_memory(4 * 1024 * 1024, 64 * 1024) == IGS_SUCCESS);
+    assert(igs_net_shared_memory(&sharedMemoryThreshold) == 4 * 1024 * 1024 && sharedMemoryThreshold == 64 * 1024);
+    assert(igs_net_set_shared_memory(0, 0) == IGS_SUCCESS);
+#endif
 
     //general control functions
     assert(igs_pipe_to_ingescape() == NULL);
@@ -689,6 +751,28 @@ void run_static_tests (int argc, const char * argv[]){
     assert(igs_input_data("my_data", &data, &dataSize) == IGS_SUCCESS);
     assert(dataSize == 0 && data == NULL);
 
+    //pinned values
+    const void *pinned = NULL;
+    size_t pinnedSize = 0;
+    igs_value_pin_t *pin = NULL;
+    assert(igs_input_pin("my_int", &pinned, &pinnedSize, &pin) == IGS_FAILURE);
+    assert(igs_input_pin("my_data", &pinned, &pinnedSize, &pin) == IGS_SUCCESS);
+    assert(pinned == NULL && pinnedSize == 0 && pin == NULL);
+    igs_value_unpin(&pin);
+    assert(igs_input_pin("my_string", &pinned, &pinnedSize, &pin) == IGS_SUCCESS);
+    assert(pin && streq((const char *)pinned, "new string") && pinnedSize == strlen("new string") + 1);
+    assert(igs_input_set_string("my_string", "newer string") == IGS_SUCCESS);
+    assert(streq((const char *)pinned, "new string"));
+    igs_value_unpin(&pin);
+    assert(pin == NULL);
+    assert(igs_input_set_data("my_data", myOtherData, 64) == IGS_SUCCESS);
+    assert(igs_input_pin("my_data", &pinned, &pinnedSize, &pin) == IGS_SUCCESS);
+    assert(pinnedSize == 64 && memcmp(pinned, myOtherData, pinnedSize) == 0);
+    igs_clear_input("my_data");
+    assert(memcmp(pinned, myOtherData, pinnedSize) == 0);
+    igs_value_unpin(&pin);
+    assert(igs_input_set_string("my_string", "new string") == IGS_SUCCESS);
+
     //outputs
     assert(igs_output_create("my impulsion", IGS_IMPULSION_T, NULL, 0) == IGS_SUCCESS);
     assert(igs_output_create("my impulsion", IGS_IMPULSION_T, NULL, 0) == IGS_FAILURE);
@@ -762,6 +846,46 @@ void run_static_tests (int argc, const char * argv[]){
     dataSize = 0;
     assert(igs_output_data("my_data", &data, &dataSize) == IGS_SUCCESS);
     assert(dataSize == 0 && data == NULL);
+    void *ownedData = malloc(64);
+    memcpy(ownedData, myOtherData, 64);
+    assert(igs_output_set_data_owned("my_data", ownedData, 64, testerFreeData) == IGS_SUCCESS);
+    assert(testerFreedDataCount == 0);
+    assert(igs_output_data("my_data", &data, &dataSize) == IGS_SUCCESS);
+    assert(dataSize == 64 && memcmp(data, myOtherData, dataSize) == 0);
+    free(data);
+    data = NULL;
+    dataSize = 0;
+    igs_clear_output("my_data");
+    assert(testerFreedDataCount == 1);
+    assert(igs_output_set_data_owned("", malloc(8), 8, testerFreeData) == IGS_FAILURE);
+    assert(testerFreedDataCount == 2);
+    //typed arrays
+    float myFloats[6] = {1.5f, -2.25f, 3, 4, 5.5f, -6};
+    int myInts[5] = {1, 2, 3, 4, 5};
+    assert(igs_output_create("my_floats", IGS_FLOAT_ARRAY_T, myFloats, sizeof(myFloats)) == IGS_SUCCESS);
+    assert(igs_output_type("my_floats") == IGS_FLOAT_ARRAY_T);
+    double *doubles = NULL;
+    size_t nbElementsInArray = 0;
+    assert(igs_output_array("my_floats", IGS_DOUBLE_ARRAY_T, (void **)&doubles, &nbElementsInArray) == IGS_SUCCESS);
+    assert(nbElementsInArray == 6);
+    assert(doubles[1] > -2.2501 && doubles[1] < -2.2499 && doubles[4] > 5.4999 && doubles[4] < 5.5001);
+    free(doubles);
+    assert(igs_output_set_array("my_floats", IGS_INTEGER_ARRAY_T, myInts, 5) == IGS_SUCCESS);
+    int *ints = NULL;
+    assert(igs_output_array("my_floats", IGS_INTEGER_ARRAY_T, (void **)&ints, &nbElementsInArray) == IGS_SUCCESS);
+    assert(nbElementsInArray == 5 && memcmp(ints, myInts, sizeof(myInts)) == 0);
+    free(ints);
+    assert(igs_output_set_string("my_floats", "[0.5, 1, 2]") == IGS_SUCCESS);
+    string = igs_output_string("my_floats");
+    assert(streq(string, "[0.5, 1, 2]"));
+    free(string);
+    assert(igs_output_set_string("my_floats", "[0.5, one]") == IGS_FAILURE);
+    assert(igs_output_set_data("my_floats", myInts, 3) == IGS_FAILURE);
+    assert(igs_output_set_array("my_floats", IGS_INTEGER_T, myInts, 5) == IGS_FAILURE);
+    assert(igs_output_set_array("my_double", IGS_FLOAT_ARRAY_T, myFloats, 6) == IGS_SUCCESS);
+    assert(igs_output_double("my_double") > 1.4999 && igs_output_double("my_double") < 1.5001);
+    assert(igs_output_set_double("my_double", 2) == IGS_SUCCESS);
+    assert(igs_output_remove("my_floats") == IGS_SUCCESS);
 
 
     //parameters
@@ -844,8 +968,35 @@ void run_static_tests (int argc, const char * argv[]){
     igs_input_set_description("my_impulsion", "my iop description here");
     igs_output_set_description("my_impulsion", "my iop description here");
     igs_parameter_set_description("my_impulsion", "my iop description here");
+    //publication policies
+    assert(igs_output_set_max_rate("unknown", 60) == IGS_FAILURE);
+    assert(igs_output_set_max_rate("my_int", -1) == IGS_FAILURE);
+    assert(igs_output_set_min_interval("my_double", 20) == IGS_SUCCESS);
+    assert(igs_output_max_rate("my_double") > 49.999 && igs_output_max_rate("my_double") < 50.001);
+    assert(igs_output_set_max_rate("my_int", 60) == IGS_SUCCESS);
+    assert(igs_output_set_conflate("my_int", true) == IGS_SUCCESS);
+    assert(igs_output_is_conflated("my_int") && !igs_output_is_conflated("my_double"));
+    size_t suppressedPublications = 1, flushedPublications = 1;
+    igs_output_publication_stats("my_int", &suppressedPublications, &flushedPublications);
+    assert(suppressedPublications == 0 && flushedPublications == 0);
+    assert(igs_output_set_delta_encoding("my_int", 10) == IGS_FAILURE);
+    assert(igs_output_set_delta_encoding("my_data", 10) == IGS_SUCCESS);
+    assert(igs_output_delta_encoding("my_data") == 10 && igs_output_delta_encoding("my_int") == 0);
+    size_t keyframes = 1, deltas = 1;
+    igs_output_delta_stats("my_data", &keyframes, &deltas);
+    assert(keyframes == 0 && deltas == 0);
+    assert(igs_output_set_codec("my_int", IGS_CODEC_LZ, 0) == IGS_FAILURE);
+    assert(igs_output_set_codec("my_data", IGS_CODEC_LZ, 256) == IGS_SUCCESS);
+    assert(igs_output_set_chunk_size("my_int", 1024) == IGS_FAILURE);
+    assert(igs_output_set_chunk_size("my_data", 1024 * 1024) == IGS_SUCCESS);
+    assert(igs_output_set_priority("my_int", IGS_PRIORITY_CONTROL) == IGS_SUCCESS);
+    assert(igs_output_set_priority("my_data", IGS_PRIORITY_BULK) == IGS_SUCCESS);
+    assert(igs_output_set_priority("my_data", (igs_output_priority_t) 42) == IGS_FAILURE);
     char *exportedDef = igs_definition_json();
     assert(exportedDef);
+    assert(strstr(exportedDef, "\"id\"")); //outputs have ids for compact publications
+    assert(strstr(exportedDef, "\"max_rate\"") && strstr(exportedDef, "\"conflate\""));
+    assert(strstr(exportedDef, "\"keyframe_interval\""));
     igs_definition_set_path("/tmp/simple Demo Agent.json");
     igs_definition_save();
     igs_clear_definition();
@@ -868,6 +1019,16 @@ void run_static_tests (int argc, const char * argv[]){
     assert(listOfStrings == NULL && nbElements == 0);
     //////////////////////////////////
     igs_definition_load_str(exportedDef);
+    assert(igs_output_max_rate("my_int") > 59.99 && igs_output_max_rate("my_int") < 60.01);
+    assert(igs_output_is_conflated("my_int"));
+    assert(igs_output_delta_encoding("my_data") == 10);
+    size_t outputCodecThreshold = 0;
+    assert(igs_output_codec("my_data", &outputCodecThreshold) == IGS_CODEC_LZ && outputCodecThreshold == 256);
+    assert(igs_output_chunk_size("my_data") == 1024 * 1024);
+    assert(igs_output_priority("my_int") == IGS_PRIORITY_CONTROL);
+    assert(igs_output_priority("my_data") == IGS_PRIORITY_BULK);
+    assert(igs_output_priority("my_double") == IGS_PRIORITY_NORMAL);
+    assert(igs_output_set_delta_encoding("my_data", 0) == IGS_SUCCESS);
     listOfStrings = NULL;
     listOfStrings = igs_input_list(&nbElements);
     assert(listOfStrings && nbElements == 6);
@@ -1221,10 +1382,14 @@ void run_static_tests (int argc, const char * argv[]){
     assert(list->next->next->next->next->type == IGS_DATA_T);
     assert(list->next->next->next->next->size == 0);
     assert(list->next->next->next->next->data == NULL);
+    assert(igs_service_set_codec("toto", IGS_CODEC_LZ, 0) == IGS_FAILURE);
+    assert(igs_service_set_codec("myService", IGS_CODEC_LZ, 1024) == IGS_SUCCESS);
     igs_definition_save();
     assert(igs_service_remove("myService") == IGS_SUCCESS);
     igs_clear_definition();
     igs_definition_load_file("/tmp/simple Demo Agent.json");
+    size_t codecThreshold = 0;
+    assert(igs_service_codec("myService", &codecThreshold) == IGS_CODEC_LZ && codecThreshold == 1024);
     assert(igs_service_args_count("myService") == 5);
     assert(igs_service_arg_exists("myService", "myBool"));
     assert(igs_service_arg_exists("myService", "myInt"));
@@ -1796,6 +1961,106 @@ void run_static_tests (int argc, const char * argv[]){
     assert(igsagent_input_data(secondAgent, "second_data", &data, &dataSize) == IGS_SUCCESS);
     assert(streq((char*)data, "my data") && strlen((char*)data) == dataSize - 1);
 
+    //test mapping updates in same process
+    igsagent_mapping_remove_with_name(secondAgent, "second_int", "firstAgent", "first_int");
+    igsagent_output_set_int(firstAgent, "first_int", 6);
+    assert(igsagent_input_int(secondAgent, "second_int") == 5);
+    igsagent_mapping_add(secondAgent, "second_int", "firstAgent", "first_int");
+    igsagent_output_set_int(firstAgent, "first_int", 7);
+    assert(igsagent_input_int(secondAgent, "second_int") == 7);
+    igsagent_input_remove(secondAgent, "second_int");
+    igsagent_output_set_int(firstAgent, "first_int", 8);
+    igsagent_input_create(secondAgent, "second_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    igsagent_output_set_int(firstAgent, "first_int", 9);
+    assert(igsagent_input_int(secondAgent, "second_int") == 9);
+
+    //test output handles in same process
+    igsagent_output_handle_t *firstIntHandle = igsagent_output_handle_new(firstAgent, "first_int");
+    assert(firstIntHandle);
+    assert(igsagent_output_handle_new(firstAgent, "unknown_output") == NULL);
+    assert(igsagent_output_handle_set_int(firstIntHandle, 10) == IGS_SUCCESS);
+    assert(igsagent_output_int(firstAgent, "first_int") == 10);
+    assert(igsagent_input_int(secondAgent, "second_int") == 10);
+    igsagent_output_remove(firstAgent, "first_int");
+    assert(igsagent_output_handle_set_int(firstIntHandle, 11) == IGS_FAILURE);
+    igsagent_output_create(firstAgent, "first_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    assert(igsagent_output_handle_set_int(firstIntHandle, 12) == IGS_SUCCESS);
+    assert(igsagent_input_int(secondAgent, "second_int") == 12);
+    igsagent_output_handle_destroy(&firstIntHandle);
+    assert(firstIntHandle == NULL);
+
+    //test output batches in same process
+    assert(igsagent_output_batch_commit(firstAgent) == IGS_FAILURE);
+    assert(igsagent_output_batch_begin(firstAgent) == IGS_SUCCESS);
+    assert(igsagent_output_batch_begin(firstAgent) == IGS_FAILURE);
+    igsagent_output_set_int(firstAgent, "first_int", 13);
+    igsagent_output_set_double(firstAgent, "first_double", 13.5);
+    igsagent_output_set_int(firstAgent, "first_int", 14);
+    assert(igsagent_output_int(firstAgent, "first_int") == 14);
+    assert(igsagent_input_int(secondAgent, "second_int") == 12);
+    assert(igsagent_output_batch_commit(firstAgent) == IGS_SUCCESS);
+    assert(igsagent_input_int(secondAgent, "second_int") == 14);
+    assert(fabs(igsagent_input_double(secondAgent, "second_double") - 13.5) < 0.000001);
+
+    //test read handles in same process
+    igsagent_read_handle_t *secondIntHandle = igsagent_read_handle_new(secondAgent, "second_int", IGS_INPUT_T);
+    assert(secondIntHandle);
+    assert(igsagent_read_handle_new(secondAgent, "unknown_input", IGS_INPUT_T) == NULL);
+    igsagent_output_set_int(firstAgent, "first_int", 15);
+    assert(igsagent_read_handle_int(secondIntHandle) == 15);
+    assert(fabs(igsagent_read_handle_double(secondIntHandle) - 15) < 0.000001);
+    igsagent_input_remove(secondAgent, "second_int");
+    igsagent_input_create(secondAgent, "second_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    igsagent_output_set_int(firstAgent, "first_int", 16);
+    assert(igsagent_read_handle_int(secondIntHandle) == 16);
+    igsagent_read_handle_destroy(&secondIntHandle);
+    assert(secondIntHandle == NULL);
+
+    //test publication filters in same process
+    assert(igsagent_output_set_publication_filter(firstAgent, "first_impulsion", IGS_PUBLICATION_FILTER_CHANGE, 0) == IGS_FAILURE);
+    assert(igsagent_output_set_publication_filter(firstAgent, "first_string", IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE, 1) == IGS_FAILURE);
+    assert(igsagent_output_set_publication_filter(firstAgent, "first_int", IGS_PUBLICATION_FILTER_DEADBAND_ABSOLUTE, 2) == IGS_SUCCESS);
+    igsagent_output_set_int(firstAgent, "first_int", 20); //first value is always published
+    assert(igsagent_input_int(secondAgent, "second_int") == 20);
+    igsagent_output_set_int(firstAgent, "first_int", 21);
+    assert(igsagent_output_int(firstAgent, "first_int") == 21);
+    assert(igsagent_input_int(secondAgent, "second_int") == 20);
+    igsagent_output_set_int(firstAgent, "first_int", 23);
+    assert(igsagent_input_int(secondAgent, "second_int") == 23);
+    assert(igsagent_output_filtered_publications(firstAgent, "first_int") == 1);
+    igsagent_output_mute(firstAgent, "first_int");
+    igsagent_output_set_int(firstAgent, "first_int", 30); //not published : 23 stays the reference
+    igsagent_output_unmute(firstAgent, "first_int");
+    igsagent_output_set_int(firstAgent, "first_int", 31);
+    assert(igsagent_input_int(secondAgent, "second_int") == 31);
+    assert(igsagent_output_filtered_publications(firstAgent, "first_int") == 1);
+    assert(igsagent_output_set_publication_filter(firstAgent, "first_string", IGS_PUBLICATION_FILTER_CHANGE, 0) == IGS_SUCCESS);
+    igsagent_output_set_string(firstAgent, "first_string", "filtered");
+    igsagent_output_set_string(firstAgent, "first_string", "filtered");
+    assert(igsagent_output_filtered_publications(firstAgent, "first_string") == 1);
+    igsagent_output_set_string(firstAgent, "first_string", "filtereD");
+    assert(igsagent_output_filtered_publications(firstAgent, "first_string") == 1);
+    igsagent_output_set_publication_filter(firstAgent, "first_string", IGS_PUBLICATION_FILTER_NONE, 0);
+    igsagent_output_set_publication_filter(firstAgent, "first_int", IGS_PUBLICATION_FILTER_NONE, 0);
+
+    //stress model locks with concurrent writers in same process
+    igs_log_level_t consoleLevel = igs_log_console_level();
+    igs_log_set_console_level(IGS_LOG_ERROR);
+    zactor_t *writers[TESTER_STRESS_WRITERS];
+    int writersOffsets[TESTER_STRESS_WRITERS];
+    for (int i = 0; i < TESTER_STRESS_WRITERS; i++){
+        writersOffsets[i] = i;
+        writers[i] = zactor_new(testerStressWriter, &writersOffsets[i]);
+    }
+    for (int i = 0; i < TESTER_STRESS_WRITERS; i++){
+        zsock_wait(writers[i]);
+        zactor_destroy(&writers[i]);
+    }
+    igs_log_set_console_level(consoleLevel);
+    igsagent_output_set_int(firstAgent, "first_int", 42);
+    assert(igsagent_input_int(secondAgent, "second_int") == 42);
+    igsagent_observe_input(secondAgent, "second_int", agentIOPCallback, NULL);
+
     //test service in the same process
     list = NULL;
     igs_service_args_add_bool(&list, true);
@@ -1825,6 +2090,7 @@ void run_static_tests (int argc, const char * argv[]){
     assert(tester_secondAgentKnowsUs);
     assert(first_secondAgentEntered);
     assert(first_secondAgentKnowsUs);
+
     igsagent_deactivate(firstAgent);
     assert(tester_firstAgentExited);
     assert(second_firstAgentExited);